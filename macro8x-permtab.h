@@ -0,0 +1,557 @@
+/* Generated by mkpermtab from macro8x.c.  Do not edit. */
+
+#define PERMTAB_BUCKETS  128
+#define PERMTAB_COUNT    144
+#define PERMTAB_SIZE     512
+
+int     permtab_builtin_disp[PERMTAB_BUCKETS] =
+{
+  1, 0, 1, 2, 1, 1, 1, 2, 1, 2,
+  0, 1, 1, 0, 1, 0, 0, 0, 2, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+  0, 1, 1, 0, 0, 1, 1, 2, 1, 1,
+  1, 0, 0, 2, 1, 1, 0, 0, 0, 1,
+  0, 2, 1, 1, 1, 1, 1, 0, 1, 1,
+  1, 0, 0, 0, 1, 1, 0, 1, 0, 2,
+  2, 0, 0, 1, 0, 0, 0, 1, 1, 0,
+  1, 1, 2, 1, 1, 0, 1, 2, 1, 1,
+  1, 1, 0, 1, 0, 1, 1, 3, 1, 2,
+  1, 0, 0, 1, 2, 1, 0, 0, 1, 1,
+  0, 1, 2, 1, 0, 4, 2, 0, 1, 1,
+  1, 0, 1, 0, 2, 1, 2, 1
+};
+
+int     permtab_builtin_order[PERMTAB_COUNT] =
+{
+  195, 77, 229, 391, 344, 268, 496, 238, 120, 290,
+  486, 380, 26, 323, 211, 258, 185, 92, 11, 51,
+  365, 78, 129, 231, 161, 336, 442, 53, 110, 339,
+  115, 153, 99, 474, 168, 55, 311, 104, 103, 479,
+  430, 33, 93, 379, 288, 44, 94, 121, 30, 438,
+  345, 36, 259, 27, 404, 1, 139, 466, 108, 300,
+  13, 462, 203, 128, 150, 24, 310, 83, 49, 247,
+  89, 394, 163, 201, 256, 320, 157, 257, 278, 73,
+  504, 478, 418, 273, 124, 305, 252, 50, 62, 183,
+  40, 166, 293, 487, 295, 174, 122, 208, 0, 399,
+  433, 338, 207, 29, 363, 86, 2, 328, 387, 250,
+  116, 16, 485, 46, 242, 189, 489, 243, 251, 156,
+  402, 493, 343, 412, 137, 186, 32, 410, 357, 70,
+  368, 237, 262, 220, 75, 352, 359, 37, 22, 452,
+  84, 165, 180, 280
+};
+
+SYM_T   permtab_builtin[PERMTAB_SIZE] =
+{
+  {    03, 1858103999UL, 06021 },    /* PSF    */
+  {  0103, 1152277717UL,   012 },    /* FLTG   */
+  {    03, 1978050303UL, 06224 },    /* RIF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  996173385UL, 06611 },    /* DCIM   */
+  {     0,          0UL,     0 },
+  {    03, 1221142524UL, 07204 },    /* GLK    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1996791913UL, 06011 },    /* RSF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2129705385UL, 06044 },    /* TPC    */
+  {     0,          0UL,     0 },
+  {  0103, 1348252028UL,   013 },    /* IFDEF  */
+  {     0,          0UL,     0 },
+  {    03,  945134327UL, 07040 },    /* CMA    */
+  {  0103, 1145902802UL,   010 },    /* FIELD  */
+  {     0,          0UL,     0 },
+  {  0103, 1970892283UL,   030 },    /* RELOC  */
+  {  0103, 1105241151UL,    07 },    /* EXPUNG */
+  {     0,          0UL,     0 },
+  {    03, 2063163453UL,    01 },    /* SQUARE */
+  {    03, 1028531069UL, 06771 },    /* DTSF   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1139378999UL,     0 },    /* FEXT   */
+  {    03, 2123019189UL, 06046 },    /* TLS    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1783745395UL, 07000 },    /* OPR    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1035124173UL, 06643 },    /* DXAL   */
+  {     0,          0UL,     0 },
+  {    03, 1998969992UL, 07006 },    /* RTL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1349366863UL,   016 },    /* IFZERO */
+  {    03, 1712425971UL, 07000 },    /* NOP    */
+  {    03,  996359569UL, 06601 },    /* DCMA   */
+  {     0,          0UL,     0 },
+  {    03, 1007604535UL, 06616 },    /* DIMA   */
+  {     0,          0UL,     0 },
+  {    03, 1025741047UL, 06612 },    /* DSAC   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1712469311UL,   024 },    /* NOPUNC */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2068313949UL, 07120 },    /* STL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1547651762UL, 07604 },    /* LAS    */
+  {     0,          0UL,     0 },
+  {  0103, 2109465231UL,    05 },    /* TEJECT */
+  {     0,          0UL,     0 },
+  {  0103,  853987676UL,     0 },    /* BANK   */
+  {    03,  999502793UL, 06616 },    /* DEAC   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1348787298UL,   015 },    /* IFNZER */
+  {  0103, 2195784011UL,   034 },    /* UNLIST */
+  {     0,          0UL,     0 },
+  {    03, 1977847691UL, 06234 },    /* RIB    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1365604880UL, 06001 },    /* ION    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  995954345UL, 06611 },    /* DCEA   */
+  {    03, 1028777489UL, 06764 },    /* DTXA   */
+  {  0103, 1086499537UL,    06 },    /* ENPUNC */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1014523461UL, 06605 },    /* DMAW   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1028171022UL, 06774 },    /* DTLB   */
+  {    03, 1028169653UL, 06766 },    /* DTLA   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1159842811UL, 06000 },    /* FPUT   */
+  {     0,          0UL,     0 },
+  {    03, 1007619594UL, 06615 },    /* DIML   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1014496081UL, 06626 },    /* DMAC   */
+  {    03, 1994715140UL, 06012 },    /* RRB    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  937637683UL, 07041 },    /* CIA    */
+  {    03, 1089849948UL, 06103 },    /* EPI    */
+  {    03, 1845643361UL, 06026 },    /* PLS    */
+  {     0,          0UL,     0 },
+  {    03, 1646070541UL, 07501 },    /* MQA    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1317535183UL,  0400 },    /* I      */
+  {    03,  999515114UL, 06615 },    /* DEAL   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2060969264UL, 06107 },    /* SPO    */
+  {     0,          0UL,     0 },
+  {    07, 1153973908UL, 03000 },    /* FMPY   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1338809443UL, 07001 },    /* IAC    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1014516616UL, 06603 },    /* DMAR   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2055397434UL, 06101 },    /* SMP    */
+  {    03, 1509307441UL, 06036 },    /* KRB    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103,  999765175UL,    03 },    /* DEFINE */
+  {     0,          0UL,     0 },
+  {    07, 1373709360UL, 02000 },    /* ISZ    */
+  {     0,          0UL,     0 },
+  {  0103, 2249702342UL,   035 },    /* VFD    */
+  {    03, 1789367878UL, 07404 },    /* OSR    */
+  {     0,          0UL,     0 },
+  {    03, 1020505991UL, 06100 },    /* DPI    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1828117423UL, 06022 },    /* PCF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 2496382452UL,     0 },    /* Z      */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1759498481UL,   025 },    /* OCTAL  */
+  {     0,          0UL,     0 },
+  {    07,  995736674UL, 03000 },    /* DCA    */
+  {    03, 2063030564UL,    02 },    /* SQROOT */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2044355080UL, 06006 },    /* SGT    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07,  808472533UL,     0 },    /* AND    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1431301821UL, 05000 },    /* JMP    */
+  {     0,          0UL,     0 },
+  {    03, 1290942358UL, 07402 },    /* HLT    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1968679498UL, 06214 },    /* RDF    */
+  {    03, 1852329557UL, 06024 },    /* PPC    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  945894122UL, 06104 },    /* CMP    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2105493251UL, 06042 },    /* TCF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103,  868988980UL,    01 },    /* BINPUN */
+  {     0,          0UL,     0 },
+  {  0103,  999613175UL,    02 },    /* DECIMA */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2079558915UL, 07430 },    /* SZL    */
+  {    03,  930900834UL, 06106 },    /* CEP    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1999273910UL, 07012 },    /* RTR    */
+  {    03, 2051649112UL, 07410 },    /* SKP    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1365199656UL, 06002 },    /* IOF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1991118777UL, 06010 },    /* RPE    */
+  {    03, 2054637639UL, 07500 },    /* SMA    */
+  {  0103, 1712247483UL,   023 },    /* NOLGM  */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1431453780UL, 04000 },    /* JMS    */
+  {    03, 1510168542UL, 06034 },    /* KRS    */
+  {    03,  947768283UL, 06104 },    /* CNP    */
+  {    07, 1142164914UL, 05000 },    /* FGET   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 2101643623UL, 01000 },    /* TAD    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  928520143UL, 06201 },    /* CDF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1562712567UL,   022 },    /* LITBAS */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1511384214UL, 06031 },    /* KSF    */
+  {     0,          0UL,     0 },
+  {  0103, 2520021477UL,   036 },    /* ZBLOCK */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1035111852UL, 06645 },    /* DXAC   */
+  {     0,          0UL,     0 },
+  {    03,  937890948UL, 06202 },    /* CIF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1824440289UL,   026 },    /* PAGE   */
+  {     0,          0UL,     0 },
+  {    03, 1828066770UL, 06020 },    /* PCE    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1165440652UL, 02000 },    /* FSUB   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1646627724UL, 07421 },    /* MQL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1348757168UL,   014 },    /* IFNDEF */
+  {    03, 1027713776UL, 06762 },    /* DTCA   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1481245679UL, 06032 },    /* KCC    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  945691510UL, 07020 },    /* CML    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1978441639UL,   031 },    /* RIMPUN */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1002288708UL, 06622 },    /* DFSC   */
+  {     0,          0UL,     0 },
+  {    03, 1966653378UL, 06016 },    /* RCC    */
+  {    03, 1007922143UL, 06623 },    /* DISK   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2057271595UL, 06101 },    /* SNP    */
+  {    03,  922897660UL, 06007 },    /* CAF    */
+  {    07, 1136747781UL, 04000 },    /* FDIV   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 2110194397UL,   032 },    /* TEXT   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2067756766UL, 07240 },    /* STA    */
+  {     0,          0UL,     0 },
+  {  0103, 2117478032UL,   033 },    /* TITLE  */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1972275861UL, 06014 },    /* RFC    */
+  {     0,          0UL,     0 },
+  {    03,  996916752UL, 06641 },    /* DCXA   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2079001732UL, 07440 },    /* SZA    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1029552343UL,    04 },    /* DUBL   */
+  {    03,  943817349UL, 07100 },    /* CLL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1985546947UL, 06224 },    /* RMF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  888149702UL, 07002 },    /* BSW    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1365908798UL, 06000 },    /* IOT    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1963360933UL, 07004 },    /* RAL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2056511800UL, 07450 },    /* SNA    */
+  {     0,          0UL,     0 },
+  {  0103, 1146876062UL,   011 },    /* FIXTAB */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2064818892UL, 06003 },    /* SRQ    */
+  {     0,          0UL,     0 },
+  {    03, 2060260122UL, 07510 },    /* SPA    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1562695703UL,   021 },    /* LIT    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1028474940UL, 06772 },    /* DTRB   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1963664851UL, 07010 },    /* RAR    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    07, 1130847391UL, 01000 },    /* FADD   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1002291446UL, 06621 },    /* DFSE   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2135479827UL, 06041 },    /* TSF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1235882547UL, 06004 },    /* GTF    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1155787833UL, 07000 },    /* FNOR   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1015127190UL, 06646 },    /* DMMT   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1562686120UL,   020 },    /* LIST   */
+  {    03, 1028473571UL, 06761 },    /* DTRA   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 1998666074UL, 06005 },    /* RTF    */
+  {    03,  943260166UL, 07200 },    /* CLA    */
+  {  0103, 1825169152UL,   027 },    /* PAUSE  */
+  {     0,          0UL,     0 },
+  {    03, 2051631315UL, 06000 },    /* SKON   */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03, 2057068983UL, 07420 },    /* SNL    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {    03,  928672102UL, 06203 },    /* CDI    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {  0103, 1558592810UL,   017 },    /* LGM    */
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 },
+  {     0,          0UL,     0 }
+};
@@ -11,19 +11,20 @@
 /*    macro8x - a PDP/8 macro8x-like assembler.                               */
 /*                                                                            */
 /* SYNOPSIS:                                                                  */
-/*    macro8x [ -d -m -p -r -x ] inputfile inputfile...                       */
+/*    macro8x [ -c -d -e -m -p -r -s -x -z ] [ -u snapshot ] inputfile...     */
+/*    macro8x -j n [ options ] { inputfile | @file }...                       */
 /*                                                                            */
 /* DESCRIPTION                                                                */
 /*    This is a cross-assembler to for PDP/8 assembly language programs.      */
 /*    It will produce an output file in bin format, rim format, and using the */
 /*    appropriate pseudo-ops, a combination of rim and bin formats.           */
-/*    A listing file is always produced and with an optional symbol table     */
-/*    and/or a symbol cross-reference (concordance).  The permanent symbol    */
-/*    table can be output in a form that may be read back in so a customized  */
-/*    permanent symbol table can be produced.  Any detected errors are output */
-/*    to a separate file giving the filename in which they were detected      */
-/*    along with the line number, column number and error message as well as  */
-/*    marking the error in the listing file.                                  */
+/*    A listing file is produced (with -e only if there are errors) with an   */
+/*    optional symbol table and/or a symbol cross-reference (concordance).    */
+/*    The permanent symbol table can be output in a form that may be read     */
+/*    back in so a customized permanent symbol table can be produced.  Any    */
+/*    detected errors are output to a separate file giving the filename in    */
+/*    which they were detected along with the line number, column number and  */
+/*    error message as well as marking the error in the listing file.         */
 /*    The following file name extensions are used:                            */
 /*       .pal    source code (input)                                          */
 /*       .lst    assembly listing (output)                                    */
@@ -32,15 +33,35 @@
 /*       .err    assembly errors detected (if any) (output)                   */
 /*       .prm    permanent symbol table in form suitable for reading after    */
 /*               the EXPUNGE pseudo-op.                                       */
+/*       .pst    permanent symbol table snapshot, to be loaded with -u.       */
 /*                                                                            */
 /* OPTIONS                                                                    */
+/*    -c   Punch the bin output from a memory image kept during the assembly, */
+/*         with an origin only where the loaded words are not consecutive.    */
+/*         It loads the same words, and is shorter.  The characters saved     */
+/*         are shown at the end of the listing.  Not used with -r.            */
 /*    -d   Dump the symbol table at end of assembly                           */
+/*    -e   Keep the listing only if there are errors.  Without errors it is   */
+/*         not made at all, and no .lst file is left.                         */
+/*    -j   Assemble each input file on its own, as if it were named alone,    */
+/*         on a pool of as many threads as the next argument, 0 for one per   */
+/*         processor.  The files with errors are then named on stderr, in the */
+/*         order they were given.  Without -j the input files are assembled   */
+/*         together, as one source named after the first.                     */
 /*    -m   Print macro expansions.                                            */
 /*    -p   Generate a file with the permanent symbols in it.                  */
 /*         (To get the current symbol table, assemble a file than has only    */
 /*          a $ in it.)                                                       */
 /*    -r   Produce output in rim format (default is bin format)               */
+/*    -s   Generate a binary snapshot of the permanent symbols at the end of  */
+/*         assembly.  It is hashed and sorted, and loaded with -u as is.      */
+/*    -u   Use the permanent symbol snapshot named by the next argument in    */
+/*         place of the built-in permanent symbol table.                      */
 /*    -x   Generate a cross-reference (concordance) of user symbols.          */
+/*    -z   List every word of a ZBLOCK.  Without it only the first and the    */
+/*         last word of the block are listed.                                 */
+/*    @file  With -j, read input file names from file, one to a line.         */
+/*         Blank lines and the blanks around a name are dropped.              */
 /*                                                                            */
 /* DIAGNOSTICS                                                                */
 /*    Assembler error diagnostics are output to an error file and inserted    */
@@ -154,22 +175,35 @@
 /*                                                                            */
 /******************************************************************************/
 
+#define _POSIX_C_SOURCE 200809L  /* For mmap() and open_memstream().       */
+
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#define LINELEN              96
 #define LIST_LINES_PER_PAGE  60         /* Includes 5 line page header.       */
 #define NAMELEN             128
 #define SYMBOL_COLUMNS        5
 #define SYMLEN                7
-#define SYMBOL_TABLE_SIZE  8192
+#define SYMBOL_CHUNK_SIZE   256         /* First chunk, later chunks double.  */
+#define SYMBOL_CHUNKS        16         /* Room for 256 * ( 2^16 - 1 ) syms. */
+#define PERM_DISP_LIMIT 100000L        /* Give up the perfect hash search.   */
+#define ARENA_BLOCK      65536         /* Size of blocks for rewritten lines.*/
 #define MAC_MAX_ARGS         20         /* Must be < 26                       */
 #define MAC_MAX_LENGTH     8192
 #define MAC_TABLE_LENGTH   1024         /* Must be <= 4096.                   */
 #define TITLELEN             63
+#define TAPE_BUFFER        8192         /* Object characters written at once. */
+#define LIST_BUFFER     2097152         /* Listing characters written at once.*/
 #define XREF_COLUMNS          8
+#define XREF_BLOCK_BYTES     12         /* Bytes of references in a block.    */
 
 #define ADDRESS_FIELD  00177
 #define FIELD_FIELD   070000
@@ -186,7 +220,10 @@
 #define PAGE_FIELD     07600
 #define PAGE_ZERO_END  00200
 #define TOTAL_PAGES    (32 * 8)
+#define LIT_VALUES    010000            /* Values of a literal, 12 bits.      */
+#define LIT_WORDS  (PAGE_SIZE / 32)     /* Words of a bit per pool location.  */
 #define GET_PAGE(x)    (((x) >> 7) & (TOTAL_PAGES - 1))
+#define IMAGE_SIZE     32768            /* Words of memory, 8 fields of 4K.   */
 
 /* Macro to get the number of elements in an array.                           */
 #define DIM(a) (sizeof(a)/sizeof(a[0]))
@@ -194,9 +231,19 @@
 /* Macro to get the address plus one of the end of an array.                  */
 #define BEYOND(a) ((a) + DIM(A))
 
-#define is_blank(c) ((c==' ') || (c=='\t') || (c=='\f') || (c=='>'))
-#define isend(c)   ((c=='\0')|| (c=='\n'))
-#define isdone(c)  ((c=='/') || (isend(c)) || (c==';'))
+/* Character classes, looked up in charclass[].                               */
+#define CC_BLANK    001                 /* Blank: space, tab, FF or '>'.      */
+#define CC_END      002                 /* End of line: newline or NUL.       */
+#define CC_DONE     004                 /* End of statements: '/', ';' too.   */
+#define CC_ALPHA    010
+#define CC_DIGIT    020
+#define CC_SKIP     040                 /* Ends a skip: '<', '>', '$' or '/'. */
+
+#define charClass(c) (charclass[(unsigned char)(c)])
+#define is_blank(c)  (charClass(c) & CC_BLANK)
+#define isend(c)     (charClass(c) & CC_END)
+#define isdone(c)    (charClass(c) & CC_DONE)
+#define is_alnum(c)  (charClass(c) & ( CC_ALPHA | CC_DIGIT ))
 
 /* Macros for testing symbol attributes.  Each macro evaluates to non-zero    */
 /* (true) if the stated condtion is met.                                      */
@@ -218,17 +265,31 @@
 /* This macro is used to test symbols by the conditional assembly pseudo-ops. */
 #define M_DEF(s) (M_DEFINED(s))
 #define M_COND(s) (M_CONDITIONAL(s))
-#define M_DEFINED_CONDITIONALLY(t) ((M_DEF(t)&&pass==1)||(!M_COND(t)&&pass==2))
+#define M_DEFINED_CONDITIONALLY(t) \
+          ((M_DEF(t)&&as->pass==1)||(!M_COND(t)&&as->pass==2))
+
+/* This macro tests if an entry of the built-in permanent symbol table is in  */
+/* use.  Only the pseudo-ops survive an EXPUNGE (I and Z are then re-entered  */
+/* in the symbol table).                                                      */
+#define M_PERMANENT(s) \
+          (M_DEFINED(s) && (M_PSEUDO(s) || !as->permanent_expunged))
 
 typedef unsigned char BOOL;
 typedef unsigned char BYTE;
 typedef          int  WORD32;
+typedef unsigned long SYMKEY;
 
 #ifndef FALSE
   #define FALSE 0
   #define TRUE (!FALSE)
 #endif
 
+/* Symbol keys.  A name of up to 6 letters and digits is packed base 37 into  */
+/* a SYMKEY, most significant position first, with 0 for unused positions,    */
+/* letters as 11 to 36 and digits as 1 to 10.  Keys compare in the same order */
+/* as the names and fit in 32 bits.  The names are only rebuilt for output.   */
+#define SYMKEY_BASE          37
+
 /* Line listing styles.  Used to control listing of lines.                    */
 enum linestyle_t
 {
@@ -236,6 +297,12 @@ enum linestyle_t
 };
 typedef enum linestyle_t LINESTYLE_T;
 
+/* Kinds of listing records that are not lines, after the line styles.        */
+#define LISTREC_ERROR        4  /* An error message, under the line before.   */
+#define LISTREC_EJECT        5  /* A new page before the next line.           */
+#define LISTREC_TITLE        6  /* A new title, and a new page.               */
+#define LISTREC_FORMFEED     7  /* A form feed in the source.                 */
+
 /* Symbol Types.                                                              */  
 /* Note that the names that have FIX as the suffix contain the FIXED bit      */
 /* included in the value.                                                     */
@@ -279,17 +346,52 @@ typedef enum pseudo_t PSEUDO_T;
 struct sym_t
 {
   SYMTYP  type;
-  char    name[SYMLEN];
+  SYMKEY  key;
   WORD32  val;
-  WORD32  xref_index;
-  WORD32  xref_count;
+  WORD32  xref_index;           /* Its entry in xrefs, 0 if none.             */
+  WORD32  xref_count;           /* Number of references in the entry.         */
 };
 typedef struct sym_t SYM_T;
 
+/* The concordance entry of a symbol, filled in by pass 2.  The line numbers  */
+/* of the references are kept as the difference from the one before, 7 bits  */
+/* to a byte, with the sign in the low bit, in a list of blocks of            */
+/* xrefblocks.  Entry and block 0 stand for none.                             */
+struct xref_t
+{
+  int     def;                  /* Line it was last defined on, or 0.         */
+  int     first;                /* First and last block of the references.    */
+  int     last;
+  int     fill;                 /* Bytes used in the last block.              */
+  int     line;                 /* Line of the last reference.                */
+};
+typedef struct xref_t XREF_T;
+
+struct xrefblock_t
+{
+  int     next;                 /* Next block of the list, 0 if none.         */
+  BYTE    bytes[XREF_BLOCK_BYTES];
+};
+typedef struct xrefblock_t XREFBLOCK_T;
+
+/* A symbol as written in the pseudo-op and permanent symbol tables.          */
+struct symdef_t
+{
+  SYMTYP  type;
+  char    name[SYMLEN];
+  WORD32  val;
+};
+typedef struct symdef_t SYMDEF_T;
+
+/* A literal pool, shared by the pages, each using the part of it between     */
+/* lit_loc and lit_base.  So that a literal is found without a search, at[]   */
+/* has a bit for each location of the pool that holds each value.  A value    */
+/* can be in the pool more than once, but only once in the part of a page.    */
 struct lpool_t
 {
   WORD32  error;                /* True if error message has been printed.    */
   WORD32  pool[PAGE_SIZE];
+  unsigned int at[LIT_VALUES][LIT_WORDS];
 };
 typedef struct lpool_t LPOOL_T;
 
@@ -314,69 +416,278 @@ struct fltg_
 };
 typedef struct fltg_ FLTG_T;
 
+/* Header of a permanent symbol table snapshot (see the -s and -u options). */
+/* It is followed, at offset PERMSNAP_TABLE, by the size slots of the       */
+/* hashed table, then by the displacement of each bucket and the slot of    */
+/* each symbol in name order.  All in the native format of this build.      */
+struct permhdr_t
+{
+  char   magic[8];             /* PERMSNAP_MAGIC                             */
+  int    sym_size;             /* sizeof( SYM_T ) of the writing build.      */
+  int    buckets;              /* Number of buckets, a power of 2.           */
+  int    count;                /* Number of symbols.                         */
+  int    size;                 /* Number of slots, a power of 2.             */
+};
+typedef struct permhdr_t PERMHDR_T;
+
+#define PERMSNAP_MAGIC  "M8XPST1"
+#define PERMSNAP_TABLE  ((long) (( sizeof( PERMHDR_T ) + sizeof( SYM_T ) - 1 ) \
+                                 / sizeof( SYM_T ) * sizeof( SYM_T )))
+
+/* The operations of the code compiled from an operand field in pass 1.  The  */
+/* code is postfix; runCodedExprs() runs it on a stack of values in pass 2.   */
+enum exop_t
+{
+  EX_END,    EX_SYM,    EX_CONST,  EX_DOT,    EX_NEG,    EX_ADD,    EX_SUB,
+  EX_MUL,    EX_DIV,    EX_AND,    EX_OR,     EX_PZLIT,  EX_CPLIT,  EX_TERM
+};
+typedef enum exop_t EXOP_T;
+
+struct excode_t
+{
+  EXOP_T  op;
+  WORD32  val;                  /* Constant, or column for diagnostics.       */
+  SYM_T  *sym;                  /* Symbol of EX_SYM.                          */
+};
+typedef struct excode_t EXCODE_T;
+
+/* An operand field compiled in pass 1, with the state of the lexer after it. */
+struct coded_t
+{
+  int     from;                 /* lexstart where the field starts.           */
+  int     code;                 /* Index of its code in excode.               */
+  int     depth;                /* Stack depth needed to run the code.        */
+  int     radix;                /* Radix its numbers were read in.            */
+  int     lexeme;               /* Lexemes of the line up to its end.         */
+  int     lexstart;
+  int     lexterm;
+  int     lexstartprev;
+  int     lextermprev;
+  int     cc;
+  char    delimiter;
+};
+typedef struct coded_t CODED_T;
+
+/* A source line read in pass 1, kept for pass 2 (see replayLine()).          */
+struct srcline_t
+{
+  char   *text;                 /* The line, in the input or in the arena.    */
+  int     length;               /* Length of the line (maxcc).                */
+  int     lexeme;               /* Index of its first lexeme in lexemes.      */
+  int     lexemes;              /* Number of lexemes found in pass 1.         */
+  int     expr;                 /* Index of its first compiled field.         */
+  int     exprs;                /* Number of fields compiled in pass 1.       */
+  BOOL    formfeed;              /* Line had a form feed in it.             */
+};
+typedef struct srcline_t SRCLINE_T;
+
+/* A lexeme found by nextLexeme() in pass 1.  Scanning the same line from the */
+/* same column in pass 2 gives the same lexeme, so it need not be repeated.   */
+struct lexeme_t
+{
+  int     from;                 /* Column counter when the scan started.      */
+  int     start;                /* lexstart                                   */
+  int     term;                 /* lexterm                                    */
+};
+typedef struct lexeme_t LEXEME_T;
+
+/* The body of a false conditional skipped in pass 1, by where it started and */
+/* ended.  Pass 2 goes straight to the end of the same skip.                  */
+struct skip_t
+{
+  int     line;                 /* Line in the source cache.                  */
+  int     col;                  /* Column after the '<'.                      */
+  int     end_line;
+  int     end_col;              /* Column after the closing '>' or '$'.       */
+};
+typedef struct skip_t SKIP_T;
+
+/* A line of the listing as the assembly found it, or a page event, recorded  */
+/* in order and made into text by renderListing() at the end of pass 2.       */
+struct listrec_t
+{
+  char   *text;                 /* The source line, or the error message.     */
+  int     num;                  /* Line number, error column or title index.  */
+  WORD32  loc;
+  WORD32  val;
+  BYTE    style;                /* A LINESTYLE_T or a LISTREC_ kind.          */
+  BYTE    indirect;             /* TRUE to list '@' after the value.          */
+  BYTE    listed;               /* TRUE if the line was listed before.        */
+};
+typedef struct listrec_t LISTREC_T;
+
+/* An input file, mapped into memory once for both passes.                    */
+struct srcfile_t
+{
+  char   *text;
+  long    size;
+  BOOL    mapped;               /* TRUE if text is mapped, not allocated.     */
+};
+typedef struct srcfile_t SRCFILE_T;
+
+/* The assembler context, defined after the permanent symbol table below.     */
+typedef struct asm_t ASM_T;
+
+/* A report of the symbols, defined after the assembler context.              */
+typedef struct report_t REPORT_T;
+
+/* A source of a batch assembled with -j.                                     */
+struct batchjob_t
+{
+  char   *path;
+  char   *args[2];              /* The argv of its assembly.                  */
+  long    size;                 /* Its size, to start the big ones first.     */
+  char   *failure;              /* Why it was not assembled, or NULL.         */
+  int     errors;
+};
+typedef struct batchjob_t BATCHJOB_T;
+
+/* A batch of sources assembled by a pool of threads (see assembleBatch()).   */
+struct batch_t
+{
+  ASM_T  *options;              /* The context the options were parsed into.  */
+  BATCHJOB_T **queue;           /* The sources, biggest first.                */
+  int     count;
+  int     next;                 /* Next source in queue to assemble.          */
+  pthread_mutex_t lock;         /* Held to take a source from the queue.      */
+};
+typedef struct batch_t BATCH_T;
+
 /*----------------------------------------------------------------------------*/
 
 /* Function Prototypes                                                        */
 
-int     binarySearch( char *name, int start, int symbol_count );
-int     copyMacLine( int length, int from, int term, int nargs );
+LISTREC_T *addListRecord( ASM_T *as, int style, char *text, int num );
+void    addSource( ASM_T *as, char *path );
+void    addXref( ASM_T *as, SYM_T *sym, int line );
+char   *arenaAlloc( ASM_T *as, int size );
+int     assemble( ASM_T *as );
+int     assembleBatch( ASM_T *as );
+void   *batchWorker( void *arg );
+void    cacheLine( ASM_T *as, BOOL flag );
+void    clearSymbolHash( ASM_T *as );
+void    codeExpr( ASM_T *as, EXOP_T op, WORD32 val, SYM_T *sym );
+int     copyMacLine( ASM_T *as, int length, int from, int term, int nargs );
+int     compareJobs( const void *a, const void *b );
 int     compareSymbols( const void *a, const void *b );
-void    conditionFalse( void );
-void    conditionTrue( void );
-SYM_T  *defineLexeme( WORD32 start, WORD32 term, WORD32 val, SYMTYP type );
-SYM_T  *defineSymbol( char *name, WORD32 val, SYMTYP type, WORD32 start);
-void    endOfBinary( void );
-void    errorLexeme( EMSG_T *mesg, WORD32 col );
-void    errorMessage( EMSG_T *mesg, WORD32 col );
-void    errorSymbol( EMSG_T *mesg, char *name, WORD32 col );
-SYM_T  *eval( void );
-WORD32  evalDubl( WORD32 initial_value );
-FLTG_T *evalFltg( void );
-SYM_T  *evalSymbol( void );
-void    getArgs( int argc, char *argv[] );
-WORD32  getDublExpr( void );
-WORD32  getDublExprs( void );
-FLTG_T *getFltgExpr( void );
-FLTG_T *getFltgExprs( void );
-SYM_T  *getExpr( void );
-WORD32  getExprs( void );
-WORD32  incrementClc( void );
-void    inputDubl( void );
-void    inputFltg( void );
-WORD32  insertLiteral( LPOOL_T *pool, WORD32 pool_page, WORD32 value );
-char   *lexemeToName( char *name, WORD32 from, WORD32 term );
-void    listLine( void );
-SYM_T  *lookup( char *name );
-void    moveToEndOfLine( void );
-void    nextLexBlank( void );
-void    nextLexeme( void );
+void    conditionFalse( ASM_T *as );
+void    conditionTrue( ASM_T *as );
+void    copyLine( char *to, char *from, int size );
+void    expandTabs( char *to, char *from, int size );
+WORD32  findLiteral( ASM_T *as, LPOOL_T *p, WORD32 pageno, WORD32 value );
+SKIP_T *findSkip( ASM_T *as );
+SYM_T  *defineLexeme( ASM_T *as, WORD32 start, WORD32 term, WORD32 val,
+                      SYMTYP type );
+SYM_T  *defineSymbol( ASM_T *as, SYMKEY key, WORD32 val, SYMTYP type,
+                      WORD32 start );
+void    endOfBinary( ASM_T *as );
+void    errorLexeme( ASM_T *as, EMSG_T *mesg, WORD32 col );
+void    errorMessage( ASM_T *as, EMSG_T *mesg, WORD32 col );
+void    errorSymbol( ASM_T *as, EMSG_T *mesg, char *name, WORD32 col );
+SYM_T  *eval( ASM_T *as );
+WORD32  evalDubl( ASM_T *as, WORD32 initial_value );
+FLTG_T *evalFltg( ASM_T *as );
+SYM_T  *evalSymbol( ASM_T *as );
+CODED_T *findCodedExprs( ASM_T *as );
+void    flushList( ASM_T *as );
+void    flushTape( ASM_T *as );
+void    freeAssembler( ASM_T *as );
+BOOL    takeLine( ASM_T *as, char *text, int length );
+void    getArgs( ASM_T *as, int argc, char *argv[] );
+WORD32  getDublExpr( ASM_T *as );
+WORD32  getDublExprs( ASM_T *as );
+FLTG_T *getFltgExpr( ASM_T *as );
+FLTG_T *getFltgExprs( ASM_T *as );
+SYM_T  *getExpr( ASM_T *as );
+WORD32  getExprs( ASM_T *as );
+WORD32  getCodedExprs( ASM_T *as );
+void    growSymbolHash( ASM_T *as );
+void    growSymbolTable( ASM_T *as );
+void   *growTable( void *table, int *room, int size, int need );
+BOOL    hashPermanentSymbols( ASM_T *as, SYM_T **syms, int count );
+unsigned long hashSymbol( SYMKEY key, unsigned long seed );
+WORD32  incrementClc( ASM_T *as );
+void    inputDubl( ASM_T *as );
+void    inputFltg( ASM_T *as );
+WORD32  insertLiteral( ASM_T *as, LPOOL_T *pool, WORD32 pool_page,
+                       WORD32 value );
+char   *keyToName( char *name, SYMKEY key );
+char   *lexemeToName( ASM_T *as, char *name, WORD32 from, WORD32 term );
+SYMKEY  lexemeToKey( ASM_T *as, WORD32 from, WORD32 term );
+void    listChars( ASM_T *as, char *text, int length );
+void    listDecimal( ASM_T *as, int value, int width );
+void    listField( ASM_T *as, char *text, int width );
+void    listFormat( ASM_T *as, char *format, ... );
+void    listLine( ASM_T *as );
+void    listNewPage( ASM_T *as, int style );
+void    listOctal( ASM_T *as, unsigned int value, int digits );
+void    listSpaces( ASM_T *as, int count );
+void    listTitle( ASM_T *as, int count );
+char   *mapSource( char *path, long *size, BOOL *mapped );
+int     mapSources( ASM_T *as );
+void    loadPermanentSnapshot( ASM_T *as, char *path );
+void    loadWord( ASM_T *as, WORD32 loc, WORD32 val );
+SYM_T  *lookup( ASM_T *as, SYMKEY key );
+void    moveToEndOfLine( ASM_T *as );
+int     expandedColumn( ASM_T *as, int col );
+int     tabWidth( ASM_T *as, int col, int column );
+void    skipSpaces( ASM_T *as );
+SYMKEY  nameToKey( char *name );
+void    xrefSymbol( ASM_T *as, SYM_T *sym );
+XREF_T *xrefEntry( ASM_T *as, SYM_T *sym );
+ASM_T  *newAssembler( void );
+void    newImage( ASM_T *as );
+char   *openSource( ASM_T *as, char *path );
+void    nextLexBlank( ASM_T *as );
+void    nextLexeme( ASM_T *as );
+int     nextXref( ASM_T *as, int *block, int *pos );
 void    normalizeFltg( FLTG_T *fltg );
-void    onePass( void );
-void    printCrossReference( void );
-void    printErrorMessages( void );
-void    printLine(char *line, WORD32 loc, WORD32 val, LINESTYLE_T linestyle);
-void    printPageBreak( void );
-void    printPermanentSymbolTable( void );
-void    printSymbolTable( void );
-BOOL    pseudoOperators( PSEUDO_T val );
-void    punchChecksum( void );
-void    punchLocObject( WORD32 loc, WORD32 val );
-void    punchLiteralPool( LPOOL_T *p, WORD32 lpool_page );
-void    punchOutObject( WORD32 loc, WORD32 val );
-void    punchLeader( WORD32 count );
-void    punchObject( WORD32 val );
-void    punchOrigin( WORD32 loc );
-void    readLine( void );
-void    saveError( char *mesg, WORD32 cc );
-BOOL    testForLiteralCollision( WORD32 loc );
-BOOL    testZeroPool( WORD32 value );
-void    topOfForm( char *title, char *sub_title );
+void    onePass( ASM_T *as );
+WORD32  orOperand( ASM_T *as, WORD32 value, SYMTYP value_type, SYM_T *symt,
+                   int col );
+void    printCrossReference( ASM_T *as );
+void    finishReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ));
+void    printErrorMessages( ASM_T *as );
+void    printLine( ASM_T *as, char *line, WORD32 loc, WORD32 val,
+                   LINESTYLE_T linestyle );
+void    printPageBreak( ASM_T *as );
+void    printPermanentSymbolTable( ASM_T *as );
+void    printReports( ASM_T *as, BOOL listing );
+void    printSymbolTable( ASM_T *as );
+BOOL    pseudoOperators( ASM_T *as, PSEUDO_T val );
+void    punchChecksum( ASM_T *as );
+void    punchImage( ASM_T *as );
+void    punchLocObject( ASM_T *as, WORD32 loc, WORD32 val );
+void    punchLiteralPool( ASM_T *as, LPOOL_T *p, WORD32 lpool_page );
+void    punchOutObject( ASM_T *as, WORD32 loc, WORD32 val );
+void    punchLeader( ASM_T *as, WORD32 count );
+void    punchObject( ASM_T *as, WORD32 val );
+void    punchOrigin( ASM_T *as, WORD32 loc );
+void    punchZeroBlock( ASM_T *as, WORD32 count );
+void    putLine( ASM_T *as, char *text );
+void    readLine( ASM_T *as );
+BOOL    readManifest( ASM_T *as, char *path );
+void    renderListing( ASM_T *as );
+void   *reportWorker( void *arg );
+BOOL    replayLine( ASM_T *as );
+WORD32  runCodedExprs( ASM_T *as, CODED_T *ex );
+SYM_T **sortSymbolTable( ASM_T *as, int *fixed_count );
+SYM_T  *symbolAt( ASM_T *as, int ix );
+void    startReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ),
+                     int pages );
+int     symbolTablePages( ASM_T *as );
+void    shareOptions( ASM_T *to, ASM_T *from );
+void    saveError( ASM_T *as, char *mesg, WORD32 cc );
+BOOL    testForLiteralCollision( ASM_T *as, WORD32 loc );
+BOOL    testZeroPool( ASM_T *as, WORD32 value );
+void    topOfForm( ASM_T *as, char *title, char *sub_title );
+void    writePermanentSnapshot( ASM_T *as );
 
 /*----------------------------------------------------------------------------*/
 
-/* Table of pseudo-ops (directives) which are used to setup the symbol        */
-/* table on startup and when the EXPUNGE pseudo-op is executed.               */
-SYM_T pseudo[] =
+/* Table of pseudo-ops (directives).  They are built into the permanent       */
+/* symbol table and remain there when the EXPUNGE pseudo-op is executed.      */
+SYMDEF_T pseudo[] =
 {
   { PSEUDO, "BANK",   BANK    },    /* Synonym for field in MACRO8X.          */
   { PSEUDO, "BINPUN", BINPUNCH },   /* Output in Binary Loader format.        */
@@ -412,9 +723,9 @@ SYM_T pseudo[] =
 };
 
 /* Symbol Table                                                               */
-/* The table is put in lexical order on startup, so symbols can be            */
+/* The table is hashed at build time (see permtab below), so symbols can be   */
 /* inserted as desired into the initial table.                                */
-SYM_T permanent_symbols[] =
+SYMDEF_T permanent_symbols[] =
 {
   /* Memory Reference Instructions                                            */
   { MRIFIX, "I",      00400   },    /* INDIRECT ADDRESSING                    */
@@ -572,25 +883,217 @@ SYM_T permanent_symbols[] =
   { FIXED,  "SPO",    06107   },    /* Skip on parity option.                 */
 };      /* End-of-Symbols for Permanent Symbol Table                          */
 
-/* Global variables                                                           */
-SYM_T *symtab;                  /* Symbol Table                               */
-int    symbol_top;              /* Number of entries in symbol table.         */
-
-SYM_T *fixed_symbols;           /* Start of the fixed symbol table entries.   */
-int    number_of_fixed_symbols;
-
-/*----------------------------------------------------------------------------*/
-
-WORD32 *xreftab;                /* Start of the concordance table.            */
+/* Perfect hash table of the pseudo-ops and permanent symbols above.  It is   */
+/* generated at build time by mkpermtab (see the Makefile), so no symbol      */
+/* table work is done on startup.  mkpermtab compiles this file with          */
+/* MKPERMTAB defined, which leaves the table empty.                           */
+#ifdef MKPERMTAB
+#define PERMTAB_BUCKETS  1
+#define PERMTAB_COUNT    0
+#define PERMTAB_SIZE     1
+int     permtab_builtin_disp[PERMTAB_BUCKETS];
+int     permtab_builtin_order[1];
+SYM_T   permtab_builtin[PERMTAB_SIZE];
+#else
+#include "macro8x-permtab.h"
+#endif
 
-ERRSAVE_T error_list[20];
-int     save_error_count;
+/* The state of one assembly.  Everything that changes while a source is     */
+/* assembled lives here, so one process can run any number of assemblies.    */
+/* Every function that needs it is passed the context as its first argument. */
+struct asm_t
+{
+  /* The permanent symbol table in use, the built-in one unless a snapshot    */
+  /* was loaded with -u.  permtab_order holds the slot of each symbol by      */
+  /* name.  The table itself is private, as it counts references to symbols. */
+  SYM_T  *permtab;
+  int    *permtab_disp;
+  int    *permtab_order;
+  int     permtab_buckets;
+  int     permtab_count;
+  int     permtab_size;
+  SYM_T  *permtab_copy;         /* The copy of permtab_builtin, if made.      */
+  BOOL    permtab_hashed;       /* TRUE if hashPermanentSymbols() made it.    */
+  char   *snapbase;             /* The snapshot mapped from -u, or NULL.      */
+  long    snapsize;
+
+  SYM_T *symchunk[SYMBOL_CHUNKS]; /* Symbol Table, in chunks that never move. */
+  int    symbol_chunks;         /* Number of chunks allocated.                */
+  int    symbol_room;           /* Number of entries in all chunks.           */
+  int    symbol_top;            /* Number of entries in symbol table.         */
+
+  int    number_of_fixed_symbols;
+
+  SYM_T **symhash;              /* Hash index into symtab, NULL if empty.     */
+  int    symhash_size;          /* Entries in symhash, a power of 2.          */
+  BOOL   permanent_expunged;    /* Set when EXPUNGE removed permtab symbols.  */
+
+  XREF_T *xrefs;                /* The concordance, by symbol.                */
+  int     xref_used;
+  int     xref_room;
+  XREFBLOCK_T *xrefblocks;      /* The references of all the symbols.         */
+  int     xrefblock_used;
+  int     xrefblock_room;
+
+  ERRSAVE_T error_list[20];
+  int     save_error_count;
+
+  LPOOL_T pz;                   /* Storage for page zero constants.           */
+  LPOOL_T cp;                   /* Storage for current page constants.        */
+  WORD32  lit_base[TOTAL_PAGES]; /* Literal base address for all pages.      */
+  WORD32  lit_loc[TOTAL_PAGES]; /* Literal current location for all pages.    */
+
+  FILE   *errorfile;
+  FILE   *listfile;
+  FILE   *listsave;
+  FILE   *objectfile;
+  FILE   *objectsave;
+  BYTE    tape[TAPE_BUFFER];    /* Object not yet written to objectsave.      */
+  int     tape_count;
+  char   *listout;              /* Listing not yet written to its file.       */
+  int     listout_count;
+  LISTREC_T *listrecs;          /* Listing not yet made into text.            */
+  int     listrec_count;
+  int     listrec_room;
+  char   *listtitles;           /* Titles of the LISTREC_TITLE records.       */
+  int     listtitle_count;
+  int     listtitle_room;
+  int     listrec_page_lineno;  /* The page and title state at the first      */
+  char    listrec_title[TITLELEN + 2];  /* record, where rendering starts.    */
+  BOOL    listrec_title_set;
+
+  char    errorpathname[NAMELEN];
+  char    filename[NAMELEN];
+  char    listpathname[NAMELEN];
+  char    objectpathname[NAMELEN];
+  char   *pathname;
+  char    permpathname[NAMELEN];
+  char    snappathname[NAMELEN];
+  char   *snapshotpath;         /* Snapshot to load, from -u.                 */
+  char   *progname;             /* Name the assembler was run by.             */
+  char  **sources;              /* The input files of a batch, from -j.       */
+  int     source_count;
+  int     source_room;
+  int     threads;              /* Threads to assemble them on, from -j.      */
+  BOOL    batch;                /* TRUE in an assembly of a batch from -j.    */
+
+  char    mac_buffer[MAC_MAX_LENGTH + 1];
+  char   *mac_bodies[MAC_TABLE_LENGTH];
+  char    mac_arg_name[MAC_MAX_ARGS][SYMLEN];
+  int     mac_arg_pos[26];
+
+  int     list_lineno;
+  int     list_pageno;
+  char    list_title[TITLELEN + 2];
+  BOOL    list_title_set;       /* Set if TITLE pseudo-op used.               */
+  char   *line;                 /* Input line, ended by a newline or NUL.     */
+  int     lineno;               /* Current line number.                       */
+  char   *linebuf;              /* Line of a macro expansion.                 */
+  int     linebuf_room;
+  char   *mac_line;             /* Saved macro invocation line.               */
+  int     mac_line_room;
+  char   *line_kept;            /* Copy of the line kept for the listing.     */
+  int     page_lineno;          /* print line number on current page.         */
+  WORD32  listed;               /* Listed flag.                               */
+  WORD32  listedsave;
+
+  /* Source cache filled in pass 1 and replayed in pass 2.                    */
+  SRCFILE_T *srcfiles;          /* The input files, indexed like argv.        */
+  long       srcpos;            /* Offset of the next line in filix_curr.     */
+  char      *arena;             /* Free space for rewritten lines.            */
+  int        arena_left;
+  char     **arena_blocks;      /* The blocks of the arena, to be freed.      */
+  int        arena_block_count;
+  int        arena_block_room;
+  SRCLINE_T *srclines;          /* The lines read in pass 1.                  */
+  int        srcline_count;
+  int        srcline_room;
+  int        srcline_next;      /* Next line to replay in pass 2.             */
+  LEXEME_T  *lexemes;           /* The lexemes of all the lines, in order.    */
+  int        lexeme_count;
+  int        lexeme_room;
+  int        lexeme_next;       /* Next lexeme to replay in pass 2.           */
+  int        lexeme_line;       /* Cached line in line, -1 if none.           */
+  SKIP_T    *skips;             /* The conditionals skipped in pass 1.        */
+  int        skip_count;
+  int        skip_room;
+  CODED_T   *coded;             /* The operand fields compiled in pass 1.     */
+  int        coded_count;
+  int        coded_room;
+  int        coded_next;        /* Next compiled field to look at in pass 2.  */
+  int        coded_valid;       /* First field compiled after an EXPUNGE.     */
+  EXCODE_T  *excode;            /* The code of all the compiled fields.       */
+  int        excode_count;
+  int        excode_room;
+  SYM_T     *exstack;           /* Stack the code is run on.                  */
+  int        exstack_room;
+  BOOL       coding;            /* TRUE while a field is being compiled.      */
+  int        coding_depth;      /* Stack depth of the code so far.            */
+  int        coding_max;        /* Greatest stack depth of the code so far.   */
+
+  /* Memory image the compact bin tape of -c is punched from.                 */
+  WORD32    *image;             /* The words punched, by address.             */
+  BYTE      *loaded;            /* TRUE for each word of image punched.       */
+  long       tape_length;       /* Characters punched, or that would be.      */
+
+  WORD32  cc;                   /* Column Counter (char position in line).    */
+  WORD32  checksum;             /* Generated checksum                         */
+  BOOL    binary_data_output;   /* Set true when data has been output.        */
+  BOOL    compact;              /* Punch the image at the end, from -c.       */
+  WORD32  clc;                  /* Location counter                           */
+  char    delimiter;            /* Character immediately after eval'd term.   */
+  int     errors;               /* Number of errors found so far.             */
+  BOOL    error_in_line;        /* TRUE if error on current line.             */
+  int     errors_pass_1;        /* Number of errors on pass 1.                */
+  WORD32  field;                /* Current field                              */
+  WORD32  fieldlc;              /* location counter without field portion.    */
+  int     filix_curr;           /* Index in argv to current input file.       */
+  int     filix_start;          /* Start of input files in argv.              */
+  BOOL    fltg_input;           /* TRUE when doing floating point input.      */
+  BOOL    indirect_generated;   /* TRUE if an off page address generated.     */
+  WORD32  lexstartprev;         /* Where previous lexeme started.             */
+  WORD32  lextermprev;          /* Where previous lexeme ended.               */
+  WORD32  lexstart;             /* Index of current lexeme on line.           */
+  WORD32  lexterm;              /* Index of character after current lexeme.   */
+  WORD32  mac_cc;               /* Saved cc after macro invocation.           */
+  WORD32  mac_count;            /* Total macros defined.                      */
+  BOOL    nomac_exp;            /* Print macro expansions.                    */
+  char   *mac_ptr;              /* Pointer to macro body, NULL if no macro.   */
+  WORD32  maxcc;                /* Current line length.                       */
+  BOOL    lgm_flag;             /* Link generated messages enable flag.       */
+  BOOL    list_errors_only;     /* Keep the listing only on errors, from -e.  */
+  BOOL    overflow;             /* Overflow flag for math routines.           */
+  WORD32  pass;                 /* Number of current pass.                    */
+  BOOL    print_permanent_symbols;
+  WORD32  radix;                /* Default number radix.                      */
+  WORD32  reloc;                /* The relocation distance.                   */
+  BOOL    rim_mode;             /* Generate rim format, defaults to bin       */
+  int     save_argc;            /* Saved argc.                                */
+  char   **save_argv;           /* Saved *argv[].                             */
+  BOOL    symtab_print;         /* Print symbol table flag                    */
+  BOOL    write_permanent_snapshot;
+  BOOL    xref;
+  BOOL    zblock_words;         /* List each word of a ZBLOCK, from -z.       */
+
+  FLTG_T  fltg_ac;              /* Value holder for evalFltg()                */
+  SYM_T   sym_eval;             /* Value holder for eval()                    */
+  SYM_T   sym_getexpr;          /* Value holder for getexpr()                 */
+  SYM_T   sym_undefined;        /* Symbol Table Terminator                    */
+};
 
-LPOOL_T pz;                     /* Storage for page zero constants.           */
-LPOOL_T cp;                     /* Storage for current page constants.        */
-WORD32  lit_base[TOTAL_PAGES];  /* Literal base address for all pages.        */
-WORD32  lit_loc[TOTAL_PAGES];   /* Literal current location for all pages.    */
+/* A report made on a thread of its own in a copy of the context.  What it    */
+/* lists is kept in memory until finishReport() adds it to the listing.       */
+struct report_t
+{
+  ASM_T     as;                 /* The copy it is made in.                    */
+  char     *text;               /* Its listing, from open_memstream().        */
+  size_t    length;
+  pthread_t thread;
+  BOOL      threaded;           /* Set if it is being made on the thread.     */
+  void    (*print)( ASM_T *as );
+};
 
+/* Global variables                                                           */
 char   s_detected[] = "detected";
 char   s_error[]    = "error";
 char   s_errors[]   = "errors";
@@ -599,6 +1102,43 @@ char   s_page[]     = "Page";
 char   s_symtable[] = "Symbol Table";
 char   s_xref[]     = "Cross Reference";
 
+/* Character classes for the lexer, indexed by the (unsigned) character.      */
+#define B  CC_BLANK
+#define D  CC_DONE
+#define E  ( CC_END | CC_DONE )
+#define A  CC_ALPHA
+#define N  CC_DIGIT
+#define S  CC_SKIP
+#define G  ( CC_BLANK | CC_SKIP )
+#define C  ( CC_DONE | CC_SKIP )
+unsigned char charclass[256] =
+{
+  E, 0, 0, 0, 0, 0, 0, 0, 0, B, E, 0, B, 0, 0, 0,   /* 000 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 020 */
+  B, 0, 0, 0, S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, C,   /* 040 */
+  N, N, N, N, N, N, N, N, N, N, 0, D, S, 0, G, 0,   /* 060 */
+  0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,   /* 100 */
+  A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,   /* 120 */
+  0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,   /* 140 */
+  A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,   /* 160 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 200 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 220 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 240 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 260 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 300 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 320 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 340 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0    /* 360 */
+};
+#undef  B
+#undef  D
+#undef  E
+#undef  A
+#undef  N
+#undef  S
+#undef  G
+#undef  C
+
 /* Assembler diagnostic messages.                                             */
 /* Some attempt has been made to keep continuity with the PAL-III and         */
 /* MACRO-8 diagnostic messages.  If a diagnostic indicator, (e.g., IC)        */
@@ -653,7 +1193,6 @@ EMSG_T  text_string         = { "no delimiter",
 EMSG_T  in_rim_mode         = { "not OK in rim mode"
                                     "FIELD pseudo-op not valid in RIM mode" };
 EMSG_T  lt_expected         = { "'<' expected",  "'<' expected" };
-EMSG_T  symbol_table_full   = { "ST Symbol Tbl full", "Symbol table full" };
 EMSG_T  no_macro_name       = { "no macro name", "No name following DEFINE" };
 EMSG_T  bad_dummy_arg       = { "bad dummy arg",
                                     "Bad dummy argument following DEFINE" };
@@ -662,77 +1201,6 @@ EMSG_T  no_virtual_memory   = { "out of memory",
                                     "Insufficient memory for macro" };
 EMSG_T  macro_table_full    = { "Macro Table full", "Macro table full" };
 
-/*----------------------------------------------------------------------------*/
-
-FILE   *errorfile;
-FILE   *infile;
-FILE   *listfile;
-FILE   *listsave;
-FILE   *objectfile;
-FILE   *objectsave;
-
-char    errorpathname[NAMELEN];
-char    filename[NAMELEN];
-char    listpathname[NAMELEN];
-char    objectpathname[NAMELEN];
-char   *pathname;
-char    permpathname[NAMELEN];
-
-char    mac_buffer[MAC_MAX_LENGTH + 1];
-char   *mac_bodies[MAC_TABLE_LENGTH];
-char    mac_arg_name[MAC_MAX_ARGS][SYMLEN];
-int     mac_arg_pos[26] = { 0 };
-
-int     list_lineno;
-int     list_pageno;
-char    list_title[LINELEN];
-BOOL    list_title_set;         /* Set if TITLE pseudo-op used.               */
-char    line[LINELEN];          /* Input line.                                */
-int     lineno;                 /* Current line number.                       */
-char    mac_line[LINELEN];      /* Saved macro invocation line.               */
-int     page_lineno;            /* print line number on current page.         */
-WORD32  listed;                 /* Listed flag.                               */
-WORD32  listedsave;
-
-WORD32  cc;                     /* Column Counter (char position in line).    */
-WORD32  checksum;               /* Generated checksum                         */
-BOOL    binary_data_output;     /* Set true when data has been output.        */
-WORD32  clc;                    /* Location counter                           */
-char    delimiter;              /* Character immediately after eval'd term.   */
-int     errors;                 /* Number of errors found so far.             */
-BOOL    error_in_line;          /* TRUE if error on current line.             */
-int     errors_pass_1;          /* Number of errors on pass 1.                */
-WORD32  field;                  /* Current field                              */
-WORD32  fieldlc;                /* location counter without field portion.    */
-int     filix_curr;             /* Index in argv to current input file.       */
-int     filix_start;            /* Start of input files in argv.              */
-BOOL    fltg_input;             /* TRUE when doing floating point input.      */
-BOOL    indirect_generated;     /* TRUE if an off page address generated.     */
-WORD32  lexstartprev;           /* Where previous lexeme started.             */
-WORD32  lextermprev;            /* Where previous lexeme ended.               */
-WORD32  lexstart;               /* Index of current lexeme on line.           */
-WORD32  lexterm;                /* Index of character after current lexeme.   */
-WORD32  mac_cc;                 /* Saved cc after macro invocation.           */
-WORD32  mac_count;              /* Total macros defined.                      */
-BOOL    nomac_exp;              /* Print macro expansions.                    */
-char   *mac_ptr;                /* Pointer to macro body, NULL if no macro.   */
-WORD32  maxcc;                  /* Current line length.                       */
-BOOL    lgm_flag;               /* Link generated messages enable flag.       */
-BOOL    overflow;               /* Overflow flag for math routines.           */
-WORD32  pass;                   /* Number of current pass.                    */
-BOOL    print_permanent_symbols;
-WORD32  radix;                  /* Default number radix.                      */
-WORD32  reloc;                  /* The relocation distance.                   */
-BOOL    rim_mode;               /* Generate rim format, defaults to bin       */
-int     save_argc;              /* Saved argc.                                */
-char   **save_argv;             /* Saved *argv[].                             */
-BOOL    symtab_print;           /* Print symbol table flag                    */
-BOOL    xref;
-
-FLTG_T  fltg_ac;                /* Value holder for evalFltg()                */
-SYM_T   sym_eval = { DEFINED, "", 0 };       /* Value holder for eval()       */
-SYM_T   sym_getexpr = { DEFINED, "", 0 };    /* Value holder for getexpr()    */
-SYM_T   sym_undefined = { UNDEFINED, "", 0 };/* Symbol Table Terminator       */
 
 
 /******************************************************************************/
@@ -744,160 +1212,536 @@ SYM_T   sym_undefined = { UNDEFINED, "", 0 };/* Symbol Table Terminator       */
 /******************************************************************************/
 int main( int argc, char *argv[] )
 {
-  int     ix;
-  int     space;
-
-  save_argc = argc;
-  save_argv = argv;
-
-  /* Set the default values for global symbols.                               */
-  binary_data_output = FALSE;
-  fltg_input = FALSE;
-  nomac_exp = TRUE;
-  print_permanent_symbols = FALSE;
-  rim_mode = FALSE;
-  symtab_print = FALSE;
-  xref = FALSE;
-  pathname = NULL;
-  for( ix = 0; ix < MAC_TABLE_LENGTH; ix++ )
-  {
-    mac_bodies[ix] = NULL;
-  }
+  ASM_T  *as;
+  int     status;
+
+  as = newAssembler();
+  as->save_argc = argc;
+  as->save_argv = argv;
 
   /* Get the options and pathnames                                            */
-  getArgs( argc, argv );
+  getArgs( as, argc, argv );
+
+  status = ( as->threads > 0 ) ? assembleBatch( as ) : assemble( as );
+  freeAssembler( as );
+  return( status );
+} /* main()                                                                   */
+
 
-  /* Setup the error file in case symbol table overflows while installing the */
-  /* permanent symbols.                                                       */
-  errorfile = fopen( errorpathname, "w" );
-  errors = 0;
-  save_error_count = 0;
-  pass = 0;             /* This is required for symbol table initialization.  */
-  symtab = (SYM_T *) malloc( sizeof( SYM_T ) * SYMBOL_TABLE_SIZE );
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  assemble                                                       */
+/*                                                                            */
+/*  Synopsis:  Assemble the sources named by the context and write its        */
+/*             output.  Returns non-zero if there were errors.                */
+/*                                                                            */
+/******************************************************************************/
+int assemble( ASM_T *as )
+{
+  int     ix;
+  BOOL    listing;
+  SYM_T  *sym;
 
-  if( symtab == NULL )
+  /* A compact tape is punched in bin format from the memory image.           */
+  as->compact = as->compact && !as->rim_mode;
+  if( as->compact && as->loaded == NULL )
   {
-    fprintf( stderr, "Could not allocate memory for symbol table.\n");
-    exit( -1 );
+    newImage( as );
   }
 
-  /* Place end marker in symbol table.                                        */
-  symtab[0] = sym_undefined;
-  symbol_top = 0;
-  number_of_fixed_symbols = symbol_top;
-  fixed_symbols = &symtab[symbol_top - 1];
+  if( as->snapshotpath != NULL )
+  {
+    loadPermanentSnapshot( as, as->snapshotpath );
+  }
 
-  /* Enter the pseudo-ops into the symbol table                               */
-  for( ix = 0; ix < DIM( pseudo ); ix++ )
+  /* The permanent symbols are shared, and only read, except that the         */
+  /* concordance counts the references to them in their entries.              */
+  if( as->xref )
   {
-    defineSymbol( pseudo[ix].name, pseudo[ix].val, pseudo[ix].type, 0 );
+    as->permtab_copy = (SYM_T *) malloc( sizeof( SYM_T ) * as->permtab_size );
+    if( as->permtab_copy == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for symbol table.\n");
+      exit( -1 );
+    }
+    memcpy( as->permtab_copy, as->permtab,
+            sizeof( SYM_T ) * as->permtab_size );
+    as->permtab = as->permtab_copy;
   }
 
-  /* Enter the predefined symbols into the table.                             */
-  /* Also make them part of the permanent symbol table.                       */
-  for( ix = 0; ix < DIM( permanent_symbols ); ix++ )
+  /* Map all the input files, which both passes read, unless already mapped.  */
+  if( as->srcfiles == NULL && ( ix = mapSources( as )) != 0 )
   {
-    defineSymbol( permanent_symbols[ix].name,
-                  permanent_symbols[ix].val,
-                  permanent_symbols[ix].type | DEFFIX , 0 );
+    fprintf( stderr, "%s: cannot open \"%s\"\n", as->save_argv[0],
+                                                 as->save_argv[ix] );
+    exit( -1 );
   }
 
-  number_of_fixed_symbols = symbol_top;
-  fixed_symbols = &symtab[symbol_top - 1];
+  as->errorfile = fopen( as->errorpathname, "w" );
+  as->errors = 0;
+  as->save_error_count = 0;
+  as->pass = 0;
+
+  /* The symbol table and its hash index grow as symbols are entered.         */
+  as->symbol_top = 0;
+  clearSymbolHash( as );
+  as->number_of_fixed_symbols = as->symbol_top;
 
   /* Do pass one of the assembly                                              */
-  checksum = 0;
-  pass = 1;
-  onePass();
-  errors_pass_1 = errors;
+  as->checksum = 0;
+  as->pass = 1;
+  onePass( as );
+  as->errors_pass_1 = as->errors;
 
   /* Set up for pass two                                                      */
-  errorfile = fopen( errorpathname, "w" );
-  objectfile = fopen( objectpathname, "wb" );
-  objectsave = objectfile;
-
-  listfile = fopen( listpathname, "w" );
-  listsave = listfile;
+  fclose( as->errorfile );
+  as->errorfile = fopen( as->errorpathname, "w" );
+  as->objectfile = fopen( as->objectpathname, "wb" );
+  as->objectsave = as->objectfile;
+
+  as->listfile = fopen( as->listpathname, "w" );
+  as->listsave = as->listfile;
+  if( as->listout == NULL )
+  {
+    as->listout = (char *) malloc( LIST_BUFFER );
+    if( as->listout == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for listing.\n");
+      exit( -1 );
+    }
+  }
+  as->listout_count = 0;
 
-  punchLeader( 0 );
-  checksum = 0;
+  as->tape_length = 0;
+  punchLeader( as, 0 );
+  as->checksum = 0;
 
   /* Do pass two of the assembly                                              */
-  errors = 0;
-  save_error_count = 0;
+  as->errors = 0;
+  as->save_error_count = 0;
 
-  if( xref )
+  if( as->xref )
   {
-    /* Get the amount of space that will be required for the concordance.     */
-    for( space = 0, ix = 0; ix < symbol_top; ix++ )
+    /* The concordance is filled in by pass 2 alone, as it goes.  Entries     */
+    /* a snapshot may have brought along are not ours.                        */
+    for( ix = 0; ix < as->permtab_size; ix++ )
     {
-      symtab[ix].xref_index = space;    /* Index into concordance table.      */
-      space += symtab[ix].xref_count + 1;
-      symtab[ix].xref_count = 0;        /* Clear the count for pass 2.        */
-
+      as->permtab[ix].xref_index = 0;
+      as->permtab[ix].xref_count = 0;
     }
-    /* Allocate the necessary space.                                          */
-    xreftab = (WORD32 *) malloc( sizeof( WORD32 ) * space );
-
-    /* Clear the cross reference space.                                       */
-    for( ix = 0; ix < space; ix++ )
+    for( ix = 0; ix < as->symbol_top; ix++ )
     {
-      xreftab[ix] = 0;
+      sym = symbolAt( as, ix );
+      sym->xref_index = 0;
+      sym->xref_count = 0;
     }
   }
-  pass = 2;
-  onePass();
+  as->pass = 2;
+  onePass( as );
+
+  /* The listing is made from the records of pass 2.  With -e it is made,     */
+  /* and kept, only if there were errors.                                     */
+  listing = !as->list_errors_only || as->errors != 0 || as->errors_pass_1 != 0;
+  if( listing )
+  {
+    renderListing( as );
+  }
 
   /* Undo effects of NOPUNCH for any following checksum                       */
-  objectfile = objectsave;
-  punchChecksum();
+  as->objectfile = as->objectsave;
+  punchChecksum( as );
 
   /* Works great for trailer.                                                 */
-  punchLeader( 1 );
+  punchLeader( as, 1 );
 
   /* undo effects of NOLIST for any following output to listing file.         */
-  listfile = listsave;
+  as->listfile = as->listsave;
+
+  if( as->compact )
+  {
+    punchImage( as );
+  }
 
   /* Display value of error counter.                                          */
-  if( errors == 0 )
+  if( as->errors == 0 )
   {
-    fprintf( listfile, "\n      %s %s %s\n", s_no, s_detected, s_errors );
+    listFormat( as, "\n      %s %s %s\n", s_no, s_detected, s_errors );
   }
   else
   {
-    fprintf( errorfile, "\n      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
-    fprintf( listfile, "\n      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
-    fprintf( stderr,   "      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
+    fprintf( as->errorfile, "\n      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    listFormat( as, "\n      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    if( !as->batch )
+    {
+      fprintf( stderr,   "      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    }
   }
 
-  if( symtab_print )
+  printReports( as, listing );
+
+  if( as->write_permanent_snapshot )
   {
-    printSymbolTable();
+    writePermanentSnapshot( as );
   }
 
-  if( print_permanent_symbols )
+  if( !listing )
+  {
+    as->listout_count = 0;
+  }
+  flushTape( as );
+  flushList( as );
+  fclose( as->objectfile );
+  fclose( as->listfile );
+  fclose( as->errorfile );
+  if( as->errors == 0 && as->errors_pass_1 == 0 )
   {
-    printPermanentSymbolTable();
+    remove( as->errorpathname );
   }
+  if( !listing )
+  {
+    remove( as->listpathname );
+  }
+
+  return( as->errors != 0 );
+} /* assemble()                                                               */
+
 
-  if( xref )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  assembleBatch                                                  */
+/*                                                                            */
+/*  Synopsis:  Assemble each of the input files as a program of its own,      */
+/*             with the options of the context, on a pool of -j threads.      */
+/*             The output of each is the same as if it were assembled alone,  */
+/*             rather than with the files that follow it.  The files with     */
+/*             errors are reported in the order they were named.  Returns     */
+/*             non-zero if any file had errors or could not be assembled.     */
+/*                                                                            */
+/******************************************************************************/
+int assembleBatch( ASM_T *as )
+{
+  BATCH_T     batch;
+  int         failed;
+  int         ix;
+  BATCHJOB_T *job;
+  BATCHJOB_T *jobs;
+  struct stat st;
+  pthread_t  *threads;
+  int         workers;
+
+  /* A snapshot is loaded once, for all of them to share.                     */
+  if( as->snapshotpath != NULL )
   {
-    printCrossReference();
+    loadPermanentSnapshot( as, as->snapshotpath );
   }
 
-  fclose( objectfile );
-  fclose( listfile );
-  fclose( errorfile );
-  if( errors == 0 && errors_pass_1 == 0 )
+  jobs = (BATCHJOB_T *) malloc( sizeof( BATCHJOB_T ) * as->source_count );
+  batch.queue = (BATCHJOB_T **) malloc( sizeof( BATCHJOB_T * )
+                                        * as->source_count );
+  threads = (pthread_t *) malloc( sizeof( pthread_t ) * as->threads );
+  if( jobs == NULL || batch.queue == NULL || threads == NULL )
   {
-    remove( errorpathname );
+    fprintf( stderr, "Could not allocate memory for batch.\n" );
+    exit( -1 );
   }
 
-  return( errors != 0 );
-} /* main()                                                                   */
+  /* Taking the biggest sources first keeps a big one from being the last.    */
+  for( ix = 0; ix < as->source_count; ix++ )
+  {
+    jobs[ix].path = as->sources[ix];
+    jobs[ix].size = ( stat( jobs[ix].path, &st ) == 0 ) ? (long) st.st_size : 0;
+    jobs[ix].failure = NULL;
+    jobs[ix].errors = 0;
+    batch.queue[ix] = &jobs[ix];
+  }
+  qsort( batch.queue, as->source_count, sizeof( BATCHJOB_T * ), compareJobs );
+  batch.options = as;
+  batch.count = as->source_count;
+  batch.next = 0;
+  pthread_mutex_init( &batch.lock, NULL );
+
+  /* This thread is one of the workers.                                       */
+  workers = ( as->threads < batch.count ) ? as->threads : batch.count;
+  for( ix = 1; ix < workers; ix++ )
+  {
+    if( pthread_create( &threads[ix], NULL, batchWorker, &batch ) != 0 )
+    {
+      break;                        /* Make do with the threads there are.    */
+    }
+  }
+  workers = ix;
+  batchWorker( &batch );
+  for( ix = 1; ix < workers; ix++ )
+  {
+    pthread_join( threads[ix], NULL );
+  }
+  pthread_mutex_destroy( &batch.lock );
+
+  for( failed = 0, ix = 0; ix < as->source_count; ix++ )
+  {
+    job = &jobs[ix];
+    if( job->failure != NULL )
+    {
+      fprintf( stderr, job->failure, as->progname, job->path );
+      failed++;
+    }
+    else if( job->errors != 0 )
+    {
+      fprintf( stderr, "%s: %d %s %s\n", job->path, job->errors, s_detected,
+                                    ( job->errors == 1 ? s_error : s_errors ));
+      failed++;
+    }
+  }
+  free( threads );
+  free( batch.queue );
+  free( jobs );
+  return( failed != 0 );
+} /* assembleBatch()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  batchWorker                                                    */
+/*                                                                            */
+/*  Synopsis:  Assemble sources from the queue of a batch, each in a context  */
+/*             of its own, until there are none left.                         */
+/*                                                                            */
+/******************************************************************************/
+void *batchWorker( void *arg )
+{
+  ASM_T      *as;
+  BATCH_T    *batch;
+  BATCHJOB_T *job;
+
+  batch = (BATCH_T *) arg;
+  for( ;; )
+  {
+    pthread_mutex_lock( &batch->lock );
+    job = ( batch->next < batch->count ) ? batch->queue[batch->next++] : NULL;
+    pthread_mutex_unlock( &batch->lock );
+    if( job == NULL )
+    {
+      return( NULL );
+    }
+
+    /* Each source is a program of its own, as if it were named alone.        */
+    as = newAssembler();
+    shareOptions( as, batch->options );
+    job->args[0] = as->progname;
+    job->args[1] = job->path;
+    as->save_argc = 2;
+    as->save_argv = job->args;
+    as->filix_start = 1;
+    job->failure = openSource( as, job->path );
+    if( job->failure == NULL && mapSources( as ) != 0 )
+    {
+      job->failure = "%s: cannot open \"%s\"\n";
+    }
+    if( job->failure == NULL )
+    {
+      assemble( as );
+      job->errors = as->errors;
+    }
+    freeAssembler( as );
+  }
+} /* batchWorker()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  compareJobs                                                    */
+/*                                                                            */
+/*  Synopsis:  Order the sources of a batch by size, biggest first, and then  */
+/*             in the order they were named, for qsort().                     */
+/*                                                                            */
+/******************************************************************************/
+int compareJobs( const void *a, const void *b )
+{
+  BATCHJOB_T *ja;
+  BATCHJOB_T *jb;
+
+  ja = *(BATCHJOB_T **) a;
+  jb = *(BATCHJOB_T **) b;
+  if( ja->size != jb->size )
+  {
+    return(( ja->size > jb->size ) ? -1 : 1 );
+  }
+  return(( ja < jb ) ? -1 : ( ja > jb ));
+} /* compareJobs()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  shareOptions                                                   */
+/*                                                                            */
+/*  Synopsis:  Give a new context for a source of a batch the options, and    */
+/*             the permanent symbols, of the context of the batch.            */
+/*                                                                            */
+/******************************************************************************/
+void shareOptions( ASM_T *to, ASM_T *from )
+{
+  to->batch = TRUE;
+  to->compact = from->compact;
+  to->list_errors_only = from->list_errors_only;
+  to->nomac_exp = from->nomac_exp;
+  to->print_permanent_symbols = from->print_permanent_symbols;
+  to->progname = from->progname;
+  to->rim_mode = from->rim_mode;
+  to->symtab_print = from->symtab_print;
+  to->write_permanent_snapshot = from->write_permanent_snapshot;
+  to->xref = from->xref;
+  to->zblock_words = from->zblock_words;
+
+  to->permtab = from->permtab;
+  to->permtab_disp = from->permtab_disp;
+  to->permtab_order = from->permtab_order;
+  to->permtab_buckets = from->permtab_buckets;
+  to->permtab_count = from->permtab_count;
+  to->permtab_size = from->permtab_size;
+} /* shareOptions()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  newAssembler                                                   */
+/*                                                                            */
+/*  Synopsis:  Allocate an assembler context with the default options, ready  */
+/*             for getArgs() or for its options to be set by the caller.      */
+/*                                                                            */
+/******************************************************************************/
+ASM_T *newAssembler( void )
+{
+  ASM_T  *as;
+  int     ix;
+
+  as = (ASM_T *) calloc( 1, sizeof( ASM_T ));
+  if( as == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for assembler.\n");
+    exit( -1 );
+  }
+
+  /* All the assemblies of the process share the built-in permanent symbols.  */
+  as->permtab = permtab_builtin;
+  as->permtab_disp = permtab_builtin_disp;
+  as->permtab_order = permtab_builtin_order;
+  as->permtab_buckets = PERMTAB_BUCKETS;
+  as->permtab_count = PERMTAB_COUNT;
+  as->permtab_size = PERMTAB_SIZE;
+
+  /* Set the default values for the options and the state.                    */
+  as->binary_data_output = FALSE;
+  as->fltg_input = FALSE;
+  as->nomac_exp = TRUE;
+  as->permanent_expunged = FALSE;
+  as->print_permanent_symbols = FALSE;
+  as->snapshotpath = NULL;
+  as->write_permanent_snapshot = FALSE;
+  as->rim_mode = FALSE;
+  as->symtab_print = FALSE;
+  as->xref = FALSE;
+  as->pathname = NULL;
+  for( ix = 0; ix < MAC_TABLE_LENGTH; ix++ )
+  {
+    as->mac_bodies[ix] = NULL;
+  }
+  as->sym_eval.type = DEFINED;
+  as->sym_getexpr.type = DEFINED;
+  as->sym_undefined.type = UNDEFINED;
+  return( as );
+} /* newAssembler()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  newImage                                                       */
+/*                                                                            */
+/*  Synopsis:  Allocate the memory image that loadWord() fills in.            */
+/*                                                                            */
+/******************************************************************************/
+void newImage( ASM_T *as )
+{
+  as->image = (WORD32 *) malloc( sizeof( WORD32 ) * IMAGE_SIZE );
+  as->loaded = (BYTE *) calloc( IMAGE_SIZE, sizeof( BYTE ));
+  if( as->image == NULL || as->loaded == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for memory image.\n");
+    exit( -1 );
+  }
+} /* newImage()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  freeAssembler                                                  */
+/*                                                                            */
+/*  Synopsis:  Free an assembler context and all the memory of its assembly.  */
+/*                                                                            */
+/******************************************************************************/
+void freeAssembler( ASM_T *as )
+{
+  int     ix;
+
+  for( ix = 0; ix < as->symbol_chunks; ix++ )
+  {
+    free( as->symchunk[ix] );
+  }
+  free( as->symhash );
+  free( as->xrefs );
+  free( as->xrefblocks );
+  for( ix = 0; ix < MAC_TABLE_LENGTH; ix++ )
+  {
+    free( as->mac_bodies[ix] );
+  }
+  free( as->linebuf );
+  free( as->mac_line );
+
+  for( ix = 0; ix < as->arena_block_count; ix++ )
+  {
+    free( as->arena_blocks[ix] );
+  }
+  free( as->arena_blocks );
+  free( as->srclines );
+  free( as->lexemes );
+  free( as->skips );
+  free( as->coded );
+  free( as->excode );
+  free( as->exstack );
+  for( ix = 0; as->srcfiles != NULL && ix < as->save_argc; ix++ )
+  {
+    if( as->srcfiles[ix].mapped )
+    {
+      munmap( as->srcfiles[ix].text, as->srcfiles[ix].size );
+    }
+    else if( as->srcfiles[ix].size > 0 )
+    {
+      free( as->srcfiles[ix].text );
+    }
+  }
+  free( as->srcfiles );
+  free( as->sources );
+  free( as->image );
+  free( as->loaded );
+  free( as->listout );
+  free( as->listrecs );
+  free( as->listtitles );
+
+  if( as->permtab_hashed )
+  {
+    free( as->permtab );
+    free( as->permtab_disp );
+    free( as->permtab_order );
+  }
+  if( as->snapbase != NULL )
+  {
+    munmap( as->snapbase, as->snapsize );
+  }
+  free( as->permtab_copy );
+  free( as );
+} /* freeAssembler()                                                          */
 
 /******************************************************************************/
 /*                                                                            */
@@ -907,18 +1751,22 @@ int main( int argc, char *argv[] )
 /*             output files.                                                  */
 /*                                                                            */
 /******************************************************************************/
-void getArgs( int argc, char *argv[] )
+void getArgs( ASM_T *as, int argc, char *argv[] )
 {
-  WORD32  len;
+  char   *failure;
   WORD32  ix, jx;
+  BOOL    snapshot_next;
+  BOOL    threads_next;
 
   /* Set the defaults                                                         */
-  errorfile = NULL;
-  infile = NULL;
-  listfile = NULL;
-  listsave = NULL;
-  objectfile = NULL;
-  objectsave = NULL;
+  snapshot_next = FALSE;
+  threads_next = FALSE;
+  as->errorfile = NULL;
+  as->listfile = NULL;
+  as->listsave = NULL;
+  as->objectfile = NULL;
+  as->objectsave = NULL;
+  as->progname = argv[0];
 
   for( ix = 1; ix < argc; ix++ )
   {
@@ -928,69 +1776,246 @@ void getArgs( int argc, char *argv[] )
       {
         switch( argv[ix][jx] )
         {
+        case 'c':
+          as->compact = TRUE;
+          break;
+
         case 'd':
-          symtab_print = TRUE;
+          as->symtab_print = TRUE;
+          break;
+
+        case 'e':
+          as->list_errors_only = TRUE;
+          break;
+
+        case 'j':
+          threads_next = TRUE;
           break;
 
         case 'm':
-          nomac_exp = FALSE;
+          as->nomac_exp = FALSE;
           break;
 
         case 'r':
-          rim_mode = TRUE;
+          as->rim_mode = TRUE;
           break;
 
         case 'p':
-          print_permanent_symbols = TRUE;
+          as->print_permanent_symbols = TRUE;
+          break;
+
+        case 's':
+          as->write_permanent_snapshot = TRUE;
+          break;
+
+        case 'u':
+          snapshot_next = TRUE;
           break;
 
         case 'x':
-          xref = TRUE;
+          as->xref = TRUE;
+          break;
+
+        case 'z':
+          as->zblock_words = TRUE;
           break;
 
         default:
           fprintf( stderr, "%s: unknown flag: %s\n", argv[0], argv[ix] );
+          fprintf( stderr, " -c -- punch a compact bin tape from the image\n" );
           fprintf( stderr, " -d -- dump symbol table\n" );
+          fprintf( stderr, " -e -- keep the listing only on errors\n" );
+          fprintf( stderr, " -j -- assemble files separately on n threads\n" );
           fprintf( stderr, " -m -- print macro expansions\n" );
           fprintf( stderr, " -r -- output rim format file\n" );
           fprintf( stderr, " -p -- output permanent symbols to file\n" );
+          fprintf( stderr, " -s -- output permanent symbol snapshot\n" );
+          fprintf( stderr, " -u -- use permanent symbol snapshot file\n" );
           fprintf( stderr, " -x -- output cross reference to file\n" );
+          fprintf( stderr, " -z -- list every word of a ZBLOCK\n" );
+          fprintf( stderr, " @f -- with -j, read input files from f\n" );
           fflush( stderr );
           exit( -1 );
         } /* end switch                                                       */
       } /* end for                                                            */
-    }
-    else
-    {
-      filix_start = ix;
-      pathname = argv[ix];
-      break;
-    }
-  } /* end for                                                                */
 
-  if( pathname == NULL )
-  {
-    fprintf( stderr, "%s:  no input file specified\n", argv[0] );
+      /* The snapshot file given to -u is the next argument.                  */
+      if( snapshot_next )
+      {
+        if( ++ix >= argc )
+        {
+          fprintf( stderr, "%s: no snapshot file specified\n", argv[0] );
+          exit( -1 );
+        }
+        as->snapshotpath = argv[ix];
+        snapshot_next = FALSE;
+      }
+
+      /* So is the number of threads given to -j, 0 for one per processor.    */
+      if( threads_next )
+      {
+        if( ++ix >= argc || !isdigit( argv[ix][0] ))
+        {
+          fprintf( stderr, "%s: no number of threads specified\n", argv[0] );
+          exit( -1 );
+        }
+        as->threads = atoi( argv[ix] );
+        if( as->threads < 1 )
+        {
+          as->threads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+          as->threads = ( as->threads < 1 ) ? 1 : as->threads;
+        }
+        threads_next = FALSE;
+      }
+    }
+    else
+    {
+      as->filix_start = ix;
+      as->pathname = argv[ix];
+      break;
+    }
+  } /* end for                                                                */
+
+  /* With -j, each input file is assembled on its own by assembleBatch().     */
+  for( ; as->threads > 0 && ix < argc; ix++ )
+  {
+    if( argv[ix][0] == '@' )
+    {
+      if( !readManifest( as, &argv[ix][1] ))
+      {
+        fprintf( stderr, "%s: cannot open \"%s\"\n", argv[0], &argv[ix][1] );
+        exit( -1 );
+      }
+    }
+    else
+    {
+      addSource( as, argv[ix] );
+    }
+  }
+
+  if( as->pathname == NULL || ( as->threads > 0 && as->source_count == 0 ))
+  {
+    fprintf( stderr, "%s:  no input file specified\n", argv[0] );
     exit( -1 );
   }
 
-  len = strlen( pathname );
+  /* Otherwise they are assembled together, named after the first one.        */
+  if( as->threads == 0 )
+  {
+    if(( failure = openSource( as, as->pathname )) != NULL )
+    {
+      fprintf( stderr, failure, argv[0], as->pathname );
+      exit( -1 );
+    }
+  }
+} /* getArgs()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addSource                                                      */
+/*                                                                            */
+/*  Synopsis:  Add an input file to those of a batch.                         */
+/*                                                                            */
+/******************************************************************************/
+void addSource( ASM_T *as, char *path )
+{
+  as->sources = (char **) growTable( as->sources, &as->source_room,
+                                     sizeof( char * ), as->source_count + 1 );
+  as->sources[as->source_count++] = path;
+} /* addSource()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  readManifest                                                   */
+/*                                                                            */
+/*  Synopsis:  Add the input files named in a file, one per line, to those    */
+/*             of a batch.  Blanks around the names and blank lines are       */
+/*             ignored.  Returns FALSE if the file cannot be read.            */
+/*                                                                            */
+/******************************************************************************/
+BOOL readManifest( ASM_T *as, char *path )
+{
+  char   *end;
+  long    last;
+  BOOL    mapped;
+  char   *name;
+  long    next;
+  long    pos;
+  long    size;
+  char   *text;
+
+  if(( text = mapSource( path, &size, &mapped )) == NULL )
+  {
+    return( FALSE );
+  }
+  for( pos = 0; pos < size; pos = next )
+  {
+    end = (char *) memchr( &text[pos], '\n', size - pos );
+    last = ( end != NULL ) ? end - text : size;
+    next = last + 1;
+    while( pos < last && isspace( text[pos] ))
+    {
+      pos++;                        /* Drop leading blanks,                   */
+    }
+    while( last > pos && isspace( text[last - 1] ))
+    {
+      last--;                       /* and a carriage return, and blanks.     */
+    }
+    if( last > pos )
+    {
+      name = arenaAlloc( as, last - pos + 1 );
+      memcpy( name, &text[pos], last - pos );
+      name[last - pos] = '\0';
+      addSource( as, name );
+    }
+  }
+
+  if( mapped )
+  {
+    munmap( text, size );
+  }
+  else if( size > 0 )
+  {
+    free( text );
+  }
+  return( TRUE );
+} /* readManifest()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  openSource                                                     */
+/*                                                                            */
+/*  Synopsis:  Make the pathnames of the output files from the pathname of    */
+/*             the first input file.  Returns NULL, or if it fails a message  */
+/*             to print with the program name and the pathname.               */
+/*                                                                            */
+/******************************************************************************/
+char *openSource( ASM_T *as, char *path )
+{
+  int     len;
+  int     jx;
+
+  as->pathname = path;
+  len = strlen( as->pathname );
   if( len > NAMELEN - 5 )
   {
-    fprintf( stderr, "%s: pathname \"%s\" too long\n", argv[0], pathname );
-    exit( -1 );
+    return( "%s: pathname \"%s\" too long\n" );
   }
 
   /* Now make the pathnames                                                   */
   /* Find last '.', if it exists.                                             */
   jx = len - 1;
-  while( pathname[jx] != '.'  && pathname[jx] != '/'
-      && pathname[jx] != '\\' && jx >= 0 )
+  while( jx >= 0 && as->pathname[jx] != '.'  && as->pathname[jx] != '/'
+      && as->pathname[jx] != '\\' )
   {
     jx--;
   }
 
-  switch( pathname[jx] )
+  /* A name with neither has no extension to replace, as after a '/'.         */
+  switch(( jx >= 0 ) ? as->pathname[jx] : '/' )
   {
   case '.':
     break;
@@ -1005,36 +2030,73 @@ void getArgs( int argc, char *argv[] )
   }
 
   /* Add the pathname extensions.                                             */
-  strncpy( objectpathname, pathname, jx );
-  objectpathname[jx] = '\0';
-  strcat( objectpathname, rim_mode ? ".rim" : ".bin" );
+  strncpy( as->objectpathname, as->pathname, jx );
+  as->objectpathname[jx] = '\0';
+  strcat( as->objectpathname, as->rim_mode ? ".rim" : ".bin" );
 
-  strncpy( listpathname, pathname, jx );
-  listpathname[jx] = '\0';
-  strcat( listpathname, ".lst" );
+  strncpy( as->listpathname, as->pathname, jx );
+  as->listpathname[jx] = '\0';
+  strcat( as->listpathname, ".lst" );
 
-  strncpy( errorpathname, pathname, jx );
-  errorpathname[jx] = '\0';
-  strcat( errorpathname, ".err" );
+  strncpy( as->errorpathname, as->pathname, jx );
+  as->errorpathname[jx] = '\0';
+  strcat( as->errorpathname, ".err" );
 
-  strncpy( permpathname, pathname, jx );
-  permpathname[jx] = '\0';
-  strcat( permpathname, ".prm" );
+  strncpy( as->permpathname, as->pathname, jx );
+  as->permpathname[jx] = '\0';
+  strcat( as->permpathname, ".prm" );
+
+  strncpy( as->snappathname, as->pathname, jx );
+  as->snappathname[jx] = '\0';
+  strcat( as->snappathname, ".pst" );
 
   /* Extract the filename from the path.                                      */
-  if( isalpha( pathname[0] ) && pathname[1] == ':' && pathname[2] != '\\' )
+  if( isalpha( as->pathname[0] ) && as->pathname[1] == ':'
+      && as->pathname[2] != '\\' )
   {
-    pathname[1] = '\\';         /* MS-DOS style pathname                      */
+    as->pathname[1] = '\\';         /* MS-DOS style pathname                  */
   }
 
   jx = len - 1;
-  while( pathname[jx] != '/' && pathname[jx] != '\\' && jx >= 0 )
+  while( jx >= 0 && as->pathname[jx] != '/' && as->pathname[jx] != '\\' )
   {
     jx--;
   }
-  strcpy( filename, &pathname[jx + 1] );
+  strcpy( as->filename, &as->pathname[jx + 1] );
+  return( NULL );
+} /* openSource()                                                             */
 
-} /* getArgs()                                                                */
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  mapSources                                                     */
+/*                                                                            */
+/*  Synopsis:  Map all the input files, which both passes read.  Returns 0,   */
+/*             or the index in argv of a file that cannot be opened.          */
+/*                                                                            */
+/******************************************************************************/
+int mapSources( ASM_T *as )
+{
+  int     ix;
+
+  as->srcfiles = (SRCFILE_T *) calloc( as->save_argc, sizeof( SRCFILE_T ));
+  if( as->srcfiles == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for source files.\n");
+    exit( -1 );
+  }
+  for( ix = as->filix_start; ix < as->save_argc; ix++ )
+  {
+    as->srcfiles[ix].text = mapSource( as->save_argv[ix],
+                                       &as->srcfiles[ix].size,
+                                       &as->srcfiles[ix].mapped );
+    if( as->srcfiles[ix].text == NULL )
+    {
+      return( ix );
+    }
+  }
+  return( 0 );
+} /* mapSources()                                                             */
 
 
 /******************************************************************************/
@@ -1044,7 +2106,7 @@ void getArgs( int argc, char *argv[] )
 /*  Synopsis:  Do one assembly pass.                                          */
 /*                                                                            */
 /******************************************************************************/
-void onePass()
+void onePass( ASM_T *as )
 {
   BOOL    blanks;
   int     ix;
@@ -1057,189 +2119,200 @@ void onePass()
   WORD32  term;
   WORD32  val;
 
-  clc = 0200;                   /* Default starting address is 200 octal.     */
-  field = 0;
-  fieldlc = 0200;
-  reloc = 0;
+  as->clc = 0200;                   /* Default starting address is 200 octal. */
+  as->field = 0;
+  as->fieldlc = 0200;
+  as->reloc = 0;
   for( ix = 0; ix < TOTAL_PAGES; ix++ )
   {
-    lit_loc[ix] = lit_base[ix] = 00200;
+    as->lit_loc[ix] = as->lit_base[ix] = 00200;
   }
-  mac_count = 0;               /* No macros defined.                          */
-  mac_ptr = NULL;              /* Not in a macro.                             */
+  as->mac_count = 0;               /* No macros defined.                      */
+  as->mac_ptr = NULL;              /* Not in a macro.                         */
   for( ix = 0; ix < MAC_TABLE_LENGTH; ix++)
   {
-    if ( mac_bodies[ix] )
+    if ( as->mac_bodies[ix] )
     {
-      free( mac_bodies[ix] );
+      free( as->mac_bodies[ix] );
     }
   }
-  cp.error = FALSE;
-  pz.error = FALSE;
-  listed = TRUE;
-  lgm_flag = TRUE;
-  lineno = 0;
-  list_pageno = 0;
-  list_lineno = 0;
-  list_title_set = FALSE;
-  page_lineno = LIST_LINES_PER_PAGE;    /* Force top of page for new titles.  */
-  radix = 8;                    /* Initial radix is octal (base 8).           */
-
-  /* Now open the first input file.                                           */
-  filix_curr = filix_start;     /* Initialize pointer to input files.         */
-  if(( infile = fopen( save_argv[filix_curr], "r" )) == NULL )
+  as->cp.error = FALSE;
+  as->pz.error = FALSE;
+  as->listed = TRUE;
+  as->lgm_flag = TRUE;
+  as->lineno = 0;
+  as->list_pageno = 0;
+  as->list_lineno = 0;
+  as->list_title_set = FALSE;
+  as->page_lineno = LIST_LINES_PER_PAGE; /* Force top of page for new titles. */
+  as->radix = 8;                    /* Initial radix is octal (base 8).       */
+
+  as->srcline_next = 0;             /* Replay from the first cached line.     */
+  as->lexeme_line = -1;
+
+  /* Start at the first input file.  Pass 2 replays the lines cached by pass */
+  /* 1 and reads on from where pass 1 stopped only if it runs out of them.    */
+  if( as->pass == 1 )
   {
-    fprintf( stderr, "%s: cannot open \"%s\"\n", save_argv[0], save_argv[filix_curr] );
-    exit( -1 );
+    as->filix_curr = as->filix_start;   /* Initialize pointer to input files. */
+    as->srcpos = 0;
   }
 
   while( TRUE )
   {
-    readLine();
-    nextLexeme();
+    readLine( as );
+    nextLexeme( as );
 
     scanning_line = TRUE;
     while( scanning_line )
     {
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
         scanning_line = FALSE;
       }
       else
       {
-        switch( line[lexstart] )
+        switch( as->line[as->lexstart] )
         {
         case '/':
           scanning_line = FALSE;
           break;
 
         case ';':
-          nextLexeme();
+          nextLexeme( as );
           break;
 
         case '$':
-          endOfBinary();
-          fclose( infile );
+          endOfBinary( as );
           return;
 
         case '*':
-          nextLexeme();             /* Skip '*', (set origin symbol)          */
-          newclc = ((getExpr())->val & 07777 ) | field;
+          nextLexeme( as );             /* Skip '*', (set origin symbol)      */
+          newclc = ((getExpr( as ))->val & 07777 ) | as->field;
           /* Do not change Current Location Counter if an error occurred.     */
-          if( !error_in_line )
+          if( !as->error_in_line )
           {
-            if(( newclc & 07600 ) != ( clc & 07600 ))
+            if(( newclc & 07600 ) != ( as->clc & 07600 ))
             {
               /* Current page has changed.                                    */
-              punchLiteralPool( &cp, clc - 1 );
+              punchLiteralPool( as, &as->cp, as->clc - 1 );
             }
-            clc = newclc - reloc;
-            fieldlc = clc & 07777;
+            as->clc = newclc - as->reloc;
+            as->fieldlc = as->clc & 07777;
 
-            if( !rim_mode )
+            if( !as->rim_mode )
             {
               /* Not rim mode, put out origin.                                */
-              punchOrigin( clc );
+              punchOrigin( as, as->clc );
             }
-            printLine( line, 0, fieldlc, LINE_VAL );
+            printLine( as, as->line, 0, as->fieldlc, LINE_VAL );
           }
           break;
 
         default:
-          switch( line[lexterm] )
+          switch( as->line[as->lexterm] )
           {
           case ',':
-            if( isalpha( line[lexstart] ))
+            if( isalpha( as->line[as->lexstart] ))
             {
               /* Use lookup so symbol will not be counted as reference.       */
-              sym = lookup( lexemeToName( name, lexstart, lexterm ));
+              sym = lookup( as, lexemeToKey( as, as->lexstart, as->lexterm ));
               if( M_DEFINED( sym->type ))
               {
-                if( sym->val != clc && pass == 2 )
+                if( sym->val != as->clc && as->pass == 2 )
+                {
+                  errorSymbol( as, &duplicate_label,
+                               keyToName( name, sym->key ), as->lexstart );
+                }
+                if( !M_FIXED( sym->type ))
                 {
-                  errorSymbol( &duplicate_label, sym->name, lexstart );
+                  sym->type = sym->type | DUPLICATE; /* Not a shared one.     */
                 }
-                sym->type = sym->type | DUPLICATE;
               }
               /* Must call define on pass 2 to generate concordance.          */
-              defineLexeme( lexstart, lexterm, ( clc+reloc ), LABEL );
+              defineLexeme( as, as->lexstart, as->lexterm,
+                            ( as->clc+as->reloc ), LABEL );
             }
             else
             {
-              errorLexeme( &label_syntax, lexstart );
+              errorLexeme( as, &label_syntax, as->lexstart );
             }
-            nextLexeme();           /* skip label                             */
-            nextLexeme();           /* skip comma                             */
+            nextLexeme( as );           /* skip label                         */
+            nextLexeme( as );           /* skip comma                         */
             break;
 
           case '=':
-            if( isalpha( line[lexstart] ))
+            if( isalpha( as->line[as->lexstart] ))
             {
-              start = lexstart;
-              term = lexterm;
-              delimiter = line[lexterm];
-              nextLexBlank();       /* skip symbol                            */
-              nextLexBlank();       /* skip trailing =                        */
-              val = getExprs();
-              defineLexeme( start, term, val, DEFINED );
-              printLine( line, 0, val, LINE_VAL );
+              start = as->lexstart;
+              term = as->lexterm;
+              as->delimiter = as->line[as->lexterm];
+              nextLexBlank( as );       /* skip symbol                        */
+              nextLexBlank( as );       /* skip trailing =                    */
+              val = getCodedExprs( as );
+              defineLexeme( as, start, term, val, DEFINED );
+              printLine( as, as->line, 0, val, LINE_VAL );
             }
             else
             {
-              errorLexeme( &symbol_syntax, lexstartprev );
-              nextLexeme();         /* skip symbol                            */
-              nextLexeme();         /* skip trailing =                        */
-              getExprs();           /* skip expression                        */
+              errorLexeme( as, &symbol_syntax, as->lexstartprev );
+              nextLexeme( as );         /* skip symbol                        */
+              nextLexeme( as );         /* skip trailing =                    */
+              getExprs( as );           /* skip expression                    */
             }
             break;
 
           default:
-            if( isalpha( line[lexstart] ))
+            if( isalpha( as->line[as->lexstart] ))
             {
-              sym = evalSymbol();
+              sym = evalSymbol( as );
               val = sym->val;
               if( M_MACRO( sym->type ))
               {                     /* Find arguments.                       */
                 blanks = TRUE;      /* Expecting blanks.                     */
-                for( jx = 0; !isdone( line[cc] ) && ( jx < MAC_MAX_ARGS ); cc++ )
+                for( jx = 0;
+                     !isdone( as->line[as->cc] ) && ( jx < MAC_MAX_ARGS );
+                     as->cc++ )
                 {
-                  if(( line[cc] == ',' ) || is_blank( line[cc] )) blanks = TRUE;
+                  if(( as->line[as->cc] == ',' )
+                     || is_blank( as->line[as->cc] )) blanks = TRUE;
                   else if( blanks )
                   {
-                     mac_arg_pos[jx++] = cc;
+                     as->mac_arg_pos[jx++] = as->cc;
                      blanks = FALSE;
                   }
                 } /* end for                                                 */                
                 for( ; jx < MAC_MAX_ARGS; jx++ )
                 {
-                  mac_arg_pos[jx] = 0;
-                }
-                for( jx = 0; jx < LINELEN; jx++ )
-                {
-                  mac_line[jx] = line[jx];
+                  as->mac_arg_pos[jx] = 0;
                 }
-                mac_cc = cc;       /* Save line and position in line.        */
-                mac_ptr = mac_bodies[val];
-                if( mac_ptr ) scanning_line = FALSE;
-                else nextLexeme();
+                as->mac_line = (char *) growTable( as->mac_line,
+                                                   &as->mac_line_room,
+                                                   sizeof( char ),
+                                                   as->maxcc + 1 );
+                copyLine( as->mac_line, as->line, as->mac_line_room );
+                as->mac_cc = as->cc;       /* Save line and position in line. */
+                as->mac_ptr = as->mac_bodies[val];
+                if( as->mac_ptr ) scanning_line = FALSE;
+                else nextLexeme( as );
               } /* end if macro                                              */
               else if( M_PSEUDO( sym->type ))
               {
-                nextLexeme();         /* Skip symbol                          */
-                scanning_line = pseudoOperators( (PSEUDO_T)val & 07777 );
+                nextLexeme( as );         /* Skip symbol                      */
+                scanning_line = pseudoOperators( as, (PSEUDO_T)val & 07777 );
               }
               else
               {
                 /* Identifier is not a pseudo-op, interpret as load value     */
-                punchOutObject( clc, getExprs() & 07777 );
-                incrementClc();
+                punchOutObject( as, as->clc, getCodedExprs( as ) & 07777 );
+                incrementClc( as );
               }
             }
             else
             {
               /* Identifier is a value, interpret as load value               */
-              punchOutObject( clc, getExprs() & 07777 );
-              incrementClc();
+              punchOutObject( as, as->clc, getCodedExprs( as ) & 07777 );
+              incrementClc( as );
             }
             break;
           } /* end switch                                                     */
@@ -1251,6 +2324,268 @@ void onePass()
 } /* onePass()                                                                */
 
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getCodedExprs                                                  */
+/*                                                                            */
+/*  Synopsis:  Get an operand field like getExprs().  In pass 1 the field is  */
+/*             also compiled, as it is parsed, into code kept with the line,  */
+/*             and pass 2 runs that code instead of parsing the field again.  */
+/*             Fields with errors in pass 1 are parsed again in pass 2, which */
+/*             reports them.                                                  */
+/*                                                                            */
+/******************************************************************************/
+WORD32 getCodedExprs( ASM_T *as )
+{
+  CODED_T *ex;
+  WORD32  value;
+
+  if( as->pass == 2 && ( ex = findCodedExprs( as )) != NULL )
+  {
+    return( runCodedExprs( as, ex ));
+  }
+  if( as->pass != 1 || as->lexeme_line < 0 || as->error_in_line )
+  {
+    return( getExprs( as ));
+  }
+
+  as->coded = (CODED_T *) growTable( as->coded, &as->coded_room,
+                                     sizeof( CODED_T ), as->coded_count + 1 );
+  ex = &as->coded[as->coded_count];
+  ex->from = as->lexstart;
+  ex->code = as->excode_count;
+  ex->radix = as->radix;
+  as->coding = TRUE;
+  as->coding_depth = 0;
+  as->coding_max = 0;
+  value = getExprs( as );
+  codeExpr( as, EX_END, 0, NULL );
+  if( !as->coding || as->error_in_line )
+  {
+    as->coding = FALSE;
+    as->excode_count = ex->code;    /* Forget the code.                       */
+    return( value );
+  }
+  as->coding = FALSE;
+
+  ex->depth = as->coding_max;
+  ex->lexeme = as->lexeme_count - as->srclines[as->lexeme_line].lexeme;
+  ex->lexstart = as->lexstart;
+  ex->lexterm = as->lexterm;
+  ex->lexstartprev = as->lexstartprev;
+  ex->lextermprev = as->lextermprev;
+  ex->cc = as->cc;
+  ex->delimiter = as->delimiter;
+  as->srclines[as->lexeme_line].exprs++;
+  as->coded_count++;
+  return( value );
+} /* getCodedExprs()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  codeExpr                                                       */
+/*                                                                            */
+/*  Synopsis:  Add an operation to the code of the operand field being        */
+/*             compiled by getCodedExprs(), if any.                           */
+/*                                                                            */
+/******************************************************************************/
+void codeExpr( ASM_T *as, EXOP_T op, WORD32 val, SYM_T *sym )
+{
+  EXCODE_T *code;
+
+  if( !as->coding )
+  {
+    return;
+  }
+  as->excode = (EXCODE_T *) growTable( as->excode, &as->excode_room,
+                                       sizeof( EXCODE_T ),
+                                       as->excode_count + 1 );
+  code = &as->excode[as->excode_count++];
+  code->op = op;
+  code->val = val;
+  code->sym = sym;
+
+  switch( op )
+  {
+  case EX_SYM:
+  case EX_CONST:
+  case EX_DOT:
+    as->coding_depth++;             /* Pushes a value.                        */
+    as->coding_max = ( as->coding_depth > as->coding_max ) ? as->coding_depth
+                                                             : as->coding_max;
+    break;
+
+  case EX_END:
+  case EX_NEG:
+  case EX_PZLIT:
+  case EX_CPLIT:
+    break;
+
+  default:
+    as->coding_depth--;             /* Combines two values.                   */
+    break;
+  }
+} /* codeExpr()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  findCodedExprs                                                 */
+/*                                                                            */
+/*  Synopsis:  Find the code compiled in pass 1 for the operand field at      */
+/*             lexstart of the current line.  Returns NULL if there is none,  */
+/*             or if it may not give what parsing the field would.            */
+/*                                                                            */
+/******************************************************************************/
+CODED_T *findCodedExprs( ASM_T *as )
+{
+  CODED_T   *ex;
+  SRCLINE_T *src;
+
+  if( as->lexeme_line < 0 )
+  {
+    return( NULL );
+  }
+  src = &as->srclines[as->lexeme_line];
+  while( as->coded_next < src->expr + src->exprs &&
+         as->coded[as->coded_next].from < as->lexstart )
+  {
+    as->coded_next++;
+  }
+  if( as->coded_next >= src->expr + src->exprs )
+  {
+    return( NULL );
+  }
+  ex = &as->coded[as->coded_next];
+  if( ex->from != as->lexstart || as->coded_next < as->coded_valid ||
+      ex->radix != as->radix )
+  {
+    return( NULL );
+  }
+  as->coded_next++;
+  return( ex );
+} /* findCodedExprs()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  runCodedExprs                                                  */
+/*                                                                            */
+/*  Synopsis:  Run the code compiled for an operand field against the values  */
+/*             the symbols have now, and leave the lexer after the field, as  */
+/*             getExprs() would.  Returns the value of the field.             */
+/*                                                                            */
+/******************************************************************************/
+WORD32 runCodedExprs( ASM_T *as, CODED_T *ex )
+{
+  EXCODE_T *code;
+  char      name[SYMLEN];
+  SYM_T    *sp;
+
+  as->exstack = (SYM_T *) growTable( as->exstack, &as->exstack_room,
+                                     sizeof( SYM_T ), ex->depth );
+  sp = as->exstack - 1;
+  for( code = &as->excode[ex->code]; code->op != EX_END; code++ )
+  {
+    switch( code->op )
+    {
+    case EX_SYM:                /* Value of a symbol.                         */
+      xrefSymbol( as, code->sym );
+      if( M_UNDEFINED( code->sym->type ))
+      {
+        errorSymbol( as, &undefined_symbol, keyToName( name, code->sym->key ),
+                                                                  code->val );
+      }
+      *++sp = *code->sym;
+      break;
+
+    case EX_CONST:              /* Number or quoted letter.                   */
+      as->sym_eval.val = code->val;
+      *++sp = as->sym_eval;
+      break;
+
+    case EX_DOT:                /* Value of Current Location Counter          */
+      as->sym_eval.val = as->clc + as->reloc;
+      *++sp = as->sym_eval;
+      break;
+
+    case EX_NEG:
+      sp->val = ( - sp->val );
+      break;
+
+    case EX_ADD:
+      sp--;
+      sp->val += sp[1].val;
+      break;
+
+    case EX_SUB:
+      sp--;
+      sp->val -= sp[1].val;
+      break;
+
+    case EX_MUL:
+      sp--;
+      sp->val *= sp[1].val;
+      break;
+
+    case EX_DIV:
+      sp--;
+      sp->val /= sp[1].val;
+      break;
+
+    case EX_AND:
+      sp--;
+      sp->val &= sp[1].val;
+      break;
+
+    case EX_OR:
+      sp--;
+      sp->val |= sp[1].val;
+      break;
+
+    case EX_PZLIT:              /* Literal on page zero.                      */
+      as->sym_eval.val = insertLiteral( as, &as->pz, as->field,
+                                        sp->val & 07777 );
+      *sp = as->sym_eval;
+      break;
+
+    case EX_CPLIT:              /* Literal on the current page, or page zero. */
+      if( testZeroPool( as, sp->val & 07777 ))
+      {
+        as->sym_eval.val = insertLiteral( as, &as->pz, as->field,
+                                          sp->val & 07777 );
+      }
+      else
+      {
+        as->sym_eval.val = insertLiteral( as, &as->cp, as->clc,
+                                          sp->val & 07777 )
+                           + (( as->clc + as->reloc ) & 077600 );
+      }
+      *sp = as->sym_eval;
+      break;
+
+    case EX_TERM:               /* Next expression of the field.              */
+      sp--;
+      sp->val = orOperand( as, sp->val, sp->type, &sp[1], code->val );
+      break;
+
+    case EX_END:
+      break;
+    }
+  }
+
+  as->lexeme_next = as->srclines[as->lexeme_line].lexeme + ex->lexeme;
+  as->lexstart = ex->lexstart;
+  as->lexterm = ex->lexterm;
+  as->lexstartprev = ex->lexstartprev;
+  as->lextermprev = ex->lextermprev;
+  as->cc = ex->cc;
+  as->delimiter = ex->delimiter;
+  return( sp->val );
+} /* runCodedExprs()                                                          */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  getExprs                                                       */
@@ -1260,26 +2595,24 @@ void onePass()
 /*             the last one in the list.                                      */
 /*                                                                            */
 /******************************************************************************/
-WORD32 getExprs()
+WORD32 getExprs( ASM_T *as )
 {
   SYM_T  *symv;
   SYM_T  *symt;
-  WORD32  temp;
-  SYMTYP  temp_type;
   WORD32  value;
   SYMTYP  value_type;
 
-  symv = getExpr();
+  symv = getExpr( as );
   value = symv->val;
   value_type = symv->type;
 
   while( TRUE )
   {
-    if( isdone( line[lexstart] ))
+    if( isdone( as->line[as->lexstart] ))
     {
       return( value );
     }
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case ')':
     case ']':
@@ -1290,67 +2623,92 @@ WORD32 getExprs()
     }
 
     /* Interpret space as logical or                                          */
-    symt = getExpr();
-    temp = symt->val & 07777;
-    temp_type = symt->type;
+    symt = getExpr( as );
+    value = orOperand( as, value, value_type, symt, as->lexstartprev );
+    codeExpr( as, EX_TERM, as->lexstartprev, NULL );
+  } /* end while                                                              */
+} /* getExprs()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  orOperand                                                      */
+/*                                                                            */
+/*  Synopsis:  Or the next expression of an operand field, symt, into value,  */
+/*             the field so far, whose first expression has type value_type.  */
+/*             An address after a memory reference instruction is made a page */
+/*             zero, current page or literal reference.  Diagnostics are given*/
+/*             at column col.  Returns the new value.                         */
+/*                                                                            */
+/******************************************************************************/
+WORD32 orOperand( ASM_T *as, WORD32 value, SYMTYP value_type, SYM_T *symt,
+                  int col )
+{
+  char    name[SYMLEN];
+  WORD32  temp;
+  SYMTYP  temp_type;
+
+  temp = symt->val & 07777;
+  temp_type = symt->type;
 
-    switch( value_type )
+  switch( value_type )
+  {
+  case MRI:
+  case MRIFIX:
+    /* Previous symbol was a Memory Reference Instruction.                  */
+    switch( temp_type )
     {
     case MRI:
     case MRIFIX:
-      /* Previous symbol was a Memory Reference Instruction.                  */
-      switch( temp_type )
-      {
-      case MRI:
-      case MRIFIX:
-        /* Current symbol is also a Memory Reference Instruction.             */
-        value |= temp;          /* Just OR the MRI instructions.              */
-        break;
+      /* Current symbol is also a Memory Reference Instruction.             */
+      value |= temp;          /* Just OR the MRI instructions.              */
+      break;
 
-      default:
-        /* Now have the address part of the MRI instruction.                  */
-        if( temp < 00200 )
-        {
-          value |= temp;        /* Page zero MRI.                             */
-        }
-        else if( (( fieldlc + reloc ) & 07600 ) <= temp
-             && temp <= (( fieldlc + reloc ) | 0177 ))
+    default:
+      /* Now have the address part of the MRI instruction.                  */
+      if( temp < 00200 )
+      {
+        value |= temp;        /* Page zero MRI.                             */
+      }
+      else if( (( as->fieldlc + as->reloc ) & 07600 ) <= temp
+           && temp <= (( as->fieldlc + as->reloc ) | 0177 ))
+      {
+        value |= ( PAGE_BIT | (temp & ADDRESS_FIELD )); /* Current page MRI */
+      }
+      else
+      {
+        if(( value & INDIRECT_BIT ) == INDIRECT_BIT )
         {
-          value |= ( PAGE_BIT | (temp & ADDRESS_FIELD )); /* Current page MRI */
+          /* Already indirect, can't generate                               */
+          errorSymbol( as, &illegal_indirect, keyToName( name, symt->key ),
+                                                               col );
         }
         else
         {
-          if(( value & INDIRECT_BIT ) == INDIRECT_BIT )
+          /* Now fix off page reference.                                    */
+          /* Search current page literal pool for needed value.             */
+          /* Set Indirect Current Page                                      */
+          if( testZeroPool( as, temp ))
           {
-            /* Already indirect, can't generate                               */
-            errorSymbol( &illegal_indirect, symt->name, lexstartprev );
+            value |= ( 00400 | insertLiteral( as, &as->pz, as->field, temp ));
           }
           else
           {
-            /* Now fix off page reference.                                    */
-            /* Search current page literal pool for needed value.             */
-            /* Set Indirect Current Page                                      */
-            if( testZeroPool( temp ))
-            {
-              value |= ( 00400 | insertLiteral( &pz, field, temp ));
-            }
-            else
-            {
-              value |= ( 00600 | insertLiteral( &cp, clc, temp ));
-            }
-            indirect_generated = TRUE;
+            value |= ( 00600 | insertLiteral( as, &as->cp, as->clc, temp ));
           }
+          as->indirect_generated = TRUE;
         }
-        break;
       }
       break;
-
-    default:
-        value |= temp;          /* Normal 12 bit value.                       */
-        break;
     }
-  } /* end while                                                              */
-} /* getExprs()                                                               */
+    break;
+
+  default:
+      value |= temp;          /* Normal 12 bit value.                       */
+      break;
+  }
+  return( value );
+} /* orOperand()                                                              */
 
 
 /******************************************************************************/
@@ -1362,25 +2720,26 @@ WORD32 getExprs()
 /*             contain terminal symbols (identifiers) separated by operators. */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *getExpr()
+SYM_T *getExpr( ASM_T *as )
 {
-  delimiter = line[lexterm];
+  as->delimiter = as->line[as->lexterm];
 
-  if( line[lexstart] == '-' )
+  if( as->line[as->lexstart] == '-' )
   {
-    nextLexBlank();
-    sym_getexpr = *(eval());
-    sym_getexpr.val = ( - sym_getexpr.val );
+    nextLexBlank( as );
+    as->sym_getexpr = *(eval( as ));
+    as->sym_getexpr.val = ( - as->sym_getexpr.val );
+    codeExpr( as, EX_NEG, 0, NULL );
   }
   else
   {
-    sym_getexpr = *(eval());
+    as->sym_getexpr = *(eval( as ));
   }
 
 
-  if( is_blank( delimiter ))
+  if( is_blank( as->delimiter ))
   {
-    return( &sym_getexpr );
+    return( &as->sym_getexpr );
   }
 
   /* Here we assume the current lexeme is the operator separating the         */
@@ -1388,50 +2747,56 @@ SYM_T *getExpr()
   while( TRUE )
   {
     /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
+    if( is_blank( as->delimiter ))
     {
-      return( &sym_getexpr );
+      return( &as->sym_getexpr );
     }
 
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case '+':                   /* add                                        */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val += (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val += (eval( as ))->val;
+      codeExpr( as, EX_ADD, 0, NULL );
       break;
 
     case '-':                   /* subtract                                   */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val -= (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val -= (eval( as ))->val;
+      codeExpr( as, EX_SUB, 0, NULL );
       break;
 
     case '^':                   /* multiply                                   */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val *= (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val *= (eval( as ))->val;
+      codeExpr( as, EX_MUL, 0, NULL );
       break;
 
     case '%':                   /* divide                                     */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val /= (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val /= (eval( as ))->val;
+      codeExpr( as, EX_DIV, 0, NULL );
       break;
 
     case '&':                   /* and                                        */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val &= (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val &= (eval( as ))->val;
+      codeExpr( as, EX_AND, 0, NULL );
       break;
 
     case '!':                   /* or                                         */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val |= (eval())->val;
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val |= (eval( as ))->val;
+      codeExpr( as, EX_OR, 0, NULL );
       break;
 
     default:
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
-        return( &sym_getexpr );
+        return( &as->sym_getexpr );
       }
 
-      switch( line[lexstart] )
+      switch( as->line[as->lexstart] )
       {
       case '/':
       case ';':
@@ -1443,18 +2808,18 @@ SYM_T *getExpr()
         break;
 
       case '=':
-        errorMessage( &illegal_equals, lexstart );
-        moveToEndOfLine();
-        sym_getexpr.val = 0;
+        errorMessage( as, &illegal_equals, as->lexstart );
+        moveToEndOfLine( as );
+        as->sym_getexpr.val = 0;
         break;
 
       default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
-        sym_getexpr.val = 0;
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
+        as->sym_getexpr.val = 0;
         break;
       }
-      return( &sym_getexpr );
+      return( &as->sym_getexpr );
     }
   } /* end while                                                              */
 } /* getExpr()                                                                */
@@ -1467,176 +2832,190 @@ SYM_T *getExpr()
 /*  Synopsis:  Get the value of the current lexeme, set delimiter and advance.*/
 /*                                                                            */
 /******************************************************************************/
-SYM_T *eval()
+SYM_T *eval( ASM_T *as )
 {
   WORD32  digit;
   WORD32  from;
   WORD32  loc;
+  char    name[SYMLEN];
   SYM_T  *sym;
   WORD32  val;
 
   val = 0;
 
-  delimiter = line[lexterm];
-  if( isalpha( line[lexstart] ))
+  as->delimiter = as->line[as->lexterm];
+  if( isalpha( as->line[as->lexstart] ))
   {
-    sym = evalSymbol();
+    sym = evalSymbol( as );
+    codeExpr( as, EX_SYM, as->lexstart, sym );
     if( M_UNDEFINED( sym->type ))
     {
-      if( pass == 2 )
+      if( as->pass == 2 )
       {
-        errorSymbol( &undefined_symbol, sym->name, lexstart );
+        errorSymbol( as, &undefined_symbol, keyToName( name, sym->key ),
+                     as->lexstart );
       }
-      nextLexeme();
+      nextLexeme( as );
       return( sym );
     }
     else if( M_PSEUDO( sym->type ))
     {
+      as->coding = FALSE;           /* Not worth compiling.                   */
       if( sym->val == DECIMAL )
       {
-        radix = 10;
+        as->radix = 10;
       }
       else if( sym->val == OCTAL )
       {
-        radix = 8;
+        as->radix = 8;
       }
-      else if( pass == 2 )
+      else if( as->pass == 2 )
       {
-        errorSymbol( &misplaced_symbol, sym->name, lexstart );
+        errorSymbol( as, &misplaced_symbol, keyToName( name, sym->key ),
+                     as->lexstart );
       }
-      sym_eval.type = sym->type;
-      sym_eval.val = 0;
-      nextLexeme();
-      return( &sym_eval );
+      as->sym_eval.type = sym->type;
+      as->sym_eval.val = 0;
+      nextLexeme( as );
+      return( &as->sym_eval );
     }
     else if( M_MACRO( sym->type ))
     {
-      if( pass == 2 )
+      as->coding = FALSE;           /* Not worth compiling.                   */
+      if( as->pass == 2 )
       {
-        errorSymbol( &misplaced_symbol, sym->name, lexstart );
+        errorSymbol( as, &misplaced_symbol, keyToName( name, sym->key ),
+                     as->lexstart );
       }
-      sym_eval.type = sym->type;
-      sym_eval.val = 0;
-      nextLexeme();
-      return( &sym_eval );
+      as->sym_eval.type = sym->type;
+      as->sym_eval.val = 0;
+      nextLexeme( as );
+      return( &as->sym_eval );
     }
     else
     {
-      nextLexeme();
+      nextLexeme( as );
       return( sym );
     }
   }
-  else if( isdigit( line[lexstart] ))
+  else if( isdigit( as->line[as->lexstart] ))
   {
-    from = lexstart;
+    from = as->lexstart;
     val = 0;
-    while( from < lexterm )
+    while( from < as->lexterm )
     {
-      if( isdigit( line[from] ))
+      if( isdigit( as->line[from] ))
       {
-        digit = (WORD32) line[from++] - (WORD32) '0';
-        if( digit < radix )
+        digit = (WORD32) as->line[from++] - (WORD32) '0';
+        if( digit < as->radix )
         {
-          val = val * radix + digit;
+          val = val * as->radix + digit;
         }
         else
         {
-          errorLexeme( &number_not_radix, from - 1 );
+          errorLexeme( as, &number_not_radix, from - 1 );
           val = 0;
-          from = lexterm;
+          from = as->lexterm;
         }
       }
       else
       {
-        errorLexeme( &not_a_number, lexstart );
+        errorLexeme( as, &not_a_number, as->lexstart );
         val = 0;
-        from = lexterm;
+        from = as->lexterm;
       }
     }
-    nextLexeme();
-    sym_eval.val = val;
-    return( &sym_eval );
+    codeExpr( as, EX_CONST, val, NULL );
+    nextLexeme( as );
+    as->sym_eval.val = val;
+    return( &as->sym_eval );
   }
   else
   {
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case '"':                   /* Character literal                          */
-      if( lexstart + 2 < maxcc )
+      if( expandedColumn( as, as->lexstart ) + 2
+          < expandedColumn( as, as->maxcc ))
       {
-        val = line[lexstart + 1] | 0200;
-        delimiter = line[lexstart + 2];
-        cc = lexstart + 2;
+        val = (( as->line[as->lexstart + 1] == '\t' )
+               ? ' ' : as->line[as->lexstart + 1] ) | 0200;
+        as->delimiter = as->line[as->lexstart + 2];
+        as->cc = as->lexstart + 2;
+        codeExpr( as, EX_CONST, val, NULL );
       }
       else
       {
-        errorMessage( &no_literal_value, lexstart );
+        errorMessage( as, &no_literal_value, as->lexstart );
       }
-      nextLexeme();
+      nextLexeme( as );
       break;
 
     case '.':                   /* Value of Current Location Counter          */
-      val = clc + reloc;
-      nextLexeme();
+      val = as->clc + as->reloc;
+      codeExpr( as, EX_DOT, 0, NULL );
+      nextLexeme( as );
       break;
 
     case '[':                   /* Generate literal on page zero.             */
-      nextLexBlank();           /* Skip bracket                               */
-      val = getExprs() & 07777;
-      if( line[lexstart] == ']' )
+      nextLexBlank( as );           /* Skip bracket                           */
+      val = getExprs( as ) & 07777;
+      if( as->line[as->lexstart] == ']' )
       {
-        delimiter = line[lexterm];
-        nextLexeme();           /* Skip end bracket                           */
+        as->delimiter = as->line[as->lexterm];
+        nextLexeme( as );           /* Skip end bracket                       */
       }
       else
       {
         /* errorMessage( "parens", lexstart );                                */
       }
-      sym_eval.val = insertLiteral( &pz, field, val );
-      return( &sym_eval );
+      codeExpr( as, EX_PZLIT, 0, NULL );
+      as->sym_eval.val = insertLiteral( as, &as->pz, as->field, val );
+      return( &as->sym_eval );
 
     case '(':                   /* Generate literal on current page.          */
-      nextLexBlank();           /* Skip paren                                 */
-      val = getExprs() & 07777;
+      nextLexBlank( as );           /* Skip paren                             */
+      val = getExprs( as ) & 07777;
 
-      if( line[lexstart] == ')' )
+      if( as->line[as->lexstart] == ')' )
       {
-        delimiter = line[lexterm];
-        nextLexeme();           /* Skip end paren                             */
+        as->delimiter = as->line[as->lexterm];
+        nextLexeme( as );           /* Skip end paren                         */
       }
       else
       {
         /* errorMessage( "parens", NULL );                                    */
       }
-      if( testZeroPool( val ))
+      codeExpr( as, EX_CPLIT, 0, NULL );
+      if( testZeroPool( as, val ))
       {
-        sym_eval.val = insertLiteral( &pz, field, val );
+        as->sym_eval.val = insertLiteral( as, &as->pz, as->field, val );
       }
       else
       {
-        loc = insertLiteral( &cp, clc, val );
-        sym_eval.val = loc + (( clc + reloc ) & 077600 );
+        loc = insertLiteral( as, &as->cp, as->clc, val );
+        as->sym_eval.val = loc + (( as->clc + as->reloc ) & 077600 );
       }
-      return( &sym_eval );
+      return( &as->sym_eval );
 
     default:
-      switch( line[lexstart] )
+      switch( as->line[as->lexstart] )
       {
       case '=':
-        errorMessage( &illegal_equals, lexstart );
-        moveToEndOfLine();
+        errorMessage( as, &illegal_equals, as->lexstart );
+        moveToEndOfLine( as );
         break;
 
       default:
-        errorMessage( &illegal_character, lexstart );
+        errorMessage( as, &illegal_character, as->lexstart );
         break;
       }
       val = 0;                  /* On error, set value to zero.               */
-      nextLexBlank();           /* Go past illegal character.                 */
+      nextLexBlank( as );           /* Go past illegal character.             */
     }
   }
-  sym_eval.val = val;
-  return( &sym_eval );
+  as->sym_eval.val = val;
+  return( &as->sym_eval );
 } /* eval()                                                                   */
 
 
@@ -1647,7 +3026,7 @@ SYM_T *eval()
 /*  Synopsis:  Get the value of the current lexeme as a double word.          */
 /*                                                                            */
 /******************************************************************************/
-void inputDubl()
+void inputDubl( ASM_T *as )
 {
   WORD32 dublvalue;
   BOOL   scanning_line;
@@ -1657,34 +3036,36 @@ void inputDubl()
   {
     while( scanning_line )
     {
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
         scanning_line = FALSE;
       }
       else
       {
-        switch( line[lexstart] )
+        switch( as->line[as->lexstart] )
         {
         case '/':
           scanning_line = FALSE;
           break;
 
         case ';':
-          nextLexeme();
+          nextLexeme( as );
           break;
 
         case '+':
-          delimiter = line[lexterm];
-          nextLexBlank();
+          as->delimiter = as->line[as->lexterm];
+          nextLexBlank( as );
         case '-':
         default:
-          if( isdigit( line[lexstart] ) || line[lexstart] == '-' )
+          if( isdigit( as->line[as->lexstart] )
+              || as->line[as->lexstart] == '-' )
           {
-            dublvalue = getDublExprs();
-            punchOutObject( clc, (WORD32)(( dublvalue >> 12 ) & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD32)( dublvalue & 07777 ));
-            incrementClc();
+            dublvalue = getDublExprs( as );
+            punchOutObject( as, as->clc,
+                            (WORD32)(( dublvalue >> 12 ) & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc, (WORD32)( dublvalue & 07777 ));
+            incrementClc( as );
           }
           else
           {
@@ -1694,13 +3075,13 @@ void inputDubl()
         } /* end switch                                                       */
       } /* end if                                                             */
 
-      if( error_in_line )
+      if( as->error_in_line )
       {
         return;                 /* Error occurred, exit DUBL input mode.      */
       }
     } /* end while( scanning_line )                                           */
-    readLine();
-    nextLexeme();
+    readLine( as );
+    nextLexeme( as );
     scanning_line = TRUE;
   }
   while( TRUE );
@@ -1714,21 +3095,21 @@ void inputDubl()
 /*  Synopsis:  Get a DUBL expression.                                         */
 /*                                                                            */
 /******************************************************************************/
-WORD32 getDublExprs()
+WORD32 getDublExprs( ASM_T *as )
 {
   WORD32 dublvalue;
 
-  dublvalue = getDublExpr();
+  dublvalue = getDublExpr( as );
 
   while( TRUE )
   {
-    if( isdone( line[lexstart] ))
+    if( isdone( as->line[as->lexstart] ))
     {
       return( dublvalue );
     }
     else
     {
-      errorMessage( &illegal_expression, lexstart - 1 );
+      errorMessage( as, &illegal_expression, as->lexstart - 1 );
       return( 0 );
     }
   } /* end while                                                              */
@@ -1743,37 +3124,37 @@ WORD32 getDublExprs()
 /*             number is always considered to have a decimal radix.           */
 /*                                                                            */
 /******************************************************************************/
-WORD32 getDublExpr()
+WORD32 getDublExpr( ASM_T *as )
 {
   WORD32 dublvalue;
 
-  delimiter = line[lexterm];
-  if( line[lexstart] == '-' )
+  as->delimiter = as->line[as->lexterm];
+  if( as->line[as->lexstart] == '-' )
   {
-    nextLexBlank();
-    dublvalue = evalDubl( 0 );
-    nextLexeme();
+    nextLexBlank( as );
+    dublvalue = evalDubl( as, 0 );
+    nextLexeme( as );
     /* Test for any value greater than 23 bits in length.                     */
     if( (unsigned long int)dublvalue > 040000000L )
     {
-      errorMessage( &dubl_overflow, lexstart );
+      errorMessage( as, &dubl_overflow, as->lexstart );
       dublvalue = 0;
     }
     dublvalue = -dublvalue;
   }
   else
   {
-    dublvalue = evalDubl( 0 );
-    nextLexeme();
+    dublvalue = evalDubl( as, 0 );
+    nextLexeme( as );
     /* Test for any value greater than 23 bits in length.                     */
     if( (unsigned long int)dublvalue > 037777777L )
     {
-      errorMessage( &dubl_overflow, lexstart );
+      errorMessage( as, &dubl_overflow, as->lexstart );
       dublvalue = 0;
     }
   }
 
-  if( is_blank( delimiter ))
+  if( is_blank( as->delimiter ))
   {
     return( dublvalue );
   }
@@ -1783,15 +3164,15 @@ WORD32 getDublExpr()
   while( TRUE )
   {
     /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
+    if( is_blank( as->delimiter ))
     {
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
       dublvalue = 0;
       return( dublvalue );
     }
 
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case '+':                   /* add                                        */
     case '-':                   /* subtract                                   */
@@ -1799,26 +3180,26 @@ WORD32 getDublExpr()
     case '%':                   /* divide                                     */
     case '&':                   /* and                                        */
     case '!':                   /* or                                         */
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
       dublvalue = 0;
       break;
 
     default:
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
         return( dublvalue );
       }
 
-      switch( line[lexstart] )
+      switch( as->line[as->lexstart] )
       {
       case '/':
       case ';':
         break;
 
       default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
         dublvalue = 0;
         break;
       }
@@ -1836,35 +3217,35 @@ WORD32 getDublExpr()
 /*             number is always considered to have a decimal radix.           */
 /*                                                                            */
 /******************************************************************************/
-WORD32 evalDubl( WORD32 initial_value )
+WORD32 evalDubl( ASM_T *as, WORD32 initial_value )
 {
   WORD32  digit;
   WORD32  from;
   WORD32  dublvalue;
   WORD32  olddublvalue;
 
-  overflow = FALSE;
-  delimiter = line[lexterm];
-  from = lexstart;
+  as->overflow = FALSE;
+  as->delimiter = as->line[as->lexterm];
+  from = as->lexstart;
   dublvalue = initial_value;
 
-  while( from < lexterm )
+  while( from < as->lexterm )
   {
-    if( isdigit( line[from] ))
+    if( isdigit( as->line[from] ))
     {
       olddublvalue = dublvalue;
-      digit = (WORD32)( line[from++] - '0' );
+      digit = (WORD32)( as->line[from++] - '0' );
       dublvalue = dublvalue * 10 + digit;
       if( dublvalue < olddublvalue )
       {
-        overflow = TRUE;
+        as->overflow = TRUE;
       }
     }
     else
     {
-      errorLexeme( &not_a_number, from );
+      errorLexeme( as, &not_a_number, from );
       dublvalue = 0;
-      from = lexterm;
+      from = as->lexterm;
     }
   }
   return( dublvalue );
@@ -1878,65 +3259,67 @@ WORD32 evalDubl( WORD32 initial_value )
 /*  Synopsis:  Get the value of the current lexeme as a Floating Point const. */
 /*                                                                            */
 /******************************************************************************/
-void inputFltg()
+void inputFltg( ASM_T *as )
 {
   FLTG_T   *fltg;
   BOOL   scanning_line;
 
-  fltg_input = TRUE;            /* Set lexeme scanner for floating point.     */
+  as->fltg_input = TRUE;            /* Set lexeme scanner for floating point. */
   scanning_line = TRUE;
   while( TRUE )
   {
     while( scanning_line )
     {
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
         scanning_line = FALSE;
       }
       else
       {
-        switch( line[lexstart] )
+        switch( as->line[as->lexstart] )
         {
         case '/':
           scanning_line = FALSE;
           break;
 
         case ';':
-          nextLexeme();
+          nextLexeme( as );
           break;
 
         case '+':
-          delimiter = line[lexterm];
-          nextLexBlank();
+          as->delimiter = as->line[as->lexterm];
+          nextLexBlank( as );
         case '-':
         default:
-          if( isdigit( line[lexstart] ) || line[lexstart] == '-' )
+          if( isdigit( as->line[as->lexstart] )
+              || as->line[as->lexstart] == '-' )
           {
-            fltg = getFltgExprs();
-            punchOutObject( clc, ( fltg->exponent & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD32)(( fltg->mantissa >> 12 ) & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD32)( fltg->mantissa & 07777 ));
-            incrementClc();
+            fltg = getFltgExprs( as );
+            punchOutObject( as, as->clc, ( fltg->exponent & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc,
+                            (WORD32)(( fltg->mantissa >> 12 ) & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc, (WORD32)( fltg->mantissa & 07777 ));
+            incrementClc( as );
           }
           else
           {
-            fltg_input = FALSE; /* Reset lexeme scanner.                      */
+            as->fltg_input = FALSE; /* Reset lexeme scanner.                  */
             return;             /* Non-numeric input, back to assembly.       */
           }
           break;
         } /* end switch                                                       */
       } /* end if                                                             */
 
-      if( error_in_line )
+      if( as->error_in_line )
       {
-        fltg_input = FALSE;     /* Reset lexeme scanner.                      */
+        as->fltg_input = FALSE;     /* Reset lexeme scanner.                  */
         return;                 /* Error occurred, exit FLTG input mode.      */
       }
     } /* end while( scanning_line )                                           */
-    readLine();
-    nextLexeme();
+    readLine( as );
+    nextLexeme( as );
     scanning_line = TRUE;
   }
 } /* inputFltg()                                                              */
@@ -1949,21 +3332,21 @@ void inputFltg()
 /*  Synopsis:  Get a FLTG expression.                                         */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *getFltgExprs()
+FLTG_T *getFltgExprs( ASM_T *as )
 {
   FLTG_T *fltg;
 
-  fltg = getFltgExpr();
+  fltg = getFltgExpr( as );
 
   while( TRUE )
   {
-    if( isdone( line[lexstart] ))
+    if( isdone( as->line[as->lexstart] ))
     {
       return( fltg );
     }
     else
     {
-      errorMessage( &illegal_expression, lexstart - 1 );
+      errorMessage( as, &illegal_expression, as->lexstart - 1 );
       return( 0 );
     }
   } /* end while                                                              */
@@ -1978,19 +3361,19 @@ FLTG_T *getFltgExprs()
 /*             number is always considered to have a decimal radix.           */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *getFltgExpr()
+FLTG_T *getFltgExpr( ASM_T *as )
 {
   FLTG_T *fltg;
 
-  delimiter = line[lexterm];
-  fltg = evalFltg();
+  as->delimiter = as->line[as->lexterm];
+  fltg = evalFltg( as );
   /* Test for any value greater than 23 bits in length.                     */
   if( (unsigned long int)fltg->mantissa> 077777777L )
   {
-    errorMessage( &fltg_overflow, lexstart );
+    errorMessage( as, &fltg_overflow, as->lexstart );
   }
 
-  if( is_blank( delimiter ))
+  if( is_blank( as->delimiter ))
   {
     return( fltg );
   }
@@ -2000,15 +3383,15 @@ FLTG_T *getFltgExpr()
   while( TRUE )
   {
     /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
+    if( is_blank( as->delimiter ))
     {
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
       fltg = 0;
       return( fltg );
     }
 
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case '+':                   /* add                                        */
     case '-':                   /* subtract                                   */
@@ -2016,26 +3399,26 @@ FLTG_T *getFltgExpr()
     case '%':                   /* divide                                     */
     case '&':                   /* and                                        */
     case '!':                   /* or                                         */
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
       fltg = NULL;
       break;
 
     default:
-      if( isend( line[lexstart] ))
+      if( isend( as->line[as->lexstart] ))
       {
         return( fltg );
       }
 
-      switch( line[lexstart] )
+      switch( as->line[as->lexstart] )
       {
       case '/':
       case ';':
         break;
 
       default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
         fltg = NULL;
         break;
       }
@@ -2055,7 +3438,7 @@ FLTG_T *getFltgExpr()
 /*                +-ddd.dddE+-dd  where each d is a decimal digit.            */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *evalFltg()
+FLTG_T *evalFltg( ASM_T *as )
 {
   BYTE     current_state;
   BYTE     current_col;
@@ -2086,8 +3469,8 @@ FLTG_T *evalFltg()
                                        /* 11  Error state.                    */
   };
 
-  delimiter = line[lexterm];
-  fltg = &fltg_ac;
+  as->delimiter = as->line[as->lexterm];
+  fltg = &as->fltg_ac;
   fltg->exponent = 0;
   fltg->mantissa = 0;
   input_value = 0;
@@ -2100,7 +3483,7 @@ FLTG_T *evalFltg()
   while( TRUE )
   {
     /* Classify character.  This is the column index.                         */
-    switch( line[lexstart] )
+    switch( as->line[as->lexstart] )
     {
     case '+':
       current_col = 0;
@@ -2119,11 +3502,11 @@ FLTG_T *evalFltg()
       break;
 
     default:
-      if( isdigit( line[lexstart] ))
+      if( isdigit( as->line[as->lexstart] ))
       {
         current_col = 2;
       }
-      else if( isdone( line[lexstart] ))
+      else if( isdone( as->line[as->lexstart] ))
       {
         current_col = 5;
       }
@@ -2141,43 +3524,43 @@ FLTG_T *evalFltg()
     case 1:                             /*  -                                 */
       negate = TRUE;
     case 2:                             /*  +                                 */
-      delimiter = line[lexterm];        /* Move past the + or - character.    */
-      nextLexBlank();
+      as->delimiter = as->line[as->lexterm]; /* Move past the + or -.     */
+      nextLexBlank( as );
       break;
 
     case 3:                             /* Number  (+-ddd)                    */
-      input_value = evalDubl( 0 );      /* Integer part of the number.        */
-      nextLexeme();                     /* Move past previous lexeme.         */
+      input_value = evalDubl( as, 0 );      /* Integer part of the number.    */
+      nextLexeme( as );                     /* Move past previous lexeme.     */
       break;
 
     case 4:
-      delimiter = line[lexterm];
-      nextLexBlank();                   /* Move past the . character.         */
+      as->delimiter = as->line[as->lexterm];
+      nextLexBlank( as );                   /* Move past the . character.     */
       break;
 
     case 5:                             /* .  (+-ddd.ddd)                     */
                                         /* Fractional part of the number.     */
-      input_value = evalDubl( input_value );
-      right_digits = lexterm - lexstart;/* Digit count to right of decimal.   */
-      nextLexeme();                     /* Move past previous lexeme.         */
+      input_value = evalDubl( as, input_value );
+      right_digits = as->lexterm - as->lexstart; /* Digits right of the . */
+      nextLexeme( as );                     /* Move past previous lexeme.     */
       break;
 
     case 6:                             /* E  (+-ddd.dddE)                    */
-      delimiter = line[lexterm];        /* Move past the E.                   */
-      nextLexBlank();
+      as->delimiter = as->line[as->lexterm];        /* Move past the E.       */
+      nextLexBlank( as );
       break;
 
     case 7:                             /* -  (+-ddd.dddE-)                   */
       negate_exponent = TRUE;
     case 8:                             /* +  (+-ddd.dddE+)                   */
-      delimiter = line[lexterm];        /* Move past the + or - character.    */
-      nextLexBlank();
+      as->delimiter = as->line[as->lexterm]; /* Move past the + or -.     */
+      nextLexBlank( as );
       break;
 
     case 9:                             /* #  (+-ddd.dddE+-dd)                */
-      exponent = (int)evalDubl( 0 );    /* Exponent of floating point number. */
+      exponent = (int)evalDubl( as, 0 );  /* Exponent of the number.       */
       if( negate_exponent ) { exponent = - exponent; }
-      nextLexeme();                     /* Move past previous lexeme.         */
+      nextLexeme( as );                     /* Move past previous lexeme.     */
       break;
 
     case 10:                            /* Floating number parsed, convert    */
@@ -2286,14 +3669,14 @@ void normalizeFltg( FLTG_T *fltg )
 /*             the literal tables.                                            */
 /*                                                                            */
 /******************************************************************************/
-WORD32 incrementClc()
+WORD32 incrementClc( ASM_T *as )
 {
-  testForLiteralCollision( clc );
+  testForLiteralCollision( as, as->clc );
 
   /* Incrementing the location counter is not to change field setting.        */
-  clc = ( clc & 070000 ) + (( clc + 1 ) & 07777 );
-  fieldlc = clc & 07777;
-  return( clc );
+  as->clc = ( as->clc & 070000 ) + (( as->clc + 1 ) & 07777 );
+  as->fieldlc = as->clc & 07777;
+  return( as->clc );
 } /* incrementClc()                                                           */
 
 
@@ -2304,7 +3687,7 @@ WORD32 incrementClc()
 /*  Synopsis:  Test the given location for collision with the literal tables. */
 /*                                                                            */
 /******************************************************************************/
-BOOL testForLiteralCollision( WORD32 loc )
+BOOL testForLiteralCollision( ASM_T *as, WORD32 loc )
 {
   WORD32  pagelc;
   WORD32  pageno;
@@ -2315,19 +3698,19 @@ BOOL testForLiteralCollision( WORD32 loc )
 
   if( pageno == 0 )
   {
-    if( pagelc >= lit_loc[pageno] && !pz.error )
+    if( pagelc >= as->lit_loc[pageno] && !as->pz.error )
     {
-      errorMessage( &pz_literal_overflow, -1 );
-      pz.error = TRUE;
+      errorMessage( as, &pz_literal_overflow, -1 );
+      as->pz.error = TRUE;
       result = TRUE;
     }
   }
   else
   {
-    if( pagelc >= lit_loc[pageno] && !cp.error )
+    if( pagelc >= as->lit_loc[pageno] && !as->cp.error )
     {
-      errorMessage( &literal_overflow, -1 );
-      cp.error = TRUE;
+      errorMessage( as, &literal_overflow, -1 );
+      as->cp.error = TRUE;
       result = TRUE;
     }
   }
@@ -2342,283 +3725,974 @@ BOOL testForLiteralCollision( WORD32 loc )
 /*  Synopsis:  Get next line of input.  Print previous line if needed.        */
 /*                                                                            */
 /******************************************************************************/
-void readLine()
+void readLine( ASM_T *as )
 {
+  char   *end;
   BOOL    ffseen;
   WORD32  ix;
   WORD32  iy;
+  int     length;
   char    mc;
-  char    inpline[LINELEN];
+  char   *text;
 
-  listLine();                   /* List previous line if needed.              */
-  indirect_generated = FALSE;   /* Mark no indirect address generated.        */
-  error_in_line = FALSE;        /* No error in line.                          */
+  listLine( as );                   /* List previous line if needed.          */
+  as->line_kept = NULL;
+  as->indirect_generated = FALSE;   /* Mark no indirect address generated.    */
+  as->error_in_line = FALSE;        /* No error in line.                      */
 
-  if( mac_ptr && ( *mac_ptr == '\0' )) /* End of macro?                       */
+  if( as->mac_ptr && ( *as->mac_ptr == '\0' )) /* End of macro?               */
   {
-    mac_ptr = NULL;
-    for( ix = 0; ix < LINELEN; ix++ )
-    {
-      line[ix] = mac_line[ix];  /* Restore invoking line.                     */
-    }
-    cc = lexstartprev = mac_cc; /* Restore cc.                                */
-    maxcc = strlen( line );     /* Restore maxcc.                             */
-    listed = TRUE;              /* Already listed.                            */
+    as->mac_ptr = NULL;
+    as->line = as->mac_line;            /* Restore invoking line.             */
+    as->cc = as->lexstartprev = as->mac_cc; /* Restore cc.                    */
+    as->lexeme_line = -1;           /* Its remaining lexemes are not cached.  */
+    as->maxcc = strlen( as->line );     /* Restore maxcc.                     */
+    as->listed = TRUE;              /* Already listed.                        */
     return;
   }
 
-  cc = 0;                       /* Initialize column counter.                 */
-  lexstartprev = 0;
-  if( mac_ptr )                 /* Inside macro? */
+  as->cc = 0;                       /* Initialize column counter.             */
+  as->lexstartprev = 0;
+  if( as->mac_ptr )                 /* Inside macro? */
   {
-    maxcc = 0;
+    as->lexeme_line = -1;           /* Macro expansions are not cached.       */
+    as->maxcc = 0;
     do
     {
-      mc = *mac_ptr++;          /* Next character.                            */
-      if( islower( mc ))        /* Encoded argument number?                   */
+      if( as->maxcc + 2 > as->linebuf_room )
+      {
+        as->linebuf = (char *) growTable( as->linebuf, &as->linebuf_room,
+                                          sizeof( char ), as->maxcc + 2 );
+      }
+      mc = *as->mac_ptr++;          /* Next character.                        */
+      if( islower( mc ))        /* Encoded argument number?                   */
       {
         ix = mc - 'a';          /* Convert to index.                          */
-        if( iy = mac_arg_pos[ix] )
+        if( iy = as->mac_arg_pos[ix] )
         {
           do                    /* Copy argument string.                      */
             {
-              line[maxcc++] = mac_line[iy++];
-            } while(( mac_line[iy] != ',' ) && ( !is_blank( mac_line[iy] )) &&
-                    ( !isend( mac_line[iy] )));
+              if( as->maxcc + 2 > as->linebuf_room )
+              {
+                as->linebuf = (char *) growTable( as->linebuf,
+                                                  &as->linebuf_room,
+                                                  sizeof( char ),
+                                                  as->maxcc + 2 );
+              }
+              as->linebuf[as->maxcc++] = as->mac_line[iy++];
+            } while(( as->mac_line[iy] != ',' ) &&
+                    ( !is_blank( as->mac_line[iy] )) &&
+                    ( !isend( as->mac_line[iy] )));
         }
       }
       else                      /* Ordinary character, just copy.             */
       {
-      line[maxcc++] = mc;
+      as->linebuf[as->maxcc++] = mc;
       }
     } while( !isend( mc ));
-    line[maxcc] = '\0';
-    listed = nomac_exp;
+    as->linebuf[as->maxcc] = '\0';
+    as->line = as->linebuf;
+    as->listed = as->nomac_exp;
+    return;
+  }
+
+  as->lineno++;                         /* Count lines read.                  */
+  as->listed = FALSE;                   /* Mark as not listed.                */
+
+  /* Pass 2 replays the lines read in pass 1 instead of reading them again.   */
+  if( as->pass == 2 && replayLine( as ))
+  {
     return;
   }
+  /* Take the next line, however long, from the mapped input files.          */
+  while( as->filix_curr < as->save_argc
+         && as->srcpos >= as->srcfiles[as->filix_curr].size )
+  {
+    as->filix_curr++;                   /* Advance to next file.              */
+    as->srcpos = 0;
+  }
+  if( as->filix_curr >= as->save_argc )
+  {
+    as->line = "$\n";
+    as->maxcc = 2;
+    ffseen = FALSE;
+  }
+  else
+  {
+    text = as->srcfiles[as->filix_curr].text + as->srcpos;
+    length = as->srcfiles[as->filix_curr].size - as->srcpos;
+    if(( end = (char *) memchr( text, '\n', length )) != NULL )
+    {
+      length = end - text + 1;
+    }
+    as->srcpos += length;
+    ffseen = takeLine( as, text, length );
+  }
+
+  if( ffseen )
+  {
+    listNewPage( as, LISTREC_FORMFEED );
+  }
+
+  if( as->pass == 1 )
+  {
+    cacheLine( as, ffseen );
+  }
+} /* readLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  takeLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Make the length characters of input at text the current line.  */
+/*             The line is used where it is unless it has a form feed, a      */
+/*             CR-LF or no newline at its end.  Only then is it rewritten,    */
+/*             into the arena.  A NUL ends the line, as it ended the string   */
+/*             read by fgets().  Form feeds are dropped from the line, and    */
+/*             TRUE is returned if there was one.  Tabs are left in the line  */
+/*             for the lexer.                                                 */
+/*                                                                            */
+/******************************************************************************/
+BOOL takeLine( ASM_T *as, char *text, int length )
+{
+  char   *end;
+  BOOL    ffseen;
+  int     ix;
+  int     iy;
 
-  lineno++;                         /* Count lines read.                      */
-  listed = FALSE;                   /* Mark as not listed.                    */
-READ_LINE:
-  if(( fgets( inpline, LINELEN - 1, infile )) == NULL )
+  if(( end = (char *) memchr( text, '\0', length )) != NULL )
+  {
+    length = end - text;
+  }
+  if( length > 0 && text[length - 1] == '\n' &&
+      !( length > 1 && text[length - 2] == '\r' ) &&
+      memchr( text, '\f', length ) == NULL )
+  {
+    as->line = text;
+    as->maxcc = length;
+    return( FALSE );
+  }
+
+  as->line = arenaAlloc( as, length + 1 );
+  ffseen = FALSE;
+  for( ix = 0, iy = 0; ix < length; ix++ )
+  {
+    if( text[ix] == '\f' )
+    {
+      ffseen = TRUE;
+    }
+    else
+    {
+      as->line[iy] = text[ix];
+      iy++;
+    }
+  }
+  as->line[iy] = '\0';
+
+  /* If the line is terminated by CR-LF, remove, the CR.                      */
+  if( iy > 1 && as->line[iy - 2] == '\r' )
+  {
+    iy--;
+    as->line[iy - 1] = as->line[iy - 0];
+    as->line[iy] = '\0';
+  }
+  as->maxcc = iy;                   /* Save the current line length.          */
+  return( ffseen );
+} /* takeLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  cacheLine                                                      */
+/*                                                                            */
+/*  Synopsis:  Keep the line just read in pass 1 for replayLine() in pass 2,  */
+/*             with flag set if it had a form feed in it.                     */
+/*             Its lexemes are added by nextLexeme() as they are found.       */
+/*                                                                            */
+/******************************************************************************/
+void cacheLine( ASM_T *as, BOOL flag )
+{
+  SRCLINE_T *src;
+
+  as->srclines = (SRCLINE_T *) growTable( as->srclines, &as->srcline_room,
+                                          sizeof( SRCLINE_T ),
+                                          as->srcline_count + 1 );
+
+  /* The line is in the mapped input or in the arena, so it stays put.        */
+  src = &as->srclines[as->srcline_count];
+  src->text = as->line;
+  src->length = as->maxcc;
+  src->lexeme = as->lexeme_count;
+  src->lexemes = 0;
+  src->expr = as->coded_count;
+  src->exprs = 0;
+  src->formfeed = flag;
+  as->lexeme_line = as->srcline_count++;
+} /* cacheLine()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  replayLine                                                     */
+/*                                                                            */
+/*  Synopsis:  Get the next line cached by pass 1.  Returns FALSE when there  */
+/*             are no more, and the input file must be read from where pass 1 */
+/*             stopped.                                                       */
+/*                                                                            */
+/******************************************************************************/
+BOOL replayLine( ASM_T *as )
+{
+  SRCLINE_T *src;
+
+  if( as->srcline_next >= as->srcline_count )
+  {
+    as->lexeme_line = -1;
+    return( FALSE );
+  }
+  as->lexeme_line = as->srcline_next++;
+  src = &as->srclines[as->lexeme_line];
+  as->line = src->text;
+  as->maxcc = src->length;
+  as->lexeme_next = src->lexeme;
+  as->coded_next = src->expr;
+  if( src->formfeed )
+  {
+    listNewPage( as, LISTREC_FORMFEED );
+  }
+  return( TRUE );
+} /* replayLine()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  growTable                                                      */
+/*                                                                            */
+/*  Synopsis:  Make room in table for at least need entries of size bytes,    */
+/*             doubling the room it has.  Returns the possibly moved table.   */
+/*                                                                            */
+/******************************************************************************/
+void *growTable( void *table, int *room, int size, int need )
+{
+  int  newroom;
+
+  if( need <= *room )
+  {
+    return( table );
+  }
+  for( newroom = ( *room == 0 ) ? 1024 : 2 * *room; newroom < need; )
+  {
+    newroom *= 2;
+  }
+  if(( table = realloc( table, (size_t) size * newroom )) == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for source cache.\n");
+    exit( -1 );
+  }
+  *room = newroom;
+  return( table );
+} /* growTable()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  arenaAlloc                                                     */
+/*                                                                            */
+/*  Synopsis:  Return room for size characters of a rewritten line.  It is    */
+/*             taken from blocks which are never moved, and only freed with   */
+/*             the context, so lines kept by cacheLine() stay valid.          */
+/*                                                                            */
+/******************************************************************************/
+char *arenaAlloc( ASM_T *as, int size )
+{
+  char   *text;
+
+  if( size > as->arena_left )
+  {
+    as->arena_left = ( size > ARENA_BLOCK ) ? size : ARENA_BLOCK;
+    if(( as->arena = (char *) malloc( as->arena_left )) == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for source cache.\n");
+      exit( -1 );
+    }
+    as->arena_blocks = (char **) growTable( as->arena_blocks,
+                                            &as->arena_block_room,
+                                            sizeof( char * ),
+                                            as->arena_block_count + 1 );
+    as->arena_blocks[as->arena_block_count++] = as->arena;
+  }
+  text = as->arena;
+  as->arena += size;
+  as->arena_left -= size;
+  return( text );
+} /* arenaAlloc()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  mapSource                                                      */
+/*                                                                            */
+/*  Synopsis:  Map an input file into memory for the whole assembly, and      */
+/*             return its address with its size in *size.  A file that can   */
+/*             not be mapped, such as a pipe, is read into memory instead,    */
+/*             and *mapped tells which.  An empty file is "", neither mapped  */
+/*             nor allocated.  Returns NULL if the file cannot be opened.     */
+/*                                                                            */
+/******************************************************************************/
+char *mapSource( char *path, long *size, BOOL *mapped )
+{
+  int          fd;
+  FILE        *file;
+  size_t       got;
+  int          room;
+  struct stat  st;
+  char        *text;
+
+  *mapped = FALSE;
+  if(( fd = open( path, O_RDONLY )) < 0 )
+  {
+    return( NULL );
+  }
+  if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ))
+  {
+    *size = (long) st.st_size;
+    if( *size == 0 )
+    {
+      close( fd );
+      return( "" );
+    }
+    text = (char *) mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( text != (char *) MAP_FAILED )
+    {
+      close( fd );
+      *mapped = TRUE;
+      return( text );
+    }
+  }
+
+  if(( file = fdopen( fd, "r" )) == NULL )
+  {
+    close( fd );
+    return( NULL );
+  }
+  for( *size = 0, room = 0, text = NULL; ; *size += got )
+  {
+    text = (char *) growTable( text, &room, sizeof( char ), *size + 4096 );
+    if(( got = fread( &text[*size], 1, room - *size, file )) == 0 )
+    {
+      break;
+    }
+  }
+  fclose( file );
+  if( *size == 0 )
+  {
+    free( text );
+    return( "" );
+  }
+  return( text );
+} /* mapSource()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Output a line to the listing file.                             */
+/*                                                                            */
+/******************************************************************************/
+void listLine( ASM_T *as )
+/* generate a line of listing if not already done!                            */
+{
+  if( as->listfile != NULL && as->listed == FALSE )
+  {
+    printLine( as, as->line, 0, 0, LINE );
+  }
+} /* listLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printPageBreak                                                 */
+/*                                                                            */
+/*  Synopsis:  Output a Top of Form and listing header if new page necessary. */
+/*                                                                            */
+/******************************************************************************/
+void printPageBreak( ASM_T *as )
+{
+  if( as->page_lineno >= LIST_LINES_PER_PAGE )
+         /*  ( list_lineno % LIST_LINES_PER_PAGE ) == 0 ) */
   {
-    filix_curr++;                   /* Advance to next file.                  */
-    if( filix_curr < save_argc )    /* More files?                            */
+    if( !as->list_title_set )
     {
-      fclose( infile );
-      if(( infile = fopen( save_argv[filix_curr], "r" )) == NULL )
+      expandTabs( as->list_title, as->line, sizeof( as->list_title ));
+      if( as->list_title[strlen(as->list_title) - 1] == '\n' )
       {
-        fprintf( stderr, "%s: cannot open \"%s\"\n", save_argv[0],
-          save_argv[filix_curr] );
-        exit( -1 );
+        as->list_title[strlen(as->list_title) - 1] = '\0';
+      }
+      if( strlen( as->list_title ) > TITLELEN )
+      {
+        as->list_title[TITLELEN] = '\0';
       }
-      goto READ_LINE;
+      as->list_title_set = TRUE;
     }
-    else
+    topOfForm( as, as->list_title, NULL );
+
+  }
+} /* printPageBreak()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printLine                                                      */
+/*                                                                            */
+/*  Synopsis:  Record a line for the listing, with the errors saved for it.   */
+/*             renderListing() makes the text, with new pages as necessary.   */
+/*             A line of a macro expansion is copied, as its buffer is reused.*/
+/*                                                                            */
+/******************************************************************************/
+void printLine( ASM_T *as, char *line, WORD32 loc, WORD32 val,
+                LINESTYLE_T linestyle )
+{
+  LISTREC_T *rec;
+
+  if( as->listfile == NULL )
+  {
+    as->save_error_count = 0;
+    return;
+  }
+
+  if( line == as->linebuf || line == as->mac_line )
+  {
+    if( as->line_kept == NULL )
     {
-      inpline[0] = '$';
-      inpline[1] = '\n';
-      inpline[2] = '\0';
+      as->line_kept = arenaAlloc( as, strlen( line ) + 1 );
+      strcpy( as->line_kept, line );
     }
+    line = as->line_kept;
+  }
+  rec = addListRecord( as, linestyle, line, as->lineno );
+  rec->loc = loc;
+  rec->val = val;
+  rec->indirect = as->indirect_generated && as->lgm_flag;
+  rec->listed = ( as->listed != FALSE );
+  if( linestyle != LOC_VAL )
+  {
+    as->listed = TRUE;
   }
+  printErrorMessages( as );
+} /* printLine()                                                              */
 
-  /* Remove any tabs from the input line by inserting the required number     */
-  /* of spaces to simulate 8 character tab stops.                             */
-  ffseen = FALSE;
-  for( ix = 0, iy = 0; inpline[ix] != '\0'; ix++ )
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addListRecord                                                  */
+/*                                                                            */
+/*  Synopsis:  Add a record to the listing.  The first one also keeps the     */
+/*             page line and the title, which the rendering starts from.      */
+/*                                                                            */
+/******************************************************************************/
+LISTREC_T *addListRecord( ASM_T *as, int style, char *text, int num )
+{
+  LISTREC_T *rec;
+
+  if( as->listrec_count == 0 )
+  {
+    as->listrec_page_lineno = as->page_lineno;
+    memcpy( as->listrec_title, as->list_title, sizeof( as->list_title ));
+    as->listrec_title_set = as->list_title_set;
+  }
+  as->listrecs = (LISTREC_T *) growTable( as->listrecs, &as->listrec_room,
+                                          sizeof( LISTREC_T ),
+                                          as->listrec_count + 1 );
+  rec = &as->listrecs[as->listrec_count++];
+  rec->text = text;
+  rec->num = num;
+  rec->loc = 0;
+  rec->val = 0;
+  rec->style = (BYTE) style;
+  rec->indirect = FALSE;
+  rec->listed = FALSE;
+  return( rec );
+} /* addListRecord()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listNewPage                                                    */
+/*                                                                            */
+/*  Synopsis:  Start a new page of the listing for an EJECT or a form feed in */
+/*             the source.  It is recorded even while UNLIST has turned the   */
+/*             listing off, as the page is still due after it.                */
+/*                                                                            */
+/******************************************************************************/
+void listNewPage( ASM_T *as, int style )
+{
+  if( as->listfile != NULL || as->listsave != NULL )
+  {
+    addListRecord( as, style, NULL, 0 );
+  }
+  else if( style == LISTREC_EJECT )
+  {
+    as->page_lineno = LIST_LINES_PER_PAGE;
+  }
+  else if( as->list_title_set )
+  {
+    topOfForm( as, as->list_title, NULL );
+  }
+} /* listNewPage()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listTitle                                                      */
+/*                                                                            */
+/*  Synopsis:  Start a new page of the listing for a TITLE, which has put the */
+/*             count characters of the new title over the old one in          */
+/*             list_title.  Recorded like listNewPage().                      */
+/*                                                                            */
+/******************************************************************************/
+void listTitle( ASM_T *as, int count )
+{
+  char   *title;
+
+  if( as->listfile != NULL || as->listsave != NULL )
+  {
+    as->listtitles = growTable( as->listtitles, &as->listtitle_room,
+                                TITLELEN + 2, as->listtitle_count + 1 );
+    title = &as->listtitles[as->listtitle_count * ( TITLELEN + 2 )];
+    memcpy( title, as->list_title, count );
+    title[count] = '\0';
+    addListRecord( as, LISTREC_TITLE, NULL, as->listtitle_count );
+    as->listtitle_count++;
+  }
+  else
+  {
+    as->page_lineno = LIST_LINES_PER_PAGE;
+  }
+  as->list_title_set = TRUE;
+} /* listTitle()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  renderListing                                                  */
+/*                                                                            */
+/*  Synopsis:  Make the text of the listing recorded in pass 2, with a new    */
+/*             page where necessary, and forget the records.                  */
+/*                                                                            */
+/******************************************************************************/
+void renderListing( ASM_T *as )
+{
+  char      *line;
+  LISTREC_T *rec;
+  char      *title;
+
+  if( as->listrec_count == 0 )
+  {
+    return;
+  }
+  line = as->line;
+  as->page_lineno = as->listrec_page_lineno;
+  memcpy( as->list_title, as->listrec_title, sizeof( as->list_title ));
+  as->list_title_set = as->listrec_title_set;
+
+  for( rec = as->listrecs; rec < as->listrecs + as->listrec_count; rec++ )
   {
-    switch( inpline[ix] )
+    switch( rec->style )
     {
-    case '\t':
-      do
+    case LISTREC_TITLE:
+      title = &as->listtitles[rec->num * ( TITLELEN + 2 )];
+      memcpy( as->list_title, title, strlen( title ));
+      if( strlen( as->list_title ) > TITLELEN )
       {
-        line[iy] = ' ';
-        iy++;
+        as->list_title[TITLELEN] = '\0';
       }
-      while(( iy % 8 ) != 0 );
+      as->page_lineno = LIST_LINES_PER_PAGE;
+      as->list_title_set = TRUE;
       break;
 
-    case '\f':
-      if( !ffseen && list_title_set ) topOfForm( list_title, NULL );
-      ffseen = TRUE;
+    case LISTREC_EJECT:
+      as->page_lineno = LIST_LINES_PER_PAGE;
       break;
-      
+
+    case LISTREC_FORMFEED:
+      if( as->list_title_set )
+      {
+        topOfForm( as, as->list_title, NULL );
+      }
+      break;
+
+    case LISTREC_ERROR:
+      printPageBreak( as );
+      listField( as, rec->text, 18 );
+      if( rec->num >= 0 )
+      {
+        listSpaces( as, rec->num );
+        listChars( as, "^", 1 );
+        as->list_lineno++;
+        as->page_lineno++;
+      }
+      listChars( as, "\n", 1 );
+      break;
+
     default:
-      line[iy] = inpline[ix];
-      iy++;
+    case LINE:
+      as->line = rec->text;         /* An untitled first page is titled by it.*/
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, rec->num, 5 );
+      listSpaces( as, 13 );
+      putLine( as, rec->text );
+      break;
+
+    case LINE_VAL:
+      as->line = rec->text;
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      if( !rec->listed )
+      {
+        listDecimal( as, rec->num, 5 );
+        listSpaces( as, 7 );
+        listOctal( as, rec->val, 4 );
+        listSpaces( as, 2 );
+        putLine( as, rec->text );
+      }
+      else
+      {
+        listSpaces( as, 12 );
+        listOctal( as, rec->val, 4 );
+        listChars( as, "\n", 1 );
+      }
+      break;
+
+    case LINE_LOC_VAL:
+      as->line = rec->text;
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      if( !rec->listed )
+      {
+        listDecimal( as, rec->num, 5 );
+        listSpaces( as, 1 );
+        listOctal( as, rec->loc, 5 );
+        listSpaces( as, 1 );
+        listOctal( as, rec->val, 4 );
+        listChars( as, ( rec->indirect ? "@ " : "  " ), 2 );
+        putLine( as, rec->text );
+      }
+      else
+      {
+        listSpaces( as, 6 );
+        listOctal( as, rec->loc, 5 );
+        listSpaces( as, 1 );
+        listOctal( as, rec->val, 4 );
+        listChars( as, "\n", 1 );
+      }
+      break;
+
+    case LOC_VAL:
+      as->line = rec->text;
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listSpaces( as, 6 );
+      listOctal( as, rec->loc, 5 );
+      listSpaces( as, 1 );
+      listOctal( as, rec->val, 4 );
+      listChars( as, "\n", 1 );
+      break;
+    }
+  }
+
+  as->line = line;
+  as->listrec_count = 0;
+  as->listtitle_count = 0;
+} /* renderListing()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  putLine                                                        */
+/*                                                                            */
+/*  Synopsis:  Write a line, up to and including its newline, to the listing  */
+/*             with its tabs expanded to 8 character tab stops.               */
+/*                                                                            */
+/******************************************************************************/
+void putLine( ASM_T *as, char *text )
+{
+  int     col;
+  int     length;
+
+  col = 0;
+  while( TRUE )
+  {
+    length = strcspn( text, "\t\n" );
+    listChars( as, text, length );
+    col += length;
+    text += length;
+    if( *text != '\t' )
+    {
       break;
     }
+    listSpaces( as, 8 - col % 8 );
+    col += 8 - col % 8;
+    text++;
   }
-  line[iy] = '\0';
+  if( *text == '\n' )
+  {
+    listChars( as, "\n", 1 );
+  }
+} /* putLine()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  copyLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Copy a line, up to and including its newline, into a buffer of */
+/*             size characters as a NUL terminated string.  The line may      */
+/*             already be in the buffer.                                      */
+/*                                                                            */
+/******************************************************************************/
+void copyLine( char *to, char *from, int size )
+{
+  int     length;
+
+  length = strcspn( from, "\n" );
+  length += ( from[length] == '\n' );
+  length = ( length < size ) ? length : size - 1;
+  memmove( to, from, length );
+  to[length] = '\0';
+} /* copyLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listChars                                                      */
+/*                                                                            */
+/*  Synopsis:  Put length characters into the listing buffer, writing it to   */
+/*             the listing file whenever it fills.                            */
+/*                                                                            */
+/******************************************************************************/
+void listChars( ASM_T *as, char *text, int length )
+{
+  int     room;
+
+  while( length > 0 )
+  {
+    if( as->listout_count == LIST_BUFFER )
+    {
+      flushList( as );
+    }
+    room = LIST_BUFFER - as->listout_count;
+    room = ( room < length ) ? room : length;
+    memcpy( &as->listout[as->listout_count], text, room );
+    as->listout_count += room;
+    text += room;
+    length -= room;
+  }
+} /* listChars()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listSpaces                                                     */
+/*                                                                            */
+/*  Synopsis:  Put count spaces into the listing buffer.                      */
+/*                                                                            */
+/******************************************************************************/
+void listSpaces( ASM_T *as, int count )
+{
+  static char spaces[] = "                                ";
 
-  /* If the line is terminated by CR-LF, remove, the CR.                      */
-  if( line[iy - 2] == '\r' )
+  for( ; count > 32; count -= 32 )
   {
-    iy--;
-    line[iy - 1] = line[iy - 0];
-    line[iy] = '\0';
+    listChars( as, spaces, 32 );
   }
-  maxcc = iy;                   /* Save the current line length.              */
-} /* readLine()                                                               */
+  listChars( as, spaces, count );
+} /* listSpaces()                                                             */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  listLine                                                       */
+/*  Function:  listDecimal                                                    */
 /*                                                                            */
-/*  Synopsis:  Output a line to the listing file.                             */
+/*  Synopsis:  Put a number into the listing buffer in decimal, right         */
+/*             justified in width columns, as printf() does for "%*d".        */
 /*                                                                            */
 /******************************************************************************/
-void listLine()
-/* generate a line of listing if not already done!                            */
+void listDecimal( ASM_T *as, int value, int width )
 {
-  if( listfile != NULL && listed == FALSE )
+  char          digits[12];
+  int           ix;
+  unsigned int  magnitude;
+
+  magnitude = ( value < 0 ) ? 0U - (unsigned int) value : (unsigned int) value;
+  ix = sizeof( digits );
+  do
   {
-    printLine( line, 0, 0, LINE );
+    digits[--ix] = '0' + magnitude % 10;
+    magnitude /= 10;
   }
-} /* listLine()                                                               */
+  while( magnitude > 0 );
+  if( value < 0 )
+  {
+    digits[--ix] = '-';
+  }
+  listSpaces( as, width - ( (int) sizeof( digits ) - ix ));
+  listChars( as, &digits[ix], sizeof( digits ) - ix );
+} /* listDecimal()                                                            */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printPageBreak                                                 */
+/*  Function:  listOctal                                                      */
 /*                                                                            */
-/*  Synopsis:  Output a Top of Form and listing header if new page necessary. */
+/*  Synopsis:  Put a number into the listing buffer in octal with at least    */
+/*             digits digits, as printf() does for "%*.*o".                   */
 /*                                                                            */
 /******************************************************************************/
-void printPageBreak()
+void listOctal( ASM_T *as, unsigned int value, int digits )
 {
-  if( page_lineno >= LIST_LINES_PER_PAGE )
-         /*  ( list_lineno % LIST_LINES_PER_PAGE ) == 0 ) */
-  {
-    if( !list_title_set )
-    {
-      strcpy( list_title, line );
-      if( list_title[strlen(list_title) - 1] == '\n' )
-      {
-        list_title[strlen(list_title) - 1] = '\0';
-      }
-      if( strlen( list_title ) > TITLELEN )
-      {
-        list_title[TITLELEN] = '\0';
-      }
-      list_title_set = TRUE;
-    }
-    topOfForm( list_title, NULL );
+  char    octal[12];
+  int     ix;
 
+  ix = sizeof( octal );
+  do
+  {
+    octal[--ix] = '0' + ( value & 07 );
+    value >>= 3;
   }
-} /* printPageBreak()                                                         */
+  while( value > 0 || (int) sizeof( octal ) - ix < digits );
+  listChars( as, &octal[ix], sizeof( octal ) - ix );
+} /* listOctal()                                                              */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printLine                                                      */
+/*  Function:  listField                                                      */
 /*                                                                            */
-/*  Synopsis:  Output a line to the listing file with new page if necessary.  */
+/*  Synopsis:  Put a string into the listing buffer left justified in width   */
+/*             columns and cut to them, as printf() does for "%-*.*s".        */
 /*                                                                            */
 /******************************************************************************/
-void printLine( char *line, WORD32 loc, WORD32 val, LINESTYLE_T linestyle )
+void listField( ASM_T *as, char *text, int width )
 {
-  if( listfile == NULL )
+  int     length;
+
+  for( length = 0; length < width && text[length] != '\0'; length++ )
   {
-    save_error_count = 0;
-    return;
+    ;
   }
+  listChars( as, text, length );
+  listSpaces( as, width - length );
+} /* listField()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listFormat                                                     */
+/*                                                                            */
+/*  Synopsis:  Put a line formatted by printf() into the listing buffer, for  */
+/*             the few lines that are not listed often.                       */
+/*                                                                            */
+/******************************************************************************/
+void listFormat( ASM_T *as, char *format, ... )
+{
+  va_list args;
+  char    text[256];
+  int     length;
 
-  printPageBreak();
+  va_start( args, format );
+  length = vsnprintf( text, sizeof( text ), format, args );
+  va_end( args );
+  listChars( as, text, ( length < (int) sizeof( text ))
+                       ? length : (int) sizeof( text ) - 1 );
+} /* listFormat()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  flushList                                                      */
+/*                                                                            */
+/*  Synopsis:  Write the listing buffer to the listing file, all at once.     */
+/*                                                                            */
+/******************************************************************************/
+void flushList( ASM_T *as )
+{
+  FILE   *list;
 
-  list_lineno++;
-  page_lineno++;
-  switch( linestyle )
+  list = ( as->listfile != NULL ) ? as->listfile : as->listsave;
+  if( as->listout_count > 0 && list != NULL )
   {
-  default:
-  case LINE:
-    fprintf( listfile, "%5d             ", lineno );
-    fputs( line, listfile );
-    listed = TRUE;
-    break;
+    fwrite( as->listout, 1, as->listout_count, list );
+  }
+  as->listout_count = 0;
+} /* flushList()                                                              */
 
-  case LINE_VAL:
-    if( !listed )
-    {
-      fprintf( listfile, "%5d       %4.4o  ", lineno, val );
-      fputs( line, listfile );
-      listed = TRUE;
-    }
-    else
-    {
-      fprintf( listfile, "            %4.4o\n", val );
-    }
-    break;
 
-  case LINE_LOC_VAL:
-    if( !listed )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  expandTabs                                                     */
+/*                                                                            */
+/*  Synopsis:  Copy a line, up to and including its newline, into a buffer of */
+/*             size characters as a NUL terminated string, with its tabs      */
+/*             expanded to 8 character tab stops.                             */
+/*                                                                            */
+/******************************************************************************/
+void expandTabs( char *to, char *from, int size )
+{
+  int     ix;
+  int     iy;
+
+  for( ix = 0, iy = 0; iy < size - 1 && from[ix] != '\0'; ix++ )
+  {
+    if( from[ix] == '\t' )
     {
-      if( indirect_generated && lgm_flag )
-      {
-        fprintf( listfile, "%5d %5.5o %4.4o@ ", lineno, loc, val );
-      }
-      else
+      do
       {
-        fprintf( listfile, "%5d %5.5o %4.4o  ", lineno, loc, val );
+        to[iy] = ' ';
+        iy++;
       }
-      fputs( line, listfile );
-      listed = TRUE;
+      while(( iy % 8 ) != 0 && iy < size - 1 );
     }
     else
     {
-      fprintf( listfile, "      %5.5o %4.4o\n", loc, val );
+      to[iy] = from[ix];
+      iy++;
+      if( from[ix] == '\n' )
+      {
+        break;
+      }
     }
-    break;
-
-  case LOC_VAL:
-    fprintf( listfile, "      %5.5o %4.4o\n", loc, val );
-    break;
   }
-  printErrorMessages();
-} /* printLine()                                                              */
+  to[iy] = '\0';
+} /* expandTabs()                                                             */
 
 
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  printErrorMessages                                             */
 /*                                                                            */
-/*  Synopsis:  Output any error messages from the current list of errors.     */
+/*  Synopsis:  Record any error messages from the current list of errors.     */
 /*                                                                            */
 /******************************************************************************/
-void printErrorMessages()
+void printErrorMessages( ASM_T *as )
 {
-  WORD32  ix;
   WORD32  iy;
 
-  if( listfile != NULL )
+  if( as->listfile != NULL )
   {
-    /* If any errors, display them now.                                       */
-    for( iy = 0; iy < save_error_count; iy++ )
+    /* If any errors, list them now.                                          */
+    for( iy = 0; iy < as->save_error_count; iy++ )
     {
-      printPageBreak();
-      fprintf( listfile, "%-18.18s", error_list[iy].mesg );
-      if( error_list[iy].col >= 0 )
-      {
-        for( ix = 0; ix < error_list[iy].col; ix++ )
-        {
-          if( line[ix] == '\t' )
-          {
-            putc( '\t', listfile );
-          }
-          else
-          {
-            putc( ' ', listfile );
-          }
-        }
-        fputs( "^", listfile );
-        list_lineno++;
-        page_lineno++;
-      }
-      fputs( "\n", listfile );
+      addListRecord( as, LISTREC_ERROR, as->error_list[iy].mesg,
+                     as->error_list[iy].col );
     }
   }
-  save_error_count = 0;
+  as->save_error_count = 0;
 } /* printErrorMessages()                                                     */
 
 
@@ -2629,14 +4703,14 @@ void printErrorMessages()
 /*  Synopsis:  Outputs both literal tables at the end of a binary segment.    */
 /*                                                                            */
 /******************************************************************************/
-void endOfBinary()
+void endOfBinary( ASM_T *as )
 {
   /* Points to end of page for () operands.                                   */
-  punchLiteralPool( &cp, clc - 1 );
+  punchLiteralPool( as, &as->cp, as->clc - 1 );
   /* Points to end of page zero for [] operands.                              */
-  punchLiteralPool( &pz, field );
-  if( error_in_line )
-  listLine();             /* List line if not done yet.                       */
+  punchLiteralPool( as, &as->pz, as->field );
+  if( as->error_in_line )
+  listLine( as );             /* List line if not done yet.                   */
   return;
 } /* endOfBinary()                                                            */
 
@@ -2649,18 +4723,93 @@ void endOfBinary()
 /*             object file exists.                                            */
 /*                                                                            */
 /******************************************************************************/
-void punchChecksum()
+void punchChecksum( ASM_T *as )
 {
   /* If the assembler has output any BIN data output the checksum.            */
-  if( binary_data_output && !rim_mode )
+  if( as->binary_data_output && !as->rim_mode )
   {
-    punchLocObject( 0, checksum );
+    punchLocObject( as, 0, as->checksum );
   }
-  binary_data_output = FALSE;
-  checksum = 0;
+  as->binary_data_output = FALSE;
+  as->checksum = 0;
 } /* punchChecksum()                                                          */
 
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  flushTape                                                      */
+/*                                                                            */
+/*  Synopsis:  Write the object characters punched into the tape buffer to    */
+/*             the object file, all at once.                                  */
+/*                                                                            */
+/******************************************************************************/
+void flushTape( ASM_T *as )
+{
+  if( as->tape_count > 0 && as->objectsave != NULL )
+  {
+    fwrite( as->tape, 1, as->tape_count, as->objectsave );
+  }
+  as->tape_count = 0;
+} /* flushTape()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchImage                                                     */
+/*                                                                            */
+/*  Synopsis:  Punch the memory image as a bin tape, with an origin only      */
+/*             where the words loaded are not consecutive and a field setting */
+/*             only where the field changes.  The tape loads the same words   */
+/*             as the one punched during pass 2, which only counted its       */
+/*             length.                                                        */
+/*                                                                            */
+/******************************************************************************/
+void punchImage( ASM_T *as )
+{
+  WORD32  field;
+  long    ix;
+  long    streamed;
+
+  streamed = as->tape_length;
+  as->compact = FALSE;
+  as->tape_length = 0;
+  as->checksum = 0;
+  as->binary_data_output = FALSE;
+
+  punchLeader( as, 0 );
+  field = 0;
+  for( ix = 0; ix < IMAGE_SIZE; ix++ )
+  {
+    if( !as->loaded[ix] )
+    {
+      continue;
+    }
+    if(( ix >> 12 ) != field )
+    {
+      field = ix >> 12;
+      punchObject( as, ( field << 3 ) | 00300 );
+      as->checksum -= ( field << 3 ) | 00300;   /* Not added to checksum.     */
+    }
+    if(( ix & 07777 ) == 0 || !as->loaded[ix - 1] )
+    {
+      punchOrigin( as, ix & 07777 );
+    }
+    punchLocObject( as, 0, as->image[ix] );
+  }
+  punchChecksum( as );
+  punchLeader( as, 1 );
+  as->compact = TRUE;
+
+  listFormat( as, "\n      %ld tape characters, %ld saved\n",
+           as->tape_length, streamed - as->tape_length );
+  if( !as->batch )
+  {
+    fprintf( stderr, "      %ld tape characters, %ld saved\n",
+             as->tape_length, streamed - as->tape_length );
+  }
+} /* punchImage()                                                             */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  punchLeader                                                    */
@@ -2669,19 +4818,24 @@ void punchChecksum()
 /*             documentation.  Paper tape has 10 punches per inch.            */
 /*                                                                            */
 /******************************************************************************/
-void punchLeader( WORD32 count )
+void punchLeader( ASM_T *as, WORD32 count )
 {
   WORD32  ix;
 
   /* If value is zero, set to the default of 2 feet of leader.                */
   count = ( count == 0 ) ? 240 : count;
 
-  if( objectfile != NULL )
+  if( as->objectfile != NULL )
   {
-    for( ix = 0; ix < count; ix++ )
+    for( ix = 0; ix < count && !as->compact; ix++ )
     {
-      fputc( 0200, objectfile );
+      if( as->tape_count == TAPE_BUFFER )
+      {
+        flushTape( as );
+      }
+      as->tape[as->tape_count++] = 0200;
     }
+    as->tape_length += count;
   }
 } /* punchLeader()                                                            */
 
@@ -2693,10 +4847,10 @@ void punchLeader( WORD32 count )
 /*  Synopsis:  Output an origin to the object file.                           */
 /*                                                                            */
 /******************************************************************************/
-void punchOrigin( WORD32 loc )
+void punchOrigin( ASM_T *as, WORD32 loc )
 {
-  punchObject((( loc >> 6 ) & 0077 ) | 0100 );
-  punchObject( loc & 0077 );
+  punchObject( as, (( loc >> 6 ) & 0077 ) | 0100 );
+  punchObject( as, loc & 0077 );
 } /* punchOrigin()                                                            */
 
 
@@ -2707,15 +4861,23 @@ void punchOrigin( WORD32 loc )
 /*  Synopsis:  Put one character to object file and include it in checksum.   */
 /*                                                                            */
 /******************************************************************************/
-void punchObject( WORD32 val )
+void punchObject( ASM_T *as, WORD32 val )
 {
   val &= 0377;
-  if( objectfile != NULL )
+  if( as->objectfile != NULL )
   {
-    fputc( val, objectfile );
+    if( !as->compact )
+    {
+      if( as->tape_count == TAPE_BUFFER )
+      {
+        flushTape( as );
+      }
+      as->tape[as->tape_count++] = val;
+    }
+    as->tape_length++;
   }
-  checksum += val;
-  binary_data_output = TRUE;
+  as->checksum += val;
+  as->binary_data_output = TRUE;
 } /* punchObject()                                                            */
 
 
@@ -2727,12 +4889,96 @@ void punchObject( WORD32 val )
 /*             object file.                                                   */
 /*                                                                            */
 /******************************************************************************/
-void punchOutObject( WORD32 loc, WORD32 val )
+void punchOutObject( ASM_T *as, WORD32 loc, WORD32 val )
 {
-  printLine( line, ( field | loc ), val, LINE_LOC_VAL );
-  punchLocObject( loc, val );
+  printLine( as, as->line, ( as->field | loc ), val, LINE_LOC_VAL );
+  punchLocObject( as, loc, val );
+  loadWord( as, ( as->field | loc ), val );
 } /* punchOutObject()                                                         */
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchZeroBlock                                                 */
+/*                                                                            */
+/*  Synopsis:  Punch count zero words from the current location on, for       */
+/*             ZBLOCK, all at once.  Only the first and the last word are     */
+/*             listed.  A literal collision is reported at the first word     */
+/*             that collides, as incrementClc() would for each word.          */
+/*                                                                            */
+/******************************************************************************/
+void punchZeroBlock( ASM_T *as, WORD32 count )
+{
+  WORD32  end;
+  WORD32  first;
+  WORD32  left;
+  WORD32  length;
+  WORD32  loc;
+  WORD32  next;
+  WORD32  pool;
+
+  first = as->clc;
+  end = first + count;
+
+  /* In each page the block runs into the literals, if at all, at the         */
+  /* start of the page's literals or at the start of the block.               */
+  for( loc = first; loc < end; loc = next )
+  {
+    next = ( loc | 00177 ) + 1;
+    next = ( next < end ) ? next : end;
+    pool = ( loc & ~00177 ) | as->lit_loc[GET_PAGE( loc )];
+    if( pool < next )
+    {
+      as->clc = ( pool > loc ) ? pool : loc;
+      testForLiteralCollision( as, as->clc );
+    }
+  }
+
+  printLine( as, as->line, ( as->field | first ), 0, LINE_LOC_VAL );
+  if( count > 1 )
+  {
+    printLine( as, as->line, ( as->field | ( end - 1 )), 0, LOC_VAL );
+  }
+
+  if( as->rim_mode )
+  {
+    for( loc = first; loc < end; loc++ )
+    {
+      punchLocObject( as, loc, 0 );
+    }
+  }
+  else
+  {
+    as->binary_data_output = TRUE;  /* Zeros add nothing to the checksum.     */
+    if( as->objectfile != NULL )
+    {
+      as->tape_length += 2 * count;
+      for( left = 2 * count; left > 0 && !as->compact; left -= length )
+      {
+        if( as->tape_count == TAPE_BUFFER )
+        {
+          flushTape( as );
+        }
+        length = TAPE_BUFFER - as->tape_count;
+        length = ( length < left ) ? length : left;
+        memset( &as->tape[as->tape_count], 0, length );
+        as->tape_count += length;
+      }
+    }
+  }
+
+  if( as->loaded != NULL && as->objectfile != NULL )
+  {
+    loc = ( as->field | first ) & ( IMAGE_SIZE - 1 );
+    memset( &as->image[loc], 0, sizeof( WORD32 ) * count );
+    memset( &as->loaded[loc], TRUE, count );
+  }
+
+  /* Incrementing the location counter is not to change field setting.        */
+  as->clc = ( first & 070000 ) + ( end & 07777 );
+  as->fieldlc = as->clc & 07777;
+} /* punchZeroBlock()                                                         */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  punchLocObject                                                 */
@@ -2740,17 +4986,36 @@ void punchOutObject( WORD32 loc, WORD32 val )
 /*  Synopsis:  Output the word (with origin if rim format) to the object file.*/
 /*                                                                            */
 /******************************************************************************/
-void punchLocObject( WORD32 loc, WORD32 val )
+void punchLocObject( ASM_T *as, WORD32 loc, WORD32 val )
 {
-  if( rim_mode )
+  if( as->rim_mode )
   {
-    punchOrigin( loc );
+    punchOrigin( as, loc );
   }
-  punchObject(( val >> 6 ) & 0077 );
-  punchObject( val & 0077 );
+  punchObject( as, ( val >> 6 ) & 0077 );
+  punchObject( as, val & 0077 );
 } /* punchLocObject()                                                         */
 
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  loadWord                                                       */
+/*                                                                            */
+/*  Synopsis:  Put a word just punched into the memory image of -c, at the    */
+/*             address the object loads it at.                                */
+/*                                                                            */
+/******************************************************************************/
+void loadWord( ASM_T *as, WORD32 loc, WORD32 val )
+{
+  if( as->loaded != NULL && as->objectfile != NULL )
+  {
+    loc &= IMAGE_SIZE - 1;
+    as->image[loc] = val & 07777;
+    as->loaded[loc] = TRUE;
+  }
+} /* loadWord()                                                               */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  punchLiteralPool                                               */
@@ -2758,7 +5023,7 @@ void punchLocObject( WORD32 loc, WORD32 val )
 /*  Synopsis:  Output the current page data.                                  */
 /*                                                                            */
 /******************************************************************************/
-void punchLiteralPool( LPOOL_T *p, WORD32 lpool_page )
+void punchLiteralPool( ASM_T *as, LPOOL_T *p, WORD32 lpool_page )
 {
   WORD32  loc;
   WORD32  pageno;
@@ -2767,27 +5032,28 @@ void punchLiteralPool( LPOOL_T *p, WORD32 lpool_page )
   pageno  = GET_PAGE (lpool_page);
   lpool_page &= 07600;
 
-  if(( lpool_page == 0 ) && ( p != &pz ))
+  if(( lpool_page == 0 ) && ( p != &as->pz ))
   {
     return;                     /* Don't punch page 0 pool if not asked.     */
   }
 
-  if( lit_loc[pageno] < lit_base[pageno] )
+  if( as->lit_loc[pageno] < as->lit_base[pageno] )
   {
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
       /* Put out origin if not in rim mode.                                   */
-		punchOrigin( lit_loc[pageno] | lpool_page );
+		punchOrigin( as, as->lit_loc[pageno] | lpool_page );
 	 }
       /* Put the literals in the object file.                                 */
-    for( loc = lit_loc[pageno]; loc < lit_base[pageno]; loc++ )
+    for( loc = as->lit_loc[pageno]; loc < as->lit_base[pageno]; loc++ )
     {
       tmplc = loc + lpool_page;
-      printLine( line, (field | tmplc), p->pool[loc], LOC_VAL );
-      punchLocObject( tmplc, p->pool[loc] );
+      printLine( as, as->line, (as->field | tmplc), p->pool[loc], LOC_VAL );
+      punchLocObject( as, tmplc, p->pool[loc] );
+      loadWord( as, (as->field | tmplc), p->pool[loc] );
     }
     p->error = FALSE;
-    lit_base[pageno] = lit_loc[pageno];
+    as->lit_base[pageno] = as->lit_loc[pageno];
   }
 } /* punchLiteralPool()                                                       */
 
@@ -2800,7 +5066,7 @@ void punchLiteralPool( LPOOL_T *p, WORD32 lpool_page )
 /*             Return the location of the value in the pool.                  */
 /*                                                                            */
 /******************************************************************************/
-WORD32 insertLiteral( LPOOL_T *pool, WORD32 pool_page, WORD32 value )
+WORD32 insertLiteral( ASM_T *as, LPOOL_T *pool, WORD32 pool_page, WORD32 value )
 {
   WORD32  ix;
   WORD32  pageno;
@@ -2813,26 +5079,71 @@ WORD32 insertLiteral( LPOOL_T *pool, WORD32 pool_page, WORD32 value )
   /* in the page zero literal table.                                          */
   if(( pool_page & 07600 ) == 0 )
   {
-     p = &pz;
+     p = &as->pz;
   }
 
-  /* Search the literal pool for any occurence of the needed value.           */
-  ix = lit_base[pageno] - 1;
-  while( ix >= lit_loc[pageno] && p->pool[ix] != value )
+  /* Look for the value in the part of the literal pool of the page.          */
+  if(( ix = findLiteral( as, p, pageno, value )) >= 0 )
   {
-    ix--;
+    return( ix );
   }
 
-  /* Check if value found in literal pool. If not, then insert value.         */
-  if( ix < lit_loc[pageno] )
+  /* Not found, so insert the value.  A full pool leaves no room on the page  */
+  /* for the code using it, which is reported as a literal overflow.          */
+  if( as->lit_loc[pageno] > 0 )
   {
-    lit_loc[pageno]--;
-    p->pool[lit_loc[pageno]] = value;
-    ix = lit_loc[pageno];
+    ix = --as->lit_loc[pageno];
+    p->at[p->pool[ix] & 07777][ix / 32] &= ~( 1U << ( ix % 32 ));
+    p->at[value & 07777][ix / 32] |= 1U << ( ix % 32 );
+    p->pool[ix] = value;
   }
-  return( ix );
+  return( as->lit_loc[pageno] );
 } /* insertLiteral()                                                          */
 
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  findLiteral                                                    */
+/*                                                                            */
+/*  Synopsis:  Return the location of a value in the literal pool of a page,  */
+/*             or -1 if it is not there.  If it is there more than once, the  */
+/*             highest location is the one a search down the pool finds.      */
+/*                                                                            */
+/******************************************************************************/
+WORD32 findLiteral( ASM_T *as, LPOOL_T *p, WORD32 pageno, WORD32 value )
+{
+  unsigned int bits;
+  WORD32  base;
+  WORD32  ix;
+  WORD32  step;
+  WORD32  wx;
+
+  base = as->lit_base[pageno];
+  for( wx = ( base - 1 ) / 32; base > 0 && wx >= 0; wx-- )
+  {
+    bits = p->at[value & 07777][wx];
+    if( base < wx * 32 + 32 )
+    {
+      bits &= ( 1U << ( base % 32 )) - 1;   /* Only the part below base.      */
+    }
+    if( bits != 0 )
+    {
+      /* Find the highest bit.                                                */
+      for( ix = wx * 32, step = 16; step > 0; step /= 2 )
+      {
+        if(( bits >> step ) != 0 )
+        {
+          bits >>= step;
+          ix += step;
+        }
+      }
+      return(( ix >= as->lit_loc[pageno] ) ? ix : -1 );
+    }
+  }
+  return( -1 );
+} /* findLiteral()                                                            */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  testZeroPool                                                   */
@@ -2840,18 +5151,161 @@ WORD32 insertLiteral( LPOOL_T *pool, WORD32 pool_page, WORD32 value )
 /*  Synopsis:  Test for literal in page zero pool.                            */
 /*                                                                            */
 /******************************************************************************/
-BOOL testZeroPool( WORD32 value )
+BOOL testZeroPool( ASM_T *as, WORD32 value )
+{
+  return( findLiteral( as, &as->pz, GET_PAGE( as->field ), value ) >= 0 );
+} /* testZeroPool()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printReports                                                   */
+/*                                                                            */
+/*  Synopsis:  Output the symbol table, the permanent symbol table and the    */
+/*             cross reference asked for.  When there is more than one, the   */
+/*             permanent symbol table and the cross reference are each made   */
+/*             on a thread of their own while this one lists the symbol       */
+/*             table, and the cross reference then follows it in the listing. */
+/*                                                                            */
+/******************************************************************************/
+void printReports( ASM_T *as, BOOL listing )
+{
+  int      count;
+  REPORT_T perm;
+  REPORT_T xref;
+
+  count = 0;
+  count += ( as->symtab_print && listing ) ? 1 : 0;
+  count += ( as->print_permanent_symbols ) ? 1 : 0;
+  count += ( as->xref && listing ) ? 1 : 0;
+
+  perm.threaded = FALSE;
+  xref.threaded = FALSE;
+  if( count > 1 && as->print_permanent_symbols )
+  {
+    startReport( as, &perm, printPermanentSymbolTable, 0 );
+  }
+  if( count > 1 && as->xref && listing )
+  {
+    /* The cross reference starts on the page after the symbol table.         */
+    startReport( as, &xref, printCrossReference,
+                 ( as->symtab_print ) ? symbolTablePages( as ) : 0 );
+  }
+
+  if( as->symtab_print && listing )
+  {
+    printSymbolTable( as );
+  }
+
+  if( as->print_permanent_symbols )
+  {
+    finishReport( as, &perm, printPermanentSymbolTable );
+  }
+
+  if( as->xref && listing )
+  {
+    finishReport( as, &xref, printCrossReference );
+  }
+} /* printReports()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  startReport                                                    */
+/*                                                                            */
+/*  Synopsis:  Start making a report on a thread of its own, listed after     */
+/*             pages more pages.  If that cannot be done, it is left to be    */
+/*             made by finishReport() on this thread.                         */
+/*                                                                            */
+/******************************************************************************/
+void startReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ),
+                  int pages )
+{
+  rep->as = *as;
+  rep->print = print;
+  rep->text = NULL;
+  rep->length = 0;
+  rep->as.list_pageno += pages;
+  rep->as.listout_count = 0;
+  rep->as.listout = (char *) malloc( LIST_BUFFER );
+  rep->as.listfile = NULL;
+  if( rep->as.listout != NULL )
+  {
+    rep->as.listfile = open_memstream( &rep->text, &rep->length );
+  }
+  rep->as.listsave = rep->as.listfile;
+
+  rep->threaded = rep->as.listfile != NULL
+               && pthread_create( &rep->thread, NULL, reportWorker, rep ) == 0;
+  if( !rep->threaded )
+  {
+    if( rep->as.listfile != NULL )
+    {
+      fclose( rep->as.listfile );
+    }
+    free( rep->text );
+    free( rep->as.listout );
+  }
+} /* startReport()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  reportWorker                                                   */
+/*                                                                            */
+/*  Synopsis:  Make a report started by startReport().                        */
+/*                                                                            */
+/******************************************************************************/
+void *reportWorker( void *arg )
+{
+  REPORT_T *rep;
+
+  rep = (REPORT_T *) arg;
+  rep->print( &rep->as );
+  flushList( &rep->as );
+  return( NULL );
+} /* reportWorker()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  finishReport                                                   */
+/*                                                                            */
+/*  Synopsis:  Wait for a report started by startReport() and add what it     */
+/*             listed to the listing, or make it now if it was not started.   */
+/*                                                                            */
+/******************************************************************************/
+void finishReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ))
+{
+  if( !rep->threaded )
+  {
+    print( as );
+    return;
+  }
+  pthread_join( rep->thread, NULL );
+  fclose( rep->as.listfile );
+  listChars( as, rep->text, (int) rep->length );
+  free( rep->text );
+  free( rep->as.listout );
+} /* finishReport()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  symbolTablePages                                               */
+/*                                                                            */
+/*  Synopsis:  Return the number of pages printSymbolTable() lists.           */
+/*                                                                            */
+/******************************************************************************/
+int symbolTablePages( ASM_T *as )
 {
-  WORD32 ix;
-  WORD32 pageno;
+  int    per_page;
 
-  pageno = GET_PAGE( field );
-  for ( ix = lit_loc[pageno]; ix < lit_base[pageno]; ix++ )
-  {
-    if( pz.pool[ix] == value ) return TRUE;
-  }
-  return FALSE;
-}
+  /* A page has SYMBOL_COLUMNS columns of symbols below its 3 line header.    */
+  per_page = SYMBOL_COLUMNS * ( LIST_LINES_PER_PAGE - 3 );
+  return(( as->symbol_top - as->number_of_fixed_symbols + per_page - 1 )
+         / per_page );
+} /* symbolTablePages()                                                       */
 
 
 /******************************************************************************/
@@ -2861,52 +5315,46 @@ BOOL testZeroPool( WORD32 value )
 /*  Synopsis:  Output the symbol table.                                       */
 /*                                                                            */
 /******************************************************************************/
-void printSymbolTable()
+void printSymbolTable( ASM_T *as )
 {
   int    col;
   int    cx;
-  char  *fmt;
   int    ix;
   char   mark;
+  char   name[SYMLEN];
   int    page;
   int    row;
+  SYM_T **sorted;
   int    symbol_base;
+  int    symbol_end;
   int    symbol_lines;
 
-  symbol_base = number_of_fixed_symbols;
+  sorted = sortSymbolTable( as, &symbol_base );
+  symbol_end = symbol_base + as->symbol_top - as->number_of_fixed_symbols;
 
-  for( page=0, list_lineno=0, col=0, ix=symbol_base; ix < symbol_top; page++ )
+  for( page=0, as->list_lineno=0, col=0, ix=symbol_base; ix < symbol_end;
+       page++ )
   {
-    topOfForm( list_title, s_symtable );
-    symbol_lines = LIST_LINES_PER_PAGE - page_lineno;
+    topOfForm( as, as->list_title, s_symtable );
+    symbol_lines = LIST_LINES_PER_PAGE - as->page_lineno;
 
-    for( row = 0; page_lineno < LIST_LINES_PER_PAGE && ix < symbol_top; row++)
+    for( row = 0; as->page_lineno < LIST_LINES_PER_PAGE && ix < symbol_end;
+         row++)
     {
-      list_lineno++;
-      page_lineno++;
-      fprintf( listfile, "%5d", list_lineno );
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, as->list_lineno, 5 );
 
-      for( col = 0; col < SYMBOL_COLUMNS && ix < symbol_top; col++ )
+      for( col = 0; col < SYMBOL_COLUMNS && ix < symbol_end; col++ )
       {
         /* Get index of symbol for the current line and column                         */
         cx = symbol_lines * ( SYMBOL_COLUMNS * page + col ) + row;
         cx += symbol_base;
 
         /* Make sure that there is a symbol to be printed.                    */
-        if( number_of_fixed_symbols <= cx && cx < symbol_top )
+        if( symbol_base <= cx && cx < symbol_end )
         {
-          switch( symtab[cx].type & LABEL )
-          {
-          case LABEL:
-            fmt = " %c%-6.6s %5.5o ";
-            break;
-
-          default:
-            fmt = " %c%-6.6s  %4.4o ";
-            break;
-          }
-
-          switch( symtab[cx].type & ( DEFINED | REDEFINED ))
+          switch( sorted[cx]->type & ( DEFINED | REDEFINED ))
           {
           case UNDEFINED:
             mark = '?';
@@ -2920,13 +5368,27 @@ void printSymbolTable()
             mark = ' ';
             break;
           }
-          fprintf( listfile, fmt, mark, symtab[cx].name, symtab[cx].val );
+          listSpaces( as, 1 );
+          listChars( as, &mark, 1 );
+          listField( as, keyToName( name, sorted[cx]->key ), 6 );
+          if(( sorted[cx]->type & LABEL ) == LABEL )
+          {
+            listSpaces( as, 1 );
+            listOctal( as, sorted[cx]->val, 5 );
+          }
+          else
+          {
+            listSpaces( as, 2 );
+            listOctal( as, sorted[cx]->val, 4 );
+          }
+          listSpaces( as, 1 );
           ix++;
         }
       }
-      fprintf( listfile, "\n" );
+      listChars( as, "\n", 1 );
     }
   }
+  free( sorted );
 } /* printSymbolTable()                                                       */
 
 
@@ -2938,47 +5400,185 @@ void printSymbolTable()
 /*             being input after the EXPUNGE pseudo-op.                       */
 /*                                                                            */
 /******************************************************************************/
-void printPermanentSymbolTable()
+void printPermanentSymbolTable( ASM_T *as )
 {
+  int     fixed_count;
   int     ix;
+  char    name[SYMLEN];
   FILE   *permfile;
   char  *s_type;
+  SYM_T **sorted;
 
-  if(( permfile = fopen( permpathname, "w" )) == NULL )
+  if(( permfile = fopen( as->permpathname, "w" )) == NULL )
   {
     exit( 2 );
   }
+  sorted = sortSymbolTable( as, &fixed_count );
 
   fprintf( permfile, "/ PERMANENT SYMBOL TABLE\n/\n" );
   fprintf( permfile, "        EXPUNGE\n/\n" );
   /* Print the memory reference instructions first.                           */
   s_type = " ";
-  for( ix = 0; ix < symbol_top; ix++ )
+  for( ix = 0; sorted[ix] != NULL; ix++ )
   {
-    if( M_MRI( symtab[ix].type ))
+    if( M_MRI( sorted[ix]->type ))
     {
-      fprintf( permfile, "%-7s %s=%4.4o\n",
-                                    s_type, symtab[ix].name, symtab[ix].val );
+      fprintf( permfile, "%-7s %s=%4.4o\n", s_type,
+                        keyToName( name, sorted[ix]->key ), sorted[ix]->val );
     }
   }
 
   s_type = " ";
-  for( ix = 0; ix < symbol_top; ix++ )
+  for( ix = 0; sorted[ix] != NULL; ix++ )
   {
-    if( M_FIXED( symtab[ix].type ))
+    if( M_FIXED( sorted[ix]->type ))
     {
-      if( !M_MRI( symtab[ix].type ) && !M_PSEUDO( symtab[ix].type ))
+      if( !M_MRI( sorted[ix]->type ) && !M_PSEUDO( sorted[ix]->type ))
       {
-        fprintf( permfile, "%-7s %s=%4.4o\n",
-                                    s_type, symtab[ix].name, symtab[ix].val );
+        fprintf( permfile, "%-7s %s=%4.4o\n", s_type,
+                        keyToName( name, sorted[ix]->key ), sorted[ix]->val );
       }
     }
   }
   fprintf( permfile, "/\n        FIXTAB\n" );
   fclose( permfile );
+  free( sorted );
 } /* printPermanentSymbolTable()                                              */
 
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  writePermanentSnapshot                                         */
+/*                                                                            */
+/*  Synopsis:  Write the permanent symbols, already hashed and in name order, */
+/*             to a snapshot file that the -u option can map back in.         */
+/*                                                                            */
+/******************************************************************************/
+void writePermanentSnapshot( ASM_T *as )
+{
+  int        fixed_count;
+  PERMHDR_T  hdr;
+  int        ix;
+  FILE      *snapfile;
+  SYM_T    **sorted;
+
+  if(( snapfile = fopen( as->snappathname, "wb" )) == NULL )
+  {
+    fprintf( stderr, "Cannot open \"%s\".\n", as->snappathname );
+    exit( 2 );
+  }
+
+  /* The fixed symbols come first in the sorted table.  This is the end of    */
+  /* the assembly, so they can simply become the permanent symbol table.      */
+  sorted = sortSymbolTable( as, &fixed_count );
+  if( !hashPermanentSymbols( as, sorted, fixed_count ))
+  {
+    fprintf( stderr, "No perfect hash found for the permanent symbols.\n" );
+    exit( 2 );
+  }
+  free( sorted );
+
+  memset( &hdr, 0, sizeof( hdr ));
+  memcpy( hdr.magic, PERMSNAP_MAGIC, sizeof( hdr.magic ));
+  hdr.sym_size = sizeof( SYM_T );
+  hdr.buckets = as->permtab_buckets;
+  hdr.count = as->permtab_count;
+  hdr.size = as->permtab_size;
+
+  fwrite( &hdr, sizeof( hdr ), 1, snapfile );
+  for( ix = sizeof( hdr ); ix < PERMSNAP_TABLE; ix++ )
+  {
+    putc( 0, snapfile );
+  }
+  fwrite( as->permtab, sizeof( SYM_T ), as->permtab_size, snapfile );
+  fwrite( as->permtab_disp, sizeof( int ), as->permtab_buckets, snapfile );
+  fwrite( as->permtab_order, sizeof( int ), as->permtab_count, snapfile );
+
+  if( ferror( snapfile ))
+  {
+    fprintf( stderr, "Error writing \"%s\".\n", as->snappathname );
+    exit( 2 );
+  }
+  fclose( snapfile );
+} /* writePermanentSnapshot()                                                 */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  loadPermanentSnapshot                                          */
+/*                                                                            */
+/*  Synopsis:  Map a snapshot written by writePermanentSnapshot() and use it  */
+/*             as the permanent symbol table in place of the built-in one.    */
+/*             The mapping is private, so symbols may still be redefined.     */
+/*                                                                            */
+/******************************************************************************/
+void loadPermanentSnapshot( ASM_T *as, char *path )
+{
+  char       *base;
+  int         fd;
+  PERMHDR_T  *hdr;
+  int         ix;
+  int        *order;
+  long        length;
+  struct stat st;
+  BOOL        valid;
+
+  if(( fd = open( path, O_RDONLY )) < 0 )
+  {
+    fprintf( stderr, "Cannot open \"%s\".\n", path );
+    exit( -1 );
+  }
+  base = (char *) MAP_FAILED;
+  valid = ( fstat( fd, &st ) == 0 && (long) st.st_size >= PERMSNAP_TABLE );
+  if( valid )
+  {
+    base = (char *) mmap( NULL, st.st_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0 );
+  }
+  close( fd );
+  if( valid && base == (char *) MAP_FAILED )
+  {
+    fprintf( stderr, "Cannot map \"%s\".\n", path );
+    exit( -1 );
+  }
+
+  /* Check the header against this build before trusting any of it.          */
+  length = valid ? (long) st.st_size : 0;
+  hdr = (PERMHDR_T *) base;
+  valid = valid
+       && memcmp( hdr->magic, PERMSNAP_MAGIC, sizeof( hdr->magic )) == 0
+       && hdr->sym_size == sizeof( SYM_T )
+       && hdr->size > 0 && ( hdr->size & ( hdr->size - 1 )) == 0
+       && hdr->size <= length / (long) sizeof( SYM_T )
+       && hdr->buckets > 0 && ( hdr->buckets & ( hdr->buckets - 1 )) == 0
+       && hdr->buckets <= length / (long) sizeof( int )
+       && hdr->count >= 0 && hdr->count <= hdr->size
+       && length == PERMSNAP_TABLE + hdr->size * (long) sizeof( SYM_T )
+                  + ( hdr->buckets + hdr->count ) * (long) sizeof( int );
+
+  order = valid ? (int *) ( base + length ) - hdr->count : NULL;
+  for( ix = 0; valid && ix < hdr->count; ix++ )
+  {
+    valid = order[ix] >= 0 && order[ix] < hdr->size;
+  }
+  if( !valid )
+  {
+    fprintf( stderr, "\"%s\" is not a permanent symbol snapshot for this "
+                     "assembler.\n", path );
+    exit( -1 );
+  }
+
+  as->snapbase = base;
+  as->snapsize = length;
+  as->permtab = (SYM_T *) ( base + PERMSNAP_TABLE );
+  as->permtab_disp = (int *) ( as->permtab + hdr->size );
+  as->permtab_order = order;
+  as->permtab_buckets = hdr->buckets;
+  as->permtab_count = hdr->count;
+  as->permtab_size = hdr->size;
+} /* loadPermanentSnapshot()                                                  */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  printCrossReference                                            */
@@ -2987,51 +5587,69 @@ void printPermanentSymbolTable()
 /*             assembled.                                                     */
 /*                                                                            */
 /******************************************************************************/
-void printCrossReference()
+void printCrossReference( ASM_T *as )
 {
+  int    block;
+  int    def;
   int    ix;
+  int    line;
+  char   name[SYMLEN];
+  int    pos;
+  SYM_T **sorted;
   int    symbol_base;
   int    xc;
-  int    xc_index;
   int    xc_refcount;
   int    xc_cols;
 
   /* Force top of form for first page.                                        */
-  page_lineno = LIST_LINES_PER_PAGE;
+  as->page_lineno = LIST_LINES_PER_PAGE;
 
-  list_lineno = 0;
-  symbol_base = number_of_fixed_symbols;
+  as->list_lineno = 0;
+  sorted = sortSymbolTable( as, &symbol_base );
 
-  for( ix = symbol_base; ix < symbol_top; ix++ )
+  for( ix = symbol_base; sorted[ix] != NULL; ix++ )
   {
-    list_lineno++;
-    page_lineno++;
-    if( page_lineno >= LIST_LINES_PER_PAGE )
+    as->list_lineno++;
+    as->page_lineno++;
+    if( as->page_lineno >= LIST_LINES_PER_PAGE )
     {
-      topOfForm( list_title, s_xref );
+      topOfForm( as, as->list_title, s_xref );
     }
 
-    fprintf( listfile, "%5d", list_lineno );
+    listDecimal( as, as->list_lineno, 5 );
 
-    /* Get reference count & index into concordance table for this symbol.    */
-    xc_refcount = symtab[ix].xref_count;
-    xc_index = symtab[ix].xref_index;
+    /* Get reference count & concordance entry for this symbol.               */
+    xc_refcount = sorted[ix]->xref_count;
+    def = 0;
+    block = 0;
+    if( sorted[ix]->xref_index != 0 )
+    {
+      def = as->xrefs[sorted[ix]->xref_index].def;
+      block = as->xrefs[sorted[ix]->xref_index].first;
+    }
+    pos = 0;
+    line = 0;
     /* Determine how to label symbol on concordance.                          */
-    switch( symtab[ix].type & ( DEFINED | REDEFINED ))
+    switch( sorted[ix]->type & ( DEFINED | REDEFINED ))
     {
     case UNDEFINED:
-      fprintf( listfile, " U         ");
+      listChars( as, " U         ", 11 );
       break;
 
     case REDEFINED:
-      fprintf( listfile, " M  %5d  ", xreftab[xc_index] );
+      listChars( as, " M  ", 4 );
+      listDecimal( as, def, 5 );
+      listSpaces( as, 2 );
       break;
 
     default:
-      fprintf( listfile, " A  %5d  ", xreftab[xc_index] );
+      listChars( as, " A  ", 4 );
+      listDecimal( as, def, 5 );
+      listSpaces( as, 2 );
       break;
     }
-    fprintf( listfile, "%-6.6s  ", symtab[ix].name );
+    listField( as, keyToName( name, sorted[ix]->key ), 6 );
+    listSpaces( as, 2 );
 
     /* Output the references, 8 numbers per line after symbol name.           */
     for( xc_cols = 0, xc = 1; xc < xc_refcount + 1; xc++, xc_cols++ )
@@ -3039,18 +5657,23 @@ void printCrossReference()
       if( xc_cols >= XREF_COLUMNS )
       {
         xc_cols = 0;
-        page_lineno++;
-        if( page_lineno >= LIST_LINES_PER_PAGE )
+        as->page_lineno++;
+        if( as->page_lineno >= LIST_LINES_PER_PAGE )
         {
-          topOfForm( list_title, s_xref);
+          topOfForm( as, as->list_title, s_xref);
         }
-        list_lineno++;
-        fprintf( listfile, "\n%5d%-19s", list_lineno, " " );
+        as->list_lineno++;
+        listChars( as, "\n", 1 );
+        listDecimal( as, as->list_lineno, 5 );
+        listSpaces( as, 19 );
       }
-      fprintf( listfile, "  %5d", xreftab[xc_index + xc] );
+      line += nextXref( as, &block, &pos );
+      listSpaces( as, 2 );
+      listDecimal( as, line, 5 );
     }
-    fprintf( listfile, "\n" );
+    listChars( as, "\n", 1 );
   }
+  free( sorted );
 } /* printCrossReference()                                                    */
 
 
@@ -3061,35 +5684,34 @@ void printCrossReference()
 /*  Synopsis:  Prints title and sub-title on top of next page of listing.     */
 /*                                                                            */
 /******************************************************************************/
-void topOfForm( char *title, char *sub_title )
+void topOfForm( ASM_T *as, char *title, char *sub_title )
 {
-  char temp[10];
+  char temp[sizeof( s_page ) + 12];    /* "Page" and the widest int.          */
 
-  list_pageno++;
-  strcpy( temp, s_page );
-  sprintf( temp, "%s %d", s_page, list_pageno );
+  as->list_pageno++;
+  sprintf( temp, "%s %d", s_page, as->list_pageno );
 
   /* Output a top of form if not the first page of the listing.               */
-  if( list_pageno > 1 )
+  if( as->list_pageno > 1 )
   {
-    fprintf( listfile, "\f" );
+    listChars( as, "\f", 1 );
   }
-  fprintf( listfile, "\n      %-63s %10s\n", title, temp );
+  listFormat( as, "\n      %-63s %10s\n", title, temp );
 
   /* Reset the current page line counter.                                     */
-  page_lineno = 1;
+  as->page_lineno = 1;
   if( sub_title != NULL )
   {
-    fprintf( listfile, "%80s\n", sub_title );
-    page_lineno++;
+    listFormat( as, "%80s\n", sub_title );
+    as->page_lineno++;
   }
   else
   {
-    fprintf( listfile, "\n" );
-    page_lineno++;
+    listChars( as, "\n", 1 );
+    as->page_lineno++;
   }
-  fprintf( listfile, "\n" );
-  page_lineno++;
+  listChars( as, "\n", 1 );
+  as->page_lineno++;
 } /* topOfForm()                                                              */
 
 
@@ -3100,7 +5722,7 @@ void topOfForm( char *title, char *sub_title )
 /*  Synopsis:  Convert the current lexeme into a string.                      */
 /*                                                                            */
 /******************************************************************************/
-char *lexemeToName( char *name, WORD32 from, WORD32 term )
+char *lexemeToName( ASM_T *as, char *name, WORD32 from, WORD32 term )
 {
   WORD32  to;
 
@@ -3108,7 +5730,7 @@ char *lexemeToName( char *name, WORD32 from, WORD32 term )
 
   while( from < term && to < ( SYMLEN - 1 ))
   {
-    name[to++] = toupper( line[from++] );
+    name[to++] = toupper( as->line[from++] );
   }
 
   while( to < SYMLEN )
@@ -3120,182 +5742,568 @@ char *lexemeToName( char *name, WORD32 from, WORD32 term )
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  defineLexeme                                                   */
+/*  Function:  lexemeToKey                                                    */
+/*                                                                            */
+/*  Synopsis:  Pack the current lexeme into a symbol key straight from the    */
+/*             input line.                                                    */
+/*                                                                            */
+/******************************************************************************/
+SYMKEY lexemeToKey( ASM_T *as, WORD32 from, WORD32 term )
+{
+  SYMKEY  key;
+  int     to;
+  int     c;
+
+  for( key = 0, to = 0; to < ( SYMLEN - 1 ); to++ )
+  {
+    c = ( from < term ) ? toupper( as->line[from++] ) : '\0';
+    key *= SYMKEY_BASE;
+    if( isupper( c ))
+    {
+      key += c - 'A' + 11;
+    }
+    else if( isdigit( c ))
+    {
+      key += c - '0' + 1;
+    }
+  }
+  return( key );
+} /* lexemeToKey()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  nameToKey                                                      */
+/*                                                                            */
+/*  Synopsis:  Pack a symbol name string into a symbol key.                   */
+/*                                                                            */
+/******************************************************************************/
+SYMKEY nameToKey( char *name )
+{
+  SYMKEY  key;
+  int     to;
+  int     c;
+
+  for( key = 0, to = 0; to < ( SYMLEN - 1 ); to++ )
+  {
+    c = ( *name != '\0' ) ? toupper( *name++ ) : '\0';
+    key *= SYMKEY_BASE;
+    if( isupper( c ))
+    {
+      key += c - 'A' + 11;
+    }
+    else if( isdigit( c ))
+    {
+      key += c - '0' + 1;
+    }
+  }
+  return( key );
+} /* nameToKey()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  keyToName                                                      */
+/*                                                                            */
+/*  Synopsis:  Convert a symbol key back into a name string.                  */
+/*                                                                            */
+/******************************************************************************/
+char *keyToName( char *name, SYMKEY key )
+{
+  int     digit;
+  int     to;
+
+  name[SYMLEN - 1] = '\0';
+  for( to = SYMLEN - 2; to >= 0; to-- )
+  {
+    digit = (int) ( key % SYMKEY_BASE );
+    key /= SYMKEY_BASE;
+    if( digit >= 11 )
+    {
+      name[to] = (char) ( 'A' + digit - 11 );
+    }
+    else if( digit >= 1 )
+    {
+      name[to] = (char) ( '0' + digit - 1 );
+    }
+    else
+    {
+      name[to] = '\0';
+    }
+  }
+  return( name );
+} /* keyToName()                                                              */
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  defineLexeme                                                   */
+/*                                                                            */
+/*  Synopsis:  Put lexeme into symbol table with a value.                     */
+/*                                                                            */
+/******************************************************************************/
+SYM_T *defineLexeme( ASM_T  *as,       /* the assembler context.             */
+                     WORD32  start,     /* start of lexeme being defined.     */
+		         WORD32  term,      /* end+1 of lexeme being defined.     */
+                     WORD32  val,       /* value of lexeme being defined.     */
+                     SYMTYP  type )     /* how symbol is being defined.       */
+{
+  return( defineSymbol( as, lexemeToKey( as, start, term ), val, type, start ));
+} /* defineLexeme()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  defineSymbol                                                   */
+/*                                                                            */
+/*  Synopsis:  Define a symbol in the symbol table, enter symbol name if not  */
+/*             not already in table.                                          */
+/*                                                                            */
+/******************************************************************************/
+SYM_T *defineSymbol( ASM_T *as, SYMKEY key, WORD32 val, SYMTYP type,
+                     WORD32 start )
+{
+  char    name[SYMLEN];
+  SYM_T  *sym;
+
+  if( key == 0 )
+  {
+    return( &as->sym_undefined );   /* Protect against non-existent names.    */
+  }
+  sym = lookup( as, key );
+
+  if( M_DEFINED( sym->type ) && sym->val != val && M_NOTRDEF( sym -> type ))
+  {
+    if( as->pass == 2 )
+    {
+      errorSymbol( as, &redefined_symbol, keyToName( name, sym->key ), start );
+      type = type | REDEFINED;
+      if( as->xref )
+      {
+        addXref( as, sym, as->lineno ); /* Referenced symbol, count it.       */
+      }
+    }
+  return ( sym );
+  }
+  if( M_FIXED( sym->type ))
+  {
+  return ( sym );
+  }
+
+  if( as->pass == 2 && as->xref )
+  {
+    /* Put the definition line number in the concordance table.               */
+    /* Defined symbols are not counted as references.                         */
+    xrefEntry( as, sym )->def = as->lineno;
+  }
+
+  /* Now set the value and the type.                                          */
+  sym->val = ( type == LABEL) ? val : val & 07777;
+  sym->type = ( as->pass == 1 ) ? ( type | CONDITION ) : type;
+  return( sym );
+} /* defineSymbol()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  lookup                                                         */
+/*                                                                            */
+/*  Synopsis:  Find a symbol in table.  If not in table, enter symbol in      */
+/*             table as undefined.  Return address of symbol in table.        */
+/*                                                                            */
+/******************************************************************************/
+SYM_T *lookup( ASM_T *as, SYMKEY key )
+{
+  int     hx;                   /* Hash index                                 */
+  SYM_T  *sym;
+
+  /* First try the built-in permanent symbols.  The perfect hash gives the    */
+  /* only slot where the symbol can be.                                       */
+  hx = (int) ( hashSymbol( key, 0 ) & ( as->permtab_buckets - 1 ));
+  hx = (int) ( hashSymbol( key, as->permtab_disp[hx] )
+               & ( as->permtab_size - 1 ));
+  sym = &as->permtab[hx];
+  if( M_PERMANENT( sym->type ) && sym->key == key )
+  {
+    return( sym );
+  }
+
+  /* Now probe the hash index of the user symbol table until the symbol or    */
+  /* an empty entry is found.                                                 */
+  /* The index is kept at most half full, so there is always an empty entry. */
+  if( 2 * ( as->symbol_top + 1 ) > as->symhash_size )
+  {
+    growSymbolHash( as );
+  }
+  for( hx = (int) ( hashSymbol( key, 0 ) & ( as->symhash_size - 1 ));
+       as->symhash[hx] != NULL;
+       hx = ( hx + 1 ) & ( as->symhash_size - 1 ))
+  {
+    if( as->symhash[hx]->key == key )
+    {
+      return( as->symhash[hx] );    /* Found a match in symbol table.         */
+    }
+  }
+
+  /* Symbol not in table, so append it and index it at the empty entry.       */
+  if( as->symbol_top >= as->symbol_room )
+  {
+    growSymbolTable( as );
+  }
+  sym = symbolAt( as, as->symbol_top++ );
+  as->symhash[hx] = sym;
+
+  /* Enter the symbol as UNDEFINED with a value of zero.                      */
+  sym->key  = key;
+  sym->type = UNDEFINED;
+  sym->val  = 0;
+  sym->xref_index = 0;
+  sym->xref_count = 0;
+
+  return( sym );                /* Return the location of the symbol.         */
+} /* lookup()                                                                 */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  hashSymbol                                                     */
+/*                                                                            */
+/*  Synopsis:  Hash a symbol key.  Different seeds give independent hashes,   */
+/*             which the perfect hash of the permanent symbols relies on.     */
+/*                                                                            */
+/******************************************************************************/
+unsigned long hashSymbol( SYMKEY key, unsigned long seed )
+{
+  unsigned long  hash;
+
+  hash = ( key ^ ( seed * 0x9E3779B1UL )) & 0xFFFFFFFFUL;
+  hash = (( hash ^ ( hash >> 16 )) * 0x85EBCA6BUL ) & 0xFFFFFFFFUL;
+  hash = (( hash ^ ( hash >> 13 )) * 0xC2B2AE35UL ) & 0xFFFFFFFFUL;
+  return( hash ^ ( hash >> 16 ));
+} /* hashSymbol()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  hashPermanentSymbols                                           */
+/*                                                                            */
+/*  Synopsis:  Make the count symbols in syms, which must be sorted by name,  */
+/*             the permanent symbol table.  A perfect hash is built for them: */
+/*             a symbol is first hashed with seed 0 into one of the buckets,  */
+/*             and the displacement stored for that bucket is the seed of a   */
+/*             second hash which gives its slot.  The displacements are       */
+/*             chosen, largest bucket first, so that no two symbols share a   */
+/*             slot.  Returns FALSE if a bucket could not be placed.          */
+/*                                                                            */
+/******************************************************************************/
+BOOL hashPermanentSymbols( ASM_T *as, SYM_T **syms, int count )
+{
+  int     buckets;
+  int     bx;
+  int    *disp;
+  int    *first;
+  int     ix;
+  int     largest;
+  int    *member;
+  int     mx;
+  int    *order;
+  int     size;
+  int     sx;
+  SYM_T  *table;
+  long    trial;
+  int     want;
+
+  for( size = 4; size < 2 * count; size *= 2 )
+  {
+    ;
+  }
+  buckets = size / 4;
+
+  disp = (int *) malloc( sizeof( int ) * buckets );
+  first = (int *) malloc( sizeof( int ) * ( buckets + 1 ));
+  member = (int *) malloc( sizeof( int ) * ( count + 1 ));
+  order = (int *) malloc( sizeof( int ) * ( count + 1 ));
+  table = (SYM_T *) malloc( sizeof( SYM_T ) * size );
+  if( disp == NULL || first == NULL || member == NULL || order == NULL ||
+      table == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
+  }
+
+  /* Sort the symbols by bucket.  The members of bucket bx are member[mx]     */
+  /* for first[bx] <= mx < first[bx + 1].                                     */
+  for( bx = 0; bx <= buckets; bx++ )
+  {
+    first[bx] = 0;
+  }
+  for( ix = 0; ix < count; ix++ )
+  {
+    first[( hashSymbol( syms[ix]->key, 0 ) & ( buckets - 1 )) + 1]++;
+  }
+  for( largest = 0, bx = 0; bx < buckets; bx++ )
+  {
+    largest = ( first[bx + 1] > largest ) ? first[bx + 1] : largest;
+    first[bx + 1] += first[bx];
+    disp[bx] = 0;
+  }
+  for( ix = 0; ix < count; ix++ )
+  {
+    bx = (int) ( hashSymbol( syms[ix]->key, 0 ) & ( buckets - 1 ));
+    member[first[bx] + disp[bx]++] = ix;
+  }
+
+  for( sx = 0; sx < size; sx++ )
+  {
+    table[sx] = as->sym_undefined;
+  }
+
+  /* Place the buckets, largest first, each with the first displacement that  */
+  /* puts all of its symbols in distinct free slots.                          */
+  for( want = largest; want > 0; want-- )
+  {
+    for( bx = 0; bx < buckets; bx++ )
+    {
+      if( first[bx + 1] - first[bx] != want )
+      {
+        continue;
+      }
+      for( trial = 1; trial < PERM_DISP_LIMIT; trial++ )
+      {
+        for( mx = first[bx]; mx < first[bx + 1]; mx++ )
+        {
+          ix = member[mx];
+          sx = (int) ( hashSymbol( syms[ix]->key, trial ) & ( size - 1 ));
+          if( table[sx].key != 0 )
+          {
+            break;
+          }
+          table[sx] = *syms[ix];
+          table[sx].xref_index = 0;
+          table[sx].xref_count = 0;
+          order[ix] = sx;
+        }
+        if( mx == first[bx + 1] )
+        {
+          break;                /* All symbols of the bucket placed.          */
+        }
+
+        /* Collision, so take back the slots of this trial.                   */
+        while( mx-- > first[bx] )
+        {
+          table[order[member[mx]]] = as->sym_undefined;
+        }
+      }
+      if( trial >= PERM_DISP_LIMIT )
+      {
+        free( disp );
+        free( first );
+        free( member );
+        free( order );
+        free( table );
+        return( FALSE );
+      }
+      disp[bx] = (int) trial;
+    }
+  }
+  free( first );
+  free( member );
+
+  if( as->permtab_hashed )
+  {
+    free( as->permtab );
+    free( as->permtab_disp );
+    free( as->permtab_order );
+  }
+  as->permtab_hashed = TRUE;
+  as->permtab = table;
+  as->permtab_disp = disp;
+  as->permtab_order = order;
+  as->permtab_buckets = buckets;
+  as->permtab_count = count;
+  as->permtab_size = size;
+  return( TRUE );
+} /* hashPermanentSymbols()                                                   */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  clearSymbolHash                                                */
 /*                                                                            */
-/*  Synopsis:  Put lexeme into symbol table with a value.                     */
+/*  Synopsis:  Empty the symbol hash index.  Used whenever the symbol table   */
+/*             is reset.                                                      */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *defineLexeme( WORD32  start,     /* start of lexeme being defined.     */
-		         WORD32  term,      /* end+1 of lexeme being defined.     */
-                     WORD32  val,       /* value of lexeme being defined.     */
-                     SYMTYP  type )     /* how symbol is being defined.       */
+void clearSymbolHash( ASM_T *as )
 {
-  char  name[SYMLEN];
+  int  hx;
 
-  lexemeToName( name, start, term);
-  return( defineSymbol( name, val, type, start ));
-} /* defineLexeme()                                                           */
+  for( hx = 0; hx < as->symhash_size; hx++ )
+  {
+    as->symhash[hx] = NULL;
+  }
+} /* clearSymbolHash()                                                        */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  defineSymbol                                                   */
+/*  Function:  growSymbolHash                                                 */
 /*                                                                            */
-/*  Synopsis:  Define a symbol in the symbol table, enter symbol name if not  */
-/*             not already in table.                                          */
+/*  Synopsis:  Double the size of the symbol hash index and enter all the     */
+/*             symbols again.                                                 */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *defineSymbol( char *name, WORD32 val, SYMTYP type, WORD32 start )
+void growSymbolHash( ASM_T *as )
 {
+  int     hx;
+  int     ix;
+  int     size;
   SYM_T  *sym;
-  WORD32  xref_count;
 
-  if( strlen( name ) < 1 )
+  size = ( as->symhash_size == 0 ) ? 2 * SYMBOL_CHUNK_SIZE
+                                   : 2 * as->symhash_size;
+  free( as->symhash );
+  as->symhash = (SYM_T **) malloc( sizeof( SYM_T * ) * size );
+  if( as->symhash == NULL )
   {
-    return( &sym_undefined );   /* Protect against non-existent names.        */
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
   }
-  sym = lookup( name );
-  xref_count = 0;               /* Set concordance for normal defintion.      */
+  as->symhash_size = size;
+  clearSymbolHash( as );
 
-  if( M_DEFINED( sym->type ) && sym->val != val && M_NOTRDEF( sym -> type ))
+  for( ix = 0; ix < as->symbol_top; ix++ )
   {
-    if( pass == 2 )
+    sym = symbolAt( as, ix );
+    for( hx = (int) ( hashSymbol( sym->key, 0 ) & ( size - 1 ));
+         as->symhash[hx] != NULL;
+         hx = ( hx + 1 ) & ( size - 1 ))
     {
-      errorSymbol( &redefined_symbol, sym->name, start );
-      type = type | REDEFINED;
-      sym->xref_count++;      /* Referenced symbol, count it.                */
-      xref_count = sym->xref_count;
+      ;
     }
-  return ( sym );
+    as->symhash[hx] = sym;
   }
-  if( M_FIXED( sym->type ))
+} /* growSymbolHash()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  growSymbolTable                                                */
+/*                                                                            */
+/*  Synopsis:  Add a chunk to the symbol table, twice the size of the last.   */
+/*             Chunks are never moved, so pointers to symbols stay valid.     */
+/*                                                                            */
+/******************************************************************************/
+void growSymbolTable( ASM_T *as )
+{
+  int  size;
+
+  size = SYMBOL_CHUNK_SIZE << as->symbol_chunks;
+  if( as->symbol_chunks < SYMBOL_CHUNKS )
   {
-  return ( sym );
+    as->symchunk[as->symbol_chunks] =
+                                  (SYM_T *) malloc( sizeof( SYM_T ) * size );
   }
-
-  if( pass == 2 && xref )
+  if( as->symbol_chunks >= SYMBOL_CHUNKS
+      || as->symchunk[as->symbol_chunks] == NULL )
   {
-    /* Put the definition line number in the concordance table.               */
-    /* Defined symbols are not counted as references.                         */
-    xreftab[sym->xref_index] = lineno;
-    /* Put the line number in the concordance table.                          */
-    xreftab[sym->xref_index + xref_count] = lineno;
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
   }
-
-  /* Now set the value and the type.                                          */
-  sym->val = ( type == LABEL) ? val : val & 07777;
-  sym->type = ( pass == 1 ) ? ( type | CONDITION ) : type;
-  return( sym );
-} /* defineSymbol()                                                           */
+  as->symbol_chunks++;
+  as->symbol_room += size;
+} /* growSymbolTable()                                                        */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  lookup                                                         */
+/*  Function:  symbolAt                                                       */
 /*                                                                            */
-/*  Synopsis:  Find a symbol in table.  If not in table, enter symbol in      */
-/*             table as undefined.  Return address of symbol in table.        */
+/*  Synopsis:  Return the address of the symbol table entry with index ix.   */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *lookup( char *name )
+SYM_T *symbolAt( ASM_T *as, int ix )
 {
-  int     ix;                   /* Insertion index                            */
-  int     lx;                   /* Left index                                 */
-  int     rx;                   /* Right index                                */
-
-  /* First search the permanent symbols.                                      */
-  lx = 0;
-  ix = binarySearch( name, lx, number_of_fixed_symbols );
+  int  cx;
+  int  size;
 
-  /* If symbol not in permanent symbol table.                                 */
-  if( ix < 0 )
+  for( cx = 0, size = SYMBOL_CHUNK_SIZE; ix >= size; cx++, size *= 2 )
   {
-    /* Now try the user symbol table.                                         */
-    ix = binarySearch( name, number_of_fixed_symbols, symbol_top );
-
-    /* If symbol not in user symbol table.                                    */
-    if( ix < 0 )
-    {
-      /* Must put symbol in table if index is negative.                       */
-      ix = ~ix;
-      if( symbol_top + 1 >= SYMBOL_TABLE_SIZE )
-      {
-        errorSymbol( &symbol_table_full, name, lexstart );
-        exit( 1 );
-      }
-
-      for( rx = symbol_top; rx >= ix; rx-- )
-      {
-        symtab[rx + 1] = symtab[rx];
-      }
-      symbol_top++;
-
-      /* Enter the symbol as UNDEFINED with a value of zero.                  */
-      strcpy( symtab[ix].name, name );
-      symtab[ix].type = UNDEFINED;
-      symtab[ix].val  = 0;
-      symtab[ix].xref_count = 0;
-      if( xref && pass == 2 )
-      {
-        xreftab[symtab[ix].xref_index] = 0;
-      }
-    }
+    ix -= size;
   }
-
-  return( &symtab[ix] );        /* Return the location of the symbol.         */
-} /* lookup()                                                                 */
+  return( &as->symchunk[cx][ix] );
+} /* symbolAt()                                                               */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  binarySearch                                                   */
+/*  Function:  sortSymbolTable                                                */
 /*                                                                            */
-/*  Synopsis:  Searches the symbol table within the limits given.  If the     */
-/*             symbol is not in the table, it returns the insertion point.    */
+/*  Synopsis:  Return a NULL terminated array of pointers to every symbol in  */
+/*             use, the fixed symbols first and then the user symbols, each   */
+/*             part sorted by name.  The number of fixed symbols is returned  */
+/*             through fixed_count.  The caller must free the array.          */
 /*                                                                            */
 /******************************************************************************/
-int binarySearch( char *name, int start, int symbol_count )
+SYM_T **sortSymbolTable( ASM_T *as, int *fixed_count )
 {
-  int     lx;                   /* Left index                                 */
-  int     mx;                   /* Middle index                               */
-  int     rx;                   /* Right index                                */
-  int     compare;              /* Results of comparison                      */
+  int     ix;
+  int     nx;
+  SYM_T **sorted;
 
-  lx = start;
-  rx = symbol_count - 1;
-  while( lx <= rx )
+  sorted = (SYM_T **) malloc( sizeof( SYM_T * ) *
+                              ( as->permtab_count + as->symbol_top + 1 ));
+  if( sorted == NULL )
   {
-    mx = ( lx + rx ) / 2;   /* Find center of search area.                    */
-
-    compare = strcmp( name, symtab[mx].name );
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
+  }
 
-    if( compare < 0 )
-    {
-      rx = mx - 1;
-    }
-    else if( compare > 0 )
-    {
-      lx = mx + 1;
-    }
-    else
+  /* The permanent symbols are kept in name order, so the fixed part only    */
+  /* needs sorting when FIXTAB added to it.                                   */
+  for( nx = 0, ix = 0; ix < as->permtab_count; ix++ )
+  {
+    if( M_PERMANENT( as->permtab[as->permtab_order[ix]].type ))
     {
-      return( mx );         /* Found a match in symbol table.                 */
+      sorted[nx++] = &as->permtab[as->permtab_order[ix]];
     }
-  } /* end while                                                              */
-  return( ~lx );            /* Return insertion point.                        */
-} /* binarySearch()                                                           */
+  }
+  for( ix = 0; ix < as->number_of_fixed_symbols; ix++ )
+  {
+    sorted[nx++] = symbolAt( as, ix );
+  }
+  *fixed_count = nx;
+
+  for( ; ix < as->symbol_top; ix++ )
+  {
+    sorted[nx++] = symbolAt( as, ix );
+  }
+  sorted[nx] = NULL;
+
+  if( as->number_of_fixed_symbols > 0 )
+  {
+    qsort( sorted, *fixed_count, sizeof( sorted[0] ), compareSymbols );
+  }
+  qsort( &sorted[*fixed_count], nx - *fixed_count,
+                                        sizeof( sorted[0] ), compareSymbols );
+  return( sorted );
+} /* sortSymbolTable()                                                        */
 
 
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  compareSymbols                                                 */
 /*                                                                            */
-/*  Synopsis:  Used to presort the symbol table when starting assembler.      */
+/*  Synopsis:  Used to sort symbol table pointers by name for the listings.   */
 /*                                                                            */
 /******************************************************************************/
 int compareSymbols( const void *a, const void *b )
 {
-  return( strcmp( ((SYM_T *) a)->name, ((SYM_T *) b)->name ));
+  SYMKEY  ka;
+  SYMKEY  kb;
+
+  ka = (*(SYM_T **) a)->key;
+  kb = (*(SYM_T **) b)->key;
+  return(( ka < kb ) ? -1 : ( ka > kb ));
 } /* compareSymbols()                                                         */
 
 /******************************************************************************/
@@ -3305,9 +6313,10 @@ int compareSymbols( const void *a, const void *b )
 /*  Synopsis:  Used to copy a macro line to the macro buffer.                 */
 /*                                                                            */
 /******************************************************************************/
-int copyMacLine( int length, int from, int term, int nargs )
+int copyMacLine( ASM_T *as, int length, int from, int term, int nargs )
 {
   char    name[SYMLEN];
+  int     column;
   int     ix;
   int     jx;
   int     kx;
@@ -3316,27 +6325,30 @@ int copyMacLine( int length, int from, int term, int nargs )
   bl = TRUE;
   for( ix = from; ix < term; ix++ )
   {
-    if( !is_blank( line[ix] )) bl = FALSE;
+    if( !is_blank( as->line[ix] )) bl = FALSE;
   }
   if( bl || ( length < 0 )) return length;
-  if(( length + term - from + 1) >= MAC_MAX_LENGTH ) return -1;
+  if(( length + expandedColumn( as, term ) - expandedColumn( as, from ) + 1)
+                                             >= MAC_MAX_LENGTH ) return -1;
+  column = expandedColumn( as, from );
   for( ix = from; ix < term; )
   {
-    if( nargs && isalpha( line[ix] ))      /* Start of symbol?                */
+    if( nargs && isalpha( as->line[ix] ))      /* Start of symbol?            */
     {
       for( jx = ix + 1; jx < term; jx++)   /* Find end of symbol.             */
       {
-        if( !isalnum( line[jx] )) break;
+        if( !isalnum( as->line[jx] )) break;
       }
-      lexemeToName( name, ix, jx );        /* Make into name.                 */
+      lexemeToName( as, name, ix, jx );        /* Make into name.             */
+      column += jx - ix;
       for( kx = 0; kx < nargs; kx++ )      /* Compare to arguments.           */
       {
-        if( strncmp( name, &mac_arg_name[kx + 1][0], SYMLEN ) == 0 )
+        if( strncmp( name, &as->mac_arg_name[kx + 1][0], SYMLEN ) == 0 )
         {
-           mac_buffer[length++] = 'a' + (char) kx;
+           as->mac_buffer[length++] = 'a' + (char) kx;
            for( ix++; ix < jx; ix++ )
            {
-             mac_buffer[length++] = 'z';
+             as->mac_buffer[length++] = 'z';
            }
            break;
         } /* end if strncmp                                                   */
@@ -3345,17 +6357,26 @@ int copyMacLine( int length, int from, int term, int nargs )
       {
         for ( ; ix < jx; )
         {
-          mac_buffer[length++] = toupper( line[ix++] );
+          as->mac_buffer[length++] = toupper( as->line[ix++] );
 		}
       }
     } /*end if nargs                                                          */
+    else if( as->line[ix] == '\t' )           /* Keep tabs as listed.         */
+    {
+      jx = tabWidth( as, ix++, column );
+      for( column += jx; jx > 0; jx-- )
+      {
+        as->mac_buffer[length++] = ' ';
+      }
+    }
     else
     {
-      mac_buffer[length++] = toupper( line[ix++] );
+      as->mac_buffer[length++] = toupper( as->line[ix++] );
+      column++;
     } /* end else                                                            */
   } /* end for ix                                                            */
-  mac_buffer[length++] = '\n';
-  mac_buffer[length] = 0;
+  as->mac_buffer[length++] = '\n';
+  as->mac_buffer[length] = 0;
   return length;
 }
 
@@ -3367,23 +6388,146 @@ int copyMacLine( int length, int from, int term, int nargs )
 /*             If symbol doesn't exist, return a pointer to the undefined sym */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *evalSymbol()
+SYM_T *evalSymbol( ASM_T *as )
 {
-  char   name[SYMLEN];
   SYM_T *sym;
 
-  sym = lookup( lexemeToName( name, lexstart, lexterm ));
+  sym = lookup( as, lexemeToKey( as, as->lexstart, as->lexterm ));
+  xrefSymbol( as, sym );
+  return( sym );
+} /* evalSymbol()                                                             */
 
-  sym->xref_count++;            /* Count the number of references to symbol.  */
 
-  if( xref && pass == 2 )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  xrefSymbol                                                     */
+/*                                                                            */
+/*  Synopsis:  Count a reference to sym.                                      */
+/*                                                                            */
+/******************************************************************************/
+void xrefSymbol( ASM_T *as, SYM_T *sym )
+{
+  /* Only the concordance needs the references, so without it the shared      */
+  /* permanent symbols are not written to.  Pass 2 alone fills it in.         */
+  if( !as->xref || as->pass != 2 )
   {
-    /* Put the line number in the concordance table.                          */
-    xreftab[sym->xref_index + sym->xref_count] = lineno;
+    return;
   }
 
-  return( sym );
-} /* evalSymbol()                                                             */
+  /* Put the line number in the concordance table.                            */
+  addXref( as, sym, as->lineno );
+} /* xrefSymbol()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  xrefEntry                                                      */
+/*                                                                            */
+/*  Synopsis:  Return the concordance entry of sym, making one if it has none.*/
+/*                                                                            */
+/******************************************************************************/
+XREF_T *xrefEntry( ASM_T *as, SYM_T *sym )
+{
+  XREF_T *xr;
+
+  if( sym->xref_index == 0 )
+  {
+    if( as->xref_used == 0 )
+    {
+      as->xref_used = 1;            /* Entry 0 is none.                       */
+    }
+    as->xrefs = (XREF_T *) growTable( as->xrefs, &as->xref_room,
+                                      sizeof( XREF_T ), as->xref_used + 1 );
+    xr = &as->xrefs[as->xref_used];
+    xr->def = 0;
+    xr->first = 0;
+    xr->last = 0;
+    xr->fill = 0;
+    xr->line = 0;
+    sym->xref_index = as->xref_used++;
+  }
+  return( &as->xrefs[sym->xref_index] );
+} /* xrefEntry()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addXref                                                        */
+/*                                                                            */
+/*  Synopsis:  Add a reference on line to the concordance entry of sym.       */
+/*                                                                            */
+/******************************************************************************/
+void addXref( ASM_T *as, SYM_T *sym, int line )
+{
+  unsigned int code;
+  XREF_T      *xr;
+
+  xr = xrefEntry( as, sym );
+  code = ( line < xr->line ) ? ((unsigned int) ( xr->line - line ) << 1 ) - 1
+                             : (unsigned int) ( line - xr->line ) << 1;
+  xr->line = line;
+  do
+  {
+    if( xr->first == 0 || xr->fill == XREF_BLOCK_BYTES )
+    {
+      if( as->xrefblock_used == 0 )
+      {
+        as->xrefblock_used = 1;     /* Block 0 is none.                       */
+      }
+      as->xrefblocks = (XREFBLOCK_T *) growTable( as->xrefblocks,
+                                                  &as->xrefblock_room,
+                                                  sizeof( XREFBLOCK_T ),
+                                                  as->xrefblock_used + 1 );
+      as->xrefblocks[as->xrefblock_used].next = 0;
+      if( xr->first == 0 )
+      {
+        xr->first = as->xrefblock_used;
+      }
+      else
+      {
+        as->xrefblocks[xr->last].next = as->xrefblock_used;
+      }
+      xr->last = as->xrefblock_used++;
+      xr->fill = 0;
+    }
+    as->xrefblocks[xr->last].bytes[xr->fill++] =
+                          (BYTE) (( code & 0177 ) | ( code > 0177 ? 0200 : 0 ));
+    code >>= 7;
+  } while( code != 0 );
+  sym->xref_count++;            /* Count the number of references to symbol.  */
+} /* addXref()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  nextXref                                                       */
+/*                                                                            */
+/*  Synopsis:  Return the difference of the next reference of a concordance   */
+/*             entry from the one before, read from byte pos of block, both   */
+/*             of which are moved past it.                                    */
+/*                                                                            */
+/******************************************************************************/
+int nextXref( ASM_T *as, int *block, int *pos )
+{
+  BYTE         byte;
+  unsigned int code;
+  int          shift;
+
+  code = 0;
+  shift = 0;
+  do
+  {
+    if( *pos == XREF_BLOCK_BYTES )
+    {
+      *block = as->xrefblocks[*block].next;
+      *pos = 0;
+    }
+    byte = as->xrefblocks[*block].bytes[( *pos )++];
+    code |= (unsigned int) ( byte & 0177 ) << shift;
+    shift += 7;
+  } while( byte & 0200 );
+  return(( code & 1 ) ? -(int) (( code + 1 ) >> 1 ) : (int) ( code >> 1 ));
+} /* nextXref()                                                               */
 
 
 /******************************************************************************/
@@ -3393,14 +6537,82 @@ SYM_T *evalSymbol()
 /*  Synopsis:  Move the parser input to the end of the current input line.    */
 /*                                                                            */
 /******************************************************************************/
-void moveToEndOfLine()
+void moveToEndOfLine( ASM_T *as )
 {
-  while( !isend( line[cc] )) cc++;
-  lexstart = cc;
-  lexterm = cc;
-  lexstartprev = lexstart;
+  /* Only the last character of a line can end it, so there is no need to    */
+  /* look for the end.                                                        */
+  as->cc = ( as->maxcc > 0 && isend( as->line[as->maxcc - 1] ))
+           ? as->maxcc - 1 : as->maxcc;
+  as->lexstart = as->cc;
+  as->lexterm = as->cc;
+  as->lexstartprev = as->lexstart;
 } /* moveToEndOfLine()                                                        */
 
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  expandedColumn                                                 */
+/*                                                                            */
+/*  Synopsis:  Return the listing column of column col of the current line.   */
+/*             Tabs are only expanded, to 8 character tab stops, when the     */
+/*             line is listed or an error in it is reported.                  */
+/*                                                                            */
+/******************************************************************************/
+int expandedColumn( ASM_T *as, int col )
+{
+  int     ix;
+  int     iy;
+
+  for( ix = 0, iy = 0; ix < col && ix < as->maxcc; ix++ )
+  {
+    iy = ( as->line[ix] == '\t' ) ? ( iy / 8 + 1 ) * 8 : iy + 1;
+  }
+  return( iy + col - ix );
+} /* expandedColumn()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  tabWidth                                                       */
+/*                                                                            */
+/*  Synopsis:  Return the number of listing columns taken by the character at */
+/*             column col of the current line, listed at listing column       */
+/*             column: one, or up to 8 for a tab.  The callers keep column as */
+/*             they go along the line, so that it is not counted again.       */
+/*                                                                            */
+/******************************************************************************/
+int tabWidth( ASM_T *as, int col, int column )
+{
+  return(( as->line[col] == '\t' ) ? 8 - column % 8 : 1 );
+} /* tabWidth()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  skipSpaces                                                     */
+/*                                                                            */
+/*  Synopsis:  Skip runs of spaces a word at a time.                          */
+/*             Whole words within the line are compared with a word of        */
+/*             spaces; the rest of the blanks are left to the caller.         */
+/*                                                                            */
+/******************************************************************************/
+void skipSpaces( ASM_T *as )
+{
+  unsigned long  spaces;
+  unsigned long  word;
+
+  spaces = ~0UL / 0377 * ' ';
+  while( as->cc + (int) sizeof( word ) <= as->maxcc )
+  {
+    memcpy( &word, &as->line[as->cc], sizeof( word ));
+    if( word != spaces )
+    {
+      break;
+    }
+    as->cc += sizeof( word );
+  }
+} /* skipSpaces()                                                             */
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  nextLexeme                                                     */
@@ -3408,37 +6620,57 @@ void moveToEndOfLine()
 /*  Synopsis:  Get the next lexical element from input line.                  */
 /*                                                                            */
 /******************************************************************************/
-void nextLexeme()
+void nextLexeme( ASM_T *as )
 {
+  BOOL      cache;
+  int       from;
+  LEXEME_T *lex;
+
   /* Save start column of previous lexeme for diagnostic messages.            */
-  lexstartprev = lexstart;
-  lextermprev = lexterm;
+  as->lexstartprev = as->lexstart;
+  as->lextermprev = as->lexterm;
+
+  /* In pass 2, take the lexeme pass 1 found from this column, if any.        */
+  if( as->pass == 2 && as->lexeme_line >= 0 &&
+      as->lexeme_next < as->srclines[as->lexeme_line].lexeme
+                        + as->srclines[as->lexeme_line].lexemes &&
+      as->lexemes[as->lexeme_next].from == as->cc )
+  {
+    lex = &as->lexemes[as->lexeme_next++];
+    as->lexstart = lex->start;
+    as->cc = as->lexterm = lex->term;
+    return;
+  }
 
-  while( is_blank( line[cc] )) { cc++; }
-  lexstart = cc;
+  cache = ( as->pass == 1 && as->lexeme_line >= 0 );
+  from = as->cc;
+  skipSpaces( as );
+  while( is_blank( as->line[as->cc] )) { as->cc++; }
+  as->lexstart = as->cc;
 
-  if( isalnum( line[cc] ))
+  if( is_alnum( as->line[as->cc] ))
   {
-    while( isalnum( line[cc] )) { cc++; }
+    while( is_alnum( as->line[as->cc] )) { as->cc++; }
   }
-  else if( isend( line[cc] ))
+  else if( isend( as->line[as->cc] ))
   {
     /* End-of-Line, don't advance cc!                                         */
   }
   else
   {
-    switch( line[cc] )
+    switch( as->line[as->cc] )
     {
-    case '"':     /* Quoted letter                                            */
-      if( cc + 2 < maxcc )
+    case '"':     /* Quoted letter, counted in listing columns for tabs.      */
+      if( expandedColumn( as, as->cc ) + 2 < expandedColumn( as, as->maxcc ))
       {
-        cc++;
-        cc++;
+        as->cc++;
+        as->cc++;
       }
       else
       {
-        errorMessage( &no_literal_value, lexstart );
-        cc++;
+        errorMessage( as, &no_literal_value, as->lexstart );
+        as->cc++;
+        cache = FALSE;          /* Scan again in pass 2 to report the error.  */
       }
       break;
 
@@ -3446,11 +6678,23 @@ void nextLexeme()
       break;
 
     default:      /* All other punctuation.                                   */
-      cc++;
+      as->cc++;
       break;
     }
   }
-  lexterm = cc;
+  as->lexterm = as->cc;
+
+  if( cache )
+  {
+    as->lexemes = (LEXEME_T *) growTable( as->lexemes, &as->lexeme_room,
+                                          sizeof( LEXEME_T ),
+                                          as->lexeme_count + 1 );
+    lex = &as->lexemes[as->lexeme_count++];
+    lex->from = from;
+    lex->start = as->lexstart;
+    lex->term = as->lexterm;
+    as->srclines[as->lexeme_line].lexemes++;
+  }
 } /* nextLexeme()                                                             */
 
 
@@ -3461,14 +6705,14 @@ void nextLexeme()
 /*  Synopsis:  Used to prevent illegal blanks in expressions.                 */
 /*                                                                            */
 /******************************************************************************/
-void nextLexBlank()
+void nextLexBlank( ASM_T *as )
 {
-  nextLexeme();
-  if( is_blank( delimiter ))
+  nextLexeme( as );
+  if( is_blank( as->delimiter ))
   {
-    errorMessage( &illegal_blank, lexstart - 1 );
+    errorMessage( as, &illegal_blank, as->lexstart - 1 );
   }
-  delimiter = line[lexterm];
+  as->delimiter = as->line[as->lexterm];
 } /* nextLexBlank()                                                           */
  
 
@@ -3480,8 +6724,9 @@ void nextLexBlank()
 /*  Synopsis:  Process pseudo-ops (directives).                               */
 /*                                                                            */
 /******************************************************************************/
-BOOL pseudoOperators( PSEUDO_T val )
+BOOL pseudoOperators( ASM_T *as, PSEUDO_T val )
 {
+  int     column;
   int     count;
   int     delim;
   int     index;
@@ -3495,6 +6740,7 @@ BOOL pseudoOperators( PSEUDO_T val )
   int     pageno;
   int     pos;
   int     radixprev;
+  int     spaces;
   BOOL    status;
   SYM_T  *sym;
   WORD32  value;
@@ -3510,391 +6756,391 @@ BOOL pseudoOperators( PSEUDO_T val )
   case BINPUNCH:
     /* If there has been data output and this is a mode switch, set up to     */
     /* output data in BIN mode.                                               */
-    if( binary_data_output && rim_mode )
+    if( as->binary_data_output && as->rim_mode )
     {
       for( ix = 0; ix < TOTAL_PAGES; ix++)
       {
-        lit_loc[ix] = lit_base[ix] = 00200;
+        as->lit_loc[ix] = as->lit_base[ix] = 00200;
       }
-      cp.error = FALSE;
-      pz.error = FALSE;
-      punchLeader( 8 );         /* Generate a short leader/trailer.           */
-      checksum = 0;
-      binary_data_output = FALSE;
+      as->cp.error = FALSE;
+      as->pz.error = FALSE;
+      punchLeader( as, 8 );         /* Generate a short leader/trailer.       */
+      as->checksum = 0;
+      as->binary_data_output = FALSE;
     }
-    rim_mode = FALSE;
+    as->rim_mode = FALSE;
     break;
 
   case DECIMAL:
-    radix = 10;
+    as->radix = 10;
     break;
 
   case DEFINE:
     count = 0;
     index = 0;
-    lexstartsave = lexstart;
-    while(( line[lexstart] != '<' ) && ( !isdone( line[lexstart] )) &&
+    lexstartsave = as->lexstart;
+    while(( as->line[as->lexstart] != '<' ) &&
+          ( !isdone( as->line[as->lexstart] )) &&
           ( count < MAC_MAX_ARGS ))
     {
-      if ( !isalpha( line[lexstart] ) && ( index == 0 ))
+      if ( !isalpha( as->line[as->lexstart] ) && ( index == 0 ))
       {
-        index = lexstart;
+        index = as->lexstart;
       }
-      lexemeToName( &mac_arg_name[count++][0], lexstart, lexterm );
-      nextLexeme();
+      lexemeToName( as, &as->mac_arg_name[count++][0], as->lexstart,
+                    as->lexterm );
+      nextLexeme( as );
     }
     if( count == 0 )                 /* No macro name.                        */
     {
-      errorMessage( &no_macro_name, lexstartsave );
+      errorMessage( as, &no_macro_name, lexstartsave );
       index = 1;
     }
     else if( index )                 /* Bad argument name.                    */
     {
-      errorMessage( &bad_dummy_arg, index );
+      errorMessage( as, &bad_dummy_arg, index );
     }
-    else if( mac_count >= MAC_TABLE_LENGTH )
+    else if( as->mac_count >= MAC_TABLE_LENGTH )
     {
-      errorMessage( &macro_table_full, lexstartsave );
+      errorMessage( as, &macro_table_full, lexstartsave );
       index = 1;
     }
     else
     {
-      value = mac_count;
-      mac_count++;                  /* Value is entry in mac_bodies.         */
-      defineSymbol( &mac_arg_name[0][0], value, MACRO, lexstartsave );
+      value = as->mac_count;
+      as->mac_count++;                  /* Value is entry in mac_bodies.      */
+      defineSymbol( as, nameToKey( &as->mac_arg_name[0][0] ), value, MACRO,
+                                                              lexstartsave );
     }
-    if( isend( line[lexstart] ) || ( line[lexstart] == '/' ))
+    if( isend( as->line[as->lexstart] ) || ( as->line[as->lexstart] == '/' ))
     {
-      readLine();
-      nextLexeme();
+      readLine( as );
+      nextLexeme( as );
     }
     if( index )
     {
-      conditionFalse();             /* On error skip macro body.             */
+      conditionFalse( as );             /* On error skip macro body.          */
     }
-    else if( line[lexstart] == '<' )
+    else if( as->line[as->lexstart] == '<' )
     {
       /* Invariant: line[cc] is the next unexamined character.                */
-      index = lexstart + 1;
+      index = as->lexstart + 1;
       length = 0;
       level = 1;
       while( level > 0 )
       {
-        if( isend( line[cc] ) || ( line[cc] == '/' ))
+        if( isend( as->line[as->cc] ) || ( as->line[as->cc] == '/' ))
         {
-          length = copyMacLine( length, index, cc, count - 1 );
-          readLine();
+          length = copyMacLine( as, length, index, as->cc, count - 1 );
+          readLine( as );
           index = 0;
         }
         else
         {
-          switch( line[cc] )
+          switch( as->line[as->cc] )
           {
           case '>':
             level--;
-            cc++;
+            as->cc++;
             break;
 
           case '<':
             level++;
-            cc++;
+            as->cc++;
             break;
 
           case '$':
             level = 0;
-            cc++;
+            as->cc++;
             break;
 
           default:
-            cc++;
+            as->cc++;
             break;
           } /* end switch                                                     */
         } /* end if                                                           */
       } /* end while                                                          */
-      length = copyMacLine( length, index, cc - 1, count - 1 );
+      length = copyMacLine( as, length, index, as->cc - 1, count - 1 );
       if( length < 0 )
       {
-        errorMessage (&macro_too_long, lexstart );
+        errorMessage ( as, &macro_too_long, as->lexstart );
       }
       else if( length == 0 )
       {
-        mac_bodies[value] = NULL;
+        as->mac_bodies[value] = NULL;
       }
       else
       {
-        mac_bodies[value] = (char *) malloc( length + 1 );
-        if( mac_bodies[value] )
+        as->mac_bodies[value] = (char *) malloc( length + 1 );
+        if( as->mac_bodies[value] )
         {
-           strncpy( mac_bodies[value], mac_buffer, length );
-           *( mac_bodies[value] + length ) = 0;
+           strncpy( as->mac_bodies[value], as->mac_buffer, length );
+           *( as->mac_bodies[value] + length ) = 0;
         }
         else
         {
-           errorMessage( &no_virtual_memory, lexstart );
+           errorMessage( as, &no_virtual_memory, as->lexstart );
         }
       }
-      nextLexeme();
+      nextLexeme( as );
     }
     else
     {
-      errorMessage( &lt_expected, lexstart );
+      errorMessage( as, &lt_expected, as->lexstart );
     } /* end if                                                               */
     break;
       
   case DUBL:
-    inputDubl();
+    inputDubl( as );
     break;
 
   case EJECT:
-    page_lineno = LIST_LINES_PER_PAGE;  /* This will force a page break.      */
+    listNewPage( as, LISTREC_EJECT );   /* This will force a page break.      */
     status = FALSE;             /* This will force reading of next line       */
     break;
 
   case ENPUNCH:
-    if( pass == 2 )
+    if( as->pass == 2 )
     {
-      objectfile = objectsave;
+      as->objectfile = as->objectsave;
     }
     break;
 
   case EXPUNGE:                 /* Erase symbol table                         */
-    if( pass == 1 )
+    if( as->pass == 1 )
     {
-      symtab[0] = sym_undefined;
-      symbol_top = 0;
-      number_of_fixed_symbols = symbol_top;
-      fixed_symbols = &symtab[symbol_top - 1];
+      as->symbol_top = 0;
+      clearSymbolHash( as );
+      as->number_of_fixed_symbols = as->symbol_top;
+
+      /* Only the pseudo-ops are left in the permanent symbol table.          */
+      as->permanent_expunged = TRUE;
+
+      /* The code compiled so far refers to the symbols just erased.          */
+      as->coded_valid = as->coded_count;
 
-      /* Enter the pseudo-ops into the symbol table.                          */
-      for( ix = 0; ix < DIM( pseudo ); ix++ )
-      {
-        defineSymbol( pseudo[ix].name, pseudo[ix].val, pseudo[ix].type, 0 );
-      }
       /* Enter I and Z into the symbol table.                                 */
       for( ix = 0; ix < 2; ix++ )
       {
-        defineSymbol( permanent_symbols[ix].name,
+        defineSymbol( as, nameToKey( permanent_symbols[ix].name ),
                       permanent_symbols[ix].val,
                       permanent_symbols[ix].type | DEFFIX , 0 );
       }
-      number_of_fixed_symbols = symbol_top;
-      fixed_symbols = &symtab[symbol_top - 1];
+      as->number_of_fixed_symbols = as->symbol_top;
     }
     break;
 
   case BANK:
   case FIELD:
-    punchLiteralPool( &cp, clc - 1 );
-    punchLiteralPool( &pz, field );
-    newfield = field >> 12;
-    lexstartsave = lexstartprev;
-    if( isdone( line[lexstart] ))
+    punchLiteralPool( as, &as->cp, as->clc - 1 );
+    punchLiteralPool( as, &as->pz, as->field );
+    newfield = as->field >> 12;
+    lexstartsave = as->lexstartprev;
+    if( isdone( as->line[as->lexstart] ))
     {
       newfield += 1;            /* Blank FIELD directive.                     */
     }
     else
     {
-      newfield = (getExpr())->val;      /* FIELD with argument.               */
+      newfield = (getExpr( as ))->val;      /* FIELD with argument.           */
     }
 
-    if( rim_mode )
+    if( as->rim_mode )
     {
-      errorMessage( &in_rim_mode, lexstartsave ); /* Can't change fields.     */
+      errorMessage( as, &in_rim_mode, lexstartsave ); /* Can't change fields. */
     }
     else if( newfield > 7 || newfield < 0 )
     {
-      errorMessage( &illegal_field_value, lexstartprev );
+      errorMessage( as, &illegal_field_value, as->lexstartprev );
     }
     else
     {
       value = (( newfield & 0007 ) << 3 ) | 00300;
-      punchObject( value );
-      checksum -= value;        /* Field punches are not added to checksum.   */
-      field = newfield << 12;
+      punchObject( as, value );
+      as->checksum -= value;      /* Field punches are not added to checksum. */
+      as->field = newfield << 12;
     }
 
-    clc = 0200 | field;
-    fieldlc = clc & 07777;
+    as->clc = 0200 | as->field;
+    as->fieldlc = as->clc & 07777;
 
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
     break;
 
   case FIXTAB:
     /* Mark all current symbols as permanent symbols.                         */
-    if( pass == 1)
+    if( as->pass == 1)
     {
-      for( ix = 0; ix < symbol_top; ix++ )
+      for( ix = 0; ix < as->symbol_top; ix++ )
       {
-        symtab[ix].type = ( symtab[ix].type | FIXED ) & ~CONDITION;
-        if((( symtab[ix].val & 00777 ) == 0 ) &&
-		    ( symtab[ix].val <= 05000 ) && 
-              M_DEFINED( symtab[ix].type ) &&
-		     !M_PSEUDO( symtab[ix].type ) &&
-             !M_LABEL( symtab[ix].type ) &&
-             !M_MACRO( symtab[ix].type ))
+        sym = symbolAt( as, ix );
+        sym->type = ( sym->type | FIXED ) & ~CONDITION;
+        if((( sym->val & 00777 ) == 0 ) &&
+		    ( sym->val <= 05000 ) && 
+              M_DEFINED( sym->type ) &&
+		     !M_PSEUDO( sym->type ) &&
+             !M_LABEL( sym->type ) &&
+             !M_MACRO( sym->type ))
         {
-          symtab[ix].type = symtab[ix].type | MRI;
+          sym->type = sym->type | MRI;
         }
       }
-      number_of_fixed_symbols = symbol_top;
-      fixed_symbols = &symtab[symbol_top - 1];
-
-      /* Re-sort the symbol table                                               */
-      qsort( symtab, symbol_top, sizeof(symtab[0]), compareSymbols );
+      as->number_of_fixed_symbols = as->symbol_top;
     }
     break;
 
   case FLTG:
-    inputFltg();
+    inputFltg( as );
     /* errorSymbol( &no_pseudo_op, "FLTG", lexstartprev ); */
     break;
 
   case IFDEF:
-    if( isalpha( line[lexstart] ))
+    if( isalpha( as->line[as->lexstart] ))
     {
-      sym = evalSymbol();
-      nextLexeme();
+      sym = evalSymbol( as );
+      nextLexeme( as );
       if( M_DEFINED_CONDITIONALLY( sym->type ))
       {
-        conditionTrue();
+        conditionTrue( as );
       }
       else
       {
-        conditionFalse();
+        conditionFalse( as );
       }
     }
     else
     {
-      errorLexeme( &label_syntax, lexstart );
+      errorLexeme( as, &label_syntax, as->lexstart );
     }
     break;
 
   case IFNDEF:
-    if( isalpha( line[lexstart] ))
+    if( isalpha( as->line[as->lexstart] ))
     {
-      sym = evalSymbol();
-      nextLexeme();
+      sym = evalSymbol( as );
+      nextLexeme( as );
       if( M_DEFINED_CONDITIONALLY( sym->type ))
       {
-        conditionFalse();
+        conditionFalse( as );
       }
       else
       {
-        conditionTrue();
+        conditionTrue( as );
       }
     }
     else
     {
-      errorLexeme( &label_syntax, lexstart );
+      errorLexeme( as, &label_syntax, as->lexstart );
     }
     break;
 
   case IFNZERO:
-    if( (getExpr())->val == 0 )
+    if( (getExpr( as ))->val == 0 )
     {
-      conditionFalse();
+      conditionFalse( as );
     }
     else
     {
-      conditionTrue();
+      conditionTrue( as );
     }
     break;
 
   case IFZERO:
-    if( (getExpr())->val == 0 )
+    if( (getExpr( as ))->val == 0 )
     {
-      conditionTrue();
+      conditionTrue( as );
     }
     else
     {
-      conditionFalse();
+      conditionFalse( as );
     }
     break;
 
   case LGM:
-    lgm_flag = TRUE;
+    as->lgm_flag = TRUE;
     break;
 
   case LIST:
-    listfile = listsave;
+    as->listfile = as->listsave;
     break;
 
   case LIT:
-    if( clc & 07600 )
+    if( as->clc & 07600 )
     {
-      punchLiteralPool( &cp, clc );
+      punchLiteralPool( as, &as->cp, as->clc );
     }
     else
     {
-      punchLiteralPool( &pz, field );
+      punchLiteralPool( as, &as->pz, as->field );
     }
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
     break;
 
   case LITBAS:
-    if( clc & 07600 )
+    if( as->clc & 07600 )
     {
-      punchLiteralPool( &cp, clc );
+      punchLiteralPool( as, &as->cp, as->clc );
     }
     else
     {
-      punchLiteralPool( &pz, field );
+      punchLiteralPool( as, &as->pz, as->field );
     }
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
-    pageno = GET_PAGE (clc);
-    if( isdone( line[lexstart] ))
+    pageno = GET_PAGE (as->clc);
+    if( isdone( as->line[as->lexstart] ))
     {
-	lit_loc[pageno] = lit_base[pageno] = 0200;
+	as->lit_loc[pageno] = as->lit_base[pageno] = 0200;
     }
     else
     {
-      lit_loc[pageno] = lit_base[pageno] = (((getExpr())->val) & 0177) + 1;
+      as->lit_loc[pageno] = as->lit_base[pageno] =
+                                        (((getExpr( as ))->val) & 0177) + 1;
     }
     break;
 
   case NOLGM:
-    lgm_flag = FALSE;
+    as->lgm_flag = FALSE;
     break;
 
   case NOPUNCH:
-    if( pass == 2 )
+    if( as->pass == 2 )
     {
-      objectfile = NULL;
+      as->objectfile = NULL;
     }
     break;
 
   case OCTAL:
-    radix = 8;
+    as->radix = 8;
     break;
 
   case PAGE:
-    punchLiteralPool( &cp, clc - 1 );
-    oldclc = clc;
-    if( isdone( line[lexstart] ))
+    punchLiteralPool( as, &as->cp, as->clc - 1 );
+    oldclc = as->clc;
+    if( isdone( as->line[as->lexstart] ))
     {
-		clc = ( clc + 0177 ) & 077600;            /* No argument.               */
-		fieldlc = clc & 07777;
+		as->clc = ( as->clc + 0177 ) & 077600;            /* No argument.           */
+		as->fieldlc = as->clc & 07777;
 	 }
 	 else
 	 {
-		value = (getExpr())->val;
-		clc = field + (( value & 037 ) << 7 );
-		fieldlc = clc & 07777;
+		value = (getExpr( as ))->val;
+		as->clc = as->field + (( value & 037 ) << 7 );
+		as->fieldlc = as->clc & 07777;
 	 }
-	 testForLiteralCollision( clc );
+	 testForLiteralCollision( as, as->clc );
 
-	 if( !rim_mode && clc != oldclc )
+	 if( !as->rim_mode && as->clc != oldclc )
 	 {
-		punchOrigin( clc );
+		punchOrigin( as, as->clc );
 	 }
 	 break;
 
@@ -3902,171 +7148,190 @@ BOOL pseudoOperators( PSEUDO_T val )
 	 break;
 
   case RELOC:
-	 if( isdone( line[lexstart] ))
+	 if( isdone( as->line[as->lexstart] ))
 	 {
-		reloc = 0;                  /* Blank RELOC directive.                     */
+		as->reloc = 0;                  /* Blank RELOC directive.                   */
     }
     else
     {
-      value = (getExpr())->val; /* RELOC with argument.                       */
-      reloc = value - ( clc + reloc );
+      value = (getExpr( as ))->val; /* RELOC with argument.                   */
+      as->reloc = value - ( as->clc + as->reloc );
     }
     break;
 
   case RIMPUNCH:
     /* If the assembler has output any BIN data, output the literal tables    */
     /* and the checksum for what has been assembled and setup for RIM mode.   */
-    if( binary_data_output && !rim_mode )
+    if( as->binary_data_output && !as->rim_mode )
     {
-      endOfBinary();
-      punchChecksum();
-      punchLeader( 8 );         /* Generate a short leader/trailer.           */
+      endOfBinary( as );
+      punchChecksum( as );
+      punchLeader( as, 8 );         /* Generate a short leader/trailer.       */
     }
-    rim_mode = TRUE;
+    as->rim_mode = TRUE;
     break;
 
   case TEXT:
-    delim = line[lexstart];
+    delim = as->line[as->lexstart];
     pack = 0;
     count = 0;
-    index = lexstart + 1;
-    while( line[index] != delim && !isend( line[index] ))
+    index = as->lexstart + 1;
+    column = expandedColumn( as, index );
+    while( as->line[index] != delim && !isend( as->line[index] ))
     {
-      pack = ( pack << 6 ) | ( line[index] & 077 );
-      count++;
-      if( count > 1 )
+      /* A tab is packed as the spaces it is listed as.                       */
+      spaces = tabWidth( as, index, column );
+      column += spaces;
+      for( ; spaces > 0; spaces-- )
       {
-        punchOutObject( clc, pack );
-        incrementClc();
-        count = 0;
-        pack = 0;
+        pack = ( pack << 6 ) |
+               ((( as->line[index] == '\t' ) ? ' ' : as->line[index] ) & 077 );
+        count++;
+        if( count > 1 )
+        {
+          punchOutObject( as, as->clc, pack );
+          incrementClc( as );
+          count = 0;
+          pack = 0;
+        }
       }
       index++;
     }
 
     if( count != 0 )
     {
-      punchOutObject( clc, pack << 6 );
-      incrementClc();
+      punchOutObject( as, as->clc, pack << 6 );
+      incrementClc( as );
     }
     else
     {
-      punchOutObject( clc, 0 );
-      incrementClc();
+      punchOutObject( as, as->clc, 0 );
+      incrementClc( as );
     }
 
-    if( isend( line[index] ))
+    if( isend( as->line[index] ))
     {
-      cc = index;
-      lexterm = cc;
-      errorMessage( &text_string, cc );
+      as->cc = index;
+      as->lexterm = as->cc;
+      errorMessage( as, &text_string, as->cc );
     }
     else
     {
-      cc = index + 1;
-      lexterm = cc;
+      as->cc = index + 1;
+      as->lexterm = as->cc;
     }
-    nextLexeme();
+    nextLexeme( as );
     break;
 
   case TITLE:
-    delim = line[lexstart];
-    ix = lexstart + 1;
+    delim = as->line[as->lexstart];
+    ix = as->lexstart + 1;
     /* Find string delimiter.                                                 */
     do
     {
-      if( list_title[ix] == delim && list_title[ix + 1] == delim )
+      if( as->line[ix] == delim && as->line[ix + 1] == delim )
       {
         ix++;
       }
       ix++;
-    } while( line[ix] != delim && !isend(line[ix]) );
+    } while( as->line[ix] != delim && !isend(as->line[ix]) );
 
-    if( !isend( line[ix] ) )
+    if( !isend( as->line[ix] ) )
     {
       count = 0;
-      ix = lexstart + 1;
+      ix = as->lexstart + 1;
+      column = expandedColumn( as, ix );
       do
       {
-        if( list_title[ix] == delim && list_title[ix + 1] == delim )
+        if( as->line[ix] == delim && as->line[ix + 1] == delim )
         {
           ix++;
+          column++;
+        }
+        spaces = tabWidth( as, ix, column );
+        column += spaces;
+        for( ; spaces > 0 && count <= TITLELEN; spaces-- )
+        {
+          as->list_title[count] = ( as->line[ix] == '\t' ) ? ' ' : as->line[ix];
+          count++;
         }
-        list_title[count] = line[ix];
-        count++;
         ix++;
-      } while( line[ix] != delim && !isend(line[ix]) );
+      } while( as->line[ix] != delim && !isend(as->line[ix]) );
 
-      if( strlen( list_title ) > TITLELEN )
+      if( strlen( as->list_title ) > TITLELEN )
       {
-        list_title[TITLELEN] = '\0';
+        as->list_title[TITLELEN] = '\0';
       }
 
-      cc = ix + 1;
-      lexterm = cc;
-      page_lineno = LIST_LINES_PER_PAGE;/* Force top of page for new titles.  */
-      list_title_set = TRUE;
+      as->cc = ix + 1;
+      as->lexterm = as->cc;
+      listTitle( as, count );           /* New titles, new page.          */
     }
     else
     {
-      cc = ix;
-      lexterm = cc;
-      errorMessage( &text_string, cc );
+      as->cc = ix;
+      as->lexterm = as->cc;
+      errorMessage( as, &text_string, as->cc );
     }
 
-    nextLexeme();
+    nextLexeme( as );
     break;
 
   case UNLIST:
-    listfile = NULL;
+    as->listfile = NULL;
     break;
 
   case VFD:
     pos = 0;
     word = 0;
-    radixprev = radix;
-    while( !isdone (line[lexstart] ))
-    {
-      lexstartsave = lexstart;
-      radix = 10;
-  	  width = (getExpr())->val;     /* Get field width.                       */ 
-      radix = radixprev;
-      if( (width <= 0) || ((width + pos) > 12) || (line[lexstart] != ':') )
+    radixprev = as->radix;
+    while( !isdone (as->line[as->lexstart] ))
+    {
+      lexstartsave = as->lexstart;
+      as->radix = 10;
+  	  width = (getExpr( as ))->val;     /* Get field width.                   */ 
+      as->radix = radixprev;
+      if( (width <= 0) || ((width + pos) > 12) ||
+          (as->line[as->lexstart] != ':') )
       {
-        errorMessage( &illegal_vfd_value, lexstartsave );
+        errorMessage( as, &illegal_vfd_value, lexstartsave );
       }
-      nextLexBlank();               /* Skip colon.                            */
-      value = (getExpr())->val;     /* Get field value.                       */
-      if( line[lexterm] == ',' ) cc++;
-      nextLexeme();                 /* Advance to next field.                 */
+      nextLexBlank( as );               /* Skip colon.                        */
+      value = (getExpr( as ))->val;     /* Get field value.                   */
+      if( as->line[as->lexterm] == ',' ) as->cc++;
+      nextLexeme( as );                 /* Advance to next field.             */
       pos = pos + width;
 	  if( pos <= 12 )
 	  {
         word = word | ((value & mask_tab[width]) << (12 - pos));
 	  }
     }
-    punchOutObject( clc, word );
-    incrementClc();
+    punchOutObject( as, as->clc, word );
+    incrementClc( as );
     break;
 
   case ZBLOCK:
-    value = (getExpr())->val;
+    value = (getExpr( as ))->val;
     if( value < 0 )
     {
-      errorMessage( &zblock_too_small, lexstartprev );
+      errorMessage( as, &zblock_too_small, as->lexstartprev );
     }
-    else if( value + ( clc & 07777 ) - 1 > 07777 )
+    else if( value + ( as->clc & 07777 ) - 1 > 07777 )
     {
-      errorMessage( &zblock_too_large, lexstartprev );
+      errorMessage( as, &zblock_too_large, as->lexstartprev );
     }
-    else
+    else if( as->zblock_words )
     {
       for( ; value > 0; value-- )
       {
-        punchOutObject( clc, 0 );
-        incrementClc();
+        punchOutObject( as, as->clc, 0 );
+        incrementClc( as );
       }
     }
+    else if( value > 0 )
+    {
+      punchZeroBlock( as, value );
+    }
 
     break;
 
@@ -4086,53 +7351,128 @@ BOOL pseudoOperators( PSEUDO_T val )
 /*             the closing >.                                                 */
 /*                                                                            */
 /******************************************************************************/
-void conditionFalse()
+void conditionFalse( ASM_T *as )
 {
   int     level;
+  SKIP_T *skip;
+  int     start_col;
+  int     start_line;
 
-  if( line[lexstart] == '<' )
+  if( as->line[as->lexstart] == '<' )
   {
-    /* Invariant: line[cc] is the next unexamined character.                  */
-    level = 1;
-    while( level > 0 )
+    skip = ( as->pass == 2 ) ? findSkip( as ) : NULL;
+    if( skip != NULL )
     {
-      if( isend( line[cc] ) || ( line[cc] == '/' ))
+      /* The lines skipped are still read, to be listed.                      */
+      while( as->lexeme_line >= 0 && as->lexeme_line < skip->end_line )
       {
-        readLine();
+        readLine( as );
       }
-      else
+      as->cc = skip->end_col;
+    }
+    else
+    {
+      start_line = as->lexeme_line;
+      start_col = as->cc;
+
+      /* Invariant: line[cc] is the next unexamined character.                */
+      level = 1;
+      while( level > 0 )
       {
-        switch( line[cc] )
+        /* Only the characters of class CC_SKIP end a run of characters.     */
+        while( !( charClass( as->line[as->cc] ) & ( CC_END | CC_SKIP )))
         {
-        case '>':
-          level--;
-          cc++;
-          break;
+          as->cc++;
+        }
+        if( isend( as->line[as->cc] ) || ( as->line[as->cc] == '/' ))
+        {
+          readLine( as );
+        }
+        else
+        {
+          switch( as->line[as->cc] )
+          {
+          case '>':
+            level--;
+            as->cc++;
+            break;
 
-        case '<':
-          level++;
-          cc++;
-          break;
+          case '<':
+            level++;
+            as->cc++;
+            break;
 
-        case '$':
-          level = 0;
-          cc++;
-          break;
+          case '$':
+            level = 0;
+            as->cc++;
+            break;
+          } /* end switch                                                     */
+        } /* end if                                                           */
+      } /* end while                                                          */
 
-        default:
-          cc++;
-          break;
-        } /* end switch                                                       */
-      } /* end if                                                             */
-    } /* end while                                                            */
-    nextLexeme();
+      if( as->pass == 1 && start_line >= 0 && as->lexeme_line >= 0 )
+      {
+        as->skips = (SKIP_T *) growTable( as->skips, &as->skip_room,
+                                          sizeof( SKIP_T ),
+                                          as->skip_count + 1 );
+        as->skips[as->skip_count].line = start_line;
+        as->skips[as->skip_count].col = start_col;
+        as->skips[as->skip_count].end_line = as->lexeme_line;
+        as->skips[as->skip_count].end_col = as->cc;
+        as->skip_count++;
+      }
+    }
+    nextLexeme( as );
   }
   else
   {
-    errorMessage( &lt_expected, lexstart );
+    errorMessage( as, &lt_expected, as->lexstart );
   }
 } /* conditionFalse()                                                         */
 
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  findSkip                                                       */
+/*                                                                            */
+/*  Synopsis:  Find the skip pass 1 made from the current line and column.    */
+/*             Returns NULL if it made none there.                            */
+/*                                                                            */
+/******************************************************************************/
+SKIP_T *findSkip( ASM_T *as )
+{
+  int     high;
+  int     low;
+  int     mid;
+
+  if( as->lexeme_line < 0 )
+  {
+    return( NULL );
+  }
+
+  /* The skips were made, and so are kept, in the order of the source.        */
+  for( low = 0, high = as->skip_count; low < high; )
+  {
+    mid = ( low + high ) / 2;
+    if( as->skips[mid].line < as->lexeme_line
+        || ( as->skips[mid].line == as->lexeme_line
+             && as->skips[mid].col < as->cc ))
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  if( low < as->skip_count && as->skips[low].line == as->lexeme_line
+      && as->skips[low].col == as->cc )
+  {
+    return( &as->skips[low] );
+  }
+  return( NULL );
+} /* findSkip()                                                               */
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  conditionTrue                                                  */
@@ -4142,15 +7482,15 @@ void conditionFalse()
 /*             normal assembly.                                               */
 /*                                                                            */
 /******************************************************************************/
-void conditionTrue()
+void conditionTrue( ASM_T *as )
 {
-  if( line[lexstart] == '<' )
+  if( as->line[as->lexstart] == '<' )
   {
-    nextLexeme();               /* Skip the opening '<'                       */
+    nextLexeme( as );               /* Skip the opening '<'                   */
   }
   else
   {
-    errorMessage( &lt_expected, lexstart );
+    errorMessage( as, &lt_expected, as->lexstart );
   }
 } /* conditionTrue()                                                          */
 
@@ -4162,11 +7502,12 @@ void conditionTrue()
 /*  Synopsis:  Display an error message using the current lexical element.    */
 /*                                                                            */
 /******************************************************************************/
-void errorLexeme( EMSG_T *mesg, WORD32 col )
+void errorLexeme( ASM_T *as, EMSG_T *mesg, WORD32 col )
 {
   char   name[SYMLEN];
 
-  errorSymbol( mesg, lexemeToName( name, lexstart, lexterm ), col );
+  errorSymbol( as, mesg, lexemeToName( as, name, as->lexstart, as->lexterm ),
+               col );
 } /* errorLexeme()                                                            */
 
 
@@ -4177,21 +7518,22 @@ void errorLexeme( EMSG_T *mesg, WORD32 col )
 /*  Synopsis:  Display an error message with a given string.                  */
 /*                                                                            */
 /******************************************************************************/
-void errorSymbol( EMSG_T *mesg, char *name, WORD32 col )
+void errorSymbol( ASM_T *as, EMSG_T *mesg, char *name, WORD32 col )
 {
   char   linecol[12];
   char  *s;
 
-  if( pass == 2 )
+  if( as->pass == 2 )
   {
     s = ( name == NULL ) ? "" : name ;
-    errors++;
-    sprintf( linecol, "(%d:%d)", lineno, col + 1 );
-    fprintf( errorfile, "%s%-9s : error:  %s \"%s\" at Loc = %5.5o\n",
-                                      filename, linecol, mesg->file, s, clc );
-    saveError( mesg->list, col );
+    as->errors++;
+    col = expandedColumn( as, col + 1 ) - 1;   /* Last column of a tab.      */
+    sprintf( linecol, "(%d:%d)", as->lineno, col + 1 );
+    fprintf( as->errorfile, "%s%-9s : error:  %s \"%s\" at Loc = %5.5o\n",
+             as->filename, linecol, mesg->file, s, as->clc );
+    saveError( as, mesg->list, col );
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 } /* errorSymbol()                                                            */
 
 
@@ -4202,19 +7544,20 @@ void errorSymbol( EMSG_T *mesg, char *name, WORD32 col )
 /*  Synopsis:  Display an error message without a name argument.              */
 /*                                                                            */
 /******************************************************************************/
-void errorMessage( EMSG_T *mesg, WORD32 col )
+void errorMessage( ASM_T *as, EMSG_T *mesg, WORD32 col )
 {
   char   linecol[12];
 
-  if( pass == 2 )
+  if( as->pass == 2 )
   {
-    errors++;
-    sprintf( linecol, "(%d:%d)", lineno, col + 1 );
-    fprintf( errorfile, "%s%-9s : error:  %s at Loc = %5.5o\n",
-                                         filename, linecol, mesg->file, clc );
-    saveError( mesg->list, col );
+    as->errors++;
+    col = expandedColumn( as, col + 1 ) - 1;   /* Last column of a tab.      */
+    sprintf( linecol, "(%d:%d)", as->lineno, col + 1 );
+    fprintf( as->errorfile, "%s%-9s : error:  %s at Loc = %5.5o\n",
+             as->filename, linecol, mesg->file, as->clc );
+    saveError( as, mesg->list, col );
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 } /* errorMessage()                                                           */
 
 /******************************************************************************/
@@ -4225,19 +7568,19 @@ void errorMessage( EMSG_T *mesg, WORD32 col )
 /*             the current line is printed.                                   */
 /*                                                                            */
 /******************************************************************************/
-void saveError( char *mesg, WORD32 col )
+void saveError( ASM_T *as, char *mesg, WORD32 col )
 {
-  if( save_error_count < DIM( error_list ))
+  if( as->save_error_count < DIM( as->error_list ))
   {
-    error_list[save_error_count].mesg = mesg;
-    error_list[save_error_count].col = col;
-    save_error_count++;
+    as->error_list[as->save_error_count].mesg = mesg;
+    as->error_list[as->save_error_count].col = col;
+    as->save_error_count++;
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 
-  if( listed )
+  if( as->listed )
   {
-    printErrorMessages();
+    printErrorMessages( as );
   }
 } /* saveError()                                                              */
 /* End-of-File                                                                */
@@ -0,0 +1,118 @@
+/******************************************************************************/
+/*                                                                            */
+/* Program:  MKPERMTAB                                                        */
+/* File:     mkpermtab.c                                                      */
+/*                                                                            */
+/* Purpose:  Build time generator of the permanent symbol table of palbart    */
+/*           and macro8x.                                                     */
+/*                                                                            */
+/* SYNOPSIS:                                                                  */
+/*    cc -ansi -DMKPERMTAB -DASMSRC='"palbart-2.5.c"' mkpermtab.c -lm         */
+/*    ./a.out > palbart-permtab.h                                             */
+/*                                                                            */
+/* DESCRIPTION                                                                */
+/*    The assembler named by ASMSRC is compiled into this program with its    */
+/*    main() renamed and with an empty permanent symbol table.  The pseudo-   */
+/*    ops and the permanent symbols are then entered into the symbol table of */
+/*    a new assembler context with defineSymbol(), exactly as the assembler   */
+/*    used to do on startup.  The assembler's hashPermanentSymbols() makes    */
+/*    them a perfect hash table, which is written to stdout as C source to be */
+/*    included by the assembler.  Unused slots are UNDEFINED with a zero key. */
+/*                                                                            */
+/******************************************************************************/
+
+#define main assemblerMain
+#include ASMSRC
+#undef main
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  main                                                           */
+/*                                                                            */
+/*  Synopsis:  Build the permanent symbol table and print it as C source.     */
+/*                                                                            */
+/******************************************************************************/
+int main( int argc, char *argv[] )
+{
+  ASM_T   *as;
+  int      bx;
+  int      fixed_count;
+  int      ix;
+  char     name[SYMLEN];
+  SYM_T  **sorted;
+  int      sx;
+  SYM_T   *sym;
+
+  as = newAssembler();
+  as->errorfile = stderr;
+  as->symbol_top = 0;
+  clearSymbolHash( as );
+  as->pass = 0;
+
+  /* Enter the pseudo-ops into the symbol table                               */
+  for( ix = 0; ix < DIM( pseudo ); ix++ )
+  {
+    defineSymbol( as, nameToKey( pseudo[ix].name ), pseudo[ix].val,
+                  pseudo[ix].type, 0 );
+  }
+
+  /* Enter the predefined symbols into the table.                             */
+  for( ix = 0; ix < DIM( permanent_symbols ); ix++ )
+  {
+    defineSymbol( as, nameToKey( permanent_symbols[ix].name ),
+                  permanent_symbols[ix].val,
+                  permanent_symbols[ix].type | DEFFIX , 0 );
+  }
+
+  /* None of them is fixed yet, so they all follow the fixed part.            */
+  sorted = sortSymbolTable( as, &fixed_count );
+  if( !hashPermanentSymbols( as, &sorted[fixed_count], as->symbol_top ))
+  {
+    fprintf( stderr, "No perfect hash found for the permanent symbols.\n" );
+    return( 1 );
+  }
+
+  printf( "/* Generated by mkpermtab from %s.  Do not edit. */\n\n", ASMSRC );
+  printf( "#define PERMTAB_BUCKETS  %d\n", as->permtab_buckets );
+  printf( "#define PERMTAB_COUNT    %d\n", as->permtab_count );
+  printf( "#define PERMTAB_SIZE     %d\n\n", as->permtab_size );
+
+  printf( "int     permtab_builtin_disp[PERMTAB_BUCKETS] =\n{" );
+  for( bx = 0; bx < as->permtab_buckets; bx++ )
+  {
+    printf( "%s%s%d", ( bx == 0 ? "" : "," ),
+                      ( bx % 10 == 0 ? "\n  " : " " ), as->permtab_disp[bx] );
+  }
+  printf( "\n};\n\n" );
+
+  printf( "int     permtab_builtin_order[PERMTAB_COUNT] =\n{" );
+  for( ix = 0; ix < as->permtab_count; ix++ )
+  {
+    printf( "%s%s%d", ( ix == 0 ? "" : "," ),
+                      ( ix % 10 == 0 ? "\n  " : " " ), as->permtab_order[ix] );
+  }
+  printf( "\n};\n\n" );
+
+  printf( "SYM_T   permtab_builtin[PERMTAB_SIZE] =\n{\n" );
+  for( sx = 0; sx < as->permtab_size; sx++ )
+  {
+    sym = &as->permtab[sx];
+    if( sym->key == 0 )
+    {
+      printf( "  { %#5o, %10luUL, %#5o }%s\n", 0, 0UL, 0,
+                              ( sx + 1 < as->permtab_size ? "," : "" ));
+    }
+    else
+    {
+      printf( "  { %#5o, %10luUL, %#5o }%s    /* %-6s */\n",
+              (unsigned int) sym->type, sym->key, (unsigned int) sym->val,
+              ( sx + 1 < as->permtab_size ? "," : " " ),
+              keyToName( name, sym->key ));
+    }
+  }
+  printf( "};\n" );
+  free( sorted );
+  freeAssembler( as );
+  return( 0 );
+} /* main()                                                                   */
@@ -13,19 +13,30 @@
 /*    pal - a PDP/8 pal-like assembler.                                       */
 /*                                                                            */
 /* SYNOPSIS:                                                                  */
-/*    pal [ -d -l -p -r -x ] inputfile                                        */
+/*    pal [ -1 -c -d -e -l -p -r -s -x -z ] [ -u snapshot ] inputfile         */
+/*    pal -j n [ options ] { inputfile | @file }...                           */
 /*                                                                            */
 /* DESCRIPTION                                                                */
 /*    This is a cross-assembler to for PDP/8 assembly language programs.      */
 /*    It will produce an output file in bin format, rim format, and using the */
 /*    appropriate pseudo-ops, a combination of rim and bin formats.           */
-/*    A listing file is always produced and with an optional symbol table     */
-/*    and/or a symbol cross-reference (concordance).  The permanent symbol    */
-/*    table can be output in a form that may be read back in so a customized  */
-/*    permanent symbol table can be produced.  Any detected errors are output */
-/*    to a separate file giving the filename in which they were detected      */
-/*    along with the line number, column number and error message as well as  */
-/*    marking the error in the listing file.                                  */
+/*    A listing file is produced (with -e only if there are errors) with an   */
+/*    optional symbol table and/or a symbol cross-reference (concordance).    */
+/*    The permanent symbol table can be output in a form that may be read     */
+/*    back in so a customized permanent symbol table can be produced.  Any    */
+/*    detected errors are output to a separate file giving the filename in    */
+/*    which they were detected along with the line number, column number and  */
+/*    error message as well as marking the error in the listing file.         */
+/*    On a machine with several processors, pass 2 of a large source is run   */
+/*    by as many processes at once, each on its own part of the source from a */
+/*    state saved by pass 1.  Their output is put together in order, and is   */
+/*    the same as that of a single pass 2, which is run instead whenever the  */
+/*    parts do not join up exactly.  The processes are forked and write to    */
+/*    temporary files, so this is only done for a single input file of at     */
+/*    least 32768 lines assembled by the palbart command, and not with -c,    */
+/*    -p, -s or -x, which need the whole of pass 2, nor with -j or in         */
+/*    libpalbart.  In all other cases pass 2 is run as a single pass, with    */
+/*    the same output.                                                        */
 /*    The following file name extensions are used:                            */
 /*       .pal    source code (input)                                          */
 /*       .lst    assembly listing (output)                                    */
@@ -34,15 +45,40 @@
 /*       .err    assembly errors detected (if any) (output)                   */
 /*       .prm    permanent symbol table in form suitable for reading after    */
 /*               the EXPUNGE pseudo-op.                                       */
+/*       .pst    permanent symbol table snapshot, to be loaded with -u.       */
 /*                                                                            */
 /* OPTIONS                                                                    */
+/*    -1   Assemble in a single pass.  The values with forward references are */
+/*         patched into the listing and object files at the end.  Sources     */
+/*         that need two passes (forward references elsewhere, symbols that   */
+/*         change value, conditionals, EXPUNGE, RIM/BIN switches, errors) are */
+/*         assembled in two passes anyway.  Not used with -x, as only pass 2  */
+/*         fills in the cross reference.                                      */
+/*    -c   Punch the bin output from a memory image kept during the assembly, */
+/*         with an origin only where the loaded words are not consecutive.    */
+/*         It loads the same words, and is shorter.  The characters saved     */
+/*         are shown at the end of the listing.  Not used with -r.            */
 /*    -d   Dump the symbol table at end of assembly                           */
+/*    -e   Keep the listing only if there are errors.  Without errors it is   */
+/*         not made at all, and no .lst file is left.                         */
+/*    -j   Assemble each input file on its own, as if it were named alone,    */
+/*         on a pool of as many threads as the next argument, 0 for one per   */
+/*         processor.  The files with errors are then named on stderr, in the */
+/*         order they were given.  Without -j there must be one input file.   */
 /*    -l   Allow generation of literals (default is no literal generation)    */
 /*    -p   Generate a file with the permanent symbols in it.                  */
 /*         (To get the current symbol table, assemble a file than has only    */
 /*          a $ in it.)                                                       */
 /*    -r   Produce output in rim format (default is bin format)               */
+/*    -s   Generate a binary snapshot of the permanent symbols at the end of  */
+/*         assembly.  It is hashed and sorted, and loaded with -u as is.      */
+/*    -u   Use the permanent symbol snapshot named by the next argument in    */
+/*         place of the built-in permanent symbol table.                      */
 /*    -x   Generate a cross-reference (concordance) of user symbols.          */
+/*    -z   List every word of a ZBLOCK.  Without it only the first and the    */
+/*         last word of the block are listed.                                 */
+/*    @file  Read input file names from file, one to a line.  Blank lines     */
+/*         and the blanks around a name are dropped.                          */
 /*                                                                            */
 /* DIAGNOSTICS                                                                */
 /*    Assembler error diagnostics are output to an error file and inserted    */
@@ -153,21 +189,41 @@
 /*                                                                            */
 /******************************************************************************/
 
+#define _POSIX_C_SOURCE 200809L  /* For mmap() and open_memstream().       */
+
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "palbart.h"
 
 char *release = "pal-2.5, 14 August 2010";
 
-#define LINELEN              96
 #define LIST_LINES_PER_PAGE  55         /* Includes 5 line page header.       */
 #define NAMELEN             128
 #define SYMBOL_COLUMNS        5
 #define SYMLEN                7
-#define SYMBOL_TABLE_SIZE  1024
+#define SYMBOL_CHUNK_SIZE   256         /* First chunk, later chunks double.  */
+#define SYMBOL_CHUNKS        16         /* Room for 256 * ( 2^16 - 1 ) syms. */
+#define PERM_DISP_LIMIT 100000L        /* Give up the perfect hash search.   */
+#define ARENA_BLOCK      65536         /* Size of blocks for rewritten lines.*/
 #define TITLELEN             63
+#define CHECKPOINT_LINES   1024         /* Lines between pass 1 checkpoints.  */
+#define CHUNK_LINES       16384         /* Least lines for a pass 2 worker.   */
+#define PAGE_UNKNOWN    (-1000)         /* page_lineno of a worker at a break.*/
+#define TAPE_BUFFER        8192         /* Object characters written at once. */
+#define LIST_BUFFER     2097152         /* Listing characters written at once.*/
 #define XREF_COLUMNS          8
+#define XREF_BLOCK_BYTES     12         /* Bytes of references in a block.    */
 
 #define ADDRESS_FIELD  00177
 #define FIELD_FIELD   070000
@@ -183,6 +239,7 @@ char *release = "pal-2.5, 14 August 2010";
 
 #define PAGE_FIELD     07600
 #define PAGE_ZERO_END  00200
+#define LIT_VALUES    010000            /* Values of a literal, 12 bits.      */
 
 /* Macro to get the number of elements in an array.                           */
 #define DIM(a) (sizeof(a)/sizeof(a[0]))
@@ -190,9 +247,19 @@ char *release = "pal-2.5, 14 August 2010";
 /* Macro to get the address plus one of the end of an array.                  */
 #define BEYOND(a) ((a) + DIM(A))
 
-#define is_blank(c) ((c==' ') || (c=='\t') || (c=='\f') || (c=='>'))
-#define isend(c)   ((c=='\0')|| (c=='\n'))
-#define isdone(c)  ((c=='/') || (isend(c)) || (c==';'))
+/* Character classes, looked up in charclass[].                               */
+#define CC_BLANK    001                 /* Blank: space, tab, FF or '>'.      */
+#define CC_END      002                 /* End of line: newline or NUL.       */
+#define CC_DONE     004                 /* End of statements: '/', ';' too.   */
+#define CC_ALPHA    010
+#define CC_DIGIT    020
+#define CC_SKIP     040                 /* Ends a skip: '<', '>' or '$'.      */
+
+#define charClass(c) (charclass[(unsigned char)(c)])
+#define is_blank(c)  (charClass(c) & CC_BLANK)
+#define isend(c)     (charClass(c) & CC_END)
+#define isdone(c)    (charClass(c) & CC_DONE)
+#define is_alnum(c)  (charClass(c) & ( CC_ALPHA | CC_DIGIT ))
 
 /* Macros for testing symbol attributes.  Each macro evaluates to non-zero    */
 /* (true) if the stated condtion is met.                                      */
@@ -209,21 +276,37 @@ char *release = "pal-2.5, 14 August 2010";
 #define M_REDEFINED(s)   ((s & REDEFINED) == REDEFINED)
 #define M_UNDEFINED(s)   (!M_DEFINED(s))
 
+/* The type bits that pass 2 changes without changing how a symbol is used.   */
+#define PASS_2_BITS ((CONDITION | DUPLICATE) & ~DEFINED)
+
 /* This macro is used to test symbols by the conditional assembly pseudo-ops. */
 #define M_DEF(s) (M_DEFINED(s))
 #define M_COND(s) (M_DEFINED(s))
-#define M_DEFINED_CONDITIONALLY(t) ((M_DEF(t)&&pass==1)||(!M_COND(t)&&pass==2))
+#define M_DEFINED_CONDITIONALLY(t) \
+          ((M_DEF(t)&&as->pass==1)||(!M_COND(t)&&as->pass==2))
+
+/* This macro tests if an entry of the built-in permanent symbol table is in  */
+/* use.  Only the pseudo-ops survive an EXPUNGE.                              */
+#define M_PERMANENT(s) \
+          (M_DEFINED(s) && (M_PSEUDO(s) || !as->permanent_expunged))
 
 typedef unsigned char BOOL;
 typedef unsigned char BYTE;
 typedef short    int  WORD16;
 typedef long     int  WORD32;
+typedef unsigned long SYMKEY;
 
 #ifndef FALSE
   #define FALSE 0
   #define TRUE (!FALSE)
 #endif
 
+/* Symbol keys.  A name of up to 6 letters and digits is packed base 37 into  */
+/* a SYMKEY, most significant position first, with 0 for unused positions,    */
+/* letters as 11 to 36 and digits as 1 to 10.  Keys compare in the same order */
+/* as the names and fit in 32 bits.  The names are only rebuilt for output.   */
+#define SYMKEY_BASE          37
+
 /* Line listing styles.  Used to control listing of lines.                    */
 enum linestyle_t
 {
@@ -231,6 +314,11 @@ enum linestyle_t
 };
 typedef enum linestyle_t LINESTYLE_T;
 
+/* Kinds of listing records that are not lines, after the line styles.        */
+#define LISTREC_ERROR        4  /* An error message, under the line before.   */
+#define LISTREC_EJECT        5  /* A new page before the next line.           */
+#define LISTREC_TITLE        6  /* A new title, and a new page.               */
+
 /* Symbol Types.                                                              */
 /* Note that the names that have FIX as the suffix contain the FIXED bit      */
 /* included in the value.                                                     */
@@ -271,18 +359,52 @@ typedef enum pseudo_t PSEUDO_T;
 struct sym_t
 {
   SYMTYP  type;
-  char    name[SYMLEN];
+  SYMKEY  key;
   WORD16  val;
-  int     xref_index;
-  int     xref_count;
+  int     xref_index;           /* Its entry in xrefs, 0 if none.             */
+  int     xref_count;           /* Number of references in the entry.         */
 };
 typedef struct sym_t SYM_T;
 
+/* The concordance entry of a symbol, filled in by pass 2.  The line numbers  */
+/* of the references are kept as the difference from the one before, 7 bits  */
+/* to a byte, with the sign in the low bit, in a list of blocks of            */
+/* xrefblocks.  Entry and block 0 stand for none.                             */
+struct xref_t
+{
+  int     def;                  /* Line it was last defined on, or 0.         */
+  int     first;                /* First and last block of the references.    */
+  int     last;
+  int     fill;                 /* Bytes used in the last block.              */
+  int     line;                 /* Line of the last reference.                */
+};
+typedef struct xref_t XREF_T;
+
+struct xrefblock_t
+{
+  int     next;                 /* Next block of the list, 0 if none.         */
+  BYTE    bytes[XREF_BLOCK_BYTES];
+};
+typedef struct xrefblock_t XREFBLOCK_T;
+
+/* A symbol as written in the pseudo-op and permanent symbol tables.          */
+struct symdef_t
+{
+  SYMTYP  type;
+  char    name[SYMLEN];
+  WORD16  val;
+};
+typedef struct symdef_t SYMDEF_T;
+
+/* A literal pool.  slot[] indexes the pool by value, so that a literal is    */
+/* found without a search.  An entry is only good if it is at or above loc    */
+/* and the value is still there, so the index is never cleared.               */
 struct lpool_t
 {
   BOOL    error;                /* True if error message has been printed.    */
   WORD16  loc;
   WORD16  pool[PAGE_SIZE];
+  BYTE    slot[LIT_VALUES];     /* Where each value was last put in pool.     */
 };
 typedef struct lpool_t LPOOL_T;
 
@@ -307,67 +429,355 @@ struct fltg_
 };
 typedef struct fltg_ FLTG_T;
 
+/* Header of a permanent symbol table snapshot (see the -s and -u options). */
+/* It is followed, at offset PERMSNAP_TABLE, by the size slots of the       */
+/* hashed table, then by the displacement of each bucket and the slot of    */
+/* each symbol in name order.  All in the native format of this build.      */
+struct permhdr_t
+{
+  char   magic[8];             /* PERMSNAP_MAGIC                             */
+  int    sym_size;             /* sizeof( SYM_T ) of the writing build.      */
+  int    buckets;              /* Number of buckets, a power of 2.           */
+  int    count;                /* Number of symbols.                         */
+  int    size;                 /* Number of slots, a power of 2.             */
+};
+typedef struct permhdr_t PERMHDR_T;
+
+#define PERMSNAP_MAGIC  "PALPST1"
+#define PERMSNAP_TABLE  ((long) (( sizeof( PERMHDR_T ) + sizeof( SYM_T ) - 1 ) \
+                                 / sizeof( SYM_T ) * sizeof( SYM_T )))
+
+/* The operations of the code compiled from an operand field in pass 1.  The  */
+/* code is postfix; runCodedExprs() runs it on a stack of values in pass 2.   */
+enum exop_t
+{
+  EX_END,    EX_SYM,    EX_CONST,  EX_DOT,    EX_NEG,    EX_ADD,    EX_SUB,
+  EX_MUL,    EX_DIV,    EX_AND,    EX_OR,     EX_PZLIT,  EX_CPLIT,  EX_TERM
+};
+typedef enum exop_t EXOP_T;
+
+struct excode_t
+{
+  EXOP_T  op;
+  WORD16  val;                  /* Constant, or column for diagnostics.       */
+  SYM_T  *sym;                  /* Symbol of EX_SYM.                          */
+};
+typedef struct excode_t EXCODE_T;
+
+/* An operand field compiled in pass 1, with the state of the lexer after it. */
+struct coded_t
+{
+  int     from;                 /* lexstart where the field starts.           */
+  int     code;                 /* Index of its code in excode.               */
+  int     depth;                /* Stack depth needed to run the code.        */
+  int     radix;                /* Radix its numbers were read in.            */
+  BOOL    literals;             /* TRUE if it generates literals.             */
+  int     lexeme;               /* Lexemes of the line up to its end.         */
+  int     lexstart;
+  int     lexterm;
+  int     lexstartprev;
+  int     lextermprev;
+  int     cc;
+  char    delimiter;
+};
+typedef struct coded_t CODED_T;
+
+/* A value with a forward reference punched by a single pass assembly, to be  */
+/* fixed up by fixupOnePass() once the symbols are all defined.               */
+struct fixup_t
+{
+  int     expr;                 /* Index of its compiled field in coded.      */
+  WORD16  clc;                  /* State the field was evaluated in.          */
+  WORD16  fieldlc;
+  WORD16  reloc;
+  WORD16  val;                  /* Value punched.                             */
+  int     list_rec;             /* Its listing record, -1 if not listed.      */
+  long    object_pos;           /* Where it is in the object file, -1 if not. */
+  WORD16  loc;                  /* Where it is loaded, field included.        */
+};
+typedef struct fixup_t FIXUP_T;
+
+/* A source line read in pass 1, kept for pass 2 (see replayLine()).          */
+struct srcline_t
+{
+  char   *text;                 /* The line, in the input or in the arena.    */
+  int     length;               /* Length of the line (maxcc).                */
+  int     lexeme;               /* Index of its first lexeme in lexemes.      */
+  int     lexemes;              /* Number of lexemes found in pass 1.         */
+  int     expr;                 /* Index of its first compiled field.         */
+  int     exprs;                /* Number of fields compiled in pass 1.       */
+  BOOL    eof;                  /* Line made up at the end of the file.    */
+};
+typedef struct srcline_t SRCLINE_T;
+
+/* A lexeme found by nextLexeme() in pass 1.  Scanning the same line from the */
+/* same column in pass 2 gives the same lexeme, so it need not be repeated.   */
+struct lexeme_t
+{
+  int     from;                 /* Column counter when the scan started.      */
+  int     start;                /* lexstart                                   */
+  int     term;                 /* lexterm                                    */
+};
+typedef struct lexeme_t LEXEME_T;
+
+/* The body of a false conditional skipped in pass 1, by where it started and */
+/* ended.  Pass 2 goes straight to the end of the same skip.                  */
+struct skip_t
+{
+  int     line;                 /* Line in the source cache.                  */
+  int     col;                  /* Column after the '<'.                      */
+  int     end_line;
+  int     end_col;              /* Column after the closing '>' or '$'.       */
+};
+typedef struct skip_t SKIP_T;
+
+/* The state of the assembly between two lines.  Pass 1 takes one every       */
+/* CHECKPOINT_LINES lines, and pass 2 can be started from it.  The rest of    */
+/* the state is the same between lines in both passes, or is the symbol       */
+/* table, which pass 2 normally leaves as pass 1 left it.                     */
+struct checkpoint_t
+{
+  int     srcline;              /* Next line of the source cache to read.     */
+  int     lineno;
+  WORD16  clc;
+  WORD16  field;
+  WORD16  fieldlc;
+  WORD16  reloc;
+  WORD16  radix;
+  BOOL    binary_data_output;
+  BOOL    fltg_input;
+  BOOL    rim_mode;
+  BOOL    list_off;
+  BOOL    punch_off;
+  LPOOL_T cp;
+  LPOOL_T pz;
+  char    list_title[TITLELEN + 2];
+};
+typedef struct checkpoint_t CHECKPOINT_T;
+
+/* A line of the listing as the assembly found it, or a page event, recorded  */
+/* in order and made into text by renderListing() once the pass is done.      */
+struct listrec_t
+{
+  char   *text;                 /* The source line, or the error message.     */
+  int     num;                  /* Line number, error column or title index.  */
+  WORD16  loc;
+  WORD16  val;
+  BYTE    style;                /* A LINESTYLE_T or a LISTREC_ kind.          */
+  BYTE    indirect;             /* TRUE to list '@' after the value.          */
+};
+typedef struct listrec_t LISTREC_T;
+
+/* A page break that a pass 2 worker left to the parent, which alone knows    */
+/* how far down the page the listing is.                                      */
+struct pagebreak_t
+{
+  long    pos;                  /* Where it is in the chunk's listing.        */
+  int     lines;                /* page_lineno there, counted from            */
+                                /* PAGE_UNKNOWN unless an EJECT set it.       */
+  int     title;                /* Index of the listing title in titles.      */
+};
+typedef struct pagebreak_t PAGEBREAK_T;
+
+/* A part of the source that pass 2 is run on by a worker process.            */
+struct chunk_t
+{
+  CHECKPOINT_T *from;           /* State it starts in, NULL for the first.    */
+  int     end;                  /* Line it ends before, -1 for the last.      */
+  pid_t   pid;
+  FILE   *list;                 /* Its listing, object and error output.      */
+  FILE   *object;
+  FILE   *errors;
+  FILE   *report;               /* A CHUNKEND_T, its titles, its page breaks. */
+};
+typedef struct chunk_t CHUNK_T;
+
+/* How a worker ended its chunk, as reported to the parent.                   */
+struct chunkend_t
+{
+  CHECKPOINT_T state;           /* State at the end of the chunk.             */
+  BOOL    usable;               /* FALSE if a single pass 2 could differ.     */
+  int     errors;
+  WORD16  checksum;             /* Sum of what was punched.                   */
+  BOOL    checksum_partial;     /* TRUE if it adds to the sum before it.      */
+  int     page_lineno;
+  int     pagebreaks;
+  int     titles;
+};
+typedef struct chunkend_t CHUNKEND_T;
+
+/* The assembler context, defined after the permanent symbol table below.     */
+typedef struct asm_t ASM_T;
+
+/* A report of the symbols, defined after the assembler context.              */
+typedef struct report_t REPORT_T;
+
+/* A source of a batch assembled with -j.                                     */
+struct batchjob_t
+{
+  char   *path;
+  long    size;                 /* Its size, to start the big ones first.     */
+  char   *failure;              /* Why it was not assembled, or NULL.         */
+  int     errors;
+};
+typedef struct batchjob_t BATCHJOB_T;
+
+/* A batch of sources assembled by a pool of threads (see assembleBatch()).   */
+struct batch_t
+{
+  ASM_T  *options;              /* The context the options were parsed into.  */
+  BATCHJOB_T **queue;           /* The sources, biggest first.                */
+  int     count;
+  int     next;                 /* Next source in queue to assemble.          */
+  pthread_mutex_t lock;         /* Held to take a source from the queue.      */
+};
+typedef struct batch_t BATCH_T;
+
 /*----------------------------------------------------------------------------*/
 
 /* Function Prototypes                                                        */
 
-int     binarySearch( char *name, int start, int symbol_count );
+void    addFixup( ASM_T *as, WORD16 val );
+void    addXref( ASM_T *as, SYM_T *sym, int line );
+LISTREC_T *addListRecord( ASM_T *as, int style, char *text, int num );
+void    addPageBreak( ASM_T *as );
+void    addSource( ASM_T *as, char *path );
+char   *arenaAlloc( ASM_T *as, int size );
+int     assemble( ASM_T *as );
+int     assembleBatch( ASM_T *as );
+void   *batchWorker( void *arg );
+void    cacheLine( ASM_T *as, BOOL flag );
+void    clearSymbolHash( ASM_T *as );
+void    codeExpr( ASM_T *as, EXOP_T op, WORD16 val, SYM_T *sym );
+int     compareJobs( const void *a, const void *b );
 int     compareSymbols( const void *a, const void *b );
-void    conditionFalse( void );
-void    conditionTrue( void );
-SYM_T  *defineLexeme( int start, int term, WORD16 val, SYMTYP type );
-SYM_T  *defineSymbol( char *name, WORD16 val, SYMTYP type, WORD16 start);
-void    endOfBinary( void );
-void    errorLexeme( EMSG_T *mesg, int col );
-void    errorMessage( EMSG_T *mesg, int col );
-void    errorSymbol( EMSG_T *mesg, char *name, int col );
-SYM_T  *eval( void );
-WORD32  evalDubl( WORD32 initial_value );
-FLTG_T *evalFltg( void );
-SYM_T  *evalSymbol( void );
-void    getArgs( int argc, char *argv[] );
-WORD32  getDublExpr( void );
-WORD32  getDublExprs( void );
-FLTG_T *getFltgExpr( void );
-FLTG_T *getFltgExprs( void );
-SYM_T  *getExpr( void );
-WORD16  getExprs( void );
-WORD16  incrementClc( void );
-void    inputDubl( void );
-void    inputFltg( void );
-WORD16  insertLiteral( LPOOL_T *pool, WORD16 value );
-char   *lexemeToName( char *name, int from, int term );
-void    listLine( void );
-SYM_T  *lookup( char *name );
-void    moveToEndOfLine( void );
-void    nextLexBlank( void );
-void    nextLexeme( void );
+void    conditionFalse( ASM_T *as );
+void    conditionTrue( ASM_T *as );
+void    copyOutput( FILE *to, FILE *from, long count );
+SYM_T  *defineLexeme( ASM_T *as, int start, int term, WORD16 val, SYMTYP type );
+SYM_T  *defineSymbol( ASM_T *as, SYMKEY key, WORD16 val, SYMTYP type,
+                      WORD16 start );
+void    endOfBinary( ASM_T *as );
+void    errorLexeme( ASM_T *as, EMSG_T *mesg, int col );
+void    errorMessage( ASM_T *as, EMSG_T *mesg, int col );
+void    errorSymbol( ASM_T *as, EMSG_T *mesg, char *name, int col );
+SYM_T  *eval( ASM_T *as );
+WORD32  evalDubl( ASM_T *as, WORD32 initial_value );
+FLTG_T *evalFltg( ASM_T *as );
+SYM_T  *evalSymbol( ASM_T *as );
+CODED_T *findCodedExprs( ASM_T *as );
+void    failOnePass( ASM_T *as );
+void    fixupOnePass( ASM_T *as );
+void    flushList( ASM_T *as );
+void    flushTape( ASM_T *as );
+void    freeAssembler( ASM_T *as );
+void    takeLine( ASM_T *as, char *text, int length );
+void    getArgs( ASM_T *as, int argc, char *argv[] );
+WORD32  getDublExpr( ASM_T *as );
+WORD32  getDublExprs( ASM_T *as );
+FLTG_T *getFltgExpr( ASM_T *as );
+FLTG_T *getFltgExprs( ASM_T *as );
+SYM_T  *getExpr( ASM_T *as );
+WORD16  getExprs( ASM_T *as );
+WORD16  getCodedExprs( ASM_T *as );
+void    growSymbolHash( ASM_T *as );
+void    growSymbolTable( ASM_T *as );
+void   *growTable( void *table, int *room, int size, int need );
+BOOL    hashPermanentSymbols( ASM_T *as, SYM_T **syms, int count );
+unsigned long hashSymbol( SYMKEY key, unsigned long seed );
+WORD16  incrementClc( ASM_T *as );
+void    inputDubl( ASM_T *as );
+void    inputFltg( ASM_T *as );
+WORD16  insertLiteral( ASM_T *as, LPOOL_T *pool, WORD16 value );
+char   *keyToName( char *name, SYMKEY key );
+char   *lexemeToName( ASM_T *as, char *name, int from, int term );
+SYMKEY  lexemeToKey( ASM_T *as, int from, int term );
+void    listChars( ASM_T *as, char *text, int length );
+void    listDecimal( ASM_T *as, int value, int width );
+void    listField( ASM_T *as, char *text, int width );
+void    listFormat( ASM_T *as, char *format, ... );
+void    listLine( ASM_T *as );
+void    listNewPage( ASM_T *as, BOOL titled );
+void    listOctal( ASM_T *as, unsigned int value, int digits );
+long    listPosition( ASM_T *as );
+void    listSpaces( ASM_T *as, int count );
+char   *mapSource( char *path, long *size, BOOL *mapped );
+void    loadPermanentSnapshot( ASM_T *as, char *path );
+void    loadWord( ASM_T *as, WORD16 loc, WORD16 val );
+SYM_T  *lookup( ASM_T *as, SYMKEY key );
+void    moveToEndOfLine( ASM_T *as );
+void    expandTabs( char *to, char *from, int size );
+SKIP_T *findSkip( ASM_T *as );
+int     expandedColumn( ASM_T *as, int col );
+int     tabWidth( ASM_T *as, int col, int column );
+void    skipSpaces( ASM_T *as );
+SYMKEY  nameToKey( char *name );
+void    xrefSymbol( ASM_T *as, SYM_T *sym, int col );
+XREF_T *xrefEntry( ASM_T *as, SYM_T *sym );
+ASM_T  *newAssembler( void );
+void    newImage( ASM_T *as );
+char   *openSource( ASM_T *as, char *path );
+void    nextLexBlank( ASM_T *as );
+void    nextLexeme( ASM_T *as );
+int     nextXref( ASM_T *as, int *block, int *pos );
 void    normalizeFltg( FLTG_T *fltg );
-void    onePass( void );
-void    printCrossReference( void );
-void    printErrorMessages( void );
-void    printLine(char *line, WORD16 loc, WORD16 val, LINESTYLE_T linestyle);
-void    printPageBreak( void );
-void    printPermanentSymbolTable( void );
-void    printSymbolTable( void );
-BOOL    pseudoOperators( PSEUDO_T val );
-void    punchChecksum( void );
-void    punchLocObject( WORD16 loc, WORD16 val );
-void    punchLiteralPool( LPOOL_T *p, WORD16 lpool_page );
-void    punchOutObject( WORD16 loc, WORD16 val );
-void    punchLeader( int count );
-void    punchObject( WORD16 val );
-void    punchOrigin( WORD16 loc );
-void    readLine( void );
-void    saveError( char *mesg, int cc );
-BOOL    testForLiteralCollision( WORD16 loc );
-void    topOfForm( char *title, char *sub_title );
+void    onePass( ASM_T *as );
+FILE   *openOutput( ASM_T *as, char *path, char *mode, char **buf,
+                    size_t *size );
+void    openOutputFiles( ASM_T *as );
+WORD16  orOperand( ASM_T *as, WORD16 value, SYMTYP value_type, SYM_T *symt,
+                   int col );
+BOOL    parallelPass( ASM_T *as );
+void    printCrossReference( ASM_T *as );
+void    finishReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ));
+void    printErrorMessages( ASM_T *as );
+void    printLine( ASM_T *as, char *line, WORD16 loc, WORD16 val,
+                   LINESTYLE_T linestyle );
+void    printPageBreak( ASM_T *as );
+void    printPermanentSymbolTable( ASM_T *as );
+void    printReports( ASM_T *as, BOOL listing );
+void    printSymbolTable( ASM_T *as );
+BOOL    pseudoOperators( ASM_T *as, PSEUDO_T val );
+void    punchChecksum( ASM_T *as );
+void    punchImage( ASM_T *as );
+void    punchLocObject( ASM_T *as, WORD16 loc, WORD16 val );
+void    punchLiteralPool( ASM_T *as, LPOOL_T *p, WORD16 lpool_page );
+void    punchOutObject( ASM_T *as, WORD16 loc, WORD16 val );
+void    punchLeader( ASM_T *as, int count );
+void    punchObject( ASM_T *as, WORD16 val );
+void    punchOrigin( ASM_T *as, WORD16 loc );
+void    punchZeroBlock( ASM_T *as, WORD16 count );
+void    putLine( ASM_T *as, char *text );
+void    readLine( ASM_T *as );
+BOOL    readManifest( ASM_T *as, char *path );
+void    renderListing( ASM_T *as );
+void   *reportWorker( void *arg );
+BOOL    replayLine( ASM_T *as );
+void    restoreCheckpoint( ASM_T *as, CHECKPOINT_T *cpt );
+void    runChunk( ASM_T *as, CHUNK_T *chunk );
+WORD16  runCodedExprs( ASM_T *as, CODED_T *ex );
+BOOL    sameCheckpoint( CHECKPOINT_T *a, CHECKPOINT_T *b );
+BOOL    samePool( LPOOL_T *a, LPOOL_T *b );
+SYM_T **sortSymbolTable( ASM_T *as, int *fixed_count );
+SYM_T  *symbolAt( ASM_T *as, int ix );
+void    startReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ),
+                     int pages );
+int     symbolTablePages( ASM_T *as );
+void    saveDiag( ASM_T *as, EMSG_T *mesg, char *name, int col );
+void    shareOptions( ASM_T *to, ASM_T *from );
+void    saveError( ASM_T *as, char *mesg, int cc );
+void    stitchChunk( ASM_T *as, CHUNK_T *chunk, CHUNKEND_T *end );
+void    takeCheckpoint( ASM_T *as, CHECKPOINT_T *cpt );
+void    takeTitle( ASM_T *as );
+BOOL    testForLiteralCollision( ASM_T *as, WORD16 loc );
+void    topOfForm( ASM_T *as, char *title, char *sub_title );
+void    writePermanentSnapshot( ASM_T *as );
 
 /*----------------------------------------------------------------------------*/
 
-/* Table of pseudo-ops (directives) which are used to setup the symbol        */
-/* table on startup and when the EXPUNGE pseudo-op is executed.               */
-SYM_T pseudo[] =
+/* Table of pseudo-ops (directives).  They are built into the permanent       */
+/* symbol table and remain there when the EXPUNGE pseudo-op is executed.      */
+SYMDEF_T pseudo[] =
 {
   { PSEUDO, "BANK",   BANK    },    /* Like field, select some 32K out of 128K*/
   { PSEUDO, "BINPUN", BINPUNCH },   /* Output in Binary Loader format.        */
@@ -398,9 +808,9 @@ SYM_T pseudo[] =
 };
 
 /* Symbol Table                                                               */
-/* The table is put in lexical order on startup, so symbols can be            */
+/* The table is hashed at build time (see permtab below), so symbols can be   */
 /* inserted as desired into the initial table.                                */
-SYM_T permanent_symbols[] =
+SYMDEF_T permanent_symbols[] =
 {
   /* Memory Reference Instructions                                            */
   { MRIFIX, "AND",    00000   },    /* LOGICAL AND                            */
@@ -590,23 +1000,235 @@ SYM_T permanent_symbols[] =
                                     /* is cleared.                            */
 };      /* End-of-Symbols for Permanent Symbol Table                          */
 
-/* Global variables                                                           */
-SYM_T *symtab;                  /* Symbol Table                               */
-int    symbol_top;              /* Number of entries in symbol table.         */
-
-SYM_T *fixed_symbols;           /* Start of the fixed symbol table entries.   */
-int    number_of_fixed_symbols;
-
-/*----------------------------------------------------------------------------*/
-
-WORD16 *xreftab;                /* Start of the concordance table.            */
+/* Perfect hash table of the pseudo-ops and permanent symbols above.  It is   */
+/* generated at build time by mkpermtab (see the Makefile), so no symbol      */
+/* table work is done on startup.  mkpermtab compiles this file with          */
+/* MKPERMTAB defined, which leaves the table empty.                           */
+#ifdef MKPERMTAB
+#define PERMTAB_BUCKETS  1
+#define PERMTAB_COUNT    0
+#define PERMTAB_SIZE     1
+int     permtab_builtin_disp[PERMTAB_BUCKETS];
+int     permtab_builtin_order[1];
+SYM_T   permtab_builtin[PERMTAB_SIZE];
+#else
+#include "palbart-permtab.h"
+#endif
 
-ERRSAVE_T error_list[20];
-int     save_error_count;
+/* The state of one assembly.  Everything that changes while a source is     */
+/* assembled lives here, so one process can run any number of assemblies.    */
+/* Every function that needs it is passed the context as its first argument. */
+struct asm_t
+{
+  /* The permanent symbol table in use, the built-in one unless a snapshot    */
+  /* was loaded with -u.  permtab_order holds the slot of each symbol by      */
+  /* name.  The table itself is private, as it counts references to symbols. */
+  SYM_T  *permtab;
+  int    *permtab_disp;
+  int    *permtab_order;
+  int     permtab_buckets;
+  int     permtab_count;
+  int     permtab_size;
+  SYM_T  *permtab_copy;         /* The copy of permtab_builtin, if made.      */
+  BOOL    permtab_hashed;       /* TRUE if hashPermanentSymbols() made it.    */
+  char   *snapbase;             /* The snapshot mapped from -u, or NULL.      */
+  long    snapsize;
+
+  SYM_T *symchunk[SYMBOL_CHUNKS]; /* Symbol Table, in chunks that never move. */
+  int    symbol_chunks;         /* Number of chunks allocated.                */
+  int    symbol_room;           /* Number of entries in all chunks.           */
+  int    symbol_top;            /* Number of entries in symbol table.         */
+
+  int    number_of_fixed_symbols;
+
+  SYM_T **symhash;              /* Hash index into symtab, NULL if empty.     */
+  int    symhash_size;          /* Entries in symhash, a power of 2.          */
+  BOOL   permanent_expunged;    /* Set when EXPUNGE removed permtab symbols.  */
+
+  XREF_T *xrefs;                /* The concordance, by symbol.                */
+  int     xref_used;
+  int     xref_room;
+  XREFBLOCK_T *xrefblocks;      /* The references of all the symbols.         */
+  int     xrefblock_used;
+  int     xrefblock_room;
+
+  ERRSAVE_T error_list[20];
+  int     save_error_count;
+
+  LPOOL_T pz;                   /* Storage for page zero constants.           */
+  LPOOL_T cp;                   /* Storage for current page constants.        */
+
+  FILE   *errorfile;
+  FILE   *listfile;
+  FILE   *listsave;
+  FILE   *objectfile;
+  FILE   *objectsave;
+  BYTE    tape[TAPE_BUFFER];    /* Object not yet written to objectsave.      */
+  int     tape_count;
+  char   *listout;              /* Listing not yet written to its file.       */
+  int     listout_count;
+  LISTREC_T *listrecs;          /* Listing not yet made into text.            */
+  int     listrec_count;
+  int     listrec_room;
+  char   *listtitles;           /* Titles of the LISTREC_TITLE records.       */
+  int     listtitle_count;
+  int     listtitle_room;
+  int     listrec_page_lineno;  /* page_lineno and list_title at the first    */
+  char    listrec_title[TITLELEN + 2];  /* record, where rendering starts.    */
+
+  char    errorpathname[NAMELEN];
+  char    filename[NAMELEN];
+  char    listpathname[NAMELEN];
+  char    objectpathname[NAMELEN];
+  char   *pathname;
+  char    permpathname[NAMELEN];
+  char    snappathname[NAMELEN];
+  char   *snapshotpath;         /* Snapshot to load, from -u.                 */
+  char   *progname;             /* Name the assembler was run by.             */
+  char  **sources;              /* The input files named on the command line. */
+  int     source_count;
+  int     source_room;
+  int     threads;              /* Threads to assemble them on, from -j.      */
+  BOOL    batch;                /* TRUE in an assembly of a batch from -j.    */
+
+  int     list_lineno;
+  int     list_pageno;
+  char    list_title[TITLELEN + 2];
+  BOOL    list_off;             /* TRUE while XLIST turns the listing off.    */
+  char   *line;                 /* Input line, ended by a newline or NUL.     */
+  int     lineno;               /* Current line number.                       */
+  int     page_lineno;          /* print line number on current page.         */
+  BOOL    listed;               /* Listed flag.                               */
+
+  /* Source cache filled in pass 1 and replayed in pass 2.                    */
+  char      *srcbase;           /* The input file, mapped into memory.        */
+  long       srcsize;           /* Size of the input file.                    */
+  BOOL       srcmapped;         /* TRUE if srcbase is mapped, not allocated.  */
+  long       srcpos;            /* Offset of the next line to read.           */
+  char      *arena;             /* Free space for rewritten lines.            */
+  int        arena_left;
+  char     **arena_blocks;      /* The blocks of the arena, to be freed.      */
+  int        arena_block_count;
+  int        arena_block_room;
+  SRCLINE_T *srclines;          /* The lines read in pass 1.                  */
+  int        srcline_count;
+  int        srcline_room;
+  int        srcline_next;      /* Next line to replay in pass 2.             */
+  LEXEME_T  *lexemes;           /* The lexemes of all the lines, in order.    */
+  int        lexeme_count;
+  int        lexeme_room;
+  int        lexeme_next;       /* Next lexeme to replay in pass 2.           */
+  int        lexeme_line;       /* Cached line in line, -1 if none.           */
+  SKIP_T    *skips;             /* The conditionals skipped in pass 1.        */
+  int        skip_count;
+  int        skip_room;
+  CODED_T   *coded;             /* The operand fields compiled in pass 1.     */
+  int        coded_count;
+  int        coded_room;
+  int        coded_next;        /* Next compiled field to look at in pass 2.  */
+  int        coded_valid;       /* First field compiled after an EXPUNGE.     */
+  EXCODE_T  *excode;            /* The code of all the compiled fields.       */
+  int        excode_count;
+  int        excode_room;
+  SYM_T     *exstack;           /* Stack the code is run on.                  */
+  int        exstack_room;
+  BOOL       coding;            /* TRUE while a field is being compiled.      */
+  int        coding_depth;      /* Stack depth of the code so far.            */
+  int        coding_max;        /* Greatest stack depth of the code so far.   */
+  BOOL       coding_literals;   /* TRUE if the code generates literals.       */
+  BOOL       coding_forward;    /* TRUE if the code has forward references.   */
+  FIXUP_T   *fixups;            /* Values to fix up in a single pass.         */
+  int        fixup_count;
+  int        fixup_room;
+  int        fixup_field;       /* Compiled field to fix up, -1 if none.      */
+  int        fixup_list_rec;    /* Record printLine() listed its value in.    */
+  CHECKPOINT_T *checkpoints;    /* Taken by pass 1 for pass 2 workers.        */
+  int        checkpoint_count;
+  int        checkpoint_room;
+  CHECKPOINT_T *chunk_from;     /* State a worker starts pass 2 in, or NULL.  */
+  int        chunk_end;         /* Line a worker stops before, -1 if none.    */
+  BOOL       chunk_stopped;     /* TRUE once the worker has stopped there.    */
+  BOOL       worker;            /* TRUE in a pass 2 worker process.           */
+  BOOL       worker_usable;     /* FALSE once its output cannot be used.      */
+  PAGEBREAK_T *pagebreaks;      /* Page breaks left to the parent.            */
+  int        pagebreak_count;
+  int        pagebreak_room;
+  char      *titles;            /* Listing titles of the page breaks.         */
+  int        title_count;
+  int        title_room;
+
+  /* Output kept in memory by palbartAssemble() instead of written to files.  */
+  BOOL       in_memory;         /* TRUE to write to memory, not to files.     */
+  char      *objectbuf;         /* The object, listing and error output.      */
+  size_t     objectbuf_size;
+  char      *listbuf;
+  size_t     listbuf_size;
+  char      *errorbuf;
+  size_t     errorbuf_size;
+  WORD16    *image;             /* The words punched, by address.             */
+  BYTE      *loaded;            /* TRUE for each word of image punched.       */
+  long       tape_length;       /* Characters punched, or that would be.      */
+  PALBART_DIAG_T *diags;        /* The caller's buffer for the errors.        */
+  int        diag_size;
+  int        diag_count;
+
+  int     cc;                   /* Column Counter (char position in line).    */
+  BOOL    compact;              /* Punch the image at the end, from -c.       */
+  WORD16  checksum;             /* Generated checksum                         */
+  BOOL    checksum_partial;     /* TRUE if it lacks the sum before the chunk. */
+  BOOL    binary_data_output;   /* Set true when data has been output.        */
+  WORD16  clc;                  /* Location counter                           */
+  WORD16  cplc;                 /* Current page literal counter.              */
+  char    delimiter;            /* Character immediately after eval'd term.   */
+  int     errors;               /* Number of errors found so far.             */
+  BOOL    error_in_line;        /* TRUE if error on current line.             */
+  int     errors_pass_1;        /* Number of errors on pass 1.                */
+  WORD16  field;                /* Current field                              */
+  WORD16  fieldlc;              /* location counter without field portion.    */
+  BOOL    fltg_input;           /* TRUE when doing floating point input.      */
+  BOOL    indirect_generated;   /* TRUE if an off page address generated.     */
+  int     last_xref_lexstart;   /* Column where last xref symbol was located. */
+  int     last_xref_lineno;     /* Line where last xref symbol was located.   */
+  int     lexstartprev;         /* Where previous lexeme started.             */
+  int     lextermprev;          /* Where previous lexeme ended.               */
+  int     lexstart;             /* Index of current lexeme on line.           */
+  int     lexterm;              /* Index of character after current lexeme.   */
+  BOOL    list_errors_only;     /* Keep the listing only on errors, from -e.  */
+  BOOL    literals_on;          /* Generate literals, defaults to none        */
+  int     maxcc;                /* Current line length.                       */
+  BOOL    one_pass;             /* Assemble in a single pass, from -1.        */
+  BOOL    overflow;             /* Overflow flag for math routines.           */
+  int     pass;                 /* Number of current pass.                    */
+  BOOL    print_permanent_symbols;
+  BOOL    punch_off;            /* TRUE while NOPUNCH turns the output off.   */
+  WORD16  pzlc;                 /* Page Zero literal counter.                 */
+  WORD16  radix;                /* Default number radix.                      */
+  WORD16  reloc;                /* The relocation distance.                   */
+  BOOL    rim_mode;             /* Generate rim format, defaults to bin       */
+  BOOL    symtab_print;         /* Print symbol table flag                    */
+  BOOL    write_permanent_snapshot;
+  BOOL    xref;
+  BOOL    zblock_words;         /* List each word of a ZBLOCK, from -z.       */
+
+  FLTG_T  fltg_ac;              /* Value holder for evalFltg()                */
+  SYM_T   sym_eval;             /* Value holder for eval()                    */
+  SYM_T   sym_getexpr;          /* Value holder for getexpr()                 */
+  SYM_T   sym_undefined;        /* Symbol Table Terminator                    */
+};
 
-LPOOL_T pz;                     /* Storage for page zero constants.           */
-LPOOL_T cp;                     /* Storage for current page constants.        */
+/* A report made on a thread of its own in a copy of the context.  What it    */
+/* lists is kept in memory until finishReport() adds it to the listing.       */
+struct report_t
+{
+  ASM_T     as;                 /* The copy it is made in.                    */
+  char     *text;               /* Its listing, from open_memstream().        */
+  size_t    length;
+  pthread_t thread;
+  BOOL      threaded;           /* Set if it is being made on the thread.     */
+  void    (*print)( ASM_T *as );
+};
 
+/* Global variables                                                           */
 char   s_detected[] = "detected";
 char   s_error[]    = "error";
 char   s_errors[]   = "errors";
@@ -615,6 +1237,41 @@ char   s_page[]     = "Page";
 char   s_symtable[] = "Symbol Table";
 char   s_xref[]     = "Cross Reference";
 
+/* Character classes for the lexer, indexed by the (unsigned) character.      */
+#define B  CC_BLANK
+#define D  CC_DONE
+#define E  ( CC_END | CC_DONE )
+#define A  CC_ALPHA
+#define N  CC_DIGIT
+#define S  CC_SKIP
+#define G  ( CC_BLANK | CC_SKIP )
+unsigned char charclass[256] =
+{
+  E, 0, 0, 0, 0, 0, 0, 0, 0, B, E, 0, B, 0, 0, 0,   /* 000 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 020 */
+  B, 0, 0, 0, S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D,   /* 040 */
+  N, N, N, N, N, N, N, N, N, N, 0, D, S, 0, G, 0,   /* 060 */
+  0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,   /* 100 */
+  A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,   /* 120 */
+  0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,   /* 140 */
+  A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,   /* 160 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 200 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 220 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 240 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 260 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 300 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 320 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 340 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0    /* 360 */
+};
+#undef  B
+#undef  D
+#undef  E
+#undef  A
+#undef  N
+#undef  S
+#undef  G
+
 /* Assembler diagnostic messages.                                             */
 /* Some attempt has been made to keep continuity with the PAL-III and         */
 /* MACRO-8 diagnostic messages.  If a diagnostic indicator, (e.g., IC)        */
@@ -671,71 +1328,10 @@ EMSG_T  text_string         = { "no delimiter",
 EMSG_T  in_rim_mode         = { "not OK in rim mode"
                                     "FIELD pseudo-op not valid in RIM mode" };
 EMSG_T  lt_expected         = { "'<' expected",  "'<' expected" };
-EMSG_T  symbol_table_full   = { "ST Symbol Tbl Full",
-                                                    "Symbol Table Full" };
-
-/*----------------------------------------------------------------------------*/
 
-FILE   *errorfile;
-FILE   *infile;
-FILE   *listfile;
-FILE   *listsave;
-FILE   *objectfile;
-FILE   *objectsave;
-
-char    errorpathname[NAMELEN];
-char    filename[NAMELEN];
-char    listpathname[NAMELEN];
-char    objectpathname[NAMELEN];
-char   *pathname;
-char    permpathname[NAMELEN];
-
-int     list_lineno;
-int     list_pageno;
-char    list_title[LINELEN];
-BOOL    list_title_set;         /* Set if TITLE pseudo-op used.               */
-char    line[LINELEN];          /* Input line.                                */
-int     lineno;                 /* Current line number.                       */
-int     page_lineno;            /* print line number on current page.         */
-BOOL    listed;                 /* Listed flag.                               */
-
-int     cc;                     /* Column Counter (char position in line).    */
-WORD16  checksum;               /* Generated checksum                         */
-BOOL    binary_data_output;     /* Set true when data has been output.        */
-WORD16  clc;                    /* Location counter                           */
-WORD16  cplc;                   /* Current page literal counter.              */
-char    delimiter;              /* Character immediately after eval'd term.   */
-int     errors;                 /* Number of errors found so far.             */
-BOOL    error_in_line;          /* TRUE if error on current line.             */
-int     errors_pass_1;          /* Number of errors on pass 1.                */
-WORD16  field;                  /* Current field                              */
-WORD16  fieldlc;                /* location counter without field portion.    */
-BOOL    fltg_input;             /* TRUE when doing floating point input.      */
-BOOL    indirect_generated;     /* TRUE if an off page address generated.     */
-int     last_xref_lexstart;     /* Column where last xref symbol was located. */
-int     last_xref_lineno;       /* Line where last xref symbol was located.   */
-int     lexstartprev;           /* Where previous lexeme started.             */
-int     lextermprev;            /* Where previous lexeme ended.               */
-int     lexstart;               /* Index of current lexeme on line.           */
-int     lexterm;                /* Index of character after current lexeme.   */
-BOOL    literals_on;            /* Generate literals, defaults to none        */
-int     maxcc;                  /* Current line length.                       */
-BOOL    overflow;               /* Overflow flag for math routines.           */
-int     pass;                   /* Number of current pass.                    */
-BOOL    print_permanent_symbols;
-WORD16  pzlc;                   /* Page Zero literal counter.                 */
-WORD16  radix;                  /* Default number radix.                      */
-WORD16  reloc;                  /* The relocation distance.                   */
-BOOL    rim_mode;               /* Generate rim format, defaults to bin       */
-BOOL    symtab_print;           /* Print symbol table flag                    */
-BOOL    xref;
-
-FLTG_T  fltg_ac;                /* Value holder for evalFltg()                */
-SYM_T   sym_eval = { DEFINED, "", 0 };       /* Value holder for eval()       */
-SYM_T   sym_getexpr = { DEFINED, "", 0 };    /* Value holder for getexpr()    */
-SYM_T   sym_undefined = { UNDEFINED, "", 0 };/* Symbol Table Terminator       */
 
 
+#ifndef LIBPALBART
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  main                                                           */
@@ -745,2467 +1341,5858 @@ SYM_T   sym_undefined = { UNDEFINED, "", 0 };/* Symbol Table Terminator       */
 /******************************************************************************/
 int main( int argc, char *argv[] )
 {
-  int     ix;
-  int     space;
-
-  /* Set the default values for global symbols.                               */
-  binary_data_output = FALSE;
-  fltg_input = FALSE;
-  literals_on = FALSE;
-  print_permanent_symbols = FALSE;
-  rim_mode = FALSE;
-  symtab_print = FALSE;
-  xref = FALSE;
-  pathname = NULL;
+  ASM_T  *as;
+  int     status;
+
+  as = newAssembler();
 
   /* Get the options and pathnames                                            */
-  getArgs( argc, argv );
+  getArgs( as, argc, argv );
 
-  /* Setup the error file in case symbol table overflows while installing the */
-  /* permanent symbols.                                                       */
-  errorfile = fopen( errorpathname, "w" );
-  errors = 0;
-  save_error_count = 0;
-  pass = 0;             /* This is required for symbol table initialization.  */
-  symtab = (SYM_T *) malloc( sizeof( SYM_T ) * SYMBOL_TABLE_SIZE );
+  status = ( as->threads > 0 ) ? assembleBatch( as ) : assemble( as );
+  freeAssembler( as );
+  return( status );
+} /* main()                                                                   */
+#endif
 
-  if( symtab == NULL )
-  {
-    fprintf( stderr, "Could not allocate memory for symbol table.\n");
-    exit( -1 );
-  }
 
-  /* Place end marker in symbol table.                                        */
-  symtab[0] = sym_undefined;
-  symbol_top = 0;
-  number_of_fixed_symbols = symbol_top;
-  fixed_symbols = &symtab[symbol_top - 1];
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  assemble                                                       */
+/*                                                                            */
+/*  Synopsis:  Assemble the source named by the context and write its output. */
+/*             Returns non-zero if there were errors.                         */
+/*                                                                            */
+/******************************************************************************/
+int assemble( ASM_T *as )
+{
+  int     ix;
+  BOOL    listing;
+  SYM_T  *sym;
 
-  /* Enter the pseudo-ops into the symbol table                               */
-  for( ix = 0; ix < DIM( pseudo ); ix++ )
+  /* Only pass 2 fills in the concordance, and a single pass has none.        */
+  as->one_pass = as->one_pass && !as->xref;
+
+  /* A compact tape is punched in bin format from the memory image.           */
+  as->compact = as->compact && !as->rim_mode;
+  if( as->compact && as->loaded == NULL )
   {
-    defineSymbol( pseudo[ix].name, pseudo[ix].val, pseudo[ix].type, 0 );
+    newImage( as );
   }
 
-  /* Enter the predefined symbols into the table.                             */
-  /* Also make them part of the permanent symbol table.                       */
-  for( ix = 0; ix < DIM( permanent_symbols ); ix++ )
+  if( as->snapshotpath != NULL )
   {
-    defineSymbol( permanent_symbols[ix].name,
-                  permanent_symbols[ix].val,
-                  permanent_symbols[ix].type | DEFFIX , 0 );
+    loadPermanentSnapshot( as, as->snapshotpath );
   }
 
-  number_of_fixed_symbols = symbol_top;
-  fixed_symbols = &symtab[symbol_top - 1];
-
-  /* Do pass one of the assembly                                              */
-  checksum = 0;
-  pass = 1;
-  page_lineno = LIST_LINES_PER_PAGE;
-  onePass();
-  errors_pass_1 = errors;
-
-  /* Set up for pass two                                                      */
-  rewind( infile );
-  errorfile = fopen( errorpathname, "w" );
-  objectfile = fopen( objectpathname, "wb" );
-  objectsave = objectfile;
-
-  listfile = fopen( listpathname, "w" );
-  listsave = NULL;
+  /* The permanent symbols are shared, and only read, except that the         */
+  /* concordance counts the references to them in their entries.              */
+  if( as->xref )
+  {
+    as->permtab_copy = (SYM_T *) malloc( sizeof( SYM_T ) * as->permtab_size );
+    if( as->permtab_copy == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for symbol table.\n");
+      exit( -1 );
+    }
+    memcpy( as->permtab_copy, as->permtab,
+            sizeof( SYM_T ) * as->permtab_size );
+    as->permtab = as->permtab_copy;
+  }
 
-  punchLeader( 0 );
-  checksum = 0;
+  as->errorfile = openOutput( as, as->errorpathname, "w", &as->errorbuf,
+                              &as->errorbuf_size );
+  as->errors = 0;
+  as->save_error_count = 0;
+  as->pass = 0;
+
+  /* The symbol table and its hash index grow as symbols are entered.         */
+  as->symbol_top = 0;
+  clearSymbolHash( as );
+  as->number_of_fixed_symbols = as->symbol_top;
+
+  /* Do pass one of the assembly.  A single pass assembly also writes the     */
+  /* output, as pass 2 would.                                                 */
+  as->checksum = 0;
+  as->pass = 1;
+  as->page_lineno = LIST_LINES_PER_PAGE;
+  as->fixup_field = -1;
+  if( as->one_pass )
+  {
+    openOutputFiles( as );
+  }
+  onePass( as );
+  as->errors_pass_1 = as->errors;
 
-  /* Do pass two of the assembly                                              */
-  errors = 0;
-  save_error_count = 0;
-  page_lineno = LIST_LINES_PER_PAGE;
+  /* Complete the output of a single pass assembly.  When that cannot be      */
+  /* done, failOnePass() has thrown the output away, and pass 2 writes it.    */
+  if( as->one_pass )
+  {
+    fixupOnePass( as );
+  }
 
-  if( xref )
+  if( !as->one_pass )
   {
-    /* Get the amount of space that will be required for the concordance.     */
-    for( space = 0, ix = 0; ix < symbol_top; ix++ )
+    /* Set up for pass two.  Pass 2 replays the lines cached by pass 1, and   */
+    /* reads on from where pass 1 stopped only if it has to.                  */
+    fclose( as->errorfile );
+    as->errorfile = openOutput( as, as->errorpathname, "w", &as->errorbuf,
+                                &as->errorbuf_size );
+    openOutputFiles( as );
+
+    /* Do pass two of the assembly                                           */
+    as->errors = 0;
+    as->save_error_count = 0;
+    as->page_lineno = LIST_LINES_PER_PAGE;
+
+    if( as->xref )
     {
-      symtab[ix].xref_index = space;    /* Index into concordance table.      */
-      space += symtab[ix].xref_count + 1;
-      symtab[ix].xref_count = 0;        /* Clear the count for pass 2.        */
-
+      /* The concordance is filled in by pass 2 alone, as it goes.  Entries  */
+      /* a snapshot may have brought along are not ours.                     */
+      for( ix = 0; ix < as->permtab_size; ix++ )
+      {
+        as->permtab[ix].xref_index = 0;
+        as->permtab[ix].xref_count = 0;
+      }
+      for( ix = 0; ix < as->symbol_top; ix++ )
+      {
+        sym = symbolAt( as, ix );
+        sym->xref_index = 0;
+        sym->xref_count = 0;
+      }
     }
-    /* Allocate the necessary space.                                          */
-    xreftab = (WORD16 *) malloc( sizeof( WORD16 ) * space );
-
-    /* Clear the cross reference space.                                       */
-    for( ix = 0; ix < space; ix++ )
+    as->pass = 2;
+    if( !parallelPass( as ))
     {
-      xreftab[ix] = 0;
+      onePass( as );
     }
   }
-  pass = 2;
-  onePass();
+
+  /* The listing is made from the records of the pass.  With -e it is made,  */
+  /* and kept, only if there were errors.                                     */
+  listing = !as->list_errors_only || as->errors != 0 || as->errors_pass_1 != 0;
+  if( listing )
+  {
+    renderListing( as );
+  }
 
   /* Undo effects of NOPUNCH for any following checksum                       */
-  objectfile = objectsave;
-  punchChecksum();
+  as->objectfile = as->objectsave;
+  punchChecksum( as );
 
   /* Works great for trailer.                                                 */
-  punchLeader( 1 );
+  punchLeader( as, 1 );
 
   /* undo effects of XLIST for any following output to listing file.          */
-  if( listfile == NULL )
+  if( as->listfile == NULL )
+  {
+    as->listfile = as->listsave;
+  }
+
+  if( as->compact )
   {
-    listfile = listsave;
+    punchImage( as );
   }
 
   /* Display value of error counter.                                          */
-  if( errors == 0 )
+  if( as->errors == 0 )
   {
-    fprintf( listfile, "\n      %s %s %s\n", s_no, s_detected, s_errors );
+    listFormat( as, "\n      %s %s %s\n", s_no, s_detected, s_errors );
   }
   else
   {
-    fprintf( errorfile, "\n      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
-    fprintf( listfile, "\n      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
-    fprintf( stderr,   "      %d %s %s\n", errors, s_detected,
-                                        ( errors == 1 ? s_error : s_errors ));
+    fprintf( as->errorfile, "\n      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    listFormat( as, "\n      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    if( !as->in_memory && !as->batch )
+    {
+      fprintf( stderr,   "      %d %s %s\n", as->errors, s_detected,
+                                    ( as->errors == 1 ? s_error : s_errors ));
+    }
   }
 
-  if( symtab_print )
+  printReports( as, listing );
+
+  if( as->write_permanent_snapshot )
   {
-    printSymbolTable();
+    writePermanentSnapshot( as );
   }
 
-  if( print_permanent_symbols )
+  if( !listing )
   {
-    printPermanentSymbolTable();
+    as->listout_count = 0;
   }
-
-  if( xref )
+  flushTape( as );
+  flushList( as );
+  fclose( as->objectfile );
+  fclose( as->listfile );
+  fclose( as->errorfile );
+  if( as->errors == 0 && as->errors_pass_1 == 0 && !as->in_memory )
   {
-    printCrossReference();
+    remove( as->errorpathname );
   }
-
-  fclose( objectfile );
-  fclose( listfile );
-  fclose( errorfile );
-  if( errors == 0 && errors_pass_1 == 0 )
+  if( !listing && !as->in_memory )
   {
-    remove( errorpathname );
+    remove( as->listpathname );
   }
 
-  return( errors != 0 );
-} /* main()                                                                   */
+  return( as->errors != 0 );
+} /* assemble()                                                               */
+
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getArgs                                                        */
+/*  Function:  assembleBatch                                                  */
 /*                                                                            */
-/*  Synopsis:  Parse command line, set flags accordingly and setup input and  */
-/*             output files.                                                  */
+/*  Synopsis:  Assemble each of the input files on its own, with the options  */
+/*             of the context, on a pool of -j threads.  The output of each   */
+/*             is the same as if it were assembled alone.  The files with     */
+/*             errors are reported in the order they were named.  Returns     */
+/*             non-zero if any file had errors or could not be assembled.     */
 /*                                                                            */
 /******************************************************************************/
-void getArgs( int argc, char *argv[] )
+int assembleBatch( ASM_T *as )
 {
-  int  len;
-  int  ix, jx;
-
-  /* Set the defaults                                                         */
-  errorfile = NULL;
-  infile = NULL;
-  listfile = NULL;
-  listsave = NULL;
-  objectfile = NULL;
-  objectsave = NULL;
-
-  for( ix = 1; ix < argc; ix++ )
+  BATCH_T     batch;
+  int         failed;
+  int         ix;
+  BATCHJOB_T *job;
+  BATCHJOB_T *jobs;
+  struct stat st;
+  pthread_t  *threads;
+  int         workers;
+
+  /* A snapshot is loaded once, for all of them to share.                     */
+  if( as->snapshotpath != NULL )
   {
-    if( argv[ix][0] == '-' )
-    {
-      for( jx = 1; argv[ix][jx] != 0; jx++ )
-      {
-        switch( argv[ix][jx] )
-        {
-        case 'd':
-          symtab_print = TRUE;
-          break;
-
-        case 'r':
-          rim_mode = TRUE;
-          break;
-
-        case 'l':
-          literals_on = TRUE;
-          break;
-
-        case 'p':
-          print_permanent_symbols = TRUE;
-          break;
-
-        case 'x':
-          xref = TRUE;
-          break;
-
-        case 'v':
-          fprintf( stderr, "%s\n", release );
-          fflush( stderr );
-          exit( -1 );
-          break;
-
-        default:
-          fprintf( stderr, "%s: unknown flag: %s\n", argv[0], argv[ix] );
-        case 'h':
-          fprintf( stderr, " -d -- dump symbol table\n" );
-          fprintf( stderr, " -h -- show this help\n" );
-          fprintf( stderr, " -l -- generate literals\n" );
-          fprintf( stderr, " -r -- output rim format file\n" );
-          fprintf( stderr, " -p -- output permanent symbols to file\n" );
-          fprintf( stderr, " -v -- display version\n" );
-          fprintf( stderr, " -x -- output cross reference to file\n" );
-          fflush( stderr );
-          exit( -1 );
-        } /* end switch                                                       */
-      } /* end for                                                            */
-    }
-    else
-    {
-      if( pathname != NULL )
-      {
-        fprintf( stderr, "%s: too many input files\n", argv[0] );
-        exit( -1 );
-      }
-      pathname = &argv[ix][0];
-    }
-  } /* end for                                                                */
+    loadPermanentSnapshot( as, as->snapshotpath );
+  }
 
-  if( pathname == NULL )
+  jobs = (BATCHJOB_T *) malloc( sizeof( BATCHJOB_T ) * as->source_count );
+  batch.queue = (BATCHJOB_T **) malloc( sizeof( BATCHJOB_T * )
+                                        * as->source_count );
+  threads = (pthread_t *) malloc( sizeof( pthread_t ) * as->threads );
+  if( jobs == NULL || batch.queue == NULL || threads == NULL )
   {
-    fprintf( stderr, "%s:  no input file specified\n", argv[0] );
+    fprintf( stderr, "Could not allocate memory for batch.\n" );
     exit( -1 );
   }
 
-  len = strlen( pathname );
-  if( len > NAMELEN - 5 )
+  /* Taking the biggest sources first keeps a big one from being the last.    */
+  for( ix = 0; ix < as->source_count; ix++ )
   {
-    fprintf( stderr, "%s: pathname \"%s\" too long\n", argv[0], pathname );
-    exit( -1 );
+    jobs[ix].path = as->sources[ix];
+    jobs[ix].size = ( stat( jobs[ix].path, &st ) == 0 ) ? (long) st.st_size : 0;
+    jobs[ix].failure = NULL;
+    jobs[ix].errors = 0;
+    batch.queue[ix] = &jobs[ix];
   }
-
-  /* Now open the input file.                                                 */
-  if(( infile = fopen( pathname, "r" )) == NULL )
+  qsort( batch.queue, as->source_count, sizeof( BATCHJOB_T * ), compareJobs );
+  batch.options = as;
+  batch.count = as->source_count;
+  batch.next = 0;
+  pthread_mutex_init( &batch.lock, NULL );
+
+  /* This thread is one of the workers.                                       */
+  workers = ( as->threads < batch.count ) ? as->threads : batch.count;
+  for( ix = 1; ix < workers; ix++ )
   {
-    fprintf( stderr, "%s: cannot open \"%s\"\n", argv[0], pathname );
-    exit( -1 );
+    if( pthread_create( &threads[ix], NULL, batchWorker, &batch ) != 0 )
+    {
+      break;                        /* Make do with the threads there are.    */
+    }
   }
-
-  /* Now make the pathnames                                                   */
-  /* Find last '.', if it exists.                                             */
-  jx = len - 1;
-  while( pathname[jx] != '.'  && pathname[jx] != '/'
-      && pathname[jx] != '\\' && jx >= 0 )
+  workers = ix;
+  batchWorker( &batch );
+  for( ix = 1; ix < workers; ix++ )
   {
-    jx--;
+    pthread_join( threads[ix], NULL );
   }
+  pthread_mutex_destroy( &batch.lock );
 
-  switch( pathname[jx] )
+  for( failed = 0, ix = 0; ix < as->source_count; ix++ )
   {
-  case '.':
-    break;
+    job = &jobs[ix];
+    if( job->failure != NULL )
+    {
+      fprintf( stderr, job->failure, as->progname, job->path );
+      failed++;
+    }
+    else if( job->errors != 0 )
+    {
+      fprintf( stderr, "%s: %d %s %s\n", job->path, job->errors, s_detected,
+                                    ( job->errors == 1 ? s_error : s_errors ));
+      failed++;
+    }
+  }
+  free( threads );
+  free( batch.queue );
+  free( jobs );
+  return( failed != 0 );
+} /* assembleBatch()                                                          */
 
-  case '/':
-  case '\\':
-    jx = len;
-    break;
 
-  default:
-    break;
-  }
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  batchWorker                                                    */
+/*                                                                            */
+/*  Synopsis:  Assemble sources from the queue of a batch, each in a context  */
+/*             of its own, until there are none left.                         */
+/*                                                                            */
+/******************************************************************************/
+void *batchWorker( void *arg )
+{
+  ASM_T      *as;
+  BATCH_T    *batch;
+  BATCHJOB_T *job;
 
-  /* Add the pathname extensions.                                             */
-  strncpy( objectpathname, pathname, jx );
-  objectpathname[jx] = '\0';
-  strcat( objectpathname, rim_mode ? ".rim" : ".bin" );
+  batch = (BATCH_T *) arg;
+  for( ;; )
+  {
+    pthread_mutex_lock( &batch->lock );
+    job = ( batch->next < batch->count ) ? batch->queue[batch->next++] : NULL;
+    pthread_mutex_unlock( &batch->lock );
+    if( job == NULL )
+    {
+      return( NULL );
+    }
 
-  strncpy( listpathname, pathname, jx );
-  listpathname[jx] = '\0';
-  strcat( listpathname, ".lst" );
+    as = newAssembler();
+    shareOptions( as, batch->options );
+    job->failure = openSource( as, job->path );
+    if( job->failure == NULL )
+    {
+      assemble( as );
+      job->errors = as->errors;
+    }
+    freeAssembler( as );
+  }
+} /* batchWorker()                                                            */
 
-  strncpy( errorpathname, pathname, jx );
-  errorpathname[jx] = '\0';
-  strcat( errorpathname, ".err" );
 
-  strncpy( permpathname, pathname, jx );
-  permpathname[jx] = '\0';
-  strcat( permpathname, ".prm" );
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  compareJobs                                                    */
+/*                                                                            */
+/*  Synopsis:  Order the sources of a batch by size, biggest first, and then  */
+/*             in the order they were named, for qsort().                     */
+/*                                                                            */
+/******************************************************************************/
+int compareJobs( const void *a, const void *b )
+{
+  BATCHJOB_T *ja;
+  BATCHJOB_T *jb;
 
-  /* Extract the filename from the path.                                      */
-  if( isalpha( pathname[0] ) && pathname[1] == ':' && pathname[2] != '\\' )
+  ja = *(BATCHJOB_T **) a;
+  jb = *(BATCHJOB_T **) b;
+  if( ja->size != jb->size )
   {
-    pathname[1] = '\\';         /* MS-DOS style pathname                      */
+    return(( ja->size > jb->size ) ? -1 : 1 );
   }
+  return(( ja < jb ) ? -1 : ( ja > jb ));
+} /* compareJobs()                                                            */
 
-  jx = len - 1;
-  while( pathname[jx] != '/' && pathname[jx] != '\\' && jx >= 0 )
-  {
-    jx--;
-  }
-  strcpy( filename, &pathname[jx + 1] );
 
-} /* getArgs()                                                                */
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  shareOptions                                                   */
+/*                                                                            */
+/*  Synopsis:  Give a new context for a source of a batch the options, and    */
+/*             the permanent symbols, of the context of the batch.            */
+/*                                                                            */
+/******************************************************************************/
+void shareOptions( ASM_T *to, ASM_T *from )
+{
+  to->batch = TRUE;
+  to->compact = from->compact;
+  to->list_errors_only = from->list_errors_only;
+  to->literals_on = from->literals_on;
+  to->one_pass = from->one_pass;
+  to->print_permanent_symbols = from->print_permanent_symbols;
+  to->rim_mode = from->rim_mode;
+  to->symtab_print = from->symtab_print;
+  to->write_permanent_snapshot = from->write_permanent_snapshot;
+  to->xref = from->xref;
+  to->zblock_words = from->zblock_words;
+
+  to->permtab = from->permtab;
+  to->permtab_disp = from->permtab_disp;
+  to->permtab_order = from->permtab_order;
+  to->permtab_buckets = from->permtab_buckets;
+  to->permtab_count = from->permtab_count;
+  to->permtab_size = from->permtab_size;
+} /* shareOptions()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  onePass                                                        */
+/*  Function:  palbartAssemble                                                */
 /*                                                                            */
-/*  Synopsis:  Do one assembly pass.                                          */
+/*  Synopsis:  Assemble a source in memory into the caller's buffers, as      */
+/*             described in palbart.h.  Returns the number of errors.         */
 /*                                                                            */
 /******************************************************************************/
-void onePass()
+int palbartAssemble( const char *source, long size, int options,
+                     PALBART_OUTPUT_T *output )
 {
-  char    name[SYMLEN];
-  WORD16  newclc;
-  BOOL    scanning_line;
-  int     start;
-  SYM_T  *sym;
-  int     term;
-  WORD16  val;
+  ASM_T  *as;
+  int     errors;
+  long    length;
+  int     ix;
 
-  clc = 0200;                   /* Default starting address is 200 octal.     */
-  field = 0;
-  fieldlc = 0;
-  reloc = 0;
-  cp.loc = 00200;               /* Points to end of page for [] operands.     */
-  pz.loc = 00200;               /* Points to end of page for () operands.     */
-  cp.error = FALSE;
-  pz.error = FALSE;
-  listed = TRUE;
-  lineno = 0;
-  list_pageno = 0;
-  list_lineno = 0;
-  last_xref_lexstart = 0;
-  last_xref_lineno = 0;
-  list_title_set = FALSE;
-  radix = 8;                    /* Initial radix is octal (base 8).           */
+  as = newAssembler();
+  as->in_memory = TRUE;
+  as->one_pass = ( options & PALBART_ONE_PASS ) != 0;
+  as->symtab_print = ( options & PALBART_SYMTAB ) != 0;
+  as->literals_on = ( options & PALBART_LITERALS ) != 0;
+  as->rim_mode = ( options & PALBART_RIM ) != 0;
+  as->xref = ( options & PALBART_XREF ) != 0;
+  as->compact = ( options & PALBART_COMPACT ) != 0;
+  as->list_errors_only = ( options & PALBART_LIST_ERRORS ) != 0;
+  as->zblock_words = ( options & PALBART_ZBLOCK_WORDS ) != 0;
+
+  /* The source is only read, just as a mapped file is.                       */
+  as->srcbase = (char *) source;
+  as->srcsize = size;
+
+  newImage( as );
+  as->diags = output->diags;
+  as->diag_size = output->diag_size;
+
+  assemble( as );
+  errors = as->errors;
+
+  /* Copy as much of the output as there is room for.                         */
+  output->object_length = (long) as->objectbuf_size;
+  length = ( output->object_length < output->object_size )
+           ? output->object_length : output->object_size;
+  if( length > 0 )
+  {
+    memcpy( output->object, as->objectbuf, length );
+  }
 
-  while( TRUE )
+  output->listing_length = (long) as->listbuf_size;
+  length = ( output->listing_length < output->listing_size )
+           ? output->listing_length : output->listing_size;
+  if( length > 0 )
+  {
+    memcpy( output->listing, as->listbuf, length );
+  }
+  if( output->listing_length < output->listing_size )
   {
-    readLine();
-    nextLexeme();
+    output->listing[output->listing_length] = '\0';
+  }
 
-    scanning_line = TRUE;
-    while( scanning_line )
+  if( output->image != NULL )
+  {
+    for( ix = 0; ix < PALBART_IMAGE_SIZE; ix++ )
     {
-      if( isend( line[lexstart] ))
+      if( as->loaded[ix] )
       {
-        scanning_line = FALSE;
+        output->image[ix] = as->image[ix];
       }
-      else
-      {
-        switch( line[lexstart] )
-        {
-        case '/':
-          scanning_line = FALSE;
-          break;
-
-        case ';':
-          nextLexeme();
-          break;
-
-        case '$':
-          endOfBinary();
-          return;
+    }
+  }
+  output->diag_count = as->diag_count;
 
-        case '*':
-          nextLexeme();             /* Skip '*', (set origin symbol)          */
-          newclc = ((getExpr())->val & 07777 ) | field;
-          /* Do not change Current Location Counter if an error occurred.     */
-          if( !error_in_line )
-          {
-            if(( newclc & 07600 ) != ( clc & 07600 ))
-            {
-              /* Current page has changed.                                    */
-              punchLiteralPool( &cp, clc - 1 );
-            }
-            clc = newclc - reloc;
-            fieldlc = clc & 07777;
+  /* The source is the caller's.                                              */
+  as->srcbase = NULL;
+  as->srcsize = 0;
+  freeAssembler( as );
+  return( errors );
+} /* palbartAssemble()                                                        */
 
-            if( !rim_mode )
-            {
-              /* Not rim mode, put out origin.                                */
-              punchOrigin( clc );
-            }
-            printLine( line, 0, fieldlc, LINE_VAL );
-          }
-          break;
 
-        default:
-          switch( line[lexterm] )
-          {
-          case ',':
-            if( isalpha( line[lexstart] ))
-            {
-              /* Use lookup so symbol will not be counted as reference.       */
-              sym = lookup( lexemeToName( name, lexstart, lexterm ));
-              if( M_DEFINED( sym->type ))
-              {
-                if( sym->val != clc && pass == 2 )
-                {
-                  errorSymbol( &duplicate_label, sym->name, lexstart );
-                }
-                sym->type = sym->type | DUPLICATE;
-              }
-              /* Must call define on pass 2 to generate concordance.          */
-              defineLexeme( lexstart, lexterm, ( clc + reloc ), LABEL );
-            }
-            else
-            {
-              errorLexeme( &label_syntax, lexstart );
-            }
-            nextLexeme();           /* skip label                             */
-            nextLexeme();           /* skip comma                             */
-            break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  newAssembler                                                   */
+/*                                                                            */
+/*  Synopsis:  Allocate an assembler context with the default options, ready  */
+/*             for getArgs() or for its options to be set by the caller.      */
+/*                                                                            */
+/******************************************************************************/
+ASM_T *newAssembler( void )
+{
+  ASM_T  *as;
 
-          case '=':
-            if( isalpha( line[lexstart] ))
-            {
-              start = lexstart;
-              term = lexterm;
-              delimiter = line[lexterm];
-              nextLexBlank();       /* skip symbol                            */
-              nextLexBlank();       /* skip trailing =                        */
-              val = getExprs();
-              defineLexeme( start, term, val, DEFINED );
-              printLine( line, 0, val, LINE_VAL );
-            }
-            else
-            {
-              errorLexeme( &symbol_syntax, lexstartprev );
-              nextLexeme();         /* skip symbol                            */
-              nextLexeme();         /* skip trailing =                        */
-              getExprs();           /* skip expression                        */
-            }
-            break;
+  as = (ASM_T *) calloc( 1, sizeof( ASM_T ));
+  if( as == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for assembler.\n");
+    exit( -1 );
+  }
 
-          default:
-            if( isalpha( line[lexstart] ))
-            {
-              sym = evalSymbol();
-              val = sym->val;
-              if( M_PSEUDO( sym->type ))
-              {
-                nextLexeme();         /* Skip symbol                          */
-                scanning_line = pseudoOperators( (PSEUDO_T)val & 07777 );
-              }
-              else
-              {
-                /* Identifier is not a pseudo-op, interpret as load value     */
-                punchOutObject( clc, getExprs() & 07777 );
-                incrementClc();
-              }
-            }
-            else
-            {
-              /* Identifier is a value, interpret as load value               */
-              punchOutObject( clc, getExprs() & 07777 );
-              incrementClc();
-            }
-            break;
-          } /* end switch                                                     */
-          break;
-        } /* end switch                                                       */
-      } /* end if                                                             */
-    } /* end while( scanning_line )                                           */
-  } /* end while( TRUE )                                                      */
-} /* onePass()                                                                */
+  /* All the assemblies of the process share the built-in permanent symbols.  */
+  as->permtab = permtab_builtin;
+  as->permtab_disp = permtab_builtin_disp;
+  as->permtab_order = permtab_builtin_order;
+  as->permtab_buckets = PERMTAB_BUCKETS;
+  as->permtab_count = PERMTAB_COUNT;
+  as->permtab_size = PERMTAB_SIZE;
+
+  /* Set the default values for the options and the state.                    */
+  as->binary_data_output = FALSE;
+  as->chunk_end = -1;
+  as->fltg_input = FALSE;
+  as->literals_on = FALSE;
+  as->one_pass = FALSE;
+  as->permanent_expunged = FALSE;
+  as->print_permanent_symbols = FALSE;
+  as->snapshotpath = NULL;
+  as->write_permanent_snapshot = FALSE;
+  as->rim_mode = FALSE;
+  as->symtab_print = FALSE;
+  as->xref = FALSE;
+  as->pathname = NULL;
+  as->sym_eval.type = DEFINED;
+  as->sym_getexpr.type = DEFINED;
+  as->sym_undefined.type = UNDEFINED;
+  return( as );
+} /* newAssembler()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getExprs                                                       */
+/*  Function:  newImage                                                       */
 /*                                                                            */
-/*  Synopsis:  Or together a list of blank separated expressions, from the    */
-/*             current lexeme onward.  Leave the current lexeme as            */
-/*             the last one in the list.                                      */
+/*  Synopsis:  Allocate the memory image that loadWord() fills in.            */
 /*                                                                            */
 /******************************************************************************/
-WORD16 getExprs()
+void newImage( ASM_T *as )
 {
-  SYM_T  *symv;
-  SYM_T  *symt;
-  WORD16  temp;
-  SYMTYP  temp_type;
-  WORD16  value;
-  SYMTYP  value_type;
-
-  symv = getExpr();
-  value = symv->val;
-  value_type = symv->type;
-
-  while( TRUE )
+  as->image = (WORD16 *) malloc( sizeof( WORD16 ) * PALBART_IMAGE_SIZE );
+  as->loaded = (BYTE *) calloc( PALBART_IMAGE_SIZE, sizeof( BYTE ));
+  if( as->image == NULL || as->loaded == NULL )
   {
-    if( isdone( line[lexstart] ))
-    {
-      return( value );
-    }
-    switch( line[lexstart] )
-    {
-    case ')':
-    case ']':
-      return( value );
+    fprintf( stderr, "Could not allocate memory for memory image.\n");
+    exit( -1 );
+  }
+} /* newImage()                                                               */
 
-    default:
-      break;
-    }
 
-    /* Interpret space as logical or                                          */
-    symt = getExpr();
-    temp = symt->val & 07777;
-    temp_type = symt->type;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  freeAssembler                                                  */
+/*                                                                            */
+/*  Synopsis:  Free an assembler context and all the memory of its assembly.  */
+/*                                                                            */
+/******************************************************************************/
+void freeAssembler( ASM_T *as )
+{
+  int     ix;
 
-    switch( value_type )
-    {
-    case MRI:
-    case MRIFIX:
-      /* Previous symbol was a Memory Reference Instruction.                  */
-      switch( temp_type )
-      {
-      case MRI:
-      case MRIFIX:
-        /* Current symbol is also a Memory Reference Instruction.             */
-        value |= temp;          /* Just OR the MRI instructions.              */
-        break;
+  for( ix = 0; ix < as->symbol_chunks; ix++ )
+  {
+    free( as->symchunk[ix] );
+  }
+  free( as->symhash );
+  free( as->xrefs );
+  free( as->xrefblocks );
 
-      default:
-        /* Now have the address part of the MRI instruction.                  */
-        if( temp < 00200 )
-        {
-          value |= temp;        /* Page zero MRI.                             */
-        }
-        else if( (( fieldlc + reloc ) & 07600 ) <= temp
-             && temp <= (( fieldlc + reloc ) | 0177 ))
-        {
-          value |= ( PAGE_BIT | (temp & ADDRESS_FIELD )); /* Current page MRI */
-        }
-        else
-        {
-          if(( value & INDIRECT_BIT ) == INDIRECT_BIT )
-          {
-            /* Already indirect, can't generate                               */
-            errorSymbol( &illegal_indirect, symt->name, lexstartprev );
-          }
-          else
-          {
-            if( literals_on )
-            {
-              /* Now fix off page reference.                                  */
-              /* Search current page literal pool for needed value.           */
-              /* Set Indirect Current Page                                    */
-              value |= ( 00600 | insertLiteral( &cp, temp ));
-              indirect_generated = TRUE;
-            }
-            else
-            {
-              errorSymbol( &illegal_reference, symt->name, lexstartprev );
-              value |= ( temp & 0177 );
-            }
-          }
-        }
-        break;
-      }
-      break;
+  for( ix = 0; ix < as->arena_block_count; ix++ )
+  {
+    free( as->arena_blocks[ix] );
+  }
+  free( as->arena_blocks );
+  free( as->srclines );
+  free( as->lexemes );
+  free( as->skips );
+  free( as->coded );
+  free( as->excode );
+  free( as->exstack );
+  free( as->fixups );
+  free( as->checkpoints );
+  free( as->pagebreaks );
+  free( as->titles );
+  free( as->sources );
+  free( as->objectbuf );
+  free( as->listbuf );
+  free( as->errorbuf );
+  free( as->image );
+  free( as->loaded );
+  free( as->listout );
+  free( as->listrecs );
+  free( as->listtitles );
+  if( as->srcmapped )
+  {
+    munmap( as->srcbase, as->srcsize );
+  }
+  else if( as->srcsize > 0 )
+  {
+    free( as->srcbase );
+  }
 
-    default:
-        value |= temp;          /* Normal 12 bit value.                       */
-        break;
-    }
-  } /* end while                                                              */
-} /* getExprs()                                                               */
+  if( as->permtab_hashed )
+  {
+    free( as->permtab );
+    free( as->permtab_disp );
+    free( as->permtab_order );
+  }
+  if( as->snapbase != NULL )
+  {
+    munmap( as->snapbase, as->snapsize );
+  }
+  free( as->permtab_copy );
+  free( as );
+} /* freeAssembler()                                                          */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getExpr                                                        */
+/*  Function:  openOutput                                                     */
 /*                                                                            */
-/*  Synopsis:  Get an expression, from the current lexeme onward, leave the   */
-/*             current lexeme as the one after the expression.  Expressions   */
-/*             contain terminal symbols (identifiers) separated by operators. */
+/*  Synopsis:  Open an output file, or for an assembly in memory a stream     */
+/*             into buf, which replaces what an earlier stream left there.    */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *getExpr()
+FILE *openOutput( ASM_T *as, char *path, char *mode, char **buf,
+                  size_t *size )
 {
-  delimiter = line[lexterm];
+  FILE   *file;
 
-  if( line[lexstart] == '-' )
+  if( !as->in_memory )
   {
-    nextLexBlank();
-    sym_getexpr = *(eval());
-    sym_getexpr.val = ( - sym_getexpr.val );
+    return( fopen( path, mode ));
   }
-  else
+  free( *buf );
+  *buf = NULL;
+  *size = 0;
+  if(( file = open_memstream( buf, size )) == NULL )
   {
-    sym_getexpr = *(eval());
+    fprintf( stderr, "Could not allocate memory for output.\n");
+    exit( -1 );
   }
+  return( file );
+} /* openOutput()                                                             */
 
 
-  if( is_blank( delimiter ))
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  openOutputFiles                                                */
+/*                                                                            */
+/*  Synopsis:  Open the listing and object files, and punch the leader.       */
+/*                                                                            */
+/******************************************************************************/
+void openOutputFiles( ASM_T *as )
+{
+  as->objectfile = openOutput( as, as->objectpathname, "wb", &as->objectbuf,
+                               &as->objectbuf_size );
+  as->objectsave = as->objectfile;
+
+  as->listfile = openOutput( as, as->listpathname, "w", &as->listbuf,
+                             &as->listbuf_size );
+  as->listsave = NULL;
+  if( as->listout == NULL )
   {
-    return( &sym_getexpr );
+    as->listout = (char *) malloc( LIST_BUFFER );
+    if( as->listout == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for listing.\n");
+      exit( -1 );
+    }
   }
+  as->listout_count = 0;
 
-  /* Here we assume the current lexeme is the operator separating the         */
-  /* previous operator from the next, if any.                                 */
-  while( TRUE )
+  /* Nothing is loaded yet, whatever a single pass given up had loaded.       */
+  if( as->loaded != NULL )
   {
-    /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
-    {
-      return( &sym_getexpr );
-    }
+    memset( as->loaded, FALSE, PALBART_IMAGE_SIZE );
+  }
+  as->tape_length = 0;
 
-    switch( line[lexstart] )
-    {
-    case '+':                   /* add                                        */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val += (eval())->val;
-      break;
+  punchLeader( as, 0 );
+  as->checksum = 0;
+} /* openOutputFiles()                                                        */
 
-    case '-':                   /* subtract                                   */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val -= (eval())->val;
-      break;
 
-    case '^':                   /* multiply                                   */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val *= (eval())->val;
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  parallelPass                                                   */
+/*                                                                            */
+/*  Synopsis:  Run pass 2 in worker processes, one for each processor, on     */
+/*             chunks of the source that start at pass 1 checkpoints.  Their  */
+/*             output is put together in order once they have all finished.   */
+/*             Returns FALSE, having output nothing, if the source is too     */
+/*             small, or if a chunk did not end in the state the next one     */
+/*             started in, or if anything else could make the output differ   */
+/*             from that of onePass(), which must then be run instead.        */
+/*                                                                            */
+/******************************************************************************/
+BOOL parallelPass( ASM_T *as )
+{
+  CHUNK_T    *chunks;
+  int         count;
+  int         cx;
+  CHUNKEND_T *ends;
+  int         ix;
+  BOOL        ok;
+  int         status;
+  long        workers;
+
+  /* The concordance and the permanent symbols need the pass 2 symbols.       */
+  if( as->xref || as->print_permanent_symbols || as->write_permanent_snapshot )
+  {
+    return( FALSE );
+  }
 
-    case '%':                   /* divide                                     */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val /= (eval())->val;
-      break;
+  /* The workers write their output to temporary files, and are forked,       */
+  /* which a thread of a batch must not do.                                   */
+  if( as->in_memory || as->batch )
+  {
+    return( FALSE );
+  }
 
-    case '&':                   /* and                                        */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val &= (eval())->val;
-      break;
+  /* A compact tape is punched from the image, which the workers do not have. */
+  if( as->compact )
+  {
+    return( FALSE );
+  }
+  workers = sysconf( _SC_NPROCESSORS_ONLN );
+  if( workers > as->srcline_count / CHUNK_LINES )
+  {
+    workers = as->srcline_count / CHUNK_LINES;
+  }
+  if( workers < 2 )
+  {
+    return( FALSE );
+  }
 
-    case '!':                   /* or                                         */
-      nextLexBlank();           /* skip over the operator                     */
-      sym_getexpr.val |= (eval())->val;
-      break;
+  chunks = (CHUNK_T *) malloc( sizeof( CHUNK_T ) * workers );
+  ends = (CHUNKEND_T *) malloc( sizeof( CHUNKEND_T ) * workers );
+  if( chunks == NULL || ends == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for pass 2 workers.\n" );
+    exit( -1 );
+  }
 
-    default:
-      if( isend( line[lexstart] ))
+  /* Split the source at the checkpoints nearest to equal parts of it.        */
+  ok = TRUE;
+  for( count = 0, cx = 0; count < workers && ok; count++ )
+  {
+    chunks[count].from = NULL;
+    chunks[count].end = -1;
+    if( count > 0 )
+    {
+      while( cx < as->checkpoint_count && as->checkpoints[cx].srcline
+                               < (long) as->srcline_count * count / workers )
       {
-        return( &sym_getexpr );
+        cx++;
       }
-
-      switch( line[lexstart] )
+      if( cx >= as->checkpoint_count )
       {
-      case '/':
-      case ';':
-      case ')':
-      case ']':
-      case '<':
-        break;
-
-      case '=':
-        errorMessage( &illegal_equals, lexstart );
-        moveToEndOfLine();
-        sym_getexpr.val = 0;
         break;
+      }
+      chunks[count].from = &as->checkpoints[cx];
+      chunks[count - 1].end = as->checkpoints[cx].srcline;
+      cx++;
+    }
+    chunks[count].pid = -1;
+    chunks[count].list = tmpfile();
+    chunks[count].object = tmpfile();
+    chunks[count].errors = tmpfile();
+    chunks[count].report = tmpfile();
+    ok = chunks[count].list != NULL && chunks[count].object != NULL
+      && chunks[count].errors != NULL && chunks[count].report != NULL;
+  }
+  ok = ok && count > 1;
+
+  /* Nothing buffered may be written twice by the workers.                    */
+  flushTape( as );
+  renderListing( as );
+  flushList( as );
+  fflush( NULL );
+  for( ix = 0; ix < count && ok; ix++ )
+  {
+    chunks[ix].pid = fork();
+    if( chunks[ix].pid == 0 )
+    {
+      runChunk( as, &chunks[ix] );
+    }
+    ok = chunks[ix].pid > 0;
+  }
 
-      default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
-        sym_getexpr.val = 0;
-        break;
+  for( ix = 0; ix < count; ix++ )
+  {
+    if( chunks[ix].pid > 0 )
+    {
+      if( waitpid( chunks[ix].pid, &status, 0 ) != chunks[ix].pid
+          || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+      {
+        ok = FALSE;
       }
-      return( &sym_getexpr );
     }
-  } /* end while                                                              */
-} /* getExpr()                                                                */
+  }
 
+  /* Each chunk must end exactly where the next one was started.              */
+  for( ix = 0; ix < count && ok; ix++ )
+  {
+    rewind( chunks[ix].report );
+    ok = fread( &ends[ix], sizeof( CHUNKEND_T ), 1, chunks[ix].report ) == 1
+      && ends[ix].usable
+      && ( ix + 1 == count
+           || sameCheckpoint( &ends[ix].state, chunks[ix + 1].from ));
+  }
 
-/******************************************************************************/
-/*                                                                            */
-/*  Function:  eval                                                           */
-/*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme, set delimiter and advance.*/
-/*                                                                            */
-/******************************************************************************/
-SYM_T *eval()
-{
-  WORD16  digit;
-  int     from;
-  WORD16  loc;
-  SYM_T  *sym;
-  WORD16  val;
-
-  val = 0;
+  for( ix = 0; ix < count && ok; ix++ )
+  {
+    stitchChunk( as, &chunks[ix], &ends[ix] );
+  }
+  if( ok )
+  {
+    restoreCheckpoint( as, &ends[count - 1].state );
+  }
 
-  delimiter = line[lexterm];
-  if( isalpha( line[lexstart] ))
+  for( ix = 0; ix < count; ix++ )
   {
-    sym = evalSymbol();
-    if( M_UNDEFINED( sym->type ) && pass == 2 )
+    if( chunks[ix].list != NULL )
     {
-      errorSymbol( &undefined_symbol, sym->name, lexstart );
-      nextLexeme();
-      return( sym );
+      fclose( chunks[ix].list );
     }
-    else
+    if( chunks[ix].object != NULL )
     {
-      nextLexeme();
-      return( sym );
+      fclose( chunks[ix].object );
     }
-  }
-  else if( isdigit( line[lexstart] ))
-  {
-    from = lexstart;
-    val = 0;
-    while( from < lexterm )
+    if( chunks[ix].errors != NULL )
     {
-      if( isdigit( line[from] ))
-      {
-        digit = (WORD16) line[from++] - (WORD16) '0';
-        if( digit < radix )
-        {
-          val = val * radix + digit;
-        }
-        else
-        {
-          errorLexeme( &number_not_radix, from - 1 );
-          val = 0;
-          from = lexterm;
-        }
-      }
-      else
-      {
-        errorLexeme( &not_a_number, lexstart );
-        val = 0;
-        from = lexterm;
-      }
+      fclose( chunks[ix].errors );
     }
-    nextLexeme();
-    sym_eval.val = val;
-    return( &sym_eval );
-  }
-  else
-  {
-    switch( line[lexstart] )
+    if( chunks[ix].report != NULL )
     {
-    case '"':                   /* Character literal                          */
-      if( cc + 2 < maxcc )
-      {
-        val = line[lexstart + 1] | 0200;
-        delimiter = line[lexstart + 2];
-        cc = lexstart + 2;
-      }
-      else
-      {
-        errorMessage( &no_literal_value, lexstart );
-      }
-      nextLexeme();
-      break;
-
-    case '.':                   /* Value of Current Location Counter          */
-      val = clc + reloc;
-      nextLexeme();
-      break;
-
-    case '[':                   /* Generate literal on page zero.             */
-      if( !literals_on )
-      {
-        errorMessage( &literal_gen_off, lexstart );
-      }
-      nextLexBlank();           /* Skip bracket                               */
-      val = (getExpr())->val & 07777;
-      if( line[lexstart] == ']' )
-      {
-        nextLexBlank();         /* Skip end bracket                           */
-      }
-      else
-      {
-        /* errorMessage( "parens", lexstart );                                */
-      }
-      sym_eval.val = literals_on ? insertLiteral( &pz, val ) : 0;
-      return( &sym_eval );
-
-    case '(':                   /* Generate literal on current page.          */
-      if( !literals_on )
-      {
-        errorMessage( &literal_gen_off, lexstart );
-      }
-
-      nextLexBlank();           /* Skip paren                                 */
-      val = getExprs() & 07777;
-
-      if( line[lexstart] == ')' )
-      {
-        nextLexBlank();         /* Skip end paren                             */
-      }
-      else
-      {
-        /* errorMessage( "parens", NULL );                                    */
-      }
-
-      loc = literals_on ? insertLiteral( &cp, val ) : 0;
-      sym_eval.val = loc + (( clc + reloc ) & 077600 );
-      return( &sym_eval );
-
-    default:
-      switch( line[lexstart] )
-      {
-      case '=':
-        errorMessage( &illegal_equals, lexstart );
-        moveToEndOfLine();
-        break;
-
-      default:
-        errorMessage( &illegal_character, lexstart );
-        break;
-      }
-      val = 0;                  /* On error, set value to zero.               */
-      nextLexBlank();           /* Go past illegal character.                 */
+      fclose( chunks[ix].report );
     }
   }
-  sym_eval.val = val;
-  return( &sym_eval );
-} /* eval()                                                                   */
+  free( chunks );
+  free( ends );
+  return( ok );
+} /* parallelPass()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  inputDubl                                                      */
+/*  Function:  runChunk                                                       */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a double word.          */
+/*  Synopsis:  Run pass 2 on a chunk, in a worker process, and report how it  */
+/*             ended.  The output goes to the chunk's own files, with the     */
+/*             page breaks left to the parent.  A chunk is not usable if it   */
+/*             changed the symbol table, as the chunks after it were run      */
+/*             without the change.                                            */
 /*                                                                            */
 /******************************************************************************/
-void inputDubl()
+void runChunk( ASM_T *as, CHUNK_T *chunk )
 {
-  WORD32 dublvalue;
-  BOOL   scanning_line;
-
-  scanning_line = TRUE;
-  do
+  CHUNKEND_T end;
+  BOOL       expunged;
+  int        fixed;
+  int        ix;
+  SYM_T     *saved;
+  int        saved_count;
+  SYM_T     *sym;
+
+  saved_count = as->symbol_top;
+  saved = (SYM_T *) malloc( sizeof( SYM_T ) * ( saved_count + 1 ));
+  if( saved == NULL )
   {
-    while( scanning_line )
-    {
-      if( isend( line[lexstart] ))
-      {
-        scanning_line = FALSE;
-      }
-      else
-      {
-        switch( line[lexstart] )
-        {
-        case '/':
-          scanning_line = FALSE;
-          break;
-
-        case ';':
-          nextLexeme();
-          break;
-
-        case '+':
-          delimiter = line[lexterm];
-          nextLexBlank();
-        case '-':
-        default:
-          if( isdigit( line[lexstart] ) || line[lexstart] == '-' )
-          {
-            dublvalue = getDublExprs();
-            punchOutObject( clc, (WORD16)(( dublvalue >> 12 ) & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD16)( dublvalue & 07777 ));
-            incrementClc();
-          }
-          else
-          {
-            return;             /* Non-numeric input, back to assembly.       */
-          }
-          break;
-        } /* end switch                                                       */
-      } /* end if                                                             */
-
-      if( error_in_line )
-      {
-        return;                 /* Error occurred, exit DUBL input mode.      */
-      }
-    } /* end while( scanning_line )                                           */
-    readLine();
-    nextLexeme();
-    scanning_line = TRUE;
+    _exit( 1 );
   }
-  while( TRUE );
-} /* inputDubl()                                                              */
+  for( ix = 0; ix < saved_count; ix++ )
+  {
+    saved[ix] = *symbolAt( as, ix );
+  }
+  fixed = as->number_of_fixed_symbols;
+  expunged = as->permanent_expunged;
+
+  as->errorfile = chunk->errors;
+  as->listfile = chunk->list;
+  as->listsave = NULL;
+  as->objectfile = chunk->object;
+  as->objectsave = as->objectfile;
+  as->worker = TRUE;
+  as->worker_usable = TRUE;
+  as->chunk_from = chunk->from;
+  as->chunk_end = chunk->end;
+  as->chunk_stopped = FALSE;
+  as->checksum = 0;
+  as->checksum_partial = ( chunk->from != NULL );
+  as->page_lineno = PAGE_UNKNOWN;
+  onePass( as );
+  renderListing( as );
+
+  takeCheckpoint( as, &end.state );
+  end.usable = as->worker_usable && ( as->chunk_end < 0 || as->chunk_stopped )
+    && as->symbol_top == saved_count && as->number_of_fixed_symbols == fixed
+    && as->permanent_expunged == expunged;
+  for( ix = 0; ix < saved_count && end.usable; ix++ )
+  {
+    sym = symbolAt( as, ix );
+    end.usable = sym->key == saved[ix].key && sym->val == saved[ix].val
+      && (( sym->type ^ saved[ix].type ) & ~PASS_2_BITS ) == 0;
+  }
+  end.errors = as->errors;
+  end.checksum = as->checksum;
+  end.checksum_partial = as->checksum_partial;
+  end.page_lineno = as->page_lineno;
+  end.pagebreaks = as->pagebreak_count;
+  end.titles = as->title_count;
+
+  flushTape( as );
+  flushList( as );
+  if( fwrite( &end, sizeof( CHUNKEND_T ), 1, chunk->report ) != 1
+      || fwrite( as->titles, TITLELEN + 2, as->title_count, chunk->report )
+         != (size_t) as->title_count
+      || fwrite( as->pagebreaks, sizeof( PAGEBREAK_T ), as->pagebreak_count,
+                 chunk->report ) != (size_t) as->pagebreak_count
+      || fflush( chunk->report ) != 0 || fflush( chunk->list ) != 0
+      || fflush( chunk->object ) != 0 || fflush( chunk->errors ) != 0 )
+  {
+    _exit( 1 );
+  }
+  _exit( 0 );
+} /* runChunk()                                                               */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getDublExprs                                                   */
+/*  Function:  stitchChunk                                                    */
 /*                                                                            */
-/*  Synopsis:  Get a DUBL expression.                                         */
+/*  Synopsis:  Append the output of a chunk to the output files, starting the */
+/*             new pages of the listing at the page breaks it left, and add   */
+/*             its errors and checksum to the totals.                         */
 /*                                                                            */
 /******************************************************************************/
-WORD32 getDublExprs()
+void stitchChunk( ASM_T *as, CHUNK_T *chunk, CHUNKEND_T *end )
 {
-  WORD32 dublvalue;
-
-  dublvalue = getDublExpr();
+  PAGEBREAK_T brk;
+  int         ix;
+  long        pos;
+
+  as->titles = growTable( as->titles, &as->title_room, TITLELEN + 2,
+                          end->titles );
+  if( fread( as->titles, TITLELEN + 2, end->titles, chunk->report )
+      != (size_t) end->titles )
+  {
+    end->pagebreaks = 0;
+  }
 
-  while( TRUE )
+  rewind( chunk->list );
+  for( pos = 0, ix = 0; ix < end->pagebreaks; ix++ )
   {
-    if( isdone( line[lexstart] ))
+    if( fread( &brk, sizeof( PAGEBREAK_T ), 1, chunk->report ) != 1 )
     {
-      return( dublvalue );
+      break;
     }
-    else
+    as->page_lineno = ( brk.lines < 0 )
+                    ? as->page_lineno + brk.lines - PAGE_UNKNOWN
+                    : brk.lines;
+    if( as->page_lineno >= LIST_LINES_PER_PAGE )
     {
-      errorMessage( &illegal_expression, lexstart - 1 );
-      return( 0 );
+      flushList( as );
+      copyOutput( as->listfile, chunk->list, brk.pos - pos );
+      pos = brk.pos;
+      topOfForm( as, &as->titles[brk.title * ( TITLELEN + 2 )], NULL );
     }
-  } /* end while                                                              */
-} /* getDublExprs()                                                           */
+  }
+  flushList( as );
+  copyOutput( as->listfile, chunk->list, -1 );
+  as->page_lineno = ( end->page_lineno < 0 )
+                  ? as->page_lineno + end->page_lineno - PAGE_UNKNOWN
+                  : end->page_lineno;
+
+  rewind( chunk->object );
+  flushTape( as );
+  copyOutput( as->objectfile, chunk->object, -1 );
+  rewind( chunk->errors );
+  copyOutput( as->errorfile, chunk->errors, -1 );
+
+  as->errors += end->errors;
+  as->checksum = ( end->checksum_partial ) ? as->checksum + end->checksum
+                                           : end->checksum;
+} /* stitchChunk()                                                            */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getDublExpr                                                    */
+/*  Function:  copyOutput                                                     */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
-/*             number is always considered to have a decimal radix.           */
+/*  Synopsis:  Copy count characters, or all if count is negative, from one   */
+/*             file to another.                                               */
 /*                                                                            */
 /******************************************************************************/
-WORD32 getDublExpr()
+void copyOutput( FILE *to, FILE *from, long count )
 {
-  WORD32 dublvalue;
-
-  delimiter = line[lexterm];
-  if( line[lexstart] == '-' )
-  {
-    nextLexBlank();
-    dublvalue = evalDubl( 0 );
-    nextLexeme();
-    /* Test for any value greater than 23 bits in length.                     */
-    if( (unsigned long int)dublvalue > 040000000L )
-    {
-      errorMessage( &dubl_overflow, lexstart );
-      dublvalue = 0;
-    }
-    dublvalue = -dublvalue;
-  }
-  else
-  {
-    dublvalue = evalDubl( 0 );
-    nextLexeme();
-    /* Test for any value greater than 23 bits in length.                     */
-    if( (unsigned long int)dublvalue > 037777777L )
-    {
-      errorMessage( &dubl_overflow, lexstart );
-      dublvalue = 0;
-    }
-  }
-
-  if( is_blank( delimiter ))
-  {
-    return( dublvalue );
-  }
+  char    buffer[BUFSIZ];
+  size_t  length;
 
-  /* Here we assume the current lexeme is the operator separating the         */
-  /* previous operator from the next, if any.                                 */
-  while( TRUE )
+  while( count != 0 )
   {
-    /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
-    {
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
-      dublvalue = 0;
-      return( dublvalue );
-    }
-
-    switch( line[lexstart] )
+    length = ( count < 0 || count > BUFSIZ ) ? BUFSIZ : (size_t) count;
+    length = fread( buffer, 1, length, from );
+    if( length == 0 )
     {
-    case '+':                   /* add                                        */
-    case '-':                   /* subtract                                   */
-    case '^':                   /* multiply                                   */
-    case '%':                   /* divide                                     */
-    case '&':                   /* and                                        */
-    case '!':                   /* or                                         */
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
-      dublvalue = 0;
       break;
-
-    default:
-      if( isend( line[lexstart] ))
-      {
-        return( dublvalue );
-      }
-
-      switch( line[lexstart] )
-      {
-      case '/':
-      case ';':
-        break;
-
-      default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
-        dublvalue = 0;
-        break;
-      }
-      return( dublvalue );
     }
-  } /* end while                                                              */
-} /* getDublExpr()                                                            */
+    fwrite( buffer, 1, length, to );
+    count = ( count < 0 ) ? count : count - (long) length;
+  }
+} /* copyOutput()                                                             */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  evalDubl                                                       */
+/*  Function:  takeCheckpoint                                                 */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
-/*             number is always considered to have a decimal radix.           */
+/*  Synopsis:  Save the state of the assembly between two lines.              */
 /*                                                                            */
 /******************************************************************************/
-WORD32 evalDubl( WORD32 initial_value )
+void takeCheckpoint( ASM_T *as, CHECKPOINT_T *cpt )
 {
-  WORD32  digit;
-  int     from;
-  WORD32  dublvalue;
-  WORD32  olddublvalue;
+  cpt->srcline = ( as->pass == 1 ) ? as->srcline_count : as->srcline_next;
+  cpt->lineno = as->lineno;
+  cpt->clc = as->clc;
+  cpt->field = as->field;
+  cpt->fieldlc = as->fieldlc;
+  cpt->reloc = as->reloc;
+  cpt->radix = as->radix;
+  cpt->binary_data_output = as->binary_data_output;
+  cpt->fltg_input = as->fltg_input;
+  cpt->rim_mode = as->rim_mode;
+  cpt->list_off = as->list_off;
+  cpt->punch_off = as->punch_off;
+  cpt->cp = as->cp;
+  cpt->pz = as->pz;
+  strcpy( cpt->list_title, as->list_title );
+} /* takeCheckpoint()                                                         */
 
-  overflow = FALSE;
-  delimiter = line[lexterm];
-  from = lexstart;
-  dublvalue = initial_value;
 
-  while( from < lexterm )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  restoreCheckpoint                                              */
+/*                                                                            */
+/*  Synopsis:  Continue pass 2 from a saved state, with XLIST and NOPUNCH     */
+/*             applied to the listing and object files.                       */
+/*                                                                            */
+/******************************************************************************/
+void restoreCheckpoint( ASM_T *as, CHECKPOINT_T *cpt )
+{
+  as->srcline_next = cpt->srcline;
+  as->lineno = cpt->lineno;
+  as->clc = cpt->clc;
+  as->field = cpt->field;
+  as->fieldlc = cpt->fieldlc;
+  as->reloc = cpt->reloc;
+  as->radix = cpt->radix;
+  as->binary_data_output = cpt->binary_data_output;
+  as->fltg_input = cpt->fltg_input;
+  as->rim_mode = cpt->rim_mode;
+  as->list_off = cpt->list_off;
+  as->punch_off = cpt->punch_off;
+  as->cp = cpt->cp;
+  as->pz = cpt->pz;
+  strcpy( as->list_title, cpt->list_title );
+
+  if( as->list_off )
   {
-    if( isdigit( line[from] ))
-    {
-      olddublvalue = dublvalue;
-      digit = (WORD32)( line[from++] - '0' );
-      dublvalue = dublvalue * 10 + digit;
-      if( dublvalue < olddublvalue )
-      {
-        overflow = TRUE;
-      }
-    }
-    else
-    {
-      errorLexeme( &not_a_number, from );
-      dublvalue = 0;
-      from = lexterm;
-    }
+    as->listsave = as->listfile;
+    as->listfile = NULL;
   }
-  return( dublvalue );
-} /* evalDubl()                                                               */
+  if( as->punch_off )
+  {
+    as->objectfile = NULL;
+  }
+} /* restoreCheckpoint()                                                      */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  inputFltg                                                      */
+/*  Function:  sameCheckpoint                                                 */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a Floating Point const. */
+/*  Synopsis:  Compare two saved states.                                      */
 /*                                                                            */
 /******************************************************************************/
-void inputFltg()
+BOOL sameCheckpoint( CHECKPOINT_T *a, CHECKPOINT_T *b )
 {
-  FLTG_T *fltg;
-  BOOL    scanning_line;
+  return( a->srcline == b->srcline && a->lineno == b->lineno
+    && a->clc == b->clc && a->field == b->field && a->fieldlc == b->fieldlc
+    && a->reloc == b->reloc && a->radix == b->radix
+    && a->binary_data_output == b->binary_data_output
+    && a->fltg_input == b->fltg_input && a->rim_mode == b->rim_mode
+    && a->list_off == b->list_off && a->punch_off == b->punch_off
+    && samePool( &a->cp, &b->cp ) && samePool( &a->pz, &b->pz )
+    && strcmp( a->list_title, b->list_title ) == 0 );
+} /* sameCheckpoint()                                                         */
 
-  fltg_input = TRUE;            /* Set lexeme scanner for floating point.     */
-  scanning_line = TRUE;
-  while( TRUE )
-  {
-    while( scanning_line )
-    {
-      if( isend( line[lexstart] ))
-      {
-        scanning_line = FALSE;
-      }
-      else
-      {
-        switch( line[lexstart] )
-        {
-        case '/':
-          scanning_line = FALSE;
-          break;
 
-        case ';':
-          nextLexeme();
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  samePool                                                       */
+/*                                                                            */
+/*  Synopsis:  Compare the literals in two literal pools.                     */
+/*                                                                            */
+/******************************************************************************/
+BOOL samePool( LPOOL_T *a, LPOOL_T *b )
+{
+  return( a->error == b->error && a->loc == b->loc
+    && a->loc >= 0 && a->loc <= PAGE_SIZE
+    && memcmp( &a->pool[a->loc], &b->pool[b->loc],
+               sizeof( WORD16 ) * ( PAGE_SIZE - a->loc )) == 0 );
+} /* samePool()                                                               */
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getArgs                                                        */
+/*                                                                            */
+/*  Synopsis:  Parse command line, set flags accordingly and setup input and  */
+/*             output files.                                                  */
+/*                                                                            */
+/******************************************************************************/
+void getArgs( ASM_T *as, int argc, char *argv[] )
+{
+  char *failure;
+  int  ix, jx;
+  BOOL snapshot_next;
+  BOOL threads_next;
+
+  /* Set the defaults                                                         */
+  snapshot_next = FALSE;
+  threads_next = FALSE;
+  as->errorfile = NULL;
+  as->srcbase = NULL;
+  as->listfile = NULL;
+  as->listsave = NULL;
+  as->objectfile = NULL;
+  as->objectsave = NULL;
+  as->progname = argv[0];
+
+  for( ix = 1; ix < argc; ix++ )
+  {
+    if( argv[ix][0] == '-' )
+    {
+      for( jx = 1; argv[ix][jx] != 0; jx++ )
+      {
+        switch( argv[ix][jx] )
+        {
+        case '1':
+          as->one_pass = TRUE;
           break;
 
-        case '+':
-          delimiter = line[lexterm];
-          nextLexBlank();
-        case '-':
-        default:
-          if( isdigit( line[lexstart] ) || line[lexstart] == '-' )
-          {
-            fltg = getFltgExprs();
-            punchOutObject( clc, ( fltg->exponent & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD16)(( fltg->mantissa >> 12 ) & 07777 ));
-            incrementClc();
-            punchOutObject( clc, (WORD16)( fltg->mantissa & 07777 ));
-            incrementClc();
-          }
-          else
-          {
-            fltg_input = FALSE; /* Reset lexeme scanner.                      */
-            return;             /* Non-numeric input, back to assembly.       */
-          }
+        case 'c':
+          as->compact = TRUE;
+          break;
+
+        case 'd':
+          as->symtab_print = TRUE;
+          break;
+
+        case 'e':
+          as->list_errors_only = TRUE;
+          break;
+
+        case 'j':
+          threads_next = TRUE;
+          break;
+
+        case 'r':
+          as->rim_mode = TRUE;
+          break;
+
+        case 'l':
+          as->literals_on = TRUE;
+          break;
+
+        case 'p':
+          as->print_permanent_symbols = TRUE;
+          break;
+
+        case 's':
+          as->write_permanent_snapshot = TRUE;
+          break;
+
+        case 'u':
+          snapshot_next = TRUE;
+          break;
+
+        case 'x':
+          as->xref = TRUE;
+          break;
+
+        case 'z':
+          as->zblock_words = TRUE;
+          break;
+
+        case 'v':
+          fprintf( stderr, "%s\n", release );
+          fflush( stderr );
+          exit( -1 );
           break;
+
+        default:
+          fprintf( stderr, "%s: unknown flag: %s\n", argv[0], argv[ix] );
+        case 'h':
+          fprintf( stderr, " -1 -- assemble in a single pass if possible\n" );
+          fprintf( stderr, " -c -- punch a compact bin tape from the image\n" );
+          fprintf( stderr, " -d -- dump symbol table\n" );
+          fprintf( stderr, " -e -- keep the listing only on errors\n" );
+          fprintf( stderr, " -h -- show this help\n" );
+          fprintf( stderr, " -j -- assemble files separately on n threads\n" );
+          fprintf( stderr, " -l -- generate literals\n" );
+          fprintf( stderr, " -r -- output rim format file\n" );
+          fprintf( stderr, " -p -- output permanent symbols to file\n" );
+          fprintf( stderr, " -s -- output permanent symbol snapshot\n" );
+          fprintf( stderr, " -u -- use permanent symbol snapshot file\n" );
+          fprintf( stderr, " -v -- display version\n" );
+          fprintf( stderr, " -x -- output cross reference to file\n" );
+          fprintf( stderr, " -z -- list every word of a ZBLOCK\n" );
+          fprintf( stderr, " @f -- read input files from f, one per line\n" );
+          fflush( stderr );
+          exit( -1 );
         } /* end switch                                                       */
-      } /* end if                                                             */
+      } /* end for                                                            */
 
-      if( error_in_line )
+      /* The snapshot file given to -u is the next argument.                  */
+      if( snapshot_next )
       {
-        fltg_input = FALSE;     /* Reset lexeme scanner.                      */
-        return;                 /* Error occurred, exit FLTG input mode.      */
+        if( ++ix >= argc )
+        {
+          fprintf( stderr, "%s: no snapshot file specified\n", argv[0] );
+          exit( -1 );
+        }
+        as->snapshotpath = argv[ix];
+        snapshot_next = FALSE;
       }
-    } /* end while( scanning_line )                                           */
-    readLine();
-    nextLexeme();
-    scanning_line = TRUE;
+
+      /* So is the number of threads given to -j, 0 for one per processor.    */
+      if( threads_next )
+      {
+        if( ++ix >= argc || !isdigit( argv[ix][0] ))
+        {
+          fprintf( stderr, "%s: no number of threads specified\n", argv[0] );
+          exit( -1 );
+        }
+        as->threads = atoi( argv[ix] );
+        if( as->threads < 1 )
+        {
+          as->threads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+          as->threads = ( as->threads < 1 ) ? 1 : as->threads;
+        }
+        threads_next = FALSE;
+      }
+    }
+    else if( argv[ix][0] == '@' )
+    {
+      if( !readManifest( as, &argv[ix][1] ))
+      {
+        fprintf( stderr, "%s: cannot open \"%s\"\n", argv[0], &argv[ix][1] );
+        exit( -1 );
+      }
+    }
+    else
+    {
+      addSource( as, argv[ix] );
+    }
+  } /* end for                                                                */
+
+  if( as->source_count == 0 )
+  {
+    fprintf( stderr, "%s:  no input file specified\n", argv[0] );
+    exit( -1 );
   }
-} /* inputFltg()                                                              */
+
+  /* Without -j, the one input file is assembled by assemble().               */
+  if( as->threads == 0 )
+  {
+    if( as->source_count > 1 )
+    {
+      fprintf( stderr, "%s: too many input files\n", argv[0] );
+      exit( -1 );
+    }
+    if(( failure = openSource( as, as->sources[0] )) != NULL )
+    {
+      fprintf( stderr, failure, argv[0], as->sources[0] );
+      exit( -1 );
+    }
+  }
+} /* getArgs()                                                                */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getFltgExprs                                                   */
+/*  Function:  addSource                                                      */
 /*                                                                            */
-/*  Synopsis:  Get a FLTG expression.                                         */
+/*  Synopsis:  Add an input file to those named on the command line.          */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *getFltgExprs()
+void addSource( ASM_T *as, char *path )
 {
-  FLTG_T *fltg;
+  as->sources = (char **) growTable( as->sources, &as->source_room,
+                                     sizeof( char * ), as->source_count + 1 );
+  as->sources[as->source_count++] = path;
+} /* addSource()                                                              */
 
-  fltg = getFltgExpr();
 
-  while( TRUE )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  readManifest                                                   */
+/*                                                                            */
+/*  Synopsis:  Add the input files named in a file, one per line, to those    */
+/*             named on the command line.  Blanks around the names and blank  */
+/*             lines are ignored.  Returns FALSE if the file cannot be read.  */
+/*                                                                            */
+/******************************************************************************/
+BOOL readManifest( ASM_T *as, char *path )
+{
+  char   *end;
+  long    last;
+  BOOL    mapped;
+  char   *name;
+  long    next;
+  long    pos;
+  long    size;
+  char   *text;
+
+  if(( text = mapSource( path, &size, &mapped )) == NULL )
+  {
+    return( FALSE );
+  }
+  for( pos = 0; pos < size; pos = next )
   {
-    if( isdone( line[lexstart] ))
+    end = (char *) memchr( &text[pos], '\n', size - pos );
+    last = ( end != NULL ) ? end - text : size;
+    next = last + 1;
+    while( pos < last && isspace( text[pos] ))
     {
-      return( fltg );
+      pos++;                        /* Drop leading blanks,                   */
     }
-    else
+    while( last > pos && isspace( text[last - 1] ))
     {
-      errorMessage( &illegal_expression, lexstart - 1 );
-      return( 0 );
+      last--;                       /* and a carriage return, and blanks.     */
     }
-  } /* end while                                                              */
-} /* getFltgExprs()                                                           */
+    if( last > pos )
+    {
+      name = arenaAlloc( as, last - pos + 1 );
+      memcpy( name, &text[pos], last - pos );
+      name[last - pos] = '\0';
+      addSource( as, name );
+    }
+  }
+
+  if( mapped )
+  {
+    munmap( text, size );
+  }
+  else if( size > 0 )
+  {
+    free( text );
+  }
+  return( TRUE );
+} /* readManifest()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  getFltgExpr                                                    */
+/*  Function:  openSource                                                     */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
-/*             number is always considered to have a decimal radix.           */
+/*  Synopsis:  Map the input file, which both passes read, and make the       */
+/*             pathnames of the output files from its pathname.  Returns      */
+/*             NULL, or if it fails a message to print with the program name  */
+/*             and the pathname.                                              */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *getFltgExpr()
+char *openSource( ASM_T *as, char *path )
 {
-  FLTG_T *fltg;
+  int  len;
+  int  jx;
 
-  delimiter = line[lexterm];
-  fltg = evalFltg();
-  /* Test for any value greater than 23 bits in length.                     */
-  if( (unsigned long int)fltg->mantissa> 077777777L )
+  as->pathname = path;
+  len = strlen( as->pathname );
+  if( len > NAMELEN - 5 )
   {
-    errorMessage( &fltg_overflow, lexstart );
+    return( "%s: pathname \"%s\" too long\n" );
   }
 
-  if( is_blank( delimiter ))
+  /* Now map the input file, which both passes read.                          */
+  as->srcbase = mapSource( as->pathname, &as->srcsize, &as->srcmapped );
+  if( as->srcbase == NULL )
   {
-    return( fltg );
+    return( "%s: cannot open \"%s\"\n" );
   }
 
-  /* Here we assume the current lexeme is the operator separating the         */
-  /* previous operator from the next, if any.                                 */
-  while( TRUE )
+  /* Now make the pathnames                                                   */
+  /* Find last '.', if it exists.                                             */
+  jx = len - 1;
+  while( jx >= 0 && as->pathname[jx] != '.'  && as->pathname[jx] != '/'
+      && as->pathname[jx] != '\\' )
   {
-    /* assert line[lexstart] == delimiter                                     */
-    if( is_blank( delimiter ))
-    {
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
-      fltg = 0;
-      return( fltg );
-    }
+    jx--;
+  }
 
-    switch( line[lexstart] )
-    {
-    case '+':                   /* add                                        */
-    case '-':                   /* subtract                                   */
-    case '^':                   /* multiply                                   */
-    case '%':                   /* divide                                     */
-    case '&':                   /* and                                        */
-    case '!':                   /* or                                         */
-      errorMessage( &illegal_expression, lexstart );
-      moveToEndOfLine();
-      fltg = NULL;
-      break;
+  /* A name with neither has no extension to replace, as after a '/'.         */
+  switch(( jx >= 0 ) ? as->pathname[jx] : '/' )
+  {
+  case '.':
+    break;
 
-    default:
-      if( isend( line[lexstart] ))
-      {
-        return( fltg );
-      }
+  case '/':
+  case '\\':
+    jx = len;
+    break;
 
-      switch( line[lexstart] )
-      {
-      case '/':
-      case ';':
-        break;
+  default:
+    break;
+  }
 
-      default:
-        errorMessage( &illegal_expression, lexstart );
-        moveToEndOfLine();
-        fltg = NULL;
-        break;
-      }
-      return( fltg );
-    }
-  } /* end while                                                              */
-} /* getFltgExpr()                                                            */
+  /* Add the pathname extensions.                                             */
+  strncpy( as->objectpathname, as->pathname, jx );
+  as->objectpathname[jx] = '\0';
+  strcat( as->objectpathname, as->rim_mode ? ".rim" : ".bin" );
+
+  strncpy( as->listpathname, as->pathname, jx );
+  as->listpathname[jx] = '\0';
+  strcat( as->listpathname, ".lst" );
+
+  strncpy( as->errorpathname, as->pathname, jx );
+  as->errorpathname[jx] = '\0';
+  strcat( as->errorpathname, ".err" );
+
+  strncpy( as->permpathname, as->pathname, jx );
+  as->permpathname[jx] = '\0';
+  strcat( as->permpathname, ".prm" );
+
+  strncpy( as->snappathname, as->pathname, jx );
+  as->snappathname[jx] = '\0';
+  strcat( as->snappathname, ".pst" );
+
+  /* Extract the filename from the path.                                      */
+  if( isalpha( as->pathname[0] ) && as->pathname[1] == ':'
+      && as->pathname[2] != '\\' )
+  {
+    as->pathname[1] = '\\';         /* MS-DOS style pathname                  */
+  }
+
+  jx = len - 1;
+  while( jx >= 0 && as->pathname[jx] != '/' && as->pathname[jx] != '\\' )
+  {
+    jx--;
+  }
+  strcpy( as->filename, &as->pathname[jx + 1] );
+  return( NULL );
+} /* openSource()                                                             */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  evalFltg                                                       */
+/*  Function:  onePass                                                        */
 /*                                                                            */
-/*  Synopsis:  Get the value of the current lexeme as a floating point value. */
-/*             Floating point input is alwasy considered decimal.             */
-/*             The general format of a floating point number is:              */
-/*                +-ddd.dddE+-dd  where each d is a decimal digit.            */
+/*  Synopsis:  Do one assembly pass.                                          */
 /*                                                                            */
 /******************************************************************************/
-FLTG_T *evalFltg()
+void onePass( ASM_T *as )
 {
-  int      current_state;
-  int      current_col;
-  WORD16   exponent;
-  FLTG_T  *fltg;
-  WORD32   input_value;
-  BOOL     negate;
-  BOOL     negate_exponent;
-  int      next_state;
-  int      right_digits;
+  char    name[SYMLEN];
+  WORD16  newclc;
+  BOOL    scanning_line;
+  int     start;
+  SYM_T  *sym;
+  int     term;
+  WORD16  val;
 
-  /* This uses a lexical analyzer to parse the floating point format.         */
-  static BYTE state_table[][10] =
+  as->clc = 0200;                   /* Default starting address is 200 octal. */
+  as->field = 0;
+  as->fieldlc = 0;
+  as->reloc = 0;
+  as->cp.loc = 00200;               /* Points to end of page for [] operands. */
+  as->pz.loc = 00200;               /* Points to end of page for () operands. */
+  as->cp.error = FALSE;
+  as->pz.error = FALSE;
+  as->listed = TRUE;
+  as->lineno = 0;
+  as->list_pageno = 0;
+  as->list_lineno = 0;
+  as->last_xref_lexstart = 0;
+  as->last_xref_lineno = 0;
+  as->list_off = FALSE;
+  as->punch_off = FALSE;
+  as->radix = 8;                    /* Initial radix is octal (base 8).       */
+  as->srcline_next = 0;             /* Replay from the first cached line.     */
+  as->lexeme_line = -1;
+  if( as->pass == 2 && as->chunk_from != NULL )
   {
-    /*  0   1   2   3   4   5   6  Oolumn index                               */
-    /*  +   -   d   .   E  sp   p      State  Comment                         */
-     {  2,  1,  3,  4, 10, 10, 10  },  /*  0  Initial state.                  */
-     { 11, 11,  3,  4, 11, 11, 11  },  /*  1  -                               */
-     { 11, 11,  3,  4, 11, 11, 11  },  /*  2  +                               */
-     { 10, 10, 10,  4,  6, 10, 10  },  /*  3  # (+-ddd)                       */
-     { 11, 11,  5, 11, 11, 10, 10  },  /*  4  . (+-ddd.)                      */
-     { 11, 11, 11, 11,  6, 10, 11  },  /*  5  # (+-ddd.ddd)                   */
-     {  8,  7,  9, 11, 11, 11, 11  },  /*  6  E (+-ddd.dddE)                  */
-     { 11, 11,  9, 11, 11, 11, 11  },  /*  7  - (+-ddd.dddE-                  */
-     { 11, 11,  9, 11, 11, 11, 11  },  /*  8  + (+-ddd.dddE+                  */
-     { 11, 11, 11, 11, 11, 10, 11  }   /*  9  # (+-ddd.dddE+-dd               */
-                                       /* 10  Completion state                */
-                                       /* 11  Error state.                    */
-  };
+    restoreCheckpoint( as, as->chunk_from );
+  }
+
+  while( TRUE )
+  {
+    if( as->pass == 1 && as->srcline_count
+                         >= ( as->checkpoint_count + 1 ) * CHECKPOINT_LINES )
+    {
+      as->checkpoints = growTable( as->checkpoints, &as->checkpoint_room,
+                                   sizeof( CHECKPOINT_T ),
+                                   as->checkpoint_count + 1 );
+      takeCheckpoint( as, &as->checkpoints[as->checkpoint_count] );
+      as->checkpoint_count++;
+    }
+    else if( as->pass == 2 && as->chunk_end >= 0
+             && as->srcline_next >= as->chunk_end )
+    {
+      listLine( as );              /* A worker stops at the end of its chunk. */
+      as->chunk_stopped = TRUE;
+      return;
+    }
+    readLine( as );
+    nextLexeme( as );
+
+    scanning_line = TRUE;
+    while( scanning_line )
+    {
+      if( isend( as->line[as->lexstart] ))
+      {
+        scanning_line = FALSE;
+      }
+      else
+      {
+        switch( as->line[as->lexstart] )
+        {
+        case '/':
+          scanning_line = FALSE;
+          break;
+
+        case ';':
+          nextLexeme( as );
+          break;
+
+        case '$':
+          endOfBinary( as );
+          return;
+
+        case '*':
+          nextLexeme( as );             /* Skip '*', (set origin symbol)      */
+          newclc = ((getExpr( as ))->val & 07777 ) | as->field;
+          /* Do not change Current Location Counter if an error occurred.     */
+          if( !as->error_in_line )
+          {
+            if(( newclc & 07600 ) != ( as->clc & 07600 ))
+            {
+              /* Current page has changed.                                    */
+              punchLiteralPool( as, &as->cp, as->clc - 1 );
+            }
+            as->clc = newclc - as->reloc;
+            as->fieldlc = as->clc & 07777;
+
+            if( !as->rim_mode )
+            {
+              /* Not rim mode, put out origin.                                */
+              punchOrigin( as, as->clc );
+            }
+            printLine( as, as->line, 0, as->fieldlc, LINE_VAL );
+          }
+          break;
+
+        default:
+          switch( as->line[as->lexterm] )
+          {
+          case ',':
+            if( isalpha( as->line[as->lexstart] ))
+            {
+              /* Use lookup so symbol will not be counted as reference.       */
+              sym = lookup( as, lexemeToKey( as, as->lexstart, as->lexterm ));
+              if( M_DEFINED( sym->type ))
+              {
+                if( sym->val != as->clc && as->pass == 2 )
+                {
+                  errorSymbol( as, &duplicate_label,
+                               keyToName( name, sym->key ), as->lexstart );
+                }
+                if( !M_FIXED( sym->type ))
+                {
+                  sym->type = sym->type | DUPLICATE; /* Not a shared one.     */
+                }
+              }
+              if( M_DEFINED( sym->type ) || as->reloc != 0 )
+              {
+                /* Pass 2 checks labels against their value at the end of    */
+                /* pass 1.                                                    */
+                failOnePass( as );
+              }
+              /* Must call define on pass 2 to generate concordance.          */
+              defineLexeme( as, as->lexstart, as->lexterm,
+                            ( as->clc + as->reloc ), LABEL );
+            }
+            else
+            {
+              errorLexeme( as, &label_syntax, as->lexstart );
+            }
+            nextLexeme( as );           /* skip label                         */
+            nextLexeme( as );           /* skip comma                         */
+            break;
+
+          case '=':
+            if( isalpha( as->line[as->lexstart] ))
+            {
+              start = as->lexstart;
+              term = as->lexterm;
+              as->delimiter = as->line[as->lexterm];
+              nextLexBlank( as );       /* skip symbol                        */
+              nextLexBlank( as );       /* skip trailing =                    */
+              val = getCodedExprs( as );
+              if( as->fixup_field >= 0 )
+              {
+                failOnePass( as );   /* Later uses would see the wrong value. */
+              }
+              defineLexeme( as, start, term, val, DEFINED );
+              printLine( as, as->line, 0, val, LINE_VAL );
+            }
+            else
+            {
+              errorLexeme( as, &symbol_syntax, as->lexstartprev );
+              nextLexeme( as );         /* skip symbol                        */
+              nextLexeme( as );         /* skip trailing =                    */
+              getExprs( as );           /* skip expression                    */
+            }
+            break;
+
+          default:
+            if( isalpha( as->line[as->lexstart] ))
+            {
+              sym = evalSymbol( as );
+              val = sym->val;
+              if( M_PSEUDO( sym->type ))
+              {
+                nextLexeme( as );         /* Skip symbol                      */
+                scanning_line = pseudoOperators( as, (PSEUDO_T)val & 07777 );
+              }
+              else
+              {
+                /* Identifier is not a pseudo-op, interpret as load value     */
+                punchOutObject( as, as->clc, getCodedExprs( as ) & 07777 );
+                incrementClc( as );
+              }
+            }
+            else
+            {
+              /* Identifier is a value, interpret as load value               */
+              punchOutObject( as, as->clc, getCodedExprs( as ) & 07777 );
+              incrementClc( as );
+            }
+            break;
+          } /* end switch                                                     */
+          break;
+        } /* end switch                                                       */
+      } /* end if                                                             */
+    } /* end while( scanning_line )                                           */
+  } /* end while( TRUE )                                                      */
+} /* onePass()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getCodedExprs                                                  */
+/*                                                                            */
+/*  Synopsis:  Get an operand field like getExprs().  In pass 1 the field is  */
+/*             also compiled, as it is parsed, into code kept with the line,  */
+/*             and pass 2 runs that code instead of parsing the field again.  */
+/*             Fields with errors in pass 1 are parsed again in pass 2, which */
+/*             reports them.                                                  */
+/*                                                                            */
+/******************************************************************************/
+WORD16 getCodedExprs( ASM_T *as )
+{
+  CODED_T *ex;
+  WORD16  value;
+
+  if( as->pass == 2 && ( ex = findCodedExprs( as )) != NULL )
+  {
+    value = runCodedExprs( as, ex );
+
+    /* Leave the lexer after the field, as getExprs() would.                  */
+    as->lexeme_next = as->srclines[as->lexeme_line].lexeme + ex->lexeme;
+    as->lexstart = ex->lexstart;
+    as->lexterm = ex->lexterm;
+    as->lexstartprev = ex->lexstartprev;
+    as->lextermprev = ex->lextermprev;
+    as->cc = ex->cc;
+    as->delimiter = ex->delimiter;
+    return( value );
+  }
+  if( as->pass != 1 || as->lexeme_line < 0 || as->error_in_line )
+  {
+    return( getExprs( as ));
+  }
+
+  as->coded = (CODED_T *) growTable( as->coded, &as->coded_room,
+                                     sizeof( CODED_T ), as->coded_count + 1 );
+  ex = &as->coded[as->coded_count];
+  ex->from = as->lexstart;
+  ex->code = as->excode_count;
+  ex->radix = as->radix;
+  as->coding = TRUE;
+  as->coding_depth = 0;
+  as->coding_max = 0;
+  as->coding_literals = FALSE;
+  as->coding_forward = FALSE;
+  value = getExprs( as );
+  codeExpr( as, EX_END, 0, NULL );
+  if( !as->coding || as->error_in_line )
+  {
+    if( as->coding_forward )
+    {
+      failOnePass( as );
+    }
+    as->coding = FALSE;
+    as->excode_count = ex->code;    /* Forget the code.                       */
+    return( value );
+  }
+  as->coding = FALSE;
+
+  ex->depth = as->coding_max;
+  ex->literals = as->coding_literals;
+  ex->lexeme = as->lexeme_count - as->srclines[as->lexeme_line].lexeme;
+  ex->lexstart = as->lexstart;
+  ex->lexterm = as->lexterm;
+  ex->lexstartprev = as->lexstartprev;
+  ex->lextermprev = as->lextermprev;
+  ex->cc = as->cc;
+  ex->delimiter = as->delimiter;
+  as->srclines[as->lexeme_line].exprs++;
+
+  /* A single pass assembly fixes up values with forward references, but not */
+  /* literals, which may have been merged with others.                        */
+  if( as->coding_forward && ex->literals )
+  {
+    failOnePass( as );
+  }
+  else if( as->coding_forward )
+  {
+    as->fixup_field = as->coded_count;
+  }
+  as->coded_count++;
+  return( value );
+} /* getCodedExprs()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  codeExpr                                                       */
+/*                                                                            */
+/*  Synopsis:  Add an operation to the code of the operand field being        */
+/*             compiled by getCodedExprs(), if any.                           */
+/*                                                                            */
+/******************************************************************************/
+void codeExpr( ASM_T *as, EXOP_T op, WORD16 val, SYM_T *sym )
+{
+  EXCODE_T *code;
+
+  if( !as->coding )
+  {
+    return;
+  }
+  as->excode = (EXCODE_T *) growTable( as->excode, &as->excode_room,
+                                       sizeof( EXCODE_T ),
+                                       as->excode_count + 1 );
+  code = &as->excode[as->excode_count++];
+  code->op = op;
+  code->val = val;
+  code->sym = sym;
+
+  switch( op )
+  {
+  case EX_SYM:
+  case EX_CONST:
+  case EX_DOT:
+    as->coding_depth++;             /* Pushes a value.                        */
+    as->coding_max = ( as->coding_depth > as->coding_max ) ? as->coding_depth
+                                                             : as->coding_max;
+    break;
+
+  case EX_PZLIT:
+  case EX_CPLIT:
+    as->coding_literals = TRUE;
+    break;
+
+  case EX_END:
+  case EX_NEG:
+    break;
+
+  default:
+    as->coding_depth--;             /* Combines two values.                   */
+    break;
+  }
+} /* codeExpr()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  findCodedExprs                                                 */
+/*                                                                            */
+/*  Synopsis:  Find the code compiled in pass 1 for the operand field at      */
+/*             lexstart of the current line.  Returns NULL if there is none,  */
+/*             or if it may not give what parsing the field would.            */
+/*                                                                            */
+/******************************************************************************/
+CODED_T *findCodedExprs( ASM_T *as )
+{
+  CODED_T   *ex;
+  SRCLINE_T *src;
+
+  if( as->lexeme_line < 0 )
+  {
+    return( NULL );
+  }
+  src = &as->srclines[as->lexeme_line];
+  while( as->coded_next < src->expr + src->exprs &&
+         as->coded[as->coded_next].from < as->lexstart )
+  {
+    as->coded_next++;
+  }
+  if( as->coded_next >= src->expr + src->exprs )
+  {
+    return( NULL );
+  }
+  ex = &as->coded[as->coded_next];
+  if( ex->from != as->lexstart || as->coded_next < as->coded_valid ||
+      ex->radix != as->radix || ( ex->literals && !as->literals_on ))
+  {
+    return( NULL );
+  }
+  as->coded_next++;
+  return( ex );
+} /* findCodedExprs()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  runCodedExprs                                                  */
+/*                                                                            */
+/*  Synopsis:  Run the code compiled for an operand field against the values  */
+/*             the symbols have now.  Returns the value of the field.         */
+/*                                                                            */
+/******************************************************************************/
+WORD16 runCodedExprs( ASM_T *as, CODED_T *ex )
+{
+  EXCODE_T *code;
+  char      name[SYMLEN];
+  SYM_T    *sp;
+
+  as->exstack = (SYM_T *) growTable( as->exstack, &as->exstack_room,
+                                     sizeof( SYM_T ), ex->depth );
+  sp = as->exstack - 1;
+  for( code = &as->excode[ex->code]; code->op != EX_END; code++ )
+  {
+    switch( code->op )
+    {
+    case EX_SYM:                /* Value of a symbol.                         */
+      xrefSymbol( as, code->sym, code->val );
+      if( M_UNDEFINED( code->sym->type ))
+      {
+        errorSymbol( as, &undefined_symbol, keyToName( name, code->sym->key ),
+                                                                  code->val );
+      }
+      *++sp = *code->sym;
+      break;
+
+    case EX_CONST:              /* Number or quoted letter.                   */
+      as->sym_eval.val = code->val;
+      *++sp = as->sym_eval;
+      break;
+
+    case EX_DOT:                /* Value of Current Location Counter          */
+      as->sym_eval.val = as->clc + as->reloc;
+      *++sp = as->sym_eval;
+      break;
+
+    case EX_NEG:
+      sp->val = ( - sp->val );
+      break;
+
+    case EX_ADD:
+      sp--;
+      sp->val += sp[1].val;
+      break;
+
+    case EX_SUB:
+      sp--;
+      sp->val -= sp[1].val;
+      break;
+
+    case EX_MUL:
+      sp--;
+      sp->val *= sp[1].val;
+      break;
+
+    case EX_DIV:
+      sp--;
+      sp->val /= sp[1].val;
+      break;
+
+    case EX_AND:
+      sp--;
+      sp->val &= sp[1].val;
+      break;
+
+    case EX_OR:
+      sp--;
+      sp->val |= sp[1].val;
+      break;
+
+    case EX_PZLIT:              /* Literal on page zero.                      */
+      as->sym_eval.val = insertLiteral( as, &as->pz, sp->val & 07777 );
+      *sp = as->sym_eval;
+      break;
+
+    case EX_CPLIT:              /* Literal on the current page.               */
+      as->sym_eval.val = insertLiteral( as, &as->cp, sp->val & 07777 )
+                         + (( as->clc + as->reloc ) & 077600 );
+      *sp = as->sym_eval;
+      break;
+
+    case EX_TERM:               /* Next expression of the field.              */
+      sp--;
+      sp->val = orOperand( as, sp->val, sp->type, &sp[1], code->val );
+      break;
+
+    case EX_END:
+      break;
+    }
+  }
+  return( sp->val );
+} /* runCodedExprs()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getExprs                                                       */
+/*                                                                            */
+/*  Synopsis:  Or together a list of blank separated expressions, from the    */
+/*             current lexeme onward.  Leave the current lexeme as            */
+/*             the last one in the list.                                      */
+/*                                                                            */
+/******************************************************************************/
+WORD16 getExprs( ASM_T *as )
+{
+  SYM_T  *symv;
+  SYM_T  *symt;
+  WORD16  value;
+  SYMTYP  value_type;
+
+  symv = getExpr( as );
+  value = symv->val;
+  value_type = symv->type;
+
+  while( TRUE )
+  {
+    if( isdone( as->line[as->lexstart] ))
+    {
+      return( value );
+    }
+    switch( as->line[as->lexstart] )
+    {
+    case ')':
+    case ']':
+      return( value );
+
+    default:
+      break;
+    }
+
+    /* Interpret space as logical or                                          */
+    symt = getExpr( as );
+    value = orOperand( as, value, value_type, symt, as->lexstartprev );
+    codeExpr( as, EX_TERM, as->lexstartprev, NULL );
+  } /* end while                                                              */
+} /* getExprs()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  orOperand                                                      */
+/*                                                                            */
+/*  Synopsis:  Or the next expression of an operand field, symt, into value,  */
+/*             the field so far, whose first expression has type value_type.  */
+/*             An address after a memory reference instruction is made a      */
+/*             page zero, current page or literal reference.  Diagnostics     */
+/*             are given at column col.  Returns the new value.               */
+/*                                                                            */
+/******************************************************************************/
+WORD16 orOperand( ASM_T *as, WORD16 value, SYMTYP value_type, SYM_T *symt,
+                  int col )
+{
+  char    name[SYMLEN];
+  WORD16  temp;
+  SYMTYP  temp_type;
+
+  temp = symt->val & 07777;
+  temp_type = symt->type;
+
+  switch( value_type )
+  {
+  case MRI:
+  case MRIFIX:
+    /* Previous symbol was a Memory Reference Instruction.                  */
+    switch( temp_type )
+    {
+    case MRI:
+    case MRIFIX:
+      /* Current symbol is also a Memory Reference Instruction.             */
+      value |= temp;          /* Just OR the MRI instructions.              */
+      break;
+
+    default:
+      /* Now have the address part of the MRI instruction.                  */
+      if( temp < 00200 )
+      {
+        value |= temp;        /* Page zero MRI.                             */
+      }
+      else if( (( as->fieldlc + as->reloc ) & 07600 ) <= temp
+           && temp <= (( as->fieldlc + as->reloc ) | 0177 ))
+      {
+        value |= ( PAGE_BIT | (temp & ADDRESS_FIELD )); /* Current page MRI */
+      }
+      else
+      {
+        if(( value & INDIRECT_BIT ) == INDIRECT_BIT )
+        {
+          /* Already indirect, can't generate                               */
+          errorSymbol( as, &illegal_indirect, keyToName( name, symt->key ),
+                                                                  col );
+        }
+        else
+        {
+          if( as->literals_on )
+          {
+            /* Now fix off page reference.                                  */
+            /* Search current page literal pool for needed value.           */
+            /* Set Indirect Current Page                                    */
+            value |= ( 00600 | insertLiteral( as, &as->cp, temp ));
+            as->indirect_generated = TRUE;
+          }
+          else
+          {
+            errorSymbol( as, &illegal_reference, keyToName( name, symt->key ),
+                                                                  col );
+            value |= ( temp & 0177 );
+          }
+        }
+      }
+      break;
+    }
+    break;
+
+  default:
+      value |= temp;          /* Normal 12 bit value.                       */
+      break;
+  }
+  return( value );
+} /* orOperand()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getExpr                                                        */
+/*                                                                            */
+/*  Synopsis:  Get an expression, from the current lexeme onward, leave the   */
+/*             current lexeme as the one after the expression.  Expressions   */
+/*             contain terminal symbols (identifiers) separated by operators. */
+/*                                                                            */
+/******************************************************************************/
+SYM_T *getExpr( ASM_T *as )
+{
+  as->delimiter = as->line[as->lexterm];
+
+  if( as->line[as->lexstart] == '-' )
+  {
+    nextLexBlank( as );
+    as->sym_getexpr = *(eval( as ));
+    as->sym_getexpr.val = ( - as->sym_getexpr.val );
+    codeExpr( as, EX_NEG, 0, NULL );
+  }
+  else
+  {
+    as->sym_getexpr = *(eval( as ));
+  }
+
+
+  if( is_blank( as->delimiter ))
+  {
+    return( &as->sym_getexpr );
+  }
+
+  /* Here we assume the current lexeme is the operator separating the         */
+  /* previous operator from the next, if any.                                 */
+  while( TRUE )
+  {
+    /* assert line[lexstart] == delimiter                                     */
+    if( is_blank( as->delimiter ))
+    {
+      return( &as->sym_getexpr );
+    }
+
+    switch( as->line[as->lexstart] )
+    {
+    case '+':                   /* add                                        */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val += (eval( as ))->val;
+      codeExpr( as, EX_ADD, 0, NULL );
+      break;
+
+    case '-':                   /* subtract                                   */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val -= (eval( as ))->val;
+      codeExpr( as, EX_SUB, 0, NULL );
+      break;
+
+    case '^':                   /* multiply                                   */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val *= (eval( as ))->val;
+      codeExpr( as, EX_MUL, 0, NULL );
+      break;
+
+    case '%':                   /* divide                                     */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val /= (eval( as ))->val;
+      codeExpr( as, EX_DIV, 0, NULL );
+      break;
+
+    case '&':                   /* and                                        */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val &= (eval( as ))->val;
+      codeExpr( as, EX_AND, 0, NULL );
+      break;
+
+    case '!':                   /* or                                         */
+      nextLexBlank( as );           /* skip over the operator                 */
+      as->sym_getexpr.val |= (eval( as ))->val;
+      codeExpr( as, EX_OR, 0, NULL );
+      break;
+
+    default:
+      if( isend( as->line[as->lexstart] ))
+      {
+        return( &as->sym_getexpr );
+      }
+
+      switch( as->line[as->lexstart] )
+      {
+      case '/':
+      case ';':
+      case ')':
+      case ']':
+      case '<':
+        break;
+
+      case '=':
+        errorMessage( as, &illegal_equals, as->lexstart );
+        moveToEndOfLine( as );
+        as->sym_getexpr.val = 0;
+        break;
+
+      default:
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
+        as->sym_getexpr.val = 0;
+        break;
+      }
+      return( &as->sym_getexpr );
+    }
+  } /* end while                                                              */
+} /* getExpr()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  eval                                                           */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme, set delimiter and advance.*/
+/*                                                                            */
+/******************************************************************************/
+SYM_T *eval( ASM_T *as )
+{
+  WORD16  digit;
+  int     from;
+  WORD16  loc;
+  char    name[SYMLEN];
+  SYM_T  *sym;
+  WORD16  val;
+
+  val = 0;
+
+  as->delimiter = as->line[as->lexterm];
+  if( isalpha( as->line[as->lexstart] ))
+  {
+    sym = evalSymbol( as );
+    codeExpr( as, EX_SYM, as->lexstart, sym );
+    if( M_UNDEFINED( sym->type ) && as->pass == 2 )
+    {
+      errorSymbol( as, &undefined_symbol, keyToName( name, sym->key ),
+                   as->lexstart );
+      nextLexeme( as );
+      return( sym );
+    }
+    else if( M_UNDEFINED( sym->type ) && as->one_pass )
+    {
+      /* A forward reference.  Only a compiled field can be fixed up.         */
+      if( as->coding )
+      {
+        as->coding_forward = TRUE;
+      }
+      else
+      {
+        failOnePass( as );
+      }
+      nextLexeme( as );
+      return( sym );
+    }
+    else
+    {
+      nextLexeme( as );
+      return( sym );
+    }
+  }
+  else if( isdigit( as->line[as->lexstart] ))
+  {
+    from = as->lexstart;
+    val = 0;
+    while( from < as->lexterm )
+    {
+      if( isdigit( as->line[from] ))
+      {
+        digit = (WORD16) as->line[from++] - (WORD16) '0';
+        if( digit < as->radix )
+        {
+          val = val * as->radix + digit;
+        }
+        else
+        {
+          errorLexeme( as, &number_not_radix, from - 1 );
+          val = 0;
+          from = as->lexterm;
+        }
+      }
+      else
+      {
+        errorLexeme( as, &not_a_number, as->lexstart );
+        val = 0;
+        from = as->lexterm;
+      }
+    }
+    codeExpr( as, EX_CONST, val, NULL );
+    nextLexeme( as );
+    as->sym_eval.val = val;
+    return( &as->sym_eval );
+  }
+  else
+  {
+    switch( as->line[as->lexstart] )
+    {
+    case '"':                   /* Character literal                          */
+      if( expandedColumn( as, as->lexstart ) + 4
+          < expandedColumn( as, as->maxcc ))
+      {
+        val = (( as->line[as->lexstart + 1] == '\t' )
+                ? ' ' : as->line[as->lexstart + 1] ) | 0200;
+        as->delimiter = as->line[as->lexstart + 2];
+        as->cc = as->lexstart + 2;
+        codeExpr( as, EX_CONST, val, NULL );
+      }
+      else
+      {
+        errorMessage( as, &no_literal_value, as->lexstart );
+      }
+      nextLexeme( as );
+      break;
+
+    case '.':                   /* Value of Current Location Counter          */
+      val = as->clc + as->reloc;
+      codeExpr( as, EX_DOT, 0, NULL );
+      nextLexeme( as );
+      break;
+
+    case '[':                   /* Generate literal on page zero.             */
+      if( !as->literals_on )
+      {
+        errorMessage( as, &literal_gen_off, as->lexstart );
+      }
+      nextLexBlank( as );           /* Skip bracket                           */
+      val = (getExpr( as ))->val & 07777;
+      if( as->line[as->lexstart] == ']' )
+      {
+        nextLexBlank( as );         /* Skip end bracket                       */
+      }
+      else
+      {
+        /* errorMessage( "parens", lexstart );                                */
+      }
+      codeExpr( as, EX_PZLIT, 0, NULL );
+      as->sym_eval.val = as->literals_on ? insertLiteral( as, &as->pz, val )
+                                         : 0;
+      return( &as->sym_eval );
+
+    case '(':                   /* Generate literal on current page.          */
+      if( !as->literals_on )
+      {
+        errorMessage( as, &literal_gen_off, as->lexstart );
+      }
+
+      nextLexBlank( as );           /* Skip paren                             */
+      val = getExprs( as ) & 07777;
+
+      if( as->line[as->lexstart] == ')' )
+      {
+        nextLexBlank( as );         /* Skip end paren                         */
+      }
+      else
+      {
+        /* errorMessage( "parens", NULL );                                    */
+      }
+
+      codeExpr( as, EX_CPLIT, 0, NULL );
+      loc = as->literals_on ? insertLiteral( as, &as->cp, val ) : 0;
+      as->sym_eval.val = loc + (( as->clc + as->reloc ) & 077600 );
+      return( &as->sym_eval );
+
+    default:
+      switch( as->line[as->lexstart] )
+      {
+      case '=':
+        errorMessage( as, &illegal_equals, as->lexstart );
+        moveToEndOfLine( as );
+        break;
+
+      default:
+        errorMessage( as, &illegal_character, as->lexstart );
+        break;
+      }
+      val = 0;                  /* On error, set value to zero.               */
+      nextLexBlank( as );           /* Go past illegal character.             */
+    }
+  }
+  as->sym_eval.val = val;
+  return( &as->sym_eval );
+} /* eval()                                                                   */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  inputDubl                                                      */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a double word.          */
+/*                                                                            */
+/******************************************************************************/
+void inputDubl( ASM_T *as )
+{
+  WORD32 dublvalue;
+  BOOL   scanning_line;
+
+  scanning_line = TRUE;
+  do
+  {
+    while( scanning_line )
+    {
+      if( isend( as->line[as->lexstart] ))
+      {
+        scanning_line = FALSE;
+      }
+      else
+      {
+        switch( as->line[as->lexstart] )
+        {
+        case '/':
+          scanning_line = FALSE;
+          break;
+
+        case ';':
+          nextLexeme( as );
+          break;
+
+        case '+':
+          as->delimiter = as->line[as->lexterm];
+          nextLexBlank( as );
+        case '-':
+        default:
+          if( isdigit( as->line[as->lexstart] )
+              || as->line[as->lexstart] == '-' )
+          {
+            dublvalue = getDublExprs( as );
+            punchOutObject( as, as->clc,
+                            (WORD16)(( dublvalue >> 12 ) & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc, (WORD16)( dublvalue & 07777 ));
+            incrementClc( as );
+          }
+          else
+          {
+            return;             /* Non-numeric input, back to assembly.       */
+          }
+          break;
+        } /* end switch                                                       */
+      } /* end if                                                             */
+
+      if( as->error_in_line )
+      {
+        return;                 /* Error occurred, exit DUBL input mode.      */
+      }
+    } /* end while( scanning_line )                                           */
+    readLine( as );
+    nextLexeme( as );
+    scanning_line = TRUE;
+  }
+  while( TRUE );
+} /* inputDubl()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getDublExprs                                                   */
+/*                                                                            */
+/*  Synopsis:  Get a DUBL expression.                                         */
+/*                                                                            */
+/******************************************************************************/
+WORD32 getDublExprs( ASM_T *as )
+{
+  WORD32 dublvalue;
+
+  dublvalue = getDublExpr( as );
+
+  while( TRUE )
+  {
+    if( isdone( as->line[as->lexstart] ))
+    {
+      return( dublvalue );
+    }
+    else
+    {
+      errorMessage( as, &illegal_expression, as->lexstart - 1 );
+      return( 0 );
+    }
+  } /* end while                                                              */
+} /* getDublExprs()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getDublExpr                                                    */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
+/*             number is always considered to have a decimal radix.           */
+/*                                                                            */
+/******************************************************************************/
+WORD32 getDublExpr( ASM_T *as )
+{
+  WORD32 dublvalue;
+
+  as->delimiter = as->line[as->lexterm];
+  if( as->line[as->lexstart] == '-' )
+  {
+    nextLexBlank( as );
+    dublvalue = evalDubl( as, 0 );
+    nextLexeme( as );
+    /* Test for any value greater than 23 bits in length.                     */
+    if( (unsigned long int)dublvalue > 040000000L )
+    {
+      errorMessage( as, &dubl_overflow, as->lexstart );
+      dublvalue = 0;
+    }
+    dublvalue = -dublvalue;
+  }
+  else
+  {
+    dublvalue = evalDubl( as, 0 );
+    nextLexeme( as );
+    /* Test for any value greater than 23 bits in length.                     */
+    if( (unsigned long int)dublvalue > 037777777L )
+    {
+      errorMessage( as, &dubl_overflow, as->lexstart );
+      dublvalue = 0;
+    }
+  }
+
+  if( is_blank( as->delimiter ))
+  {
+    return( dublvalue );
+  }
+
+  /* Here we assume the current lexeme is the operator separating the         */
+  /* previous operator from the next, if any.                                 */
+  while( TRUE )
+  {
+    /* assert line[lexstart] == delimiter                                     */
+    if( is_blank( as->delimiter ))
+    {
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
+      dublvalue = 0;
+      return( dublvalue );
+    }
+
+    switch( as->line[as->lexstart] )
+    {
+    case '+':                   /* add                                        */
+    case '-':                   /* subtract                                   */
+    case '^':                   /* multiply                                   */
+    case '%':                   /* divide                                     */
+    case '&':                   /* and                                        */
+    case '!':                   /* or                                         */
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
+      dublvalue = 0;
+      break;
+
+    default:
+      if( isend( as->line[as->lexstart] ))
+      {
+        return( dublvalue );
+      }
+
+      switch( as->line[as->lexstart] )
+      {
+      case '/':
+      case ';':
+        break;
+
+      default:
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
+        dublvalue = 0;
+        break;
+      }
+      return( dublvalue );
+    }
+  } /* end while                                                              */
+} /* getDublExpr()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  evalDubl                                                       */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
+/*             number is always considered to have a decimal radix.           */
+/*                                                                            */
+/******************************************************************************/
+WORD32 evalDubl( ASM_T *as, WORD32 initial_value )
+{
+  WORD32  digit;
+  int     from;
+  WORD32  dublvalue;
+  WORD32  olddublvalue;
+
+  as->overflow = FALSE;
+  as->delimiter = as->line[as->lexterm];
+  from = as->lexstart;
+  dublvalue = initial_value;
+
+  while( from < as->lexterm )
+  {
+    if( isdigit( as->line[from] ))
+    {
+      olddublvalue = dublvalue;
+      digit = (WORD32)( as->line[from++] - '0' );
+      dublvalue = dublvalue * 10 + digit;
+      if( dublvalue < olddublvalue )
+      {
+        as->overflow = TRUE;
+      }
+    }
+    else
+    {
+      errorLexeme( as, &not_a_number, from );
+      dublvalue = 0;
+      from = as->lexterm;
+    }
+  }
+  return( dublvalue );
+} /* evalDubl()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  inputFltg                                                      */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a Floating Point const. */
+/*                                                                            */
+/******************************************************************************/
+void inputFltg( ASM_T *as )
+{
+  FLTG_T *fltg;
+  BOOL    scanning_line;
+
+  as->fltg_input = TRUE;            /* Set lexeme scanner for floating point. */
+  scanning_line = TRUE;
+  while( TRUE )
+  {
+    while( scanning_line )
+    {
+      if( isend( as->line[as->lexstart] ))
+      {
+        scanning_line = FALSE;
+      }
+      else
+      {
+        switch( as->line[as->lexstart] )
+        {
+        case '/':
+          scanning_line = FALSE;
+          break;
+
+        case ';':
+          nextLexeme( as );
+          break;
+
+        case '+':
+          as->delimiter = as->line[as->lexterm];
+          nextLexBlank( as );
+        case '-':
+        default:
+          if( isdigit( as->line[as->lexstart] )
+              || as->line[as->lexstart] == '-' )
+          {
+            fltg = getFltgExprs( as );
+            punchOutObject( as, as->clc, ( fltg->exponent & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc,
+                            (WORD16)(( fltg->mantissa >> 12 ) & 07777 ));
+            incrementClc( as );
+            punchOutObject( as, as->clc, (WORD16)( fltg->mantissa & 07777 ));
+            incrementClc( as );
+          }
+          else
+          {
+            as->fltg_input = FALSE; /* Reset lexeme scanner.                  */
+            return;             /* Non-numeric input, back to assembly.       */
+          }
+          break;
+        } /* end switch                                                       */
+      } /* end if                                                             */
+
+      if( as->error_in_line )
+      {
+        as->fltg_input = FALSE;     /* Reset lexeme scanner.                  */
+        return;                 /* Error occurred, exit FLTG input mode.      */
+      }
+    } /* end while( scanning_line )                                           */
+    readLine( as );
+    nextLexeme( as );
+    scanning_line = TRUE;
+  }
+} /* inputFltg()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getFltgExprs                                                   */
+/*                                                                            */
+/*  Synopsis:  Get a FLTG expression.                                         */
+/*                                                                            */
+/******************************************************************************/
+FLTG_T *getFltgExprs( ASM_T *as )
+{
+  FLTG_T *fltg;
+
+  fltg = getFltgExpr( as );
+
+  while( TRUE )
+  {
+    if( isdone( as->line[as->lexstart] ))
+    {
+      return( fltg );
+    }
+    else
+    {
+      errorMessage( as, &illegal_expression, as->lexstart - 1 );
+      return( 0 );
+    }
+  } /* end while                                                              */
+} /* getFltgExprs()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  getFltgExpr                                                    */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a double word.  The     */
+/*             number is always considered to have a decimal radix.           */
+/*                                                                            */
+/******************************************************************************/
+FLTG_T *getFltgExpr( ASM_T *as )
+{
+  FLTG_T *fltg;
+
+  as->delimiter = as->line[as->lexterm];
+  fltg = evalFltg( as );
+  /* Test for any value greater than 23 bits in length.                     */
+  if( (unsigned long int)fltg->mantissa> 077777777L )
+  {
+    errorMessage( as, &fltg_overflow, as->lexstart );
+  }
+
+  if( is_blank( as->delimiter ))
+  {
+    return( fltg );
+  }
+
+  /* Here we assume the current lexeme is the operator separating the         */
+  /* previous operator from the next, if any.                                 */
+  while( TRUE )
+  {
+    /* assert line[lexstart] == delimiter                                     */
+    if( is_blank( as->delimiter ))
+    {
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
+      fltg = 0;
+      return( fltg );
+    }
+
+    switch( as->line[as->lexstart] )
+    {
+    case '+':                   /* add                                        */
+    case '-':                   /* subtract                                   */
+    case '^':                   /* multiply                                   */
+    case '%':                   /* divide                                     */
+    case '&':                   /* and                                        */
+    case '!':                   /* or                                         */
+      errorMessage( as, &illegal_expression, as->lexstart );
+      moveToEndOfLine( as );
+      fltg = NULL;
+      break;
+
+    default:
+      if( isend( as->line[as->lexstart] ))
+      {
+        return( fltg );
+      }
+
+      switch( as->line[as->lexstart] )
+      {
+      case '/':
+      case ';':
+        break;
+
+      default:
+        errorMessage( as, &illegal_expression, as->lexstart );
+        moveToEndOfLine( as );
+        fltg = NULL;
+        break;
+      }
+      return( fltg );
+    }
+  } /* end while                                                              */
+} /* getFltgExpr()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  evalFltg                                                       */
+/*                                                                            */
+/*  Synopsis:  Get the value of the current lexeme as a floating point value. */
+/*             Floating point input is alwasy considered decimal.             */
+/*             The general format of a floating point number is:              */
+/*                +-ddd.dddE+-dd  where each d is a decimal digit.            */
+/*                                                                            */
+/******************************************************************************/
+FLTG_T *evalFltg( ASM_T *as )
+{
+  int      current_state;
+  int      current_col;
+  WORD16   exponent;
+  FLTG_T  *fltg;
+  WORD32   input_value;
+  BOOL     negate;
+  BOOL     negate_exponent;
+  int      next_state;
+  int      right_digits;
+
+  /* This uses a lexical analyzer to parse the floating point format.         */
+  static BYTE state_table[][10] =
+  {
+    /*  0   1   2   3   4   5   6  Oolumn index                               */
+    /*  +   -   d   .   E  sp   p      State  Comment                         */
+     {  2,  1,  3,  4, 10, 10, 10  },  /*  0  Initial state.                  */
+     { 11, 11,  3,  4, 11, 11, 11  },  /*  1  -                               */
+     { 11, 11,  3,  4, 11, 11, 11  },  /*  2  +                               */
+     { 10, 10, 10,  4,  6, 10, 10  },  /*  3  # (+-ddd)                       */
+     { 11, 11,  5, 11, 11, 10, 10  },  /*  4  . (+-ddd.)                      */
+     { 11, 11, 11, 11,  6, 10, 11  },  /*  5  # (+-ddd.ddd)                   */
+     {  8,  7,  9, 11, 11, 11, 11  },  /*  6  E (+-ddd.dddE)                  */
+     { 11, 11,  9, 11, 11, 11, 11  },  /*  7  - (+-ddd.dddE-                  */
+     { 11, 11,  9, 11, 11, 11, 11  },  /*  8  + (+-ddd.dddE+                  */
+     { 11, 11, 11, 11, 11, 10, 11  }   /*  9  # (+-ddd.dddE+-dd               */
+                                       /* 10  Completion state                */
+                                       /* 11  Error state.                    */
+  };
+
+  as->delimiter = as->line[as->lexterm];
+  fltg = &as->fltg_ac;
+  fltg->exponent = 0;
+  fltg->mantissa = 0;
+  input_value = 0;
+  negate = FALSE;
+  negate_exponent = FALSE;
+  next_state = 0;
+  exponent = 0;
+  right_digits = 0;
+  current_state = 0;
+
+  while( TRUE )
+  {
+    /* Classify character.  This is the column index.                         */
+    switch( as->line[as->lexstart] )
+    {
+    case '+':
+      current_col = 0;
+      break;
+
+    case '-':
+      current_col = 1;
+      break;
+
+    case '.':
+      current_col = 3;
+      break;
+
+    case 'E':  case 'e':
+      current_col = 4;
+      break;
+
+    default:
+      if( isdigit( as->line[as->lexstart] ))
+      {
+        current_col = 2;
+      }
+      else if( isdone( as->line[as->lexstart] ))
+      {
+        current_col = 5;
+      }
+      else
+      {
+        current_col = 6;
+      }
+      break;
+    }
+
+    next_state = state_table[current_state][current_col];
+
+    switch( next_state )
+    {
+    case 1:                             /*  -                                 */
+      negate = TRUE;
+    case 2:                             /*  +                                 */
+      as->delimiter = as->line[as->lexterm]; /* Move past the + or -.     */
+      nextLexBlank( as );
+      break;
+
+    case 3:                             /* Number  (+-ddd)                    */
+      input_value = evalDubl( as, 0 );      /* Integer part of the number.    */
+      nextLexeme( as );                     /* Move past previous lexeme.     */
+      break;
+
+    case 4:
+      as->delimiter = as->line[as->lexterm];
+      nextLexBlank( as );                   /* Move past the . character.     */
+      break;
+
+    case 5:                             /* .  (+-ddd.ddd)                     */
+                                        /* Fractional part of the number.     */
+      input_value = evalDubl( as, input_value );
+      right_digits = as->lexterm - as->lexstart; /* Digits right of the . */
+      nextLexeme( as );                     /* Move past previous lexeme.     */
+      break;
+
+    case 6:                             /* E  (+-ddd.dddE)                    */
+      as->delimiter = as->line[as->lexterm];        /* Move past the E.       */
+      nextLexBlank( as );
+      break;
+
+    case 7:                             /* -  (+-ddd.dddE-)                   */
+      negate_exponent = TRUE;
+    case 8:                             /* +  (+-ddd.dddE+)                   */
+      as->delimiter = as->line[as->lexterm]; /* Move past the + or -.     */
+      nextLexBlank( as );
+      break;
+
+    case 9:                             /* #  (+-ddd.dddE+-dd)                */
+      exponent = (int)evalDubl( as, 0 );  /* Exponent of the number.       */
+      if( negate_exponent ) { exponent = - exponent; }
+      nextLexeme( as );                     /* Move past previous lexeme.     */
+      break;
+
+    case 10:                            /* Floating number parsed, convert    */
+                                        /* the number.                        */
+      /* Get the exponent for the number as input.                            */
+      exponent -= right_digits;
+
+      /* Remove trailing zeros and adjust the exponent accordingly.           */
+      while(( input_value % 10 ) == 0 )
+      {
+        input_value /= 10;
+        exponent++;
+      }
+
+      /* Convert the number to floating point.  The number is calculated with */
+      /* a 27 bit mantissa to improve precision.  The extra 3 bits are        */
+      /* discarded after the result has been calculated.                      */
+      fltg->exponent = 26;
+      fltg->mantissa = input_value << 3;
+      normalizeFltg( fltg );
+
+
+      while( exponent != 0 )
+      {
+        if( exponent < 0 )
+        {
+          /* Decimal point is to the left. */
+          fltg->mantissa /= 10;
+          normalizeFltg( fltg );
+          exponent++;
+        }
+        else if( exponent > 0 )
+        {
+          /* Decimal point is to the right. */
+          fltg->mantissa *= 10;
+          normalizeFltg( fltg );
+          exponent--;
+        }
+      }
+
+      /* Discard the extra precsion used for calculating the number.          */
+      fltg->mantissa >>= 3;
+      fltg->exponent -= 3;
+      if( negate )
+      {
+        fltg->mantissa = (- fltg->mantissa ) & 077777777L;
+      }
+      return( fltg );
+
+    case 11:                            /* Error in format.                   */
+      /* Not a properly constructued floating point number.                   */
+      return( fltg );
+    default:
+      break;
+    }
+    /* Set state for next pass through the loop.                              */
+    current_state = next_state;
+  }
+} /* evalFltg()                                                               */
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  normalizeFltg                                                  */
+/*                                                                            */
+/*  Synopsis:  Normalize a PDP-8 double precision floating point number.      */
+/*                                                                            */
+/******************************************************************************/
+void normalizeFltg( FLTG_T *fltg )
+{
+  /* Normalize the floating point number.                                     */
+  if( fltg->mantissa != 0 )
+  {
+    if(( fltg->mantissa & ~0x3FFFFFFL ) == 0 )
+    {
+      while(( fltg->mantissa & ~0x1FFFFFFL ) == 0 )
+
+      {
+        fltg->mantissa <<= 1;
+        fltg->exponent--;
+      }
+    }
+    else
+    {
+      while(( fltg->mantissa & ~0x3FFFFFFL ) != 0 )
+      {
+        fltg->mantissa >>= 1;
+        fltg->exponent++;
+      }
+    }
+  }
+  else
+  {
+    fltg->exponent = 0;
+  }
+  return;
+}
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  incrementClc                                                   */
+/*                                                                            */
+/*  Synopsis:  Set the next assembly location.  Test for collision with       */
+/*             the literal tables.                                            */
+/*                                                                            */
+/******************************************************************************/
+WORD16 incrementClc( ASM_T *as )
+{
+  testForLiteralCollision( as, as->clc );
+
+  /* Incrementing the location counter is not to change field setting.        */
+  as->clc = ( as->clc & 070000 ) + (( as->clc + 1 ) & 07777 );
+  as->fieldlc = as->clc & 07777;
+  return( as->clc );
+} /* incrementClc()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  testForLiteralCollision                                        */
+/*                                                                            */
+/*  Synopsis:  Test the given location for collision with the literal tables. */
+/*                                                                            */
+/******************************************************************************/
+BOOL testForLiteralCollision( ASM_T *as, WORD16 loc )
+{
+  WORD16  pagelc;
+  BOOL    result = FALSE;
+  WORD16  tmppage;
+
+  tmppage = loc & 07600;
+  pagelc  = loc & 00177;
+
+  if( tmppage == 0 )
+  {
+    if( pagelc >= as->pz.loc && !as->pz.error )
+    {
+      errorMessage( as, &pz_literal_overflow, -1 );
+      as->pz.error = TRUE;
+      result = TRUE;
+    }
+  }
+  else
+  {
+    if( pagelc >= as->cp.loc && !as->cp.error )
+    {
+      errorMessage( as, &literal_overflow, -1 );
+      as->cp.error = TRUE;
+      result = TRUE;
+    }
+  }
+  return( result );
+} /* testForLiteralCollision()                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  readLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Get next line of input.  Print previous line if needed.        */
+/*                                                                            */
+/******************************************************************************/
+void readLine( ASM_T *as )
+{
+  char   *end;
+  int     length;
+  char   *text;
+
+  listLine( as );                   /* List previous line if needed.          */
+  as->lineno++;                     /* Count lines read.                      */
+  as->indirect_generated = FALSE;   /* Mark no indirect address generated.    */
+  as->listed = FALSE;               /* Mark as not listed.                    */
+  as->cc = 0;                       /* Initialize column counter.             */
+  as->lexstartprev = 0;
+
+  /* Pass 2 replays the lines read in pass 1 instead of reading them again.   */
+  if( as->pass == 2 && replayLine( as ))
+  {
+    if( as->lineno == 1 )
+    {
+      takeTitle( as );
+    }
+    return;
+  }
+
+  if( as->srcpos >= as->srcsize )
+  {
+    as->line = "$\n";
+    as->maxcc = 2;
+    as->error_in_line = TRUE;
+  }
+  else
+  {
+    /* Take the next line, however long, from the mapped input.               */
+    text = as->srcbase + as->srcpos;
+    end = (char *) memchr( text, '\n', as->srcsize - as->srcpos );
+    length = ( end != NULL ) ? end - text + 1 : as->srcsize - as->srcpos;
+    as->srcpos += length;
+    takeLine( as, text, length );
+    as->error_in_line = FALSE;
+  }
+
+  if( as->pass == 1 )
+  {
+    cacheLine( as, as->error_in_line );
+  }
+
+  /* Save the first line for possible use as the listing title.               */
+  if( as->lineno == 1 )
+  {
+    takeTitle( as );
+  }
+} /* readLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  takeTitle                                                      */
+/*                                                                            */
+/*  Synopsis:  Take the first line as the listing title, trimmed to fit the   */
+/*             page header.  This is done as it is read, not at the first     */
+/*             page break, so that the pass 1 checkpoints hold the title as   */
+/*             pass 2 prints it.                                              */
+/*                                                                            */
+/******************************************************************************/
+void takeTitle( ASM_T *as )
+{
+  int     length;
+
+  expandTabs( as->list_title, as->line, sizeof( as->list_title ));
+  length = strlen( as->list_title );
+  if( length > 0 && as->list_title[length - 1] == '\n' )
+  {
+    length--;
+    as->list_title[length] = '\0';
+  }
+  if( length > TITLELEN )
+  {
+    as->list_title[TITLELEN] = '\0';
+  }
+} /* takeTitle()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  takeLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Make the length characters of input at text the current line.  */
+/*             The line is used where it is unless it has a CR-LF or no       */
+/*             newline at its end.  Only then is it rewritten, into the       */
+/*             arena.  A NUL ends the line, as it ended the string read by    */
+/*             fgets().  Tabs are left in the line for the lexer.             */
+/*                                                                            */
+/******************************************************************************/
+void takeLine( ASM_T *as, char *text, int length )
+{
+  char   *end;
+
+  if(( end = (char *) memchr( text, '\0', length )) != NULL )
+  {
+    length = end - text;
+  }
+  if( length > 0 && text[length - 1] == '\n' &&
+      !( length > 1 && text[length - 2] == '\r' ))
+  {
+    as->line = text;
+    as->maxcc = length;
+    return;
+  }
+
+  as->line = arenaAlloc( as, length + 1 );
+  memcpy( as->line, text, length );
+  as->line[length] = '\0';
+
+  /* If the line is terminated by CR-LF, remove, the CR.                      */
+  if( length > 1 && as->line[length - 2] == '\r' )
+  {
+    length--;
+    as->line[length - 1] = as->line[length - 0];
+    as->line[length] = '\0';
+  }
+  as->maxcc = length;               /* Save the current line length.          */
+} /* takeLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  cacheLine                                                      */
+/*                                                                            */
+/*  Synopsis:  Keep the line just read in pass 1 for replayLine() in pass 2,  */
+/*             with flag set if it was made up at the end of the file.        */
+/*             Its lexemes are added by nextLexeme() as they are found.       */
+/*                                                                            */
+/******************************************************************************/
+void cacheLine( ASM_T *as, BOOL flag )
+{
+  SRCLINE_T *src;
+
+  as->srclines = (SRCLINE_T *) growTable( as->srclines, &as->srcline_room,
+                                          sizeof( SRCLINE_T ),
+                                          as->srcline_count + 1 );
+
+  /* The line is in the mapped input or in the arena, so it stays put.        */
+  src = &as->srclines[as->srcline_count];
+  src->text = as->line;
+  src->length = as->maxcc;
+  src->lexeme = as->lexeme_count;
+  src->lexemes = 0;
+  src->expr = as->coded_count;
+  src->exprs = 0;
+  src->eof = flag;
+  as->lexeme_line = as->srcline_count++;
+} /* cacheLine()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  replayLine                                                     */
+/*                                                                            */
+/*  Synopsis:  Get the next line cached by pass 1.  Returns FALSE when there  */
+/*             are no more, and the input file must be read from where pass 1 */
+/*             stopped.                                                       */
+/*                                                                            */
+/******************************************************************************/
+BOOL replayLine( ASM_T *as )
+{
+  SRCLINE_T *src;
+
+  if( as->srcline_next >= as->srcline_count )
+  {
+    as->lexeme_line = -1;
+    return( FALSE );
+  }
+  as->lexeme_line = as->srcline_next++;
+  src = &as->srclines[as->lexeme_line];
+  as->line = src->text;
+  as->maxcc = src->length;
+  as->lexeme_next = src->lexeme;
+  as->coded_next = src->expr;
+  as->error_in_line = src->eof;
+  return( TRUE );
+} /* replayLine()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  growTable                                                      */
+/*                                                                            */
+/*  Synopsis:  Make room in table for at least need entries of size bytes,    */
+/*             doubling the room it has.  Returns the possibly moved table.   */
+/*                                                                            */
+/******************************************************************************/
+void *growTable( void *table, int *room, int size, int need )
+{
+  int  newroom;
+
+  if( need <= *room )
+  {
+    return( table );
+  }
+  for( newroom = ( *room == 0 ) ? 1024 : 2 * *room; newroom < need; )
+  {
+    newroom *= 2;
+  }
+  if(( table = realloc( table, (size_t) size * newroom )) == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for source cache.\n");
+    exit( -1 );
+  }
+  *room = newroom;
+  return( table );
+} /* growTable()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  arenaAlloc                                                     */
+/*                                                                            */
+/*  Synopsis:  Return room for size characters of a rewritten line.  It is    */
+/*             taken from blocks which are never moved, and only freed with   */
+/*             the context, so lines kept by cacheLine() stay valid.          */
+/*                                                                            */
+/******************************************************************************/
+char *arenaAlloc( ASM_T *as, int size )
+{
+  char   *text;
+
+  if( size > as->arena_left )
+  {
+    as->arena_left = ( size > ARENA_BLOCK ) ? size : ARENA_BLOCK;
+    if(( as->arena = (char *) malloc( as->arena_left )) == NULL )
+    {
+      fprintf( stderr, "Could not allocate memory for source cache.\n");
+      exit( -1 );
+    }
+    as->arena_blocks = (char **) growTable( as->arena_blocks,
+                                            &as->arena_block_room,
+                                            sizeof( char * ),
+                                            as->arena_block_count + 1 );
+    as->arena_blocks[as->arena_block_count++] = as->arena;
+  }
+  text = as->arena;
+  as->arena += size;
+  as->arena_left -= size;
+  return( text );
+} /* arenaAlloc()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  mapSource                                                      */
+/*                                                                            */
+/*  Synopsis:  Map an input file into memory for the whole assembly, and      */
+/*             return its address with its size in *size.  A file that can   */
+/*             not be mapped, such as a pipe, is read into memory instead,    */
+/*             and *mapped tells which.  An empty file is "", neither mapped  */
+/*             nor allocated.  Returns NULL if the file cannot be opened.     */
+/*                                                                            */
+/******************************************************************************/
+char *mapSource( char *path, long *size, BOOL *mapped )
+{
+  int          fd;
+  FILE        *file;
+  size_t       got;
+  int          room;
+  struct stat  st;
+  char        *text;
+
+  *mapped = FALSE;
+  if(( fd = open( path, O_RDONLY )) < 0 )
+  {
+    return( NULL );
+  }
+  if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ))
+  {
+    *size = (long) st.st_size;
+    if( *size == 0 )
+    {
+      close( fd );
+      return( "" );
+    }
+    text = (char *) mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( text != (char *) MAP_FAILED )
+    {
+      close( fd );
+      *mapped = TRUE;
+      return( text );
+    }
+  }
+
+  if(( file = fdopen( fd, "r" )) == NULL )
+  {
+    close( fd );
+    return( NULL );
+  }
+  for( *size = 0, room = 0, text = NULL; ; *size += got )
+  {
+    text = (char *) growTable( text, &room, sizeof( char ), *size + 4096 );
+    if(( got = fread( &text[*size], 1, room - *size, file )) == 0 )
+    {
+      break;
+    }
+  }
+  fclose( file );
+  if( *size == 0 )
+  {
+    free( text );
+    return( "" );
+  }
+  return( text );
+} /* mapSource()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listLine                                                       */
+/*                                                                            */
+/*  Synopsis:  Output a line to the listing file.                             */
+/*                                                                            */
+/******************************************************************************/
+void listLine( ASM_T *as )
+/* generate a line of listing if not already done!                            */
+{
+  if( as->listfile != NULL && as->listed == FALSE )
+  {
+    printLine( as, as->line, 0, 0, LINE );
+  }
+} /* listLine()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printPageBreak                                                 */
+/*                                                                            */
+/*  Synopsis:  Output a Top of Form and listing header if new page necessary. */
+/*                                                                            */
+/******************************************************************************/
+void printPageBreak( ASM_T *as )
+{
+  if( as->worker )
+  {
+    addPageBreak( as );
+  }
+  else if( as->page_lineno >= LIST_LINES_PER_PAGE )
+         /*  ( list_lineno % LIST_LINES_PER_PAGE ) == 0 ) */
+  {
+    topOfForm( as, as->list_title, NULL );
+  }
+} /* printPageBreak()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addPageBreak                                                   */
+/*                                                                            */
+/*  Synopsis:  Leave the page break at this point of the listing of a pass 2  */
+/*             worker to the parent.  The lines listed after it are counted   */
+/*             from PAGE_UNKNOWN.                                             */
+/*                                                                            */
+/******************************************************************************/
+void addPageBreak( ASM_T *as )
+{
+  PAGEBREAK_T *brk;
+
+  if( as->title_count == 0
+      || strcmp( as->list_title,
+                 &as->titles[( as->title_count - 1 ) * ( TITLELEN + 2 )] ))
+  {
+    as->titles = growTable( as->titles, &as->title_room, TITLELEN + 2,
+                            as->title_count + 1 );
+    strcpy( &as->titles[as->title_count * ( TITLELEN + 2 )], as->list_title );
+    as->title_count++;
+  }
+  as->pagebreaks = growTable( as->pagebreaks, &as->pagebreak_room,
+                              sizeof( PAGEBREAK_T ), as->pagebreak_count + 1 );
+  brk = &as->pagebreaks[as->pagebreak_count];
+  as->pagebreak_count++;
+  brk->pos = listPosition( as );
+  brk->lines = as->page_lineno;
+  brk->title = as->title_count - 1;
+  if( brk->pos < 0 )
+  {
+    as->worker_usable = FALSE;
+  }
+  as->page_lineno = PAGE_UNKNOWN;
+} /* addPageBreak()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printLine                                                      */
+/*                                                                            */
+/*  Synopsis:  Record a line for the listing, with the errors saved for it.   */
+/*             renderListing() makes the text, with new pages as necessary.   */
+/*                                                                            */
+/******************************************************************************/
+void printLine( ASM_T *as, char *line, WORD16 loc, WORD16 val,
+                LINESTYLE_T linestyle )
+{
+  LISTREC_T *rec;
+
+  if( as->listfile == NULL )
+  {
+    as->save_error_count = 0;
+    return;
+  }
+
+  if( linestyle == LINE_LOC_VAL )
+  {
+    if( as->fixup_field >= 0 )
+    {
+      as->fixup_list_rec = as->listrec_count;
+    }
+    if( as->listed )
+    {
+      linestyle = LOC_VAL;          /* Only the line's first word shows it.   */
+    }
+  }
+  rec = addListRecord( as, linestyle, line, as->lineno );
+  rec->loc = loc;
+  rec->val = val;
+  rec->indirect = as->indirect_generated;
+  if( linestyle != LOC_VAL )
+  {
+    as->listed = TRUE;
+  }
+  printErrorMessages( as );
+} /* printLine()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addListRecord                                                  */
+/*                                                                            */
+/*  Synopsis:  Add a record to the listing.  The first one also keeps the     */
+/*             page line and the title, which the rendering starts from.      */
+/*                                                                            */
+/******************************************************************************/
+LISTREC_T *addListRecord( ASM_T *as, int style, char *text, int num )
+{
+  LISTREC_T *rec;
+
+  if( as->listrec_count == 0 )
+  {
+    as->listrec_page_lineno = as->page_lineno;
+    strcpy( as->listrec_title, as->list_title );
+  }
+  as->listrecs = (LISTREC_T *) growTable( as->listrecs, &as->listrec_room,
+                                          sizeof( LISTREC_T ),
+                                          as->listrec_count + 1 );
+  rec = &as->listrecs[as->listrec_count++];
+  rec->text = text;
+  rec->num = num;
+  rec->loc = 0;
+  rec->val = 0;
+  rec->style = (BYTE) style;
+  rec->indirect = FALSE;
+  return( rec );
+} /* addListRecord()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listNewPage                                                    */
+/*                                                                            */
+/*  Synopsis:  Start a new page before the next line of the listing, with the */
+/*             title in list_title if titled.  Recorded even while XLIST has  */
+/*             turned the listing off, as the page is still due after it.     */
+/*                                                                            */
+/******************************************************************************/
+void listNewPage( ASM_T *as, BOOL titled )
+{
+  if( as->listfile == NULL && as->listsave == NULL )
+  {
+    as->page_lineno = LIST_LINES_PER_PAGE;
+    return;
+  }
+  if( !titled )
+  {
+    addListRecord( as, LISTREC_EJECT, NULL, 0 );
+    return;
+  }
+  as->listtitles = growTable( as->listtitles, &as->listtitle_room,
+                              TITLELEN + 2, as->listtitle_count + 1 );
+  strcpy( &as->listtitles[as->listtitle_count * ( TITLELEN + 2 )],
+          as->list_title );
+  addListRecord( as, LISTREC_TITLE, NULL, as->listtitle_count );
+  as->listtitle_count++;
+} /* listNewPage()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  renderListing                                                  */
+/*                                                                            */
+/*  Synopsis:  Make the text of the listing recorded so far, with a new page  */
+/*             where necessary, and forget the records.                       */
+/*                                                                            */
+/******************************************************************************/
+void renderListing( ASM_T *as )
+{
+  LISTREC_T *rec;
+  char       title[TITLELEN + 2];
+
+  if( as->listrec_count == 0 )
+  {
+    return;
+  }
+  strcpy( title, as->list_title );
+  as->page_lineno = as->listrec_page_lineno;
+  strcpy( as->list_title, as->listrec_title );
+
+  for( rec = as->listrecs; rec < as->listrecs + as->listrec_count; rec++ )
+  {
+    switch( rec->style )
+    {
+    case LISTREC_TITLE:
+      strcpy( as->list_title, &as->listtitles[rec->num * ( TITLELEN + 2 )] );
+      as->page_lineno = LIST_LINES_PER_PAGE;
+      break;
+
+    case LISTREC_EJECT:
+      as->page_lineno = LIST_LINES_PER_PAGE;
+      break;
+
+    case LISTREC_ERROR:
+      printPageBreak( as );
+      listField( as, rec->text, 18 );
+      if( rec->num >= 0 )
+      {
+        listSpaces( as, rec->num );
+        listChars( as, "^", 1 );
+        as->list_lineno++;
+        as->page_lineno++;
+      }
+      listChars( as, "\n", 1 );
+      break;
+
+    default:
+    case LINE:
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, rec->num, 5 );
+      listSpaces( as, 13 );
+      putLine( as, rec->text );
+      break;
+
+    case LINE_VAL:
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, rec->num, 5 );
+      listSpaces( as, 7 );
+      listOctal( as, rec->val, 4 );
+      listSpaces( as, 2 );
+      putLine( as, rec->text );
+      break;
+
+    case LINE_LOC_VAL:
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, rec->num, 5 );
+      listSpaces( as, 1 );
+      listOctal( as, rec->loc, 5 );
+      listSpaces( as, 1 );
+      listOctal( as, rec->val, 4 );
+      listChars( as, ( rec->indirect ? "@ " : "  " ), 2 );
+      putLine( as, rec->text );
+      break;
+
+    case LOC_VAL:
+      printPageBreak( as );
+      as->list_lineno++;
+      as->page_lineno++;
+      listSpaces( as, 6 );
+      listOctal( as, rec->loc, 5 );
+      listSpaces( as, 1 );
+      listOctal( as, rec->val, 4 );
+      listChars( as, "\n", 1 );
+      break;
+    }
+  }
+
+  strcpy( as->list_title, title );
+  as->listrec_count = 0;
+  as->listtitle_count = 0;
+} /* renderListing()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  putLine                                                        */
+/*                                                                            */
+/*  Synopsis:  Write a line, up to and including its newline, to the listing  */
+/*             with its tabs expanded to 8 character tab stops.               */
+/*                                                                            */
+/******************************************************************************/
+void putLine( ASM_T *as, char *text )
+{
+  int     col;
+  int     length;
+
+  col = 0;
+  while( TRUE )
+  {
+    length = strcspn( text, "\t\n" );
+    listChars( as, text, length );
+    col += length;
+    text += length;
+    if( *text != '\t' )
+    {
+      break;
+    }
+    listSpaces( as, 8 - col % 8 );
+    col += 8 - col % 8;
+    text++;
+  }
+  if( *text == '\n' )
+  {
+    listChars( as, "\n", 1 );
+  }
+} /* putLine()                                                                */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listChars                                                      */
+/*                                                                            */
+/*  Synopsis:  Put length characters into the listing buffer, writing it to   */
+/*             the listing file whenever it fills.                            */
+/*                                                                            */
+/******************************************************************************/
+void listChars( ASM_T *as, char *text, int length )
+{
+  int     room;
+
+  while( length > 0 )
+  {
+    if( as->listout_count == LIST_BUFFER )
+    {
+      flushList( as );
+    }
+    room = LIST_BUFFER - as->listout_count;
+    room = ( room < length ) ? room : length;
+    memcpy( &as->listout[as->listout_count], text, room );
+    as->listout_count += room;
+    text += room;
+    length -= room;
+  }
+} /* listChars()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listSpaces                                                     */
+/*                                                                            */
+/*  Synopsis:  Put count spaces into the listing buffer.                      */
+/*                                                                            */
+/******************************************************************************/
+void listSpaces( ASM_T *as, int count )
+{
+  static char spaces[] = "                                ";
+
+  for( ; count > 32; count -= 32 )
+  {
+    listChars( as, spaces, 32 );
+  }
+  listChars( as, spaces, count );
+} /* listSpaces()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listDecimal                                                    */
+/*                                                                            */
+/*  Synopsis:  Put a number into the listing buffer in decimal, right         */
+/*             justified in width columns, as printf() does for "%*d".        */
+/*                                                                            */
+/******************************************************************************/
+void listDecimal( ASM_T *as, int value, int width )
+{
+  char          digits[12];
+  int           ix;
+  unsigned int  magnitude;
+
+  magnitude = ( value < 0 ) ? 0U - (unsigned int) value : (unsigned int) value;
+  ix = sizeof( digits );
+  do
+  {
+    digits[--ix] = '0' + magnitude % 10;
+    magnitude /= 10;
+  }
+  while( magnitude > 0 );
+  if( value < 0 )
+  {
+    digits[--ix] = '-';
+  }
+  listSpaces( as, width - ( (int) sizeof( digits ) - ix ));
+  listChars( as, &digits[ix], sizeof( digits ) - ix );
+} /* listDecimal()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listOctal                                                      */
+/*                                                                            */
+/*  Synopsis:  Put a number into the listing buffer in octal with at least    */
+/*             digits digits, as printf() does for "%*.*o".                   */
+/*                                                                            */
+/******************************************************************************/
+void listOctal( ASM_T *as, unsigned int value, int digits )
+{
+  char    octal[12];
+  int     ix;
+
+  ix = sizeof( octal );
+  do
+  {
+    octal[--ix] = '0' + ( value & 07 );
+    value >>= 3;
+  }
+  while( value > 0 || (int) sizeof( octal ) - ix < digits );
+  listChars( as, &octal[ix], sizeof( octal ) - ix );
+} /* listOctal()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listField                                                      */
+/*                                                                            */
+/*  Synopsis:  Put a string into the listing buffer left justified in width   */
+/*             columns and cut to them, as printf() does for "%-*.*s".        */
+/*                                                                            */
+/******************************************************************************/
+void listField( ASM_T *as, char *text, int width )
+{
+  int     length;
+
+  for( length = 0; length < width && text[length] != '\0'; length++ )
+  {
+    ;
+  }
+  listChars( as, text, length );
+  listSpaces( as, width - length );
+} /* listField()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listFormat                                                     */
+/*                                                                            */
+/*  Synopsis:  Put a line formatted by printf() into the listing buffer, for  */
+/*             the few lines that are not listed often.                       */
+/*                                                                            */
+/******************************************************************************/
+void listFormat( ASM_T *as, char *format, ... )
+{
+  va_list args;
+  char    text[256];
+  int     length;
+
+  va_start( args, format );
+  length = vsnprintf( text, sizeof( text ), format, args );
+  va_end( args );
+  listChars( as, text, ( length < (int) sizeof( text ))
+                       ? length : (int) sizeof( text ) - 1 );
+} /* listFormat()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  listPosition                                                   */
+/*                                                                            */
+/*  Synopsis:  Return where the next character listed goes in the listing     */
+/*             file, or -1 if that is not known.                              */
+/*                                                                            */
+/******************************************************************************/
+long listPosition( ASM_T *as )
+{
+  long    pos;
+
+  pos = ftell(( as->listfile != NULL ) ? as->listfile : as->listsave );
+  return(( pos < 0 ) ? pos : pos + as->listout_count );
+} /* listPosition()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  flushList                                                      */
+/*                                                                            */
+/*  Synopsis:  Write the listing buffer to the listing file, all at once.     */
+/*                                                                            */
+/******************************************************************************/
+void flushList( ASM_T *as )
+{
+  FILE   *list;
+
+  list = ( as->listfile != NULL ) ? as->listfile : as->listsave;
+  if( as->listout_count > 0 && list != NULL )
+  {
+    fwrite( as->listout, 1, as->listout_count, list );
+  }
+  as->listout_count = 0;
+} /* flushList()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  expandTabs                                                     */
+/*                                                                            */
+/*  Synopsis:  Copy a line, up to and including its newline, into a buffer of */
+/*             size characters as a NUL terminated string, with its tabs      */
+/*             expanded to 8 character tab stops.                             */
+/*                                                                            */
+/******************************************************************************/
+void expandTabs( char *to, char *from, int size )
+{
+  int     ix;
+  int     iy;
+
+  for( ix = 0, iy = 0; iy < size - 1 && from[ix] != '\0'; ix++ )
+  {
+    if( from[ix] == '\t' )
+    {
+      do
+      {
+        to[iy] = ' ';
+        iy++;
+      }
+      while(( iy % 8 ) != 0 && iy < size - 1 );
+    }
+    else
+    {
+      to[iy] = from[ix];
+      iy++;
+      if( from[ix] == '\n' )
+      {
+        break;
+      }
+    }
+  }
+  to[iy] = '\0';
+} /* expandTabs()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  printErrorMessages                                             */
+/*                                                                            */
+/*  Synopsis:  Record any error messages from the current list of errors.     */
+/*                                                                            */
+/******************************************************************************/
+void printErrorMessages( ASM_T *as )
+{
+  WORD16  iy;
+
+  if( as->listfile != NULL )
+  {
+    /* If any errors, list them now.                                          */
+    for( iy = 0; iy < as->save_error_count; iy++ )
+    {
+      addListRecord( as, LISTREC_ERROR, as->error_list[iy].mesg,
+                     as->error_list[iy].col );
+    }
+  }
+  as->save_error_count = 0;
+} /* printErrorMessages()                                                     */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  endOfBinary                                                    */
+/*                                                                            */
+/*  Synopsis:  Outputs both literal tables at the end of a binary segment.    */
+/*                                                                            */
+/******************************************************************************/
+void endOfBinary( ASM_T *as )
+{
+  /* Points to end of page for () operands.                                   */
+  punchLiteralPool( as, &as->cp, as->clc - 1 );
+  /* Points to end of page zero for [] operands.                              */
+  punchLiteralPool( as, &as->pz, 0 );
+  if( as->error_in_line )
+  {
+    as->listed = TRUE;
+    as->clc = ( as->clc & 070000 ) + (( as->clc - 1 ) & 07777 );
+    errorMessage( as, &end_of_file, -1 );
+    as->clc = ( as->clc & 070000 ) + (( as->clc + 1 ) & 07777 );
+  }
+  else
+  {
+    listLine( as );             /* List line if not done yet.                 */
+  }
+  return;
+} /* endOfBinary()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchChecksum                                                  */
+/*                                                                            */
+/*  Synopsis:  Output a checksum if the current mode requires it and an       */
+/*             object file exists.                                            */
+/*                                                                            */
+/******************************************************************************/
+void punchChecksum( ASM_T *as )
+{
+  /* If the assembler has output any BIN data output the checksum.            */
+  if( as->binary_data_output && !as->rim_mode )
+  {
+    if( as->checksum_partial )
+    {
+      as->worker_usable = FALSE;    /* The sum before the chunk is not known. */
+    }
+    punchLocObject( as, 0, as->checksum );
+  }
+  as->binary_data_output = FALSE;
+  as->checksum = 0;
+  as->checksum_partial = FALSE;
+} /* punchChecksum()                                                          */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  flushTape                                                      */
+/*                                                                            */
+/*  Synopsis:  Write the object characters punched into the tape buffer to    */
+/*             the object file, all at once.                                  */
+/*                                                                            */
+/******************************************************************************/
+void flushTape( ASM_T *as )
+{
+  if( as->tape_count > 0 && as->objectsave != NULL )
+  {
+    fwrite( as->tape, 1, as->tape_count, as->objectsave );
+  }
+  as->tape_count = 0;
+} /* flushTape()                                                              */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchImage                                                     */
+/*                                                                            */
+/*  Synopsis:  Punch the memory image as a bin tape, with an origin only      */
+/*             where the words loaded are not consecutive and a field setting */
+/*             only where the field changes.  The tape loads the same words   */
+/*             as the one punched during the assembly, which only counted its */
+/*             length.                                                        */
+/*                                                                            */
+/******************************************************************************/
+void punchImage( ASM_T *as )
+{
+  WORD16  field;
+  long    ix;
+  long    streamed;
+
+  streamed = as->tape_length;
+  as->compact = FALSE;
+  as->tape_length = 0;
+  as->checksum = 0;
+  as->binary_data_output = FALSE;
+
+  punchLeader( as, 0 );
+  field = 0;
+  for( ix = 0; ix < PALBART_IMAGE_SIZE; ix++ )
+  {
+    if( !as->loaded[ix] )
+    {
+      continue;
+    }
+    if(( ix >> 12 ) != field )
+    {
+      field = ix >> 12;
+      punchObject( as, ( field << 3 ) | 00300 );
+      as->checksum -= ( field << 3 ) | 00300;   /* Not added to checksum.     */
+    }
+    if(( ix & 07777 ) == 0 || !as->loaded[ix - 1] )
+    {
+      punchOrigin( as, ix & 07777 );
+    }
+    punchLocObject( as, 0, as->image[ix] );
+  }
+  punchChecksum( as );
+  punchLeader( as, 1 );
+  as->compact = TRUE;
+
+  listFormat( as, "\n      %ld tape characters, %ld saved\n",
+           as->tape_length, streamed - as->tape_length );
+  if( !as->in_memory && !as->batch )
+  {
+    fprintf( stderr, "      %ld tape characters, %ld saved\n",
+             as->tape_length, streamed - as->tape_length );
+  }
+} /* punchImage()                                                             */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchLeader                                                    */
+/*                                                                            */
+/*  Synopsis:  Generate 2 feet of leader on object file, as per DEC           */
+/*             documentation.  Paper tape has 10 punches per inch.            */
+/*                                                                            */
+/******************************************************************************/
+void punchLeader( ASM_T *as, int count )
+{
+  int ix;
+
+  /* If value is zero, set to the default of 2 feet of leader.                */
+  count = ( count == 0 ) ? 240 : count;
+
+  if( as->objectfile != NULL )
+  {
+    for( ix = 0; ix < count && !as->compact; ix++ )
+    {
+      if( as->tape_count == TAPE_BUFFER )
+      {
+        flushTape( as );
+      }
+      as->tape[as->tape_count++] = 0200;
+    }
+    as->tape_length += count;
+  }
+} /* punchLeader()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchOrigin                                                    */
+/*                                                                            */
+/*  Synopsis:  Output an origin to the object file.                           */
+/*                                                                            */
+/******************************************************************************/
+void punchOrigin( ASM_T *as, WORD16 loc )
+{
+  punchObject( as, (( loc >> 6 ) & 0077 ) | 0100 );
+  punchObject( as, loc & 0077 );
+} /* punchOrigin()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchObject                                                    */
+/*                                                                            */
+/*  Synopsis:  Put one character to object file and include it in checksum.   */
+/*                                                                            */
+/******************************************************************************/
+void punchObject( ASM_T *as, WORD16 val )
+{
+  val &= 0377;
+  if( as->objectfile != NULL )
+  {
+    if( !as->compact )
+    {
+      if( as->tape_count == TAPE_BUFFER )
+      {
+        flushTape( as );
+      }
+      as->tape[as->tape_count++] = val;
+    }
+    as->tape_length++;
+  }
+  as->checksum += val;
+  as->binary_data_output = TRUE;
+} /* punchObject()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchOutObject                                                 */
+/*                                                                            */
+/*  Synopsis:  Output the current line and then then punch value to the       */
+/*             object file.                                                   */
+/*                                                                            */
+/******************************************************************************/
+void punchOutObject( ASM_T *as, WORD16 loc, WORD16 val )
+{
+  as->fixup_list_rec = -1;
+  printLine( as, as->line, ( as->field | loc ), val, LINE_LOC_VAL );
+  punchLocObject( as, loc, val );
+  loadWord( as, ( as->field | loc ), val );
+  if( as->fixup_field >= 0 )
+  {
+    addFixup( as, val );
+  }
+} /* punchOutObject()                                                         */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchZeroBlock                                                 */
+/*                                                                            */
+/*  Synopsis:  Punch count zero words from the current location on, for       */
+/*             ZBLOCK, all at once.  Only the first and the last word are     */
+/*             listed.  A literal collision is reported at the first word     */
+/*             that collides, as incrementClc() would for each word.          */
+/*                                                                            */
+/******************************************************************************/
+void punchZeroBlock( ASM_T *as, WORD16 count )
+{
+  int     end;
+  int     first;
+  int     left;
+  int     length;
+  int     loc;
+  int     next;
+  int     pool;
+
+  first = as->clc;
+  end = first + count;
+
+  /* In each page the block runs into the literals, if at all, at the         */
+  /* start of the page's literals or at the start of the block.               */
+  for( loc = first; loc < end; loc = next )
+  {
+    next = ( loc | 00177 ) + 1;
+    next = ( next < end ) ? next : end;
+    pool = ( loc & ~00177 ) | ((( loc & 07600 ) == 0 ) ? as->pz.loc
+                                                        : as->cp.loc );
+    if( pool < next )
+    {
+      as->clc = ( pool > loc ) ? pool : loc;
+      testForLiteralCollision( as, as->clc );
+    }
+  }
+
+  printLine( as, as->line, ( as->field | first ), 0, LINE_LOC_VAL );
+  if( count > 1 )
+  {
+    printLine( as, as->line, ( as->field | ( end - 1 )), 0, LOC_VAL );
+  }
+
+  if( as->rim_mode )
+  {
+    for( loc = first; loc < end; loc++ )
+    {
+      punchLocObject( as, loc, 0 );
+    }
+  }
+  else
+  {
+    as->binary_data_output = TRUE;  /* Zeros add nothing to the checksum.     */
+    if( as->objectfile != NULL )
+    {
+      as->tape_length += 2 * count;
+      for( left = 2 * count; left > 0 && !as->compact; left -= length )
+      {
+        if( as->tape_count == TAPE_BUFFER )
+        {
+          flushTape( as );
+        }
+        length = TAPE_BUFFER - as->tape_count;
+        length = ( length < left ) ? length : left;
+        memset( &as->tape[as->tape_count], 0, length );
+        as->tape_count += length;
+      }
+    }
+  }
+
+  if( as->loaded != NULL && as->objectfile != NULL )
+  {
+    loc = ( as->field | first ) & ( PALBART_IMAGE_SIZE - 1 );
+    memset( &as->image[loc], 0, sizeof( WORD16 ) * count );
+    memset( &as->loaded[loc], TRUE, count );
+  }
+
+  /* Incrementing the location counter is not to change field setting.        */
+  as->clc = ( first & 070000 ) + ( end & 07777 );
+  as->fieldlc = as->clc & 07777;
+} /* punchZeroBlock()                                                         */
 
-  delimiter = line[lexterm];
-  fltg = &fltg_ac;
-  fltg->exponent = 0;
-  fltg->mantissa = 0;
-  input_value = 0;
-  negate = FALSE;
-  negate_exponent = FALSE;
-  next_state = 0;
-  exponent = 0;
-  right_digits = 0;
-  current_state = 0;
 
-  while( TRUE )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  addFixup                                                       */
+/*                                                                            */
+/*  Synopsis:  Remember where the value val, just listed and punched for the  */
+/*             field fixup_field, went, so fixupOnePass() can patch it.       */
+/*                                                                            */
+/******************************************************************************/
+void addFixup( ASM_T *as, WORD16 val )
+{
+  FIXUP_T *fx;
+
+  as->fixups = (FIXUP_T *) growTable( as->fixups, &as->fixup_room,
+                                      sizeof( FIXUP_T ), as->fixup_count + 1 );
+  fx = &as->fixups[as->fixup_count++];
+  fx->expr = as->fixup_field;
+  fx->clc = as->clc;
+  fx->fieldlc = as->fieldlc;
+  fx->reloc = as->reloc;
+  fx->val = val;
+  fx->list_rec = ( as->listfile != NULL ) ? as->fixup_list_rec : -1;
+  if( as->objectfile == NULL )
   {
-    /* Classify character.  This is the column index.                         */
-    switch( line[lexstart] )
-    {
-    case '+':
-      current_col = 0;
-      break;
+    fx->object_pos = -1;
+  }
+  else
+  {
+    fx->object_pos = ( as->compact ? as->tape_length
+                       : ftell( as->objectfile ) + as->tape_count ) - 2;
+  }
+  fx->loc = as->field | as->clc;
+  as->fixup_field = -1;
 
-    case '-':
-      current_col = 1;
-      break;
+  if(( as->listfile != NULL && fx->list_rec < 0 ) ||
+     ( as->objectfile != NULL && fx->object_pos < 0 ))
+  {
+    failOnePass( as );              /* Output that cannot be patched.         */
+  }
+} /* addFixup()                                                               */
 
-    case '.':
-      current_col = 3;
-      break;
 
-    case 'E':  case 'e':
-      current_col = 4;
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  fixupOnePass                                                   */
+/*                                                                            */
+/*  Synopsis:  Evaluate the values with forward references again, now that    */
+/*             the symbols are defined, and patch the ones that changed into  */
+/*             the listing, the object file and the checksum.  Gives up the   */
+/*             single pass assembly if a value would come out differently in  */
+/*             pass 2 than just by patching it.                               */
+/*                                                                            */
+/******************************************************************************/
+void fixupOnePass( ASM_T *as )
+{
+  FIXUP_T *fx;
+  WORD16   val;
 
-    default:
-      if( isdigit( line[lexstart] ))
-      {
-        current_col = 2;
-      }
-      else if( isdone( line[lexstart] ))
+  flushTape( as );
+  for( fx = as->fixups;
+       as->one_pass && fx < as->fixups + as->fixup_count; fx++ )
+  {
+    as->clc = fx->clc;
+    as->fieldlc = fx->fieldlc;
+    as->reloc = fx->reloc;
+    as->indirect_generated = FALSE;
+    val = runCodedExprs( as, &as->coded[fx->expr] ) & 07777;
+    if( as->indirect_generated )
+    {
+      failOnePass( as );            /* Pass 2 would add an off page literal.  */
+    }
+    else if( as->one_pass && val != fx->val )
+    {
+      if( fx->list_rec >= 0 )
       {
-        current_col = 5;
+        as->listrecs[fx->list_rec].val = val;
       }
-      else
+      if( fx->object_pos >= 0 )
       {
-        current_col = 6;
+        if( !as->compact )
+        {
+          fseek( as->objectsave, fx->object_pos, SEEK_SET );
+          fputc(( val >> 6 ) & 0077, as->objectsave );
+          fputc( val & 0077, as->objectsave );
+        }
+        if( as->loaded != NULL )
+        {
+          as->image[fx->loc & ( PALBART_IMAGE_SIZE - 1 )] = val;
+        }
       }
-      break;
+      as->checksum += (( val >> 6 ) & 0077 ) + ( val & 0077 )
+                - (( fx->val >> 6 ) & 0077 ) - ( fx->val & 0077 );
     }
+  }
 
-    next_state = state_table[current_state][current_col];
+  if( as->one_pass )
+  {
+    fseek( as->objectsave, 0L, SEEK_END );
+  }
+} /* fixupOnePass()                                                           */
 
-    switch( next_state )
-    {
-    case 1:                             /*  -                                 */
-      negate = TRUE;
-    case 2:                             /*  +                                 */
-      delimiter = line[lexterm];        /* Move past the + or - character.    */
-      nextLexBlank();
-      break;
 
-    case 3:                             /* Number  (+-ddd)                    */
-      input_value = evalDubl( 0 );      /* Integer part of the number.        */
-      nextLexeme();                     /* Move past previous lexeme.         */
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  failOnePass                                                    */
+/*                                                                            */
+/*  Synopsis:  Give up a single pass assembly, if one is going on.  Its output*/
+/*             is thrown away, the pass goes on as pass 1, and pass 2 follows.*/
+/*                                                                            */
+/******************************************************************************/
+void failOnePass( ASM_T *as )
+{
+  if( !as->one_pass )
+  {
+    return;
+  }
+  as->one_pass = FALSE;
+  as->tape_count = 0;
+  as->listout_count = 0;
+  as->listrec_count = 0;
+  as->listtitle_count = 0;
+  fclose( as->objectsave );
+  fclose(( as->listfile != NULL ) ? as->listfile : as->listsave );
+  as->objectfile = NULL;
+  as->objectsave = NULL;
+  as->listfile = NULL;
+  as->listsave = NULL;
+  as->fixup_count = 0;
+  as->fixup_field = -1;
+} /* failOnePass()                                                            */
 
-    case 4:
-      delimiter = line[lexterm];
-      nextLexBlank();                   /* Move past the . character.         */
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchLocObject                                                 */
+/*                                                                            */
+/*  Synopsis:  Output the word (with origin if rim format) to the object file.*/
+/*                                                                            */
+/******************************************************************************/
+void punchLocObject( ASM_T *as, WORD16 loc, WORD16 val )
+{
+  if( as->rim_mode )
+  {
+    punchOrigin( as, loc );
+  }
+  punchObject( as, ( val >> 6 ) & 0077 );
+  punchObject( as, val & 0077 );
+} /* punchLocObject()                                                         */
 
-    case 5:                             /* .  (+-ddd.ddd)                     */
-                                        /* Fractional part of the number.     */
-      input_value = evalDubl( input_value );
-      right_digits = lexterm - lexstart;/* Digit count to right of decimal.   */
-      nextLexeme();                     /* Move past previous lexeme.         */
-      break;
 
-    case 6:                             /* E  (+-ddd.dddE)                    */
-      delimiter = line[lexterm];        /* Move past the E.                   */
-      nextLexBlank();
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  loadWord                                                       */
+/*                                                                            */
+/*  Synopsis:  Put a word just punched into the memory image of an assembly   */
+/*             in memory, at the address the object loads it at.              */
+/*                                                                            */
+/******************************************************************************/
+void loadWord( ASM_T *as, WORD16 loc, WORD16 val )
+{
+  if( as->loaded != NULL && as->objectfile != NULL )
+  {
+    loc &= PALBART_IMAGE_SIZE - 1;
+    as->image[loc] = val & 07777;
+    as->loaded[loc] = TRUE;
+  }
+} /* loadWord()                                                               */
 
-    case 7:                             /* -  (+-ddd.dddE-)                   */
-      negate_exponent = TRUE;
-    case 8:                             /* +  (+-ddd.dddE+)                   */
-      delimiter = line[lexterm];        /* Move past the + or - character.    */
-      nextLexBlank();
-      break;
 
-    case 9:                             /* #  (+-ddd.dddE+-dd)                */
-      exponent = (int)evalDubl( 0 );    /* Exponent of floating point number. */
-      if( negate_exponent ) { exponent = - exponent; }
-      nextLexeme();                     /* Move past previous lexeme.         */
-      break;
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  punchLiteralPool                                               */
+/*                                                                            */
+/*  Synopsis:  Output the current page data.                                  */
+/*                                                                            */
+/******************************************************************************/
+void punchLiteralPool( ASM_T *as, LPOOL_T *p, WORD16 lpool_page )
+{
+  WORD16  loc;
+  WORD16  tmplc;
 
-    case 10:                            /* Floating number parsed, convert    */
-                                        /* the number.                        */
-      /* Get the exponent for the number as input.                            */
-      exponent -= right_digits;
+  lpool_page &= 07600;
 
-      /* Remove trailing zeros and adjust the exponent accordingly.           */
-      while(( input_value % 10 ) == 0 )
-      {
-        input_value /= 10;
-        exponent++;
-      }
+  if( p->loc < 00200 )
+  {
+    if( !as->rim_mode )
+    {
+      /* Put out origin if not in rim mode.                                   */
+      punchOrigin( as, p->loc | lpool_page );
+    }
+    /* Put the literals in the object file.                                    */
+    for( loc = p->loc; loc < 00200; loc++ )
+    {
+      tmplc = loc + lpool_page;
+      printLine( as, as->line, (as->field | tmplc), p->pool[loc], LOC_VAL );
+      punchLocObject( as, tmplc, p->pool[loc] );
+      loadWord( as, (as->field | tmplc), p->pool[loc] );
+    }
+    p->error = FALSE;
+    p->loc = 00200;
+  }
+} /* punchLiteralPool()                                                       */
 
-      /* Convert the number to floating point.  The number is calculated with */
-      /* a 27 bit mantissa to improve precision.  The extra 3 bits are        */
-      /* discarded after the result has been calculated.                      */
-      fltg->exponent = 26;
-      fltg->mantissa = input_value << 3;
-      normalizeFltg( fltg );
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  insertLiteral                                                  */
+/*                                                                            */
+/*  Synopsis:  Add a value to the given literal pool if not already in pool.  */
+/*             Return the location of the value in the pool.                  */
+/*                                                                            */
+/******************************************************************************/
+WORD16 insertLiteral( ASM_T *as, LPOOL_T *pool, WORD16 value )
+{
+  WORD16  ix;
+  LPOOL_T *p;
 
-      while( exponent != 0 )
-      {
-        if( exponent < 0 )
-        {
-          /* Decimal point is to the left. */
-          fltg->mantissa /= 10;
-          normalizeFltg( fltg );
-          exponent++;
-        }
-        else if( exponent > 0 )
-        {
-          /* Decimal point is to the right. */
-          fltg->mantissa *= 10;
-          normalizeFltg( fltg );
-          exponent--;
-        }
-      }
+  p = pool;
 
-      /* Discard the extra precsion used for calculating the number.          */
-      fltg->mantissa >>= 3;
-      fltg->exponent -= 3;
-      if( negate )
-      {
-        fltg->mantissa = (- fltg->mantissa ) & 077777777L;
-      }
-      return( fltg );
+  /* If page zero is the current page, make sure that literals are inserted   */
+  /* in the page zero literal table.                                          */
+  if(( as->clc & 07600 ) == 0 )
+  {
+     p = &as->pz;
+  }
 
-    case 11:                            /* Error in format.                   */
-      /* Not a properly constructued floating point number.                   */
-      return( fltg );
-    default:
-      break;
-    }
-    /* Set state for next pass through the loop.                              */
-    current_state = next_state;
+  /* Look for the value in the literal pool.  Each value is in it only once.  */
+  ix = p->slot[value & 07777];
+  if( ix >= p->loc && p->pool[ix] == value )
+  {
+    return( ix );
   }
-} /* evalFltg()                                                               */
 
+  /* Not found, so insert the value.  A full pool leaves no room on the page  */
+  /* for the code using it, which is reported as a literal overflow.          */
+  if( p->loc > 0 )
+  {
+    (p->loc)--;
+    p->pool[p->loc] = value;
+    p->slot[value & 07777] = (BYTE) p->loc;
+  }
+  return( p->loc );
+} /* insertLiteral()                                                          */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  normalizeFltg                                                  */
+/*  Function:  printReports                                                   */
 /*                                                                            */
-/*  Synopsis:  Normalize a PDP-8 double precision floating point number.      */
+/*  Synopsis:  Output the symbol table, the permanent symbol table and the    */
+/*             cross reference asked for.  When there is more than one, the   */
+/*             permanent symbol table and the cross reference are each made   */
+/*             on a thread of their own while this one lists the symbol       */
+/*             table, and the cross reference then follows it in the listing. */
 /*                                                                            */
 /******************************************************************************/
-void normalizeFltg( FLTG_T *fltg )
+void printReports( ASM_T *as, BOOL listing )
 {
-  /* Normalize the floating point number.                                     */
-  if( fltg->mantissa != 0 )
+  int      count;
+  REPORT_T perm;
+  REPORT_T xref;
+
+  count = 0;
+  count += ( as->symtab_print && listing ) ? 1 : 0;
+  count += ( as->print_permanent_symbols ) ? 1 : 0;
+  count += ( as->xref && listing ) ? 1 : 0;
+
+  perm.threaded = FALSE;
+  xref.threaded = FALSE;
+  if( count > 1 && as->print_permanent_symbols )
   {
-    if(( fltg->mantissa & ~0x3FFFFFFL ) == 0 )
-    {
-      while(( fltg->mantissa & ~0x1FFFFFFL ) == 0 )
+    startReport( as, &perm, printPermanentSymbolTable, 0 );
+  }
+  if( count > 1 && as->xref && listing )
+  {
+    /* The cross reference starts on the page after the symbol table.         */
+    startReport( as, &xref, printCrossReference,
+                 ( as->symtab_print ) ? symbolTablePages( as ) : 0 );
+  }
 
-      {
-        fltg->mantissa <<= 1;
-        fltg->exponent--;
-      }
-    }
-    else
+  if( as->symtab_print && listing )
+  {
+    printSymbolTable( as );
+  }
+
+  if( as->print_permanent_symbols )
+  {
+    finishReport( as, &perm, printPermanentSymbolTable );
+  }
+
+  if( as->xref && listing )
+  {
+    finishReport( as, &xref, printCrossReference );
+  }
+} /* printReports()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  startReport                                                    */
+/*                                                                            */
+/*  Synopsis:  Start making a report on a thread of its own, listed after     */
+/*             pages more pages.  If that cannot be done, it is left to be    */
+/*             made by finishReport() on this thread.                         */
+/*                                                                            */
+/******************************************************************************/
+void startReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ),
+                  int pages )
+{
+  rep->as = *as;
+  rep->print = print;
+  rep->text = NULL;
+  rep->length = 0;
+  rep->as.list_pageno += pages;
+  rep->as.listout_count = 0;
+  rep->as.listout = (char *) malloc( LIST_BUFFER );
+  rep->as.listfile = NULL;
+  if( rep->as.listout != NULL )
+  {
+    rep->as.listfile = open_memstream( &rep->text, &rep->length );
+  }
+  rep->as.listsave = rep->as.listfile;
+
+  rep->threaded = rep->as.listfile != NULL
+               && pthread_create( &rep->thread, NULL, reportWorker, rep ) == 0;
+  if( !rep->threaded )
+  {
+    if( rep->as.listfile != NULL )
     {
-      while(( fltg->mantissa & ~0x3FFFFFFL ) != 0 )
-      {
-        fltg->mantissa >>= 1;
-        fltg->exponent++;
-      }
+      fclose( rep->as.listfile );
     }
+    free( rep->text );
+    free( rep->as.listout );
   }
-  else
+} /* startReport()                                                            */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  reportWorker                                                   */
+/*                                                                            */
+/*  Synopsis:  Make a report started by startReport().                        */
+/*                                                                            */
+/******************************************************************************/
+void *reportWorker( void *arg )
+{
+  REPORT_T *rep;
+
+  rep = (REPORT_T *) arg;
+  rep->print( &rep->as );
+  flushList( &rep->as );
+  return( NULL );
+} /* reportWorker()                                                           */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  finishReport                                                   */
+/*                                                                            */
+/*  Synopsis:  Wait for a report started by startReport() and add what it     */
+/*             listed to the listing, or make it now if it was not started.   */
+/*                                                                            */
+/******************************************************************************/
+void finishReport( ASM_T *as, REPORT_T *rep, void (*print)( ASM_T *as ))
+{
+  if( !rep->threaded )
   {
-    fltg->exponent = 0;
+    print( as );
+    return;
   }
-  return;
-}
+  pthread_join( rep->thread, NULL );
+  fclose( rep->as.listfile );
+  listChars( as, rep->text, (int) rep->length );
+  free( rep->text );
+  free( rep->as.listout );
+} /* finishReport()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  incrementClc                                                   */
+/*  Function:  symbolTablePages                                               */
 /*                                                                            */
-/*  Synopsis:  Set the next assembly location.  Test for collision with       */
-/*             the literal tables.                                            */
+/*  Synopsis:  Return the number of pages printSymbolTable() lists.           */
 /*                                                                            */
 /******************************************************************************/
-WORD16 incrementClc()
+int symbolTablePages( ASM_T *as )
 {
-  testForLiteralCollision( clc );
+  int    per_page;
 
-  /* Incrementing the location counter is not to change field setting.        */
-  clc = ( clc & 070000 ) + (( clc + 1 ) & 07777 );
-  fieldlc = clc & 07777;
-  return( clc );
-} /* incrementClc()                                                           */
+  /* A page has SYMBOL_COLUMNS columns of symbols below its 5 line header.    */
+  per_page = SYMBOL_COLUMNS * ( LIST_LINES_PER_PAGE - 5 );
+  return(( as->symbol_top - as->number_of_fixed_symbols + per_page - 1 )
+         / per_page );
+} /* symbolTablePages()                                                       */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  testForLiteralCollision                                        */
+/*  Function:  printSymbolTable                                               */
 /*                                                                            */
-/*  Synopsis:  Test the given location for collision with the literal tables. */
+/*  Synopsis:  Output the symbol table.                                       */
 /*                                                                            */
 /******************************************************************************/
-BOOL testForLiteralCollision( WORD16 loc )
+void printSymbolTable( ASM_T *as )
 {
-  WORD16  pagelc;
-  BOOL    result = FALSE;
-  WORD16  tmppage;
+  int    col;
+  int    cx;
+  int    ix;
+  char   mark;
+  char   name[SYMLEN];
+  int    page;
+  int    row;
+  SYM_T **sorted;
+  int    symbol_base;
+  int    symbol_end;
+  int    symbol_lines;
 
-  tmppage = loc & 07600;
-  pagelc  = loc & 00177;
+  sorted = sortSymbolTable( as, &symbol_base );
+  symbol_end = symbol_base + as->symbol_top - as->number_of_fixed_symbols;
 
-  if( tmppage == 0 )
-  {
-    if( pagelc >= pz.loc && !pz.error )
-    {
-      errorMessage( &pz_literal_overflow, -1 );
-      pz.error = TRUE;
-      result = TRUE;
-    }
-  }
-  else
+  for( page=0, as->list_lineno=0, col=0, ix=symbol_base; ix < symbol_end;
+       page++ )
   {
-    if( pagelc >= cp.loc && !cp.error )
+    topOfForm( as, as->list_title, s_symtable );
+    symbol_lines = LIST_LINES_PER_PAGE - as->page_lineno;
+
+    for( row = 0; as->page_lineno < LIST_LINES_PER_PAGE && ix < symbol_end;
+         row++)
     {
-      errorMessage( &literal_overflow, -1 );
-      cp.error = TRUE;
-      result = TRUE;
+      as->list_lineno++;
+      as->page_lineno++;
+      listDecimal( as, as->list_lineno, 5 );
+
+      for( col = 0; col < SYMBOL_COLUMNS && ix < symbol_end; col++ )
+      {
+        /* Get index of symbol for the current line and column                         */
+        cx = symbol_lines * ( SYMBOL_COLUMNS * page + col ) + row;
+        cx += symbol_base;
+
+        /* Make sure that there is a symbol to be printed.                    */
+        if( symbol_base <= cx && cx < symbol_end )
+        {
+          switch( sorted[cx]->type & ( DEFINED | REDEFINED ))
+          {
+          case UNDEFINED:
+            mark = '?';
+            break;
+
+          case REDEFINED:
+            mark = '#';
+            break;
+
+          default:
+            mark = ' ';
+            break;
+          }
+          listSpaces( as, 1 );
+          listChars( as, &mark, 1 );
+          listField( as, keyToName( name, sorted[cx]->key ), 6 );
+          if(( sorted[cx]->type & LABEL ) == LABEL )
+          {
+            listSpaces( as, 1 );
+            listOctal( as, sorted[cx]->val, 5 );
+          }
+          else
+          {
+            listSpaces( as, 2 );
+            listOctal( as, sorted[cx]->val, 4 );
+          }
+          listSpaces( as, 1 );
+          ix++;
+        }
+      }
+      listChars( as, "\n", 1 );
     }
   }
-  return( result );
-} /* testForLiteralCollision()                                                */
+  free( sorted );
+} /* printSymbolTable()                                                       */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  readLine                                                       */
+/*  Function:  printPermanentSymbolTable                                      */
 /*                                                                            */
-/*  Synopsis:  Get next line of input.  Print previous line if needed.        */
+/*  Synopsis:  Output the permanent symbol table to a file suitable for       */
+/*             being input after the EXPUNGE pseudo-op.                       */
 /*                                                                            */
 /******************************************************************************/
-void readLine()
+void printPermanentSymbolTable( ASM_T *as )
 {
-  WORD16  ix;
-  WORD16  iy;
-  char   inpline[LINELEN];
-
-  listLine();                   /* List previous line if needed.              */
-  lineno++;                     /* Count lines read.                          */
-  indirect_generated = FALSE;   /* Mark no indirect address generated.        */
-  listed = FALSE;               /* Mark as not listed.                        */
-  cc = 0;                       /* Initialize column counter.                 */
-  lexstartprev = 0;
+  int     fixed_count;
+  int     ix;
+  char    name[SYMLEN];
+  FILE   *permfile;
+  char  *s_type;
+  SYM_T **sorted;
 
-  if(( fgets( inpline, LINELEN - 1, infile )) == NULL )
+  if(( permfile = fopen( as->permpathname, "w" )) == NULL )
   {
-    inpline[0] = '$';
-    inpline[1] = '\n';
-    inpline[2] = '\0';
-    error_in_line = TRUE;
+    exit( 2 );
   }
-  else
+  sorted = sortSymbolTable( as, &fixed_count );
+
+  fprintf( permfile, "/ PERMANENT SYMBOL TABLE\n/\n" );
+  fprintf( permfile, "        EXPUNGE\n/\n" );
+  /* Print the memory reference instructions first.                           */
+  s_type = "FIXMRI";
+  for( ix = 0; sorted[ix] != NULL; ix++ )
   {
-    error_in_line = FALSE;
+    if( M_MRI( sorted[ix]->type ))
+    {
+      fprintf( permfile, "%-7s %s=%4.4o\n", s_type,
+                        keyToName( name, sorted[ix]->key ), sorted[ix]->val );
+    }
   }
 
-  /* Remove any tabs from the input line by inserting the required number     */
-  /* of spaces to simulate 8 character tab stops.                             */
-  for( ix = 0, iy = 0; inpline[ix] != '\0'; ix++ )
+  s_type = " ";
+  for( ix = 0; sorted[ix] != NULL; ix++ )
   {
-    switch( inpline[ix] )
+    if( M_FIXED( sorted[ix]->type ))
     {
-    case '\t':
-      do
+      if( !M_MRI( sorted[ix]->type ) && !M_PSEUDO( sorted[ix]->type ))
       {
-        line[iy] = ' ';
-        iy++;
+        fprintf( permfile, "%-7s %s=%4.4o\n", s_type,
+                        keyToName( name, sorted[ix]->key ), sorted[ix]->val );
       }
-      while(( iy % 8 ) != 0 );
-      break;
-
-    default:
-      line[iy] = inpline[ix];
-      iy++;
-      break;
     }
   }
-  line[iy] = '\0';
-
-  /* If the line is terminated by CR-LF, remove, the CR.                      */
-  if( line[iy - 2] == '\r' )
-  {
-    iy--;
-    line[iy - 1] = line[iy - 0];
-    line[iy] = '\0';
-  }
-  maxcc = iy;                   /* Save the current line length.              */
-
-  /* Save the first line for possible use as the listing title.               */
-  if( lineno == 1 )
-  {
-    strcpy( list_title, line );
-  }
-} /* readLine()                                                               */
+  fprintf( permfile, "/\n        FIXTAB\n" );
+  fclose( permfile );
+  free( sorted );
+} /* printPermanentSymbolTable()                                              */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  listLine                                                       */
+/*  Function:  writePermanentSnapshot                                         */
 /*                                                                            */
-/*  Synopsis:  Output a line to the listing file.                             */
+/*  Synopsis:  Write the permanent symbols, already hashed and in name order, */
+/*             to a snapshot file that the -u option can map back in.         */
 /*                                                                            */
 /******************************************************************************/
-void listLine()
-/* generate a line of listing if not already done!                            */
+void writePermanentSnapshot( ASM_T *as )
 {
-  if( listfile != NULL && listed == FALSE )
+  int        fixed_count;
+  PERMHDR_T  hdr;
+  int        ix;
+  FILE      *snapfile;
+  SYM_T    **sorted;
+
+  if(( snapfile = fopen( as->snappathname, "wb" )) == NULL )
   {
-    printLine( line, 0, 0, LINE );
+    fprintf( stderr, "Cannot open \"%s\".\n", as->snappathname );
+    exit( 2 );
   }
-} /* listLine()                                                               */
+
+  /* The fixed symbols come first in the sorted table.  This is the end of    */
+  /* the assembly, so they can simply become the permanent symbol table.      */
+  sorted = sortSymbolTable( as, &fixed_count );
+  if( !hashPermanentSymbols( as, sorted, fixed_count ))
+  {
+    fprintf( stderr, "No perfect hash found for the permanent symbols.\n" );
+    exit( 2 );
+  }
+  free( sorted );
+
+  memset( &hdr, 0, sizeof( hdr ));
+  memcpy( hdr.magic, PERMSNAP_MAGIC, sizeof( hdr.magic ));
+  hdr.sym_size = sizeof( SYM_T );
+  hdr.buckets = as->permtab_buckets;
+  hdr.count = as->permtab_count;
+  hdr.size = as->permtab_size;
+
+  fwrite( &hdr, sizeof( hdr ), 1, snapfile );
+  for( ix = sizeof( hdr ); ix < PERMSNAP_TABLE; ix++ )
+  {
+    putc( 0, snapfile );
+  }
+  fwrite( as->permtab, sizeof( SYM_T ), as->permtab_size, snapfile );
+  fwrite( as->permtab_disp, sizeof( int ), as->permtab_buckets, snapfile );
+  fwrite( as->permtab_order, sizeof( int ), as->permtab_count, snapfile );
+
+  if( ferror( snapfile ))
+  {
+    fprintf( stderr, "Error writing \"%s\".\n", as->snappathname );
+    exit( 2 );
+  }
+  fclose( snapfile );
+} /* writePermanentSnapshot()                                                 */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printPageBreak                                                 */
+/*  Function:  loadPermanentSnapshot                                          */
 /*                                                                            */
-/*  Synopsis:  Output a Top of Form and listing header if new page necessary. */
+/*  Synopsis:  Map a snapshot written by writePermanentSnapshot() and use it  */
+/*             as the permanent symbol table in place of the built-in one.    */
+/*             The mapping is private, so symbols may still be redefined.     */
 /*                                                                            */
 /******************************************************************************/
-void printPageBreak()
+void loadPermanentSnapshot( ASM_T *as, char *path )
 {
-  if( page_lineno >= LIST_LINES_PER_PAGE )
-         /*  ( list_lineno % LIST_LINES_PER_PAGE ) == 0 ) */
+  char       *base;
+  int         fd;
+  PERMHDR_T  *hdr;
+  int         ix;
+  int        *order;
+  long        length;
+  struct stat st;
+  BOOL        valid;
+
+  if(( fd = open( path, O_RDONLY )) < 0 )
   {
-    if( !list_title_set )
-    {
-      /* strcpy( list_title, line ); */
-      if( list_title[strlen(list_title) - 1] == '\n' )
-      {
-        list_title[strlen(list_title) - 1] = '\0';
-      }
-      if( strlen( list_title ) > TITLELEN )
-      {
-        list_title[TITLELEN] = '\0';
-      }
-      list_title_set = TRUE;
-    }
-    topOfForm( list_title, NULL );
+    fprintf( stderr, "Cannot open \"%s\".\n", path );
+    exit( -1 );
+  }
+  base = (char *) MAP_FAILED;
+  valid = ( fstat( fd, &st ) == 0 && (long) st.st_size >= PERMSNAP_TABLE );
+  if( valid )
+  {
+    base = (char *) mmap( NULL, st.st_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0 );
+  }
+  close( fd );
+  if( valid && base == (char *) MAP_FAILED )
+  {
+    fprintf( stderr, "Cannot map \"%s\".\n", path );
+    exit( -1 );
+  }
+
+  /* Check the header against this build before trusting any of it.          */
+  length = valid ? (long) st.st_size : 0;
+  hdr = (PERMHDR_T *) base;
+  valid = valid
+       && memcmp( hdr->magic, PERMSNAP_MAGIC, sizeof( hdr->magic )) == 0
+       && hdr->sym_size == sizeof( SYM_T )
+       && hdr->size > 0 && ( hdr->size & ( hdr->size - 1 )) == 0
+       && hdr->size <= length / (long) sizeof( SYM_T )
+       && hdr->buckets > 0 && ( hdr->buckets & ( hdr->buckets - 1 )) == 0
+       && hdr->buckets <= length / (long) sizeof( int )
+       && hdr->count >= 0 && hdr->count <= hdr->size
+       && length == PERMSNAP_TABLE + hdr->size * (long) sizeof( SYM_T )
+                  + ( hdr->buckets + hdr->count ) * (long) sizeof( int );
+
+  order = valid ? (int *) ( base + length ) - hdr->count : NULL;
+  for( ix = 0; valid && ix < hdr->count; ix++ )
+  {
+    valid = order[ix] >= 0 && order[ix] < hdr->size;
+  }
+  if( !valid )
+  {
+    fprintf( stderr, "\"%s\" is not a permanent symbol snapshot for this "
+                     "assembler.\n", path );
+    exit( -1 );
   }
-} /* printPageBreak()                                                         */
+
+  as->snapbase = base;
+  as->snapsize = length;
+  as->permtab = (SYM_T *) ( base + PERMSNAP_TABLE );
+  as->permtab_disp = (int *) ( as->permtab + hdr->size );
+  as->permtab_order = order;
+  as->permtab_buckets = hdr->buckets;
+  as->permtab_count = hdr->count;
+  as->permtab_size = hdr->size;
+} /* loadPermanentSnapshot()                                                  */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printLine                                                      */
+/*  Function:  printCrossReference                                            */
 /*                                                                            */
-/*  Synopsis:  Output a line to the listing file with new page if necessary.  */
+/*  Synopsis:  Output a cross reference (concordance) for the file being      */
+/*             assembled.                                                     */
 /*                                                                            */
 /******************************************************************************/
-void printLine( char *line, WORD16 loc, WORD16 val, LINESTYLE_T linestyle )
+void printCrossReference( ASM_T *as )
 {
-  if( listfile == NULL )
-  {
-    save_error_count = 0;
-    return;
-  }
+  int    block;
+  int    def;
+  int    ix;
+  int    line;
+  char   name[SYMLEN];
+  int    pos;
+  SYM_T **sorted;
+  int    symbol_base;
+  int    xc;
+  int    xc_refcount;
+  int    xc_cols;
 
-  printPageBreak();
+  /* Force top of form for first page.                                        */
+  as->page_lineno = LIST_LINES_PER_PAGE;
+
+  as->list_lineno = 0;
+  sorted = sortSymbolTable( as, &symbol_base );
 
-  list_lineno++;
-  page_lineno++;
-  switch( linestyle )
+  for( ix = symbol_base; sorted[ix] != NULL; ix++ )
   {
-  default:
-  case LINE:
-    fprintf(listfile, "%5d             ", lineno );
-    fputs( line, listfile );
-    listed = TRUE;
-    break;
+    as->list_lineno++;
+    as->page_lineno++;
+    if( as->page_lineno >= LIST_LINES_PER_PAGE )
+    {
+      topOfForm( as, as->list_title, s_xref );
+    }
 
-  case LINE_VAL:
-    fprintf(listfile, "%5d       %4.4o  ", lineno, val );
-    fputs( line, listfile );
-    listed = TRUE;
-    break;
+    listDecimal( as, as->list_lineno, 5 );
 
-  case LINE_LOC_VAL:
-    if( !listed )
+    /* Get reference count & concordance entry for this symbol.               */
+    xc_refcount = sorted[ix]->xref_count;
+    def = 0;
+    block = 0;
+    if( sorted[ix]->xref_index != 0 )
     {
-      if( indirect_generated )
-      {
-        fprintf( listfile, "%5d %5.5o %4.4o@ ", lineno, loc, val );
-      }
-      else
-      {
-        fprintf( listfile, "%5d %5.5o %4.4o  ", lineno, loc, val );
-      }
-      fputs( line, listfile );
-      listed = TRUE;
+      def = as->xrefs[sorted[ix]->xref_index].def;
+      block = as->xrefs[sorted[ix]->xref_index].first;
     }
-    else
+    pos = 0;
+    line = 0;
+    /* Determine how to label symbol on concordance.                          */
+    switch( sorted[ix]->type & ( DEFINED | REDEFINED ))
     {
-      fprintf( listfile, "      %5.5o %4.4o\n", loc, val );
-    }
-    break;
-
-  case LOC_VAL:
-    fprintf( listfile, "      %5.5o %4.4o\n", loc, val );
-    break;
-  }
-  printErrorMessages();
-} /* printLine()                                                              */
+    case UNDEFINED:
+      listChars( as, " U         ", 11 );
+      break;
 
+    case REDEFINED:
+      listChars( as, " M  ", 4 );
+      listDecimal( as, def, 5 );
+      listSpaces( as, 2 );
+      break;
 
-/******************************************************************************/
-/*                                                                            */
-/*  Function:  printErrorMessages                                             */
-/*                                                                            */
-/*  Synopsis:  Output any error messages from the current list of errors.     */
-/*                                                                            */
-/******************************************************************************/
-void printErrorMessages()
-{
-  WORD16  ix;
-  WORD16  iy;
+    default:
+      listChars( as, " A  ", 4 );
+      listDecimal( as, def, 5 );
+      listSpaces( as, 2 );
+      break;
+    }
+    listField( as, keyToName( name, sorted[ix]->key ), 6 );
+    listSpaces( as, 2 );
 
-  if( listfile != NULL )
-  {
-    /* If any errors, display them now.                                       */
-    for( iy = 0; iy < save_error_count; iy++ )
+    /* Output the references, 8 numbers per line after symbol name.           */
+    for( xc_cols = 0, xc = 1; xc < xc_refcount + 1; xc++, xc_cols++ )
     {
-      printPageBreak();
-      fprintf( listfile, "%-18.18s", error_list[iy].mesg );
-      if( error_list[iy].col >= 0 )
+      if( xc_cols >= XREF_COLUMNS )
       {
-        for( ix = 0; ix < error_list[iy].col; ix++ )
+        xc_cols = 0;
+        as->page_lineno++;
+        if( as->page_lineno >= LIST_LINES_PER_PAGE )
         {
-          if( line[ix] == '\t' )
-          {
-            putc( '\t', listfile );
-          }
-          else
-          {
-            putc( ' ', listfile );
-          }
+          topOfForm( as, as->list_title, s_xref);
         }
-        fputs( "^", listfile );
-        list_lineno++;
-        page_lineno++;
+        as->list_lineno++;
+        listChars( as, "\n", 1 );
+        listDecimal( as, as->list_lineno, 5 );
+        listSpaces( as, 19 );
       }
-      fputs( "\n", listfile );
+      line += nextXref( as, &block, &pos );
+      listSpaces( as, 2 );
+      listDecimal( as, line, 5 );
     }
+    listChars( as, "\n", 1 );
   }
-  save_error_count = 0;
-} /* printErrorMessages()                                                     */
+  free( sorted );
+} /* printCrossReference()                                                    */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  endOfBinary                                                    */
+/*  Function:  topOfForm                                                      */
 /*                                                                            */
-/*  Synopsis:  Outputs both literal tables at the end of a binary segment.    */
+/*  Synopsis:  Prints title and sub-title on top of next page of listing.     */
 /*                                                                            */
 /******************************************************************************/
-void endOfBinary()
+void topOfForm( ASM_T *as, char *title, char *sub_title )
 {
-  /* Points to end of page for () operands.                                   */
-  punchLiteralPool( &cp, clc - 1 );
-  /* Points to end of page zero for [] operands.                              */
-  punchLiteralPool( &pz, 0 );
-  if( error_in_line )
+  char temp[sizeof( s_page ) + 12];    /* "Page" and the widest int.          */
+
+  as->list_pageno++;
+  sprintf( temp, "%s %d", s_page, as->list_pageno );
+
+  /* Output a top of form if not the first page of the listing.               */
+  if( as->list_pageno > 1 )
+  {
+    listChars( as, "\f", 1 );
+  }
+  listFormat( as, "\n\n\n      %-63s %10s\n", title, temp );
+
+  /* Reset the current page line counter.                                     */
+  as->page_lineno = 3;
+  if( sub_title != NULL )
   {
-    listed = TRUE;
-    clc = ( clc & 070000 ) + (( clc - 1 ) & 07777 );
-    errorMessage( &end_of_file, -1 );
-    clc = ( clc & 070000 ) + (( clc + 1 ) & 07777 );
+    listFormat( as, "%80s\n", sub_title );
+    as->page_lineno++;
   }
   else
   {
-    listLine();             /* List line if not done yet.                     */
+    listChars( as, "\n", 1 );
+    as->page_lineno++;
   }
-  return;
-} /* endOfBinary()                                                            */
+  listChars( as, "\n", 1 );
+  as->page_lineno++;
+} /* topOfForm()                                                              */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchChecksum                                                  */
+/*  Function:  lexemeToName                                                   */
 /*                                                                            */
-/*  Synopsis:  Output a checksum if the current mode requires it and an       */
-/*             object file exists.                                            */
+/*  Synopsis:  Convert the current lexeme into a string.                      */
 /*                                                                            */
 /******************************************************************************/
-void punchChecksum()
+char *lexemeToName( ASM_T *as, char *name, int from, int term )
 {
-  /* If the assembler has output any BIN data output the checksum.            */
-  if( binary_data_output && !rim_mode )
+  int  to;
+
+  to = 0;
+
+  while( from < term && to < ( SYMLEN - 1 ))
+  {
+    name[to++] = toupper( as->line[from++] );
+  }
+
+  while( to < SYMLEN )
   {
-    punchLocObject( 0, checksum );
+    name[to++] = '\0';
   }
-  binary_data_output = FALSE;
-  checksum = 0;
-} /* punchChecksum()                                                          */
-
+  return( name );
+} /* lexemeToName()                                                           */
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchLeader                                                    */
+/*  Function:  lexemeToKey                                                    */
 /*                                                                            */
-/*  Synopsis:  Generate 2 feet of leader on object file, as per DEC           */
-/*             documentation.  Paper tape has 10 punches per inch.            */
+/*  Synopsis:  Pack the current lexeme into a symbol key straight from the    */
+/*             input line.                                                    */
 /*                                                                            */
 /******************************************************************************/
-void punchLeader( int count )
+SYMKEY lexemeToKey( ASM_T *as, int from, int term )
 {
-  int ix;
-
-  /* If value is zero, set to the default of 2 feet of leader.                */
-  count = ( count == 0 ) ? 240 : count;
+  SYMKEY  key;
+  int     to;
+  int     c;
 
-  if( objectfile != NULL )
+  for( key = 0, to = 0; to < ( SYMLEN - 1 ); to++ )
   {
-    for( ix = 0; ix < count; ix++ )
+    c = ( from < term ) ? toupper( as->line[from++] ) : '\0';
+    key *= SYMKEY_BASE;
+    if( isupper( c ))
     {
-      fputc( 0200, objectfile );
+      key += c - 'A' + 11;
+    }
+    else if( isdigit( c ))
+    {
+      key += c - '0' + 1;
     }
   }
-} /* punchLeader()                                                            */
+  return( key );
+} /* lexemeToKey()                                                            */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchOrigin                                                    */
+/*  Function:  nameToKey                                                      */
 /*                                                                            */
-/*  Synopsis:  Output an origin to the object file.                           */
+/*  Synopsis:  Pack a symbol name string into a symbol key.                   */
 /*                                                                            */
 /******************************************************************************/
-void punchOrigin( WORD16 loc )
+SYMKEY nameToKey( char *name )
 {
-  punchObject((( loc >> 6 ) & 0077 ) | 0100 );
-  punchObject( loc & 0077 );
-} /* punchOrigin()                                                            */
+  SYMKEY  key;
+  int     to;
+  int     c;
 
-
-/******************************************************************************/
-/*                                                                            */
-/*  Function:  punchObject                                                    */
-/*                                                                            */
-/*  Synopsis:  Put one character to object file and include it in checksum.   */
-/*                                                                            */
-/******************************************************************************/
-void punchObject( WORD16 val )
-{
-  val &= 0377;
-  if( objectfile != NULL )
+  for( key = 0, to = 0; to < ( SYMLEN - 1 ); to++ )
   {
-    fputc( val, objectfile );
+    c = ( *name != '\0' ) ? toupper( *name++ ) : '\0';
+    key *= SYMKEY_BASE;
+    if( isupper( c ))
+    {
+      key += c - 'A' + 11;
+    }
+    else if( isdigit( c ))
+    {
+      key += c - '0' + 1;
+    }
   }
-  checksum += val;
-  binary_data_output = TRUE;
-} /* punchObject()                                                            */
+  return( key );
+} /* nameToKey()                                                              */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchOutObject                                                 */
+/*  Function:  keyToName                                                      */
 /*                                                                            */
-/*  Synopsis:  Output the current line and then then punch value to the       */
-/*             object file.                                                   */
+/*  Synopsis:  Convert a symbol key back into a name string.                  */
 /*                                                                            */
 /******************************************************************************/
-void punchOutObject( WORD16 loc, WORD16 val )
+char *keyToName( char *name, SYMKEY key )
 {
-  printLine( line, ( field | loc ), val, LINE_LOC_VAL );
-  punchLocObject( loc, val );
-} /* punchOutObject()                                                         */
+  int     digit;
+  int     to;
+
+  name[SYMLEN - 1] = '\0';
+  for( to = SYMLEN - 2; to >= 0; to-- )
+  {
+    digit = (int) ( key % SYMKEY_BASE );
+    key /= SYMKEY_BASE;
+    if( digit >= 11 )
+    {
+      name[to] = (char) ( 'A' + digit - 11 );
+    }
+    else if( digit >= 1 )
+    {
+      name[to] = (char) ( '0' + digit - 1 );
+    }
+    else
+    {
+      name[to] = '\0';
+    }
+  }
+  return( name );
+} /* keyToName()                                                              */
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchLocObject                                                 */
+/*  Function:  defineLexeme                                                   */
 /*                                                                            */
-/*  Synopsis:  Output the word (with origin if rim format) to the object file.*/
+/*  Synopsis:  Put lexeme into symbol table with a value.                     */
 /*                                                                            */
 /******************************************************************************/
-void punchLocObject( WORD16 loc, WORD16 val )
+SYM_T *defineLexeme( ASM_T  *as,       /* the assembler context.             */
+                     int     start,     /* start of lexeme being defined.     */
+                     int     term,      /* end+1 of lexeme being defined.     */
+                     WORD16  val,       /* value of lexeme being defined.     */
+                     SYMTYP  type )     /* how symbol is being defined.       */
 {
-  if( rim_mode )
-  {
-    punchOrigin( loc );
-  }
-  punchObject(( val >> 6 ) & 0077 );
-  punchObject( val & 0077 );
-} /* punchLocObject()                                                         */
+  return( defineSymbol( as, lexemeToKey( as, start, term ), val, type, start ));
+} /* defineLexeme()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  punchLiteralPool                                               */
+/*  Function:  defineSymbol                                                   */
 /*                                                                            */
-/*  Synopsis:  Output the current page data.                                  */
+/*  Synopsis:  Define a symbol in the symbol table, enter symbol name if not  */
+/*             not already in table.                                          */
 /*                                                                            */
 /******************************************************************************/
-void punchLiteralPool( LPOOL_T *p, WORD16 lpool_page )
+SYM_T *defineSymbol( ASM_T *as, SYMKEY key, WORD16 val, SYMTYP type,
+                     WORD16 start )
 {
-  WORD16  loc;
-  WORD16  tmplc;
+  char    name[SYMLEN];
+  BOOL    redefined;
+  SYM_T  *sym;
 
-  lpool_page &= 07600;
+  if( key == 0 )
+  {
+    return( &as->sym_undefined );   /* Protect against non-existent names.    */
+  }
+  sym = lookup( as, key );
+  if( M_FIXED( sym->type ))
+  {
+      return( sym );            /* Can't modify permanent symbols.            */
+  }
 
-  if( p->loc < 00200 )
+  redefined = FALSE;            /* Set concordance for normal defintion.      */
+
+  if( M_DEFINED( sym->type ))
   {
-    if( !rim_mode )
+    if( as->pass == 2 && sym->val != val )
     {
-      /* Put out origin if not in rim mode.                                   */
-      punchOrigin( p->loc | lpool_page );
+      /* Generate diagnostic if redefining a symbol.                          */
+      if( M_REDEFINED( sym->type ))
+      {
+        errorSymbol( as, &redefined_symbol, keyToName( name, sym->key ),
+                     start );
+      }
+      type = type | REDEFINED;
+      redefined = TRUE;       /* Referenced suymbol, count it.                */
     }
-    /* Put the literals in the object file.                                    */
-    for( loc = p->loc; loc < 00200; loc++ )
+    else if( sym->val != val )
     {
-      tmplc = loc + lpool_page;
-      printLine( line, (field | tmplc), p->pool[loc], LOC_VAL );
-      punchLocObject( tmplc, p->pool[loc] );
+      failOnePass( as );            /* Pass 2 would see it redefined.         */
+    }
+  }
+
+  if( as->pass == 2 && as->xref )
+  {
+    /* Put the definition line number in the concordance table.               */
+    /* Defined symbols are not counted as references, unless redefined.       */
+    xrefEntry( as, sym )->def = as->lineno;
+    if( redefined )
+    {
+      addXref( as, sym, as->lineno );
     }
-    p->error = FALSE;
-    p->loc = 00200;
   }
-} /* punchLiteralPool()                                                       */
+
+  /* Now set the value and the type.                                          */
+  sym->val = ( type == LABEL) ? val : val & 07777;
+  sym->type = ( as->pass == 1 ) ? ( type | CONDITION ) : type;
+  return( sym );
+} /* defineSymbol()                                                           */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  insertLiteral                                                  */
+/*  Function:  lookup                                                         */
 /*                                                                            */
-/*  Synopsis:  Add a value to the given literal pool if not already in pool.  */
-/*             Return the location of the value in the pool.                  */
+/*  Synopsis:  Find a symbol in table.  If not in table, enter symbol in      */
+/*             table as undefined.  Return address of symbol in table.        */
 /*                                                                            */
 /******************************************************************************/
-WORD16 insertLiteral( LPOOL_T *pool, WORD16 value )
+SYM_T *lookup( ASM_T *as, SYMKEY key )
 {
-  WORD16  ix;
-  LPOOL_T *p;
-
-  p = pool;
+  int     hx;                   /* Hash index                                 */
+  SYM_T  *sym;
 
-  /* If page zero is the current page, make sure that literals are inserted   */
-  /* in the page zero literal table.                                          */
-  if(( clc & 07600 ) == 0 )
+  /* First try the built-in permanent symbols.  The perfect hash gives the    */
+  /* only slot where the symbol can be.                                       */
+  hx = (int) ( hashSymbol( key, 0 ) & ( as->permtab_buckets - 1 ));
+  hx = (int) ( hashSymbol( key, as->permtab_disp[hx] )
+               & ( as->permtab_size - 1 ));
+  sym = &as->permtab[hx];
+  if( M_PERMANENT( sym->type ) && sym->key == key )
   {
-     p = &pz;
+    return( sym );
   }
 
-  /* Search the literal pool for any occurence of the needed value.           */
-  ix = PAGE_SIZE - 1;
-  while( ix >= p->loc && p->pool[ix] != value )
+  /* Now probe the hash index of the user symbol table until the symbol or    */
+  /* an empty entry is found.                                                 */
+  /* The index is kept at most half full, so there is always an empty entry. */
+  if( 2 * ( as->symbol_top + 1 ) > as->symhash_size )
+  {
+    growSymbolHash( as );
+  }
+  for( hx = (int) ( hashSymbol( key, 0 ) & ( as->symhash_size - 1 ));
+       as->symhash[hx] != NULL;
+       hx = ( hx + 1 ) & ( as->symhash_size - 1 ))
   {
-    ix--;
+    if( as->symhash[hx]->key == key )
+    {
+      return( as->symhash[hx] );    /* Found a match in symbol table.         */
+    }
   }
 
-  /* Check if value found in literal pool. If not, then insert value.         */
-  if( ix < p->loc )
+  /* Symbol not in table, so append it and index it at the empty entry.       */
+  if( as->symbol_top >= as->symbol_room )
   {
-    (p->loc)--;
-    p->pool[p->loc] = value;
-    ix = p->loc;
+    growSymbolTable( as );
   }
-  return( ix );
-} /* insertLiteral()                                                          */
+  sym = symbolAt( as, as->symbol_top++ );
+  as->symhash[hx] = sym;
+
+  /* Enter the symbol as UNDEFINED with a value of zero.                      */
+  sym->key  = key;
+  sym->type = UNDEFINED;
+  sym->val  = 0;
+  sym->xref_index = 0;
+  sym->xref_count = 0;
+
+  return( sym );                /* Return the location of the symbol.         */
+} /* lookup()                                                                 */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printSymbolTable                                               */
+/*  Function:  hashSymbol                                                     */
 /*                                                                            */
-/*  Synopsis:  Output the symbol table.                                       */
+/*  Synopsis:  Hash a symbol key.  Different seeds give independent hashes,   */
+/*             which the perfect hash of the permanent symbols relies on.     */
 /*                                                                            */
 /******************************************************************************/
-void printSymbolTable()
+unsigned long hashSymbol( SYMKEY key, unsigned long seed )
 {
-  int    col;
-  int    cx;
-  char  *fmt;
-  int    ix;
-  char   mark;
-  int    page;
-  int    row;
-  int    symbol_base;
-  int    symbol_lines;
-
-  symbol_base = number_of_fixed_symbols;
-
-  for( page=0, list_lineno=0, col=0, ix=symbol_base; ix < symbol_top; page++ )
-  {
-    topOfForm( list_title, s_symtable );
-    symbol_lines = LIST_LINES_PER_PAGE - page_lineno;
-
-    for( row = 0; page_lineno < LIST_LINES_PER_PAGE && ix < symbol_top; row++)
-    {
-      list_lineno++;
-      page_lineno++;
-      fprintf( listfile, "%5d", list_lineno );
-
-      for( col = 0; col < SYMBOL_COLUMNS && ix < symbol_top; col++ )
-      {
-        /* Get index of symbol for the current line and column                         */
-        cx = symbol_lines * ( SYMBOL_COLUMNS * page + col ) + row;
-        cx += symbol_base;
-
-        /* Make sure that there is a symbol to be printed.                    */
-        if( number_of_fixed_symbols <= cx && cx < symbol_top )
-        {
-          switch( symtab[cx].type & LABEL )
-          {
-          case LABEL:
-            fmt = " %c%-6.6s %5.5o ";
-            break;
-
-          default:
-            fmt = " %c%-6.6s  %4.4o ";
-            break;
-          }
-
-          switch( symtab[cx].type & ( DEFINED | REDEFINED ))
-          {
-          case UNDEFINED:
-            mark = '?';
-            break;
-
-          case REDEFINED:
-            mark = '#';
-            break;
+  unsigned long  hash;
 
-          default:
-            mark = ' ';
-            break;
-          }
-          fprintf( listfile, fmt, mark, symtab[cx].name, symtab[cx].val );
-          ix++;
-        }
-      }
-      fprintf( listfile, "\n" );
-    }
-  }
-} /* printSymbolTable()                                                       */
+  hash = ( key ^ ( seed * 0x9E3779B1UL )) & 0xFFFFFFFFUL;
+  hash = (( hash ^ ( hash >> 16 )) * 0x85EBCA6BUL ) & 0xFFFFFFFFUL;
+  hash = (( hash ^ ( hash >> 13 )) * 0xC2B2AE35UL ) & 0xFFFFFFFFUL;
+  return( hash ^ ( hash >> 16 ));
+} /* hashSymbol()                                                             */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printPermanentSymbolTable                                      */
+/*  Function:  hashPermanentSymbols                                           */
 /*                                                                            */
-/*  Synopsis:  Output the permanent symbol table to a file suitable for       */
-/*             being input after the EXPUNGE pseudo-op.                       */
+/*  Synopsis:  Make the count symbols in syms, which must be sorted by name,  */
+/*             the permanent symbol table.  A perfect hash is built for them: */
+/*             a symbol is first hashed with seed 0 into one of the buckets,  */
+/*             and the displacement stored for that bucket is the seed of a   */
+/*             second hash which gives its slot.  The displacements are       */
+/*             chosen, largest bucket first, so that no two symbols share a   */
+/*             slot.  Returns FALSE if a bucket could not be placed.          */
 /*                                                                            */
 /******************************************************************************/
-void printPermanentSymbolTable()
+BOOL hashPermanentSymbols( ASM_T *as, SYM_T **syms, int count )
 {
+  int     buckets;
+  int     bx;
+  int    *disp;
+  int    *first;
   int     ix;
-  FILE   *permfile;
-  char  *s_type;
+  int     largest;
+  int    *member;
+  int     mx;
+  int    *order;
+  int     size;
+  int     sx;
+  SYM_T  *table;
+  long    trial;
+  int     want;
+
+  for( size = 4; size < 2 * count; size *= 2 )
+  {
+    ;
+  }
+  buckets = size / 4;
+
+  disp = (int *) malloc( sizeof( int ) * buckets );
+  first = (int *) malloc( sizeof( int ) * ( buckets + 1 ));
+  member = (int *) malloc( sizeof( int ) * ( count + 1 ));
+  order = (int *) malloc( sizeof( int ) * ( count + 1 ));
+  table = (SYM_T *) malloc( sizeof( SYM_T ) * size );
+  if( disp == NULL || first == NULL || member == NULL || order == NULL ||
+      table == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
+  }
 
-  if(( permfile = fopen( permpathname, "w" )) == NULL )
+  /* Sort the symbols by bucket.  The members of bucket bx are member[mx]     */
+  /* for first[bx] <= mx < first[bx + 1].                                     */
+  for( bx = 0; bx <= buckets; bx++ )
   {
-    exit( 2 );
+    first[bx] = 0;
+  }
+  for( ix = 0; ix < count; ix++ )
+  {
+    first[( hashSymbol( syms[ix]->key, 0 ) & ( buckets - 1 )) + 1]++;
+  }
+  for( largest = 0, bx = 0; bx < buckets; bx++ )
+  {
+    largest = ( first[bx + 1] > largest ) ? first[bx + 1] : largest;
+    first[bx + 1] += first[bx];
+    disp[bx] = 0;
+  }
+  for( ix = 0; ix < count; ix++ )
+  {
+    bx = (int) ( hashSymbol( syms[ix]->key, 0 ) & ( buckets - 1 ));
+    member[first[bx] + disp[bx]++] = ix;
   }
 
-  fprintf( permfile, "/ PERMANENT SYMBOL TABLE\n/\n" );
-  fprintf( permfile, "        EXPUNGE\n/\n" );
-  /* Print the memory reference instructions first.                           */
-  s_type = "FIXMRI";
-  for( ix = 0; ix < symbol_top; ix++ )
+  for( sx = 0; sx < size; sx++ )
   {
-    if( M_MRI( symtab[ix].type ))
-    {
-      fprintf( permfile, "%-7s %s=%4.4o\n",
-                                    s_type, symtab[ix].name, symtab[ix].val );
-    }
+    table[sx] = as->sym_undefined;
   }
 
-  s_type = " ";
-  for( ix = 0; ix < symbol_top; ix++ )
+  /* Place the buckets, largest first, each with the first displacement that  */
+  /* puts all of its symbols in distinct free slots.                          */
+  for( want = largest; want > 0; want-- )
   {
-    if( M_FIXED( symtab[ix].type ))
+    for( bx = 0; bx < buckets; bx++ )
     {
-      if( !M_MRI( symtab[ix].type ) && !M_PSEUDO( symtab[ix].type ))
+      if( first[bx + 1] - first[bx] != want )
+      {
+        continue;
+      }
+      for( trial = 1; trial < PERM_DISP_LIMIT; trial++ )
+      {
+        for( mx = first[bx]; mx < first[bx + 1]; mx++ )
+        {
+          ix = member[mx];
+          sx = (int) ( hashSymbol( syms[ix]->key, trial ) & ( size - 1 ));
+          if( table[sx].key != 0 )
+          {
+            break;
+          }
+          table[sx] = *syms[ix];
+          table[sx].xref_index = 0;
+          table[sx].xref_count = 0;
+          order[ix] = sx;
+        }
+        if( mx == first[bx + 1] )
+        {
+          break;                /* All symbols of the bucket placed.          */
+        }
+
+        /* Collision, so take back the slots of this trial.                   */
+        while( mx-- > first[bx] )
+        {
+          table[order[member[mx]]] = as->sym_undefined;
+        }
+      }
+      if( trial >= PERM_DISP_LIMIT )
       {
-        fprintf( permfile, "%-7s %s=%4.4o\n",
-                                    s_type, symtab[ix].name, symtab[ix].val );
+        free( disp );
+        free( first );
+        free( member );
+        free( order );
+        free( table );
+        return( FALSE );
       }
+      disp[bx] = (int) trial;
     }
   }
-  fprintf( permfile, "/\n        FIXTAB\n" );
-  fclose( permfile );
-} /* printPermanentSymbolTable()                                              */
+  free( first );
+  free( member );
+
+  if( as->permtab_hashed )
+  {
+    free( as->permtab );
+    free( as->permtab_disp );
+    free( as->permtab_order );
+  }
+  as->permtab_hashed = TRUE;
+  as->permtab = table;
+  as->permtab_disp = disp;
+  as->permtab_order = order;
+  as->permtab_buckets = buckets;
+  as->permtab_count = count;
+  as->permtab_size = size;
+  return( TRUE );
+} /* hashPermanentSymbols()                                                   */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  printCrossReference                                            */
+/*  Function:  clearSymbolHash                                                */
 /*                                                                            */
-/*  Synopsis:  Output a cross reference (concordance) for the file being      */
-/*             assembled.                                                     */
+/*  Synopsis:  Empty the symbol hash index.  Used whenever the symbol table   */
+/*             is reset.                                                      */
 /*                                                                            */
 /******************************************************************************/
-void printCrossReference()
+void clearSymbolHash( ASM_T *as )
 {
-  int    ix;
-  int    symbol_base;
-  int    xc;
-  int    xc_index;
-  int    xc_refcount;
-  int    xc_cols;
-
-  /* Force top of form for first page.                                        */
-  page_lineno = LIST_LINES_PER_PAGE;
-
-  list_lineno = 0;
-  symbol_base = number_of_fixed_symbols;
+  int  hx;
 
-  for( ix = symbol_base; ix < symbol_top; ix++ )
+  for( hx = 0; hx < as->symhash_size; hx++ )
   {
-    list_lineno++;
-    page_lineno++;
-    if( page_lineno >= LIST_LINES_PER_PAGE )
-    {
-      topOfForm( list_title, s_xref );
-    }
-
-    fprintf( listfile, "%5d", list_lineno );
-
-    /* Get reference count & index into concordance table for this symbol.    */
-    xc_refcount = symtab[ix].xref_count;
-    xc_index = symtab[ix].xref_index;
-    /* Determine how to label symbol on concordance.                          */
-    switch( symtab[ix].type & ( DEFINED | REDEFINED ))
-    {
-    case UNDEFINED:
-      fprintf( listfile, " U         ");
-      break;
+    as->symhash[hx] = NULL;
+  }
+} /* clearSymbolHash()                                                        */
 
-    case REDEFINED:
-      fprintf( listfile, " M  %5d  ", xreftab[xc_index] );
-      break;
 
-    default:
-      fprintf( listfile, " A  %5d  ", xreftab[xc_index] );
-      break;
-    }
-    fprintf( listfile, "%-6.6s  ", symtab[ix].name );
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  growSymbolHash                                                 */
+/*                                                                            */
+/*  Synopsis:  Double the size of the symbol hash index and enter all the     */
+/*             symbols again.                                                 */
+/*                                                                            */
+/******************************************************************************/
+void growSymbolHash( ASM_T *as )
+{
+  int     hx;
+  int     ix;
+  int     size;
+  SYM_T  *sym;
 
-    /* Output the references, 8 numbers per line after symbol name.           */
-    for( xc_cols = 0, xc = 1; xc < xc_refcount + 1; xc++, xc_cols++ )
+  size = ( as->symhash_size == 0 ) ? 2 * SYMBOL_CHUNK_SIZE
+                                   : 2 * as->symhash_size;
+  free( as->symhash );
+  as->symhash = (SYM_T **) malloc( sizeof( SYM_T * ) * size );
+  if( as->symhash == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
+  }
+  as->symhash_size = size;
+  clearSymbolHash( as );
+
+  for( ix = 0; ix < as->symbol_top; ix++ )
+  {
+    sym = symbolAt( as, ix );
+    for( hx = (int) ( hashSymbol( sym->key, 0 ) & ( size - 1 ));
+         as->symhash[hx] != NULL;
+         hx = ( hx + 1 ) & ( size - 1 ))
     {
-      if( xc_cols >= XREF_COLUMNS )
-      {
-        xc_cols = 0;
-        page_lineno++;
-        if( page_lineno >= LIST_LINES_PER_PAGE )
-        {
-          topOfForm( list_title, s_xref);
-        }
-        list_lineno++;
-        fprintf( listfile, "\n%5d%-19s", list_lineno, " " );
-      }
-      fprintf( listfile, "  %5d", xreftab[xc_index + xc] );
+      ;
     }
-    fprintf( listfile, "\n" );
+    as->symhash[hx] = sym;
   }
-} /* printCrossReference()                                                    */
+} /* growSymbolHash()                                                         */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  topOfForm                                                      */
+/*  Function:  growSymbolTable                                                */
 /*                                                                            */
-/*  Synopsis:  Prints title and sub-title on top of next page of listing.     */
+/*  Synopsis:  Add a chunk to the symbol table, twice the size of the last.   */
+/*             Chunks are never moved, so pointers to symbols stay valid.     */
 /*                                                                            */
 /******************************************************************************/
-void topOfForm( char *title, char *sub_title )
+void growSymbolTable( ASM_T *as )
 {
-  char temp[10];
-
-  list_pageno++;
-  strcpy( temp, s_page );
-  sprintf( temp, "%s %d", s_page, list_pageno );
+  int  size;
 
-  /* Output a top of form if not the first page of the listing.               */
-  if( list_pageno > 1 )
+  size = SYMBOL_CHUNK_SIZE << as->symbol_chunks;
+  if( as->symbol_chunks < SYMBOL_CHUNKS )
   {
-    fprintf( listfile, "\f" );
+    as->symchunk[as->symbol_chunks] =
+                                  (SYM_T *) malloc( sizeof( SYM_T ) * size );
   }
-  fprintf( listfile, "\n\n\n      %-63s %10s\n", title, temp );
-
-  /* Reset the current page line counter.                                     */
-  page_lineno = 3;
-  if( sub_title != NULL )
+  if( as->symbol_chunks >= SYMBOL_CHUNKS
+      || as->symchunk[as->symbol_chunks] == NULL )
   {
-    fprintf( listfile, "%80s\n", sub_title );
-    page_lineno++;
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
   }
-  else
+  as->symbol_chunks++;
+  as->symbol_room += size;
+} /* growSymbolTable()                                                        */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  symbolAt                                                       */
+/*                                                                            */
+/*  Synopsis:  Return the address of the symbol table entry with index ix.   */
+/*                                                                            */
+/******************************************************************************/
+SYM_T *symbolAt( ASM_T *as, int ix )
+{
+  int  cx;
+  int  size;
+
+  for( cx = 0, size = SYMBOL_CHUNK_SIZE; ix >= size; cx++, size *= 2 )
   {
-    fprintf( listfile, "\n" );
-    page_lineno++;
+    ix -= size;
   }
-  fprintf( listfile, "\n" );
-  page_lineno++;
-} /* topOfForm()                                                              */
+  return( &as->symchunk[cx][ix] );
+} /* symbolAt()                                                               */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  lexemeToName                                                   */
+/*  Function:  sortSymbolTable                                                */
 /*                                                                            */
-/*  Synopsis:  Convert the current lexeme into a string.                      */
+/*  Synopsis:  Return a NULL terminated array of pointers to every symbol in  */
+/*             use, the fixed symbols first and then the user symbols, each   */
+/*             part sorted by name.  The number of fixed symbols is returned  */
+/*             through fixed_count.  The caller must free the array.          */
 /*                                                                            */
 /******************************************************************************/
-char *lexemeToName( char *name, int from, int term )
+SYM_T **sortSymbolTable( ASM_T *as, int *fixed_count )
 {
-  int  to;
+  int     ix;
+  int     nx;
+  SYM_T **sorted;
 
-  to = 0;
+  sorted = (SYM_T **) malloc( sizeof( SYM_T * ) *
+                              ( as->permtab_count + as->symbol_top + 1 ));
+  if( sorted == NULL )
+  {
+    fprintf( stderr, "Could not allocate memory for symbol table.\n");
+    exit( -1 );
+  }
 
-  while( from < term && to < ( SYMLEN - 1 ))
+  /* The permanent symbols are kept in name order, so the fixed part only    */
+  /* needs sorting when FIXTAB added to it.                                   */
+  for( nx = 0, ix = 0; ix < as->permtab_count; ix++ )
+  {
+    if( M_PERMANENT( as->permtab[as->permtab_order[ix]].type ))
+    {
+      sorted[nx++] = &as->permtab[as->permtab_order[ix]];
+    }
+  }
+  for( ix = 0; ix < as->number_of_fixed_symbols; ix++ )
   {
-    name[to++] = toupper( line[from++] );
+    sorted[nx++] = symbolAt( as, ix );
   }
+  *fixed_count = nx;
 
-  while( to < SYMLEN )
+  for( ; ix < as->symbol_top; ix++ )
   {
-    name[to++] = '\0';
+    sorted[nx++] = symbolAt( as, ix );
   }
-  return( name );
-} /* lexemeToName()                                                           */
+  sorted[nx] = NULL;
+
+  if( as->number_of_fixed_symbols > 0 )
+  {
+    qsort( sorted, *fixed_count, sizeof( sorted[0] ), compareSymbols );
+  }
+  qsort( &sorted[*fixed_count], nx - *fixed_count,
+                                        sizeof( sorted[0] ), compareSymbols );
+  return( sorted );
+} /* sortSymbolTable()                                                        */
+
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  defineLexeme                                                   */
+/*  Function:  compareSymbols                                                 */
 /*                                                                            */
-/*  Synopsis:  Put lexeme into symbol table with a value.                     */
+/*  Synopsis:  Used to sort symbol table pointers by name for the listings.   */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *defineLexeme( int     start,     /* start of lexeme being defined.     */
-                     int     term,      /* end+1 of lexeme being defined.     */
-                     WORD16  val,       /* value of lexeme being defined.     */
-                     SYMTYP  type )     /* how symbol is being defined.       */
+int compareSymbols( const void *a, const void *b )
 {
-  char  name[SYMLEN];
+  SYMKEY  ka;
+  SYMKEY  kb;
 
-  lexemeToName( name, start, term);
-  return( defineSymbol( name, val, type, start ));
-} /* defineLexeme()                                                           */
+  ka = (*(SYM_T **) a)->key;
+  kb = (*(SYM_T **) b)->key;
+  return(( ka < kb ) ? -1 : ( ka > kb ));
+} /* compareSymbols()                                                         */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  defineSymbol                                                   */
+/*  Function:  evalSymbol                                                     */
 /*                                                                            */
-/*  Synopsis:  Define a symbol in the symbol table, enter symbol name if not  */
-/*             not already in table.                                          */
+/*  Synopsis:  Get the pointer for the symbol table entry if exists.          */
+/*             If symbol doesn't exist, return a pointer to the undefined sym */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *defineSymbol( char *name, WORD16 val, SYMTYP type, WORD16 start )
+SYM_T *evalSymbol( ASM_T *as )
 {
-  SYM_T  *sym;
-  int     xref_count;
+  SYM_T *sym;
+
+  sym = lookup( as, lexemeToKey( as, as->lexstart, as->lexterm ));
+  xrefSymbol( as, sym, as->lexstart );
+  return( sym );
+} /* evalSymbol()                                                             */
+
 
-  if( strlen( name ) < 1 )
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  xrefSymbol                                                     */
+/*                                                                            */
+/*  Synopsis:  Count a reference to sym at column col of the current line.    */
+/*                                                                            */
+/******************************************************************************/
+void xrefSymbol( ASM_T *as, SYM_T *sym, int col )
+{
+  /* Only the concordance needs the references, so without it the shared      */
+  /* permanent symbols are not written to.  Pass 2 alone fills it in.         */
+  if( !as->xref || as->pass != 2 )
   {
-    return( &sym_undefined );   /* Protect against non-existent names.        */
+    return;
   }
-  sym = lookup( name );
-  if( M_FIXED( sym->type ))
+
+  /* The symbol goes in the concordance iff it is in a different position in  */
+  /* the assembler source file.                                               */
+  if( col != as->last_xref_lexstart ||  as->lineno != as->last_xref_lineno )
   {
-      return( sym );            /* Can't modify permanent symbols.            */
+    as->last_xref_lexstart = col;
+    as->last_xref_lineno = as->lineno;
+
+    /* Put the line number in the concordance table.                          */
+    addXref( as, sym, as->lineno );
   }
+} /* xrefSymbol()                                                             */
 
-  xref_count = 0;               /* Set concordance for normal defintion.      */
 
-  if( M_DEFINED( sym->type ))
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  xrefEntry                                                      */
+/*                                                                            */
+/*  Synopsis:  Return the concordance entry of sym, making one if it has none.*/
+/*                                                                            */
+/******************************************************************************/
+XREF_T *xrefEntry( ASM_T *as, SYM_T *sym )
+{
+  XREF_T *xr;
+
+  if( sym->xref_index == 0 )
   {
-    if( pass == 2 && sym->val != val )
+    if( as->xref_used == 0 )
     {
-      /* Generate diagnostic if redefining a symbol.                          */
-      if( M_REDEFINED( sym->type ))
-      {
-        errorSymbol( &redefined_symbol, sym->name, start );
-      }
-      type = type | REDEFINED;
-      sym->xref_count++;      /* Referenced suymbol, count it.                */
-      xref_count = sym->xref_count;
+      as->xref_used = 1;            /* Entry 0 is none.                       */
     }
+    as->xrefs = (XREF_T *) growTable( as->xrefs, &as->xref_room,
+                                      sizeof( XREF_T ), as->xref_used + 1 );
+    xr = &as->xrefs[as->xref_used];
+    xr->def = 0;
+    xr->first = 0;
+    xr->last = 0;
+    xr->fill = 0;
+    xr->line = 0;
+    sym->xref_index = as->xref_used++;
   }
-
-  if( pass == 2 && xref )
-  {
-    /* Put the definition line number in the concordance table.               */
-    /* Defined symbols are not counted as references.                         */
-    xreftab[sym->xref_index] = lineno;
-    /* Put the line number in the concordance table.                          */
-    xreftab[sym->xref_index + xref_count] = lineno;
-  }
-
-  /* Now set the value and the type.                                          */
-  sym->val = ( type == LABEL) ? val : val & 07777;
-  sym->type = ( pass == 1 ) ? ( type | CONDITION ) : type;
-  return( sym );
-} /* defineSymbol()                                                           */
+  return( &as->xrefs[sym->xref_index] );
+} /* xrefEntry()                                                              */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  lookup                                                         */
+/*  Function:  addXref                                                        */
 /*                                                                            */
-/*  Synopsis:  Find a symbol in table.  If not in table, enter symbol in      */
-/*             table as undefined.  Return address of symbol in table.        */
+/*  Synopsis:  Add a reference on line to the concordance entry of sym.       */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *lookup( char *name )
+void addXref( ASM_T *as, SYM_T *sym, int line )
 {
-  int     ix;                   /* Insertion index                            */
-  int     lx;                   /* Left index                                 */
-  int     rx;                   /* Right index                                */
+  unsigned int code;
+  XREF_T      *xr;
 
-  /* First search the permanent symbols.                                      */
-  lx = 0;
-  ix = binarySearch( name, lx, number_of_fixed_symbols );
-
-  /* If symbol not in permanent symbol table.                                 */
-  if( ix < 0 )
+  xr = xrefEntry( as, sym );
+  code = ( line < xr->line ) ? ((unsigned int) ( xr->line - line ) << 1 ) - 1
+                             : (unsigned int) ( line - xr->line ) << 1;
+  xr->line = line;
+  do
   {
-    /* Now try the user symbol table.                                         */
-    ix = binarySearch( name, number_of_fixed_symbols, symbol_top );
-
-    /* If symbol not in user symbol table.                                    */
-    if( ix < 0 )
+    if( xr->first == 0 || xr->fill == XREF_BLOCK_BYTES )
     {
-      /* Must put symbol in table if index is negative.                       */
-      ix = ~ix;
-      if( symbol_top + 1 >= SYMBOL_TABLE_SIZE )
+      if( as->xrefblock_used == 0 )
       {
-        errorSymbol( &symbol_table_full, name, lexstart );
-        exit( 1 );
+        as->xrefblock_used = 1;     /* Block 0 is none.                       */
       }
-
-      for( rx = symbol_top; rx >= ix; rx-- )
+      as->xrefblocks = (XREFBLOCK_T *) growTable( as->xrefblocks,
+                                                  &as->xrefblock_room,
+                                                  sizeof( XREFBLOCK_T ),
+                                                  as->xrefblock_used + 1 );
+      as->xrefblocks[as->xrefblock_used].next = 0;
+      if( xr->first == 0 )
       {
-        symtab[rx + 1] = symtab[rx];
+        xr->first = as->xrefblock_used;
       }
-      symbol_top++;
-
-      /* Enter the symbol as UNDEFINED with a value of zero.                  */
-      strcpy( symtab[ix].name, name );
-      symtab[ix].type = UNDEFINED;
-      symtab[ix].val  = 0;
-      symtab[ix].xref_count = 0;
-      if( xref && pass == 2 )
+      else
       {
-        xreftab[symtab[ix].xref_index] = 0;
+        as->xrefblocks[xr->last].next = as->xrefblock_used;
       }
+      xr->last = as->xrefblock_used++;
+      xr->fill = 0;
     }
-  }
-
-  return( &symtab[ix] );        /* Return the location of the symbol.         */
-} /* lookup()                                                                 */
+    as->xrefblocks[xr->last].bytes[xr->fill++] =
+                          (BYTE) (( code & 0177 ) | ( code > 0177 ? 0200 : 0 ));
+    code >>= 7;
+  } while( code != 0 );
+  sym->xref_count++;            /* Count the number of references to symbol.  */
+} /* addXref()                                                                */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  binarySearch                                                   */
+/*  Function:  nextXref                                                       */
 /*                                                                            */
-/*  Synopsis:  Searches the symbol table within the limits given.  If the     */
-/*             symbol is not in the table, it returns the insertion point.    */
+/*  Synopsis:  Return the difference of the next reference of a concordance   */
+/*             entry from the one before, read from byte pos of block, both   */
+/*             of which are moved past it.                                    */
 /*                                                                            */
 /******************************************************************************/
-int binarySearch( char *name, int start, int symbol_count )
+int nextXref( ASM_T *as, int *block, int *pos )
 {
-  int     lx;                   /* Left index                                 */
-  int     mx;                   /* Middle index                               */
-  int     rx;                   /* Right index                                */
-  int     compare;              /* Results of comparison                      */
+  BYTE         byte;
+  unsigned int code;
+  int          shift;
 
-  lx = start;
-  rx = symbol_count - 1;
-  while( lx <= rx )
+  code = 0;
+  shift = 0;
+  do
   {
-    mx = ( lx + rx ) / 2;   /* Find center of search area.                    */
-
-    compare = strcmp( name, symtab[mx].name );
-
-    if( compare < 0 )
-    {
-      rx = mx - 1;
-    }
-    else if( compare > 0 )
-    {
-      lx = mx + 1;
-    }
-    else
+    if( *pos == XREF_BLOCK_BYTES )
     {
-      return( mx );         /* Found a match in symbol table.                 */
+      *block = as->xrefblocks[*block].next;
+      *pos = 0;
     }
-  } /* end while                                                              */
-  return( ~lx );            /* Return insertion point.                        */
-} /* binarySearch()                                                           */
+    byte = as->xrefblocks[*block].bytes[( *pos )++];
+    code |= (unsigned int) ( byte & 0177 ) << shift;
+    shift += 7;
+  } while( byte & 0200 );
+  return(( code & 1 ) ? -(int) (( code + 1 ) >> 1 ) : (int) ( code >> 1 ));
+} /* nextXref()                                                               */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  compareSymbols                                                 */
+/*  Function:  moveToEndOfLine                                                */
 /*                                                                            */
-/*  Synopsis:  Used to presort the symbol table when starting assembler.      */
+/*  Synopsis:  Move the parser input to the end of the current input line.    */
 /*                                                                            */
 /******************************************************************************/
-int compareSymbols( const void *a, const void *b )
+void moveToEndOfLine( ASM_T *as )
 {
-  return( strcmp( ((SYM_T *) a)->name, ((SYM_T *) b)->name ));
-} /* compareSymbols()                                                         */
+  /* Only the last character of a line can end it, so there is no need to    */
+  /* look for the end.                                                        */
+  as->cc = ( as->maxcc > 0 && isend( as->line[as->maxcc - 1] ))
+           ? as->maxcc - 1 : as->maxcc;
+  as->lexstart = as->cc;
+  as->lexterm = as->cc;
+  as->lexstartprev = as->lexstart;
+} /* moveToEndOfLine()                                                        */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  evalSymbol                                                     */
+/*  Function:  expandedColumn                                                 */
 /*                                                                            */
-/*  Synopsis:  Get the pointer for the symbol table entry if exists.          */
-/*             If symbol doesn't exist, return a pointer to the undefined sym */
+/*  Synopsis:  Return the listing column of column col of the current line.   */
+/*             Tabs are only expanded, to 8 character tab stops, when the     */
+/*             line is listed or an error in it is reported.                  */
 /*                                                                            */
 /******************************************************************************/
-SYM_T *evalSymbol()
+int expandedColumn( ASM_T *as, int col )
 {
-  char   name[SYMLEN];
-  SYM_T *sym;
-
-  sym = lookup( lexemeToName( name, lexstart, lexterm ));
+  int     ix;
+  int     iy;
 
-  /* The symbol goes in the concordance iff it is in a different position in  */
-  /* the assembler source file.                                               */
-  if( lexstart != last_xref_lexstart ||  lineno != last_xref_lineno )
+  for( ix = 0, iy = 0; ix < col && ix < as->maxcc; ix++ )
   {
-    sym->xref_count++;          /* Count the number of references to symbol.  */
-    last_xref_lexstart = lexstart;
-    last_xref_lineno = lineno;
-
-    /* Put the line number in the concordance table.                          */
-    if( xref && pass == 2 )
-    {
-      xreftab[sym->xref_index + sym->xref_count] = lineno;
-    }
+    iy = ( as->line[ix] == '\t' ) ? ( iy / 8 + 1 ) * 8 : iy + 1;
   }
-  return( sym );
-} /* evalSymbol()                                                             */
+  return( iy + col - ix );
+} /* expandedColumn()                                                         */
 
 
 /******************************************************************************/
 /*                                                                            */
-/*  Function:  moveToEndOfLine                                                */
+/*  Function:  tabWidth                                                       */
 /*                                                                            */
-/*  Synopsis:  Move the parser input to the end of the current input line.    */
+/*  Synopsis:  Return the number of listing columns taken by the character at */
+/*             column col of the current line, listed at listing column       */
+/*             column: one, or up to 8 for a tab.  The callers keep column as */
+/*             they go along the line, so that it is not counted again.       */
 /*                                                                            */
 /******************************************************************************/
-void moveToEndOfLine()
+int tabWidth( ASM_T *as, int col, int column )
 {
-  while( !isend( line[cc] )) cc++;
-  lexstart = cc;
-  lexterm = cc;
-  lexstartprev = lexstart;
-} /* moveToEndOfLine()                                                        */
+  return(( as->line[col] == '\t' ) ? 8 - column % 8 : 1 );
+} /* tabWidth()                                                               */
+
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  skipSpaces                                                     */
+/*                                                                            */
+/*  Synopsis:  Skip runs of spaces a word at a time.                          */
+/*             Whole words within the line are compared with a word of        */
+/*             spaces; the rest of the blanks are left to the caller.         */
+/*                                                                            */
+/******************************************************************************/
+void skipSpaces( ASM_T *as )
+{
+  unsigned long  spaces;
+  unsigned long  word;
+
+  spaces = ~0UL / 0377 * ' ';
+  while( as->cc + (int) sizeof( word ) <= as->maxcc )
+  {
+    memcpy( &word, &as->line[as->cc], sizeof( word ));
+    if( word != spaces )
+    {
+      break;
+    }
+    as->cc += sizeof( word );
+  }
+} /* skipSpaces()                                                             */
 
 /******************************************************************************/
 /*                                                                            */
@@ -3214,37 +7201,57 @@ void moveToEndOfLine()
 /*  Synopsis:  Get the next lexical element from input line.                  */
 /*                                                                            */
 /******************************************************************************/
-void nextLexeme()
+void nextLexeme( ASM_T *as )
 {
+  BOOL      cache;
+  int       from;
+  LEXEME_T *lex;
+
   /* Save start column of previous lexeme for diagnostic messages.            */
-  lexstartprev = lexstart;
-  lextermprev = lexterm;
+  as->lexstartprev = as->lexstart;
+  as->lextermprev = as->lexterm;
+
+  /* In pass 2, take the lexeme pass 1 found from this column, if any.        */
+  if( as->pass == 2 && as->lexeme_line >= 0 &&
+      as->lexeme_next < as->srclines[as->lexeme_line].lexeme
+                        + as->srclines[as->lexeme_line].lexemes &&
+      as->lexemes[as->lexeme_next].from == as->cc )
+  {
+    lex = &as->lexemes[as->lexeme_next++];
+    as->lexstart = lex->start;
+    as->cc = as->lexterm = lex->term;
+    return;
+  }
 
-  while( is_blank( line[cc] )) { cc++; }
-  lexstart = cc;
+  cache = ( as->pass == 1 && as->lexeme_line >= 0 );
+  from = as->cc;
+  skipSpaces( as );
+  while( is_blank( as->line[as->cc] )) { as->cc++; }
+  as->lexstart = as->cc;
 
-  if( isalnum( line[cc] ))
+  if( is_alnum( as->line[as->cc] ))
   {
-    while( isalnum( line[cc] )) { cc++; }
+    while( is_alnum( as->line[as->cc] )) { as->cc++; }
   }
-  else if( isend( line[cc] ))
+  else if( isend( as->line[as->cc] ))
   {
     /* End-of-Line, don't advance cc!                                         */
   }
   else
   {
-    switch( line[cc] )
+    switch( as->line[as->cc] )
     {
-    case '"':     /* Quoted letter                                            */
-      if( cc + 2 < maxcc )
+    case '"':     /* Quoted letter, counted in listing columns for tabs.      */
+      if( expandedColumn( as, as->cc ) + 2 < expandedColumn( as, as->maxcc ))
       {
-        cc++;
-        cc++;
+        as->cc++;
+        as->cc++;
       }
       else
       {
-        errorMessage( &no_literal_value, lexstart );
-        cc++;
+        errorMessage( as, &no_literal_value, as->lexstart );
+        as->cc++;
+        cache = FALSE;          /* Scan again in pass 2 to report the error.  */
       }
       break;
 
@@ -3252,11 +7259,23 @@ void nextLexeme()
       break;
 
     default:      /* All other punctuation.                                   */
-      cc++;
+      as->cc++;
       break;
     }
   }
-  lexterm = cc;
+  as->lexterm = as->cc;
+
+  if( cache )
+  {
+    as->lexemes = (LEXEME_T *) growTable( as->lexemes, &as->lexeme_room,
+                                          sizeof( LEXEME_T ),
+                                          as->lexeme_count + 1 );
+    lex = &as->lexemes[as->lexeme_count++];
+    lex->from = from;
+    lex->start = as->lexstart;
+    lex->term = as->lexterm;
+    as->srclines[as->lexeme_line].lexemes++;
+  }
 } /* nextLexeme()                                                             */
 
 
@@ -3267,14 +7286,14 @@ void nextLexeme()
 /*  Synopsis:  Used to prevent illegal blanks in expressions.                 */
 /*                                                                            */
 /******************************************************************************/
-void nextLexBlank()
+void nextLexBlank( ASM_T *as )
 {
-  nextLexeme();
-  if( is_blank( delimiter ))
+  nextLexeme( as );
+  if( is_blank( as->delimiter ))
   {
-    errorMessage( &illegal_blank, lexstart - 1 );
+    errorMessage( as, &illegal_blank, as->lexstart - 1 );
   }
-  delimiter = line[lexterm];
+  as->delimiter = as->line[as->lexterm];
 } /* nextLexBlank()                                                           */
 
 
@@ -3286,8 +7305,9 @@ void nextLexBlank()
 /*  Synopsis:  Process pseudo-ops (directives).                               */
 /*                                                                            */
 /******************************************************************************/
-BOOL pseudoOperators( PSEUDO_T val )
+BOOL pseudoOperators( ASM_T *as, PSEUDO_T val )
 {
+  int     column;
   int     count;
   int     delim;
   int     index;
@@ -3296,6 +7316,7 @@ BOOL pseudoOperators( PSEUDO_T val )
   WORD16  newfield;
   WORD16  oldclc;
   int     pack;
+  int     spaces;
   BOOL    status;
   SYM_T  *sym;
   FILE   *temp;
@@ -3307,242 +7328,246 @@ BOOL pseudoOperators( PSEUDO_T val )
   switch( (PSEUDO_T) val )
   {
   case BANK:
-    errorSymbol( &no_pseudo_op, "BANK", lexstartprev );
+    errorSymbol( as, &no_pseudo_op, "BANK", as->lexstartprev );
     /* should select a different 32K out of 128K                              */
     break;
 
   case BINPUNCH:
+    if( as->rim_mode )
+    {
+      failOnePass( as );         /* Pass 2 starts in the mode pass 1 ends in. */
+    }
     /* If there has been data output and this is a mode switch, set up to     */
     /* output data in BIN mode.                                               */
-    if( binary_data_output && rim_mode )
+    if( as->binary_data_output && as->rim_mode )
     {
-      lexstartsave = lexstartprev;
-      if( isdone( line[lexstart] ))
+      lexstartsave = as->lexstartprev;
+      if( isdone( as->line[as->lexstart] ))
         {
 	  leaderlen = 8; /* If not specified, the short leader/trailer will be 8. */
 	}
       else	
 	{
-	  leaderlen = (getExpr())->val;      /* BINPUN leaderlen              */
+	  leaderlen = (getExpr( as ))->val;      /* BINPUN leaderlen              */
 	}
 
 
-      cp.loc = 00200;           /* Clear the literal tables.                  */
-      cp.error = FALSE;
-      pz.loc = 00200;
-      pz.error = FALSE;
-      punchLeader( leaderlen ); /* Generate a short leader/trailer.           */
-      checksum = 0;
-      binary_data_output = FALSE;
+      as->cp.loc = 00200;           /* Clear the literal tables.              */
+      as->cp.error = FALSE;
+      as->pz.loc = 00200;
+      as->pz.error = FALSE;
+      punchLeader( as, leaderlen ); /* Generate a short leader/trailer.       */
+      as->checksum = 0;
+      as->checksum_partial = FALSE;
+      as->binary_data_output = FALSE;
     }
-    rim_mode = FALSE;
+    as->rim_mode = FALSE;
     break;
 
   case DECIMAL:
-    radix = 10;
+    as->radix = 10;
     break;
 
   case DUBL:
-    inputDubl();
+    inputDubl( as );
     break;
 
   case EJECT:
-    page_lineno = LIST_LINES_PER_PAGE;  /* This will force a page break.      */
+    listNewPage( as, FALSE );   /* This will force a page break.              */
     status = FALSE;             /* This will force reading of next line       */
     break;
 
   case ENPUNCH:
-    if( pass == 2 )
+    if( as->pass == 2 || as->one_pass )
     {
-      objectfile = objectsave;
+      as->objectfile = as->objectsave;
     }
+    as->punch_off = FALSE;
     break;
 
   case EXPUNGE:                 /* Erase symbol table                         */
-    if( pass == 1 )
+    failOnePass( as );              /* Pass 2 sees the symbols it erases.     */
+    if( as->pass == 1 )
     {
-      symtab[0] = sym_undefined;
-      symbol_top = 0;
-      number_of_fixed_symbols = symbol_top;
-      fixed_symbols = &symtab[symbol_top - 1];
+      as->symbol_top = 0;
+      clearSymbolHash( as );
+      as->number_of_fixed_symbols = as->symbol_top;
 
-      /* Enter the pseudo-ops into the symbol table.                          */
-      for( ix = 0; ix < DIM( pseudo ); ix++ )
-      {
-        defineSymbol( pseudo[ix].name, pseudo[ix].val, pseudo[ix].type, 0 );
-      }
-      number_of_fixed_symbols = symbol_top;
-      fixed_symbols = &symtab[symbol_top - 1];
+      /* Only the pseudo-ops are left in the permanent symbol table.          */
+      as->permanent_expunged = TRUE;
+
+      /* The code compiled so far refers to the symbols just erased.          */
+      as->coded_valid = as->coded_count;
     }
     break;
 
   case FIELD:
-    punchLiteralPool( &cp, clc - 1 );
-    punchLiteralPool( &pz, 0 );
-    newfield = field >> 12;
-    lexstartsave = lexstartprev;
-    if( isdone( line[lexstart] ))
+    punchLiteralPool( as, &as->cp, as->clc - 1 );
+    punchLiteralPool( as, &as->pz, 0 );
+    newfield = as->field >> 12;
+    lexstartsave = as->lexstartprev;
+    if( isdone( as->line[as->lexstart] ))
     {
       newfield += 1;            /* Blank FIELD directive.                     */
     }
     else
     {
-      newfield = (getExpr())->val;      /* FIELD with argument.               */
+      newfield = (getExpr( as ))->val;      /* FIELD with argument.           */
     }
 
-    if( rim_mode )
+    if( as->rim_mode )
     {
-      errorMessage( &in_rim_mode, lexstartsave ); /* Can't change fields.     */
+      errorMessage( as, &in_rim_mode, lexstartsave ); /* Can't change fields. */
     }
     else if( newfield > 7 || newfield < 0 )
     {
-      errorMessage( &illegal_field_value, lexstartprev );
+      errorMessage( as, &illegal_field_value, as->lexstartprev );
     }
     else
     {
       value = (( newfield & 0007 ) << 3 ) | 00300;
-      punchObject( value );
-      checksum -= value;        /* Field punches are not added to checksum.   */
-      field = newfield << 12;
+      punchObject( as, value );
+      as->checksum -= value;      /* Field punches are not added to checksum. */
+      as->field = newfield << 12;
     }
 
-    clc = 0200 | field;
-    fieldlc = clc & 07777;
+    as->clc = 0200 | as->field;
+    as->fieldlc = as->clc & 07777;
 
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
     break;
 
   case FIXMRI:
-    if( line[lexterm] == '=' && isalpha( line[lexstart] ))
+    if( as->line[as->lexterm] == '=' && isalpha( as->line[as->lexstart] ))
     {
-      lexstartsave = lexstart;
-      term = lexterm;
-      nextLexeme();           /* Skip symbol.                                 */
-      nextLexeme();           /* Skip trailing =                              */
-      defineLexeme( lexstartsave, term, getExprs(), MRI );
+      lexstartsave = as->lexstart;
+      term = as->lexterm;
+      nextLexeme( as );           /* Skip symbol.                             */
+      nextLexeme( as );           /* Skip trailing =                          */
+      defineLexeme( as, lexstartsave, term, getExprs( as ), MRI );
     }
     else
     {
-      errorLexeme( &symbol_syntax, lexstart );
-      nextLexeme();           /* Skip symbol.                                 */
-      nextLexeme();           /* Skip trailing =                              */
-      (void) getExprs();      /* Skip expression.                             */
+      errorLexeme( as, &symbol_syntax, as->lexstart );
+      nextLexeme( as );           /* Skip symbol.                             */
+      nextLexeme( as );           /* Skip trailing =                          */
+      (void) getExprs( as );      /* Skip expression.                         */
     }
     break;
 
   case FIXTAB:
     /* Mark all current symbols as permanent symbols.                         */
-    for( ix = 0; ix < symbol_top; ix++ )
+    for( ix = 0; ix < as->symbol_top; ix++ )
     {
-      symtab[ix].type = symtab[ix].type | FIXED;
+      sym = symbolAt( as, ix );
+      sym->type = sym->type | FIXED;
     }
-    number_of_fixed_symbols = symbol_top;
-    fixed_symbols = &symtab[symbol_top - 1];
-
-    /* Re-sort the symbol table                                               */
-    qsort( symtab, symbol_top, sizeof(symtab[0]), compareSymbols );
+    as->number_of_fixed_symbols = as->symbol_top;
     break;
 
   case FLTG:
-    inputFltg();
+    inputFltg( as );
     /* errorSymbol( &no_pseudo_op, "FLTG", lexstartprev ); */
     break;
 
   case IFDEF:
-    if( isalpha( line[lexstart] ))
+    failOnePass( as );              /* Pass 2 tests symbols differently.      */
+    if( isalpha( as->line[as->lexstart] ))
     {
-      sym = evalSymbol();
-      nextLexeme();
+      sym = evalSymbol( as );
+      nextLexeme( as );
       if( M_DEFINED_CONDITIONALLY( sym->type ))
       {
-        conditionTrue();
+        conditionTrue( as );
       }
       else
       {
-        conditionFalse();
+        conditionFalse( as );
       }
     }
     else
     {
-      errorLexeme( &label_syntax, lexstart );
+      errorLexeme( as, &label_syntax, as->lexstart );
     }
     break;
 
   case IFNDEF:
-    if( isalpha( line[lexstart] ))
+    failOnePass( as );              /* Pass 2 tests symbols differently.      */
+    if( isalpha( as->line[as->lexstart] ))
     {
-      sym = evalSymbol();
-      nextLexeme();
+      sym = evalSymbol( as );
+      nextLexeme( as );
       if( M_DEFINED_CONDITIONALLY( sym->type ))
       {
-        conditionFalse();
+        conditionFalse( as );
       }
       else
       {
-        conditionTrue();
+        conditionTrue( as );
       }
     }
     else
     {
-      errorLexeme( &label_syntax, lexstart );
+      errorLexeme( as, &label_syntax, as->lexstart );
     }
     break;
 
   case IFNZERO:
-    if( (getExpr())->val == 0 )
+    if( (getExpr( as ))->val == 0 )
     {
-      conditionFalse();
+      conditionFalse( as );
     }
     else
     {
-      conditionTrue();
+      conditionTrue( as );
     }
     break;
 
   case IFZERO:
-    if( (getExpr())->val == 0 )
+    if( (getExpr( as ))->val == 0 )
     {
-      conditionTrue();
+      conditionTrue( as );
     }
     else
     {
-      conditionFalse();
+      conditionFalse( as );
     }
     break;
 
   case NOPUNCH:
-    if( pass == 2 )
+    if( as->pass == 2 || as->one_pass )
     {
-      objectfile = NULL;
+      as->objectfile = NULL;
     }
+    as->punch_off = TRUE;
     break;
 
   case OCTAL:
-    radix = 8;
+    as->radix = 8;
     break;
 
   case PAGE:
-    punchLiteralPool( &cp, clc - 1 );
-    oldclc = clc;
-    if( isdone( line[lexstart] ))
+    punchLiteralPool( as, &as->cp, as->clc - 1 );
+    oldclc = as->clc;
+    if( isdone( as->line[as->lexstart] ))
     {
-      clc = ( clc + 0177 ) & 077600;            /* No argumnet.               */
-      fieldlc = clc & 07777;
+      as->clc = ( as->clc + 0177 ) & 077600;            /* No argumnet.       */
+      as->fieldlc = as->clc & 07777;
     }
     else
     {
-      value = (getExpr())->val;
-      clc = ( field << 12 ) + (( value & 037 ) << 7 );
-      fieldlc = clc & 07777;
+      value = (getExpr( as ))->val;
+      as->clc = ( as->field << 12 ) + (( value & 037 ) << 7 );
+      as->fieldlc = as->clc & 07777;
     }
-    testForLiteralCollision( clc );
+    testForLiteralCollision( as, as->clc );
 
-    if( !rim_mode && clc != oldclc )
+    if( !as->rim_mode && as->clc != oldclc )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
     break;
 
@@ -3550,201 +7575,226 @@ BOOL pseudoOperators( PSEUDO_T val )
     break;
 
   case RELOC:
-    if( isdone( line[lexstart] ))
+    if( isdone( as->line[as->lexstart] ))
     {
-       reloc = 0;               /* Blank RELOC directive.                     */
+       as->reloc = 0;               /* Blank RELOC directive.                 */
     }
     else
     {
-      value = (getExpr())->val; /* RELOC with argument.                       */
-      reloc = value - ( clc + reloc );
+      value = (getExpr( as ))->val; /* RELOC with argument.                   */
+      as->reloc = value - ( as->clc + as->reloc );
     }
     break;
 
   case RIMPUNCH:
+    if( !as->rim_mode )
+    {
+      failOnePass( as );         /* Pass 2 starts in the mode pass 1 ends in. */
+    }
     /* If the assembler has output any BIN data, output the literal tables    */
     /* and the checksum for what has been assembled and setup for RIM mode.   */
-    if( binary_data_output && !rim_mode )
+    if( as->binary_data_output && !as->rim_mode )
     {
-      lexstartsave = lexstartprev;
-      if( isdone( line[lexstart] ))
+      lexstartsave = as->lexstartprev;
+      if( isdone( as->line[as->lexstart] ))
       {
 	leaderlen = 8; /* If not specified, the short leader/trailer will be 8. */
       }
       else	
       {
-	leaderlen = (getExpr())->val;      /* BINPUN leaderlen              */
+	leaderlen = (getExpr( as ))->val;      /* BINPUN leaderlen              */
       }
 
-      endOfBinary();
+      endOfBinary( as );
       if (leaderlen != -1)
       {
-	punchChecksum();
+	punchChecksum( as );
       }
-      punchLeader( leaderlen );         /* Generate a short leader/trailer.           */
+      punchLeader( as, leaderlen );       /* Generate a short leader/trailer. */
     }
-    rim_mode = TRUE;
+    as->rim_mode = TRUE;
     break;
 
   case SEGMNT:
-    punchLiteralPool( &cp, clc - 1 );
-    if( isdone( line[lexstart] ))
+    punchLiteralPool( as, &as->cp, as->clc - 1 );
+    if( isdone( as->line[as->lexstart] ))
     {                           /* No argument.                               */
-      clc = ( clc & 06000 ) + 02000;
-      fieldlc = clc & 07777;
+      as->clc = ( as->clc & 06000 ) + 02000;
+      as->fieldlc = as->clc & 07777;
     }
     else
     {
-      getExpr();
-      clc = ( val & 003 ) << 10;
-      fieldlc = clc & 07777;
+      getExpr( as );
+      as->clc = ( val & 003 ) << 10;
+      as->fieldlc = as->clc & 07777;
     }
-    if( !rim_mode )
+    if( !as->rim_mode )
     {
-      punchOrigin( clc );
+      punchOrigin( as, as->clc );
     }
-    testForLiteralCollision( clc );
+    testForLiteralCollision( as, as->clc );
     break;
 
   case TEXT:
-    delim = line[lexstart];
+    delim = as->line[as->lexstart];
     pack = 0;
     count = 0;
-    index = lexstart + 1;
-    while( line[index] != delim && !isend( line[index] ))
+    index = as->lexstart + 1;
+    column = expandedColumn( as, index );
+    while( as->line[index] != delim && !isend( as->line[index] ))
     {
-      pack = ( pack << 6 ) | ( line[index] & 077 );
-      count++;
-      if( count > 1 )
+      /* A tab is packed as the spaces it is listed as.                       */
+      spaces = tabWidth( as, index, column );
+      column += spaces;
+      for( ; spaces > 0; spaces-- )
       {
-        punchOutObject( clc, pack );
-        incrementClc();
-        count = 0;
-        pack = 0;
+        pack = ( pack << 6 ) |
+               ((( as->line[index] == '\t' ) ? ' ' : as->line[index] ) & 077 );
+        count++;
+        if( count > 1 )
+        {
+          punchOutObject( as, as->clc, pack );
+          incrementClc( as );
+          count = 0;
+          pack = 0;
+        }
       }
       index++;
     }
 
     if( count != 0 )
     {
-      punchOutObject( clc, pack << 6 );
-      incrementClc();
+      punchOutObject( as, as->clc, pack << 6 );
+      incrementClc( as );
     }
     else
     {
-      punchOutObject( clc, 0 );
-      incrementClc();
+      punchOutObject( as, as->clc, 0 );
+      incrementClc( as );
     }
 
-    if( isend( line[index] ))
+    if( isend( as->line[index] ))
     {
-      cc = index;
-      lexterm = cc;
-      errorMessage( &text_string, cc );
+      as->cc = index;
+      as->lexterm = as->cc;
+      errorMessage( as, &text_string, as->cc );
     }
     else
     {
-      cc = index + 1;
-      lexterm = cc;
+      as->cc = index + 1;
+      as->lexterm = as->cc;
     }
-    nextLexeme();
+    nextLexeme( as );
     break;
 
   case TITLE:
-    delim = line[lexstart];
-    ix = lexstart + 1;
+    delim = as->line[as->lexstart];
+    ix = as->lexstart + 1;
     /* Find string delimiter.                                                 */
     do
     {
-      if( list_title[ix] == delim && list_title[ix + 1] == delim )
+      if( as->line[ix] == delim && as->line[ix + 1] == delim )
       {
         ix++;
       }
       ix++;
-    } while( line[ix] != delim && !isend(line[ix]) );
+    } while( as->line[ix] != delim && !isend(as->line[ix]) );
 
-    if( line[ix] == delim )
+    if( as->line[ix] == delim )
     {
       count = 0;
-      ix = lexstart + 1;
+      ix = as->lexstart + 1;
+      column = expandedColumn( as, ix );
       do
       {
-        if( list_title[ix] == delim && list_title[ix + 1] == delim )
+        if( as->line[ix] == delim && as->line[ix + 1] == delim )
         {
           ix++;
+          column++;
+        }
+        spaces = tabWidth( as, ix, column );
+        column += spaces;
+        for( ; spaces > 0 && count <= TITLELEN; spaces-- )
+        {
+          as->list_title[count] = ( as->line[ix] == '\t' ) ? ' ' : as->line[ix];
+          count++;
+          as->list_title[count] = '\0';
         }
-        list_title[count] = line[ix];
-        count++;
         ix++;
-        list_title[count] = '\0';
-      } while( line[ix] != delim && !isend(line[ix]) );
+      } while( as->line[ix] != delim && !isend(as->line[ix]) );
 
-      if( strlen( list_title ) > TITLELEN )
+      if( strlen( as->list_title ) > TITLELEN )
       {
-        list_title[TITLELEN] = '\0';
+        as->list_title[TITLELEN] = '\0';
       }
 
-      cc = ix + 1;
-      lexterm = cc;
-      page_lineno = LIST_LINES_PER_PAGE;/* Force top of page for new titles.  */
-      list_title_set = TRUE;
+      as->cc = ix + 1;
+      as->lexterm = as->cc;
+      listNewPage( as, TRUE );          /* New titles, new page.          */
     }
     else
     {
-      cc = ix;
-      lexterm = cc;
-      errorMessage( &text_string, cc );
+      as->cc = ix;
+      as->lexterm = as->cc;
+      errorMessage( as, &text_string, as->cc );
     }
 
-    nextLexeme();
+    nextLexeme( as );
     break;
 
   case XLIST:
-    if( isdone( line[lexstart] ))
+    if( isdone( as->line[as->lexstart] ))
     {
-      temp = listfile;          /* Blank XLIST directive.                     */
-      listfile = listsave;
-      listsave = temp;
+      temp = as->listfile;          /* Blank XLIST directive.                 */
+      as->listfile = as->listsave;
+      as->listsave = temp;
+      as->list_off = !as->list_off;
     }
     else
     {
-      if( (getExpr())->val == 0 )
+      if( (getExpr( as ))->val == 0 )
       {
-        if( listfile == NULL )
+        if( as->listfile == NULL )
         {
-          listfile = listsave;
-          listsave = NULL;
+          as->listfile = as->listsave;
+          as->listsave = NULL;
         }
+        as->list_off = FALSE;
       }
       else
       {
-        if( listfile != NULL )
+        if( as->listfile != NULL )
         {
-          listsave = listfile;
-          listfile = NULL;
+          as->listsave = as->listfile;
+          as->listfile = NULL;
         }
+        as->list_off = TRUE;
       }
     }
     break;
 
   case ZBLOCK:
-    value = (getExpr())->val;
+    value = (getExpr( as ))->val;
     if( value < 0 )
     {
-      errorMessage( &zblock_too_small, lexstartprev );
+      errorMessage( as, &zblock_too_small, as->lexstartprev );
     }
-    else if( value + ( clc & 07777 ) - 1 > 07777 )
+    else if( value + ( as->clc & 07777 ) - 1 > 07777 )
     {
-      errorMessage( &zblock_too_large, lexstartprev );
+      errorMessage( as, &zblock_too_large, as->lexstartprev );
     }
-    else
+    else if( as->zblock_words )
     {
       for( ; value > 0; value-- )
       {
-        punchOutObject( clc, 0 );
-        incrementClc();
+        punchOutObject( as, as->clc, 0 );
+        incrementClc( as );
       }
     }
+    else if( value > 0 )
+    {
+      punchZeroBlock( as, value );
+    }
 
     break;
 
@@ -3764,53 +7814,128 @@ BOOL pseudoOperators( PSEUDO_T val )
 /*             the closing >.                                                 */
 /*                                                                            */
 /******************************************************************************/
-void conditionFalse()
+void conditionFalse( ASM_T *as )
 {
   int     level;
+  SKIP_T *skip;
+  int     start_col;
+  int     start_line;
 
-  if( line[lexstart] == '<' )
+  if( as->line[as->lexstart] == '<' )
   {
-    /* Invariant: line[cc] is the next unexamined character.                  */
-    level = 1;
-    while( level > 0 )
+    skip = ( as->pass == 2 ) ? findSkip( as ) : NULL;
+    if( skip != NULL )
     {
-      if( isend( line[cc] ))
+      /* The lines skipped are still read, to be listed.                      */
+      while( as->lexeme_line >= 0 && as->lexeme_line < skip->end_line )
       {
-        readLine();
+        readLine( as );
       }
-      else
+      as->cc = skip->end_col;
+    }
+    else
+    {
+      start_line = as->lexeme_line;
+      start_col = as->cc;
+
+      /* Invariant: line[cc] is the next unexamined character.                */
+      level = 1;
+      while( level > 0 )
       {
-        switch( line[cc] )
+        /* Only the characters of class CC_SKIP end a run of characters.     */
+        while( !( charClass( as->line[as->cc] ) & ( CC_END | CC_SKIP )))
         {
-        case '>':
-          level--;
-          cc++;
-          break;
+          as->cc++;
+        }
+        if( isend( as->line[as->cc] ))
+        {
+          readLine( as );
+        }
+        else
+        {
+          switch( as->line[as->cc] )
+          {
+          case '>':
+            level--;
+            as->cc++;
+            break;
 
-        case '<':
-          level++;
-          cc++;
-          break;
+          case '<':
+            level++;
+            as->cc++;
+            break;
 
-        case '$':
-          level = 0;
-          cc++;
-          break;
+          case '$':
+            level = 0;
+            as->cc++;
+            break;
+          } /* end switch                                                     */
+        } /* end if                                                           */
+      } /* end while                                                          */
 
-        default:
-          cc++;
-          break;
-        } /* end switch                                                       */
-      } /* end if                                                             */
-    } /* end while                                                            */
-    nextLexeme();
+      if( as->pass == 1 && start_line >= 0 && as->lexeme_line >= 0 )
+      {
+        as->skips = (SKIP_T *) growTable( as->skips, &as->skip_room,
+                                          sizeof( SKIP_T ),
+                                          as->skip_count + 1 );
+        as->skips[as->skip_count].line = start_line;
+        as->skips[as->skip_count].col = start_col;
+        as->skips[as->skip_count].end_line = as->lexeme_line;
+        as->skips[as->skip_count].end_col = as->cc;
+        as->skip_count++;
+      }
+    }
+    nextLexeme( as );
   }
   else
   {
-    errorMessage( &lt_expected, lexstart );
+    errorMessage( as, &lt_expected, as->lexstart );
   }
 } /* conditionFalse()                                                         */
 
+
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  findSkip                                                       */
+/*                                                                            */
+/*  Synopsis:  Find the skip pass 1 made from the current line and column.    */
+/*             Returns NULL if it made none there.                            */
+/*                                                                            */
+/******************************************************************************/
+SKIP_T *findSkip( ASM_T *as )
+{
+  int     high;
+  int     low;
+  int     mid;
+
+  if( as->lexeme_line < 0 )
+  {
+    return( NULL );
+  }
+
+  /* The skips were made, and so are kept, in the order of the source.        */
+  for( low = 0, high = as->skip_count; low < high; )
+  {
+    mid = ( low + high ) / 2;
+    if( as->skips[mid].line < as->lexeme_line
+        || ( as->skips[mid].line == as->lexeme_line
+             && as->skips[mid].col < as->cc ))
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  if( low < as->skip_count && as->skips[low].line == as->lexeme_line
+      && as->skips[low].col == as->cc )
+  {
+    return( &as->skips[low] );
+  }
+  return( NULL );
+} /* findSkip()                                                               */
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  conditionTrue                                                  */
@@ -3820,15 +7945,15 @@ void conditionFalse()
 /*             normal assembly.                                               */
 /*                                                                            */
 /******************************************************************************/
-void conditionTrue()
+void conditionTrue( ASM_T *as )
 {
-  if( line[lexstart] == '<' )
+  if( as->line[as->lexstart] == '<' )
   {
-    nextLexeme();               /* Skip the opening '<'                       */
+    nextLexeme( as );               /* Skip the opening '<'                   */
   }
   else
   {
-    errorMessage( &lt_expected, lexstart );
+    errorMessage( as, &lt_expected, as->lexstart );
   }
 } /* conditionTrue()                                                          */
 
@@ -3840,11 +7965,12 @@ void conditionTrue()
 /*  Synopsis:  Display an error message using the current lexical element.    */
 /*                                                                            */
 /******************************************************************************/
-void errorLexeme( EMSG_T *mesg, int col )
+void errorLexeme( ASM_T *as, EMSG_T *mesg, int col )
 {
   char   name[SYMLEN];
 
-  errorSymbol( mesg, lexemeToName( name, lexstart, lexterm ), col );
+  errorSymbol( as, mesg, lexemeToName( as, name, as->lexstart, as->lexterm ),
+               col );
 } /* errorLexeme()                                                            */
 
 
@@ -3855,21 +7981,27 @@ void errorLexeme( EMSG_T *mesg, int col )
 /*  Synopsis:  Display an error message with a given string.                  */
 /*                                                                            */
 /******************************************************************************/
-void errorSymbol( EMSG_T *mesg, char *name, int col )
+void errorSymbol( ASM_T *as, EMSG_T *mesg, char *name, int col )
 {
   char   linecol[12];
   char  *s;
 
-  if( pass == 2 )
+  if( as->pass == 2 )
   {
     s = ( name == NULL ) ? "" : name ;
-    errors++;
-    sprintf( linecol, "(%d:%d)", lineno, col + 1 );
-    fprintf( errorfile, "%s%-9s : error:  %s \"%s\" at Loc = %5.5o\n",
-                                      filename, linecol, mesg->file, s, clc );
-    saveError( mesg->list, col );
+    as->errors++;
+    col = expandedColumn( as, col + 1 ) - 1;   /* Last column of a tab.      */
+    sprintf( linecol, "(%d:%d)", as->lineno, col + 1 );
+    fprintf( as->errorfile, "%s%-9s : error:  %s \"%s\" at Loc = %5.5o\n",
+             as->filename, linecol, mesg->file, s, as->clc );
+    saveError( as, mesg->list, col );
+    saveDiag( as, mesg, s, col );
+  }
+  else
+  {
+    failOnePass( as );              /* Only pass 2 lists the errors.          */
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 } /* errorSymbol()                                                            */
 
 
@@ -3880,21 +8012,54 @@ void errorSymbol( EMSG_T *mesg, char *name, int col )
 /*  Synopsis:  Display an error message without a name argument.              */
 /*                                                                            */
 /******************************************************************************/
-void errorMessage( EMSG_T *mesg, int col )
+void errorMessage( ASM_T *as, EMSG_T *mesg, int col )
 {
   char   linecol[12];
 
-  if( pass == 2 )
+  if( as->pass == 2 )
+  {
+    as->errors++;
+    col = expandedColumn( as, col + 1 ) - 1;   /* Last column of a tab.      */
+    sprintf( linecol, "(%d:%d)", as->lineno, col + 1 );
+    fprintf( as->errorfile, "%s%-9s : error:  %s at Loc = %5.5o\n",
+             as->filename, linecol, mesg->file, as->clc );
+    saveError( as, mesg->list, col );
+    saveDiag( as, mesg, "", col );
+  }
+  else
   {
-    errors++;
-    sprintf( linecol, "(%d:%d)", lineno, col + 1 );
-    fprintf( errorfile, "%s%-9s : error:  %s at Loc = %5.5o\n",
-                                         filename, linecol, mesg->file, clc );
-    saveError( mesg->list, col );
+    failOnePass( as );              /* Only pass 2 lists the errors.          */
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 } /* errorMessage()                                                           */
 
+/******************************************************************************/
+/*                                                                            */
+/*  Function:  saveDiag                                                       */
+/*                                                                            */
+/*  Synopsis:  Save an error for the caller of palbartAssemble(), if it has   */
+/*             room for it.  All the errors are counted.                      */
+/*                                                                            */
+/******************************************************************************/
+void saveDiag( ASM_T *as, EMSG_T *mesg, char *name, int col )
+{
+  PALBART_DIAG_T *diag;
+
+  if( as->diag_count < as->diag_size )
+  {
+    diag = &as->diags[as->diag_count];
+    diag->line = as->lineno;
+    diag->col = col + 1;
+    diag->loc = as->clc;
+    diag->mesg = mesg->file;
+    diag->list_mesg = mesg->list;
+    strncpy( diag->name, name, PALBART_NAMELEN - 1 );
+    diag->name[PALBART_NAMELEN - 1] = '\0';
+  }
+  as->diag_count++;
+} /* saveDiag()                                                               */
+
+
 /******************************************************************************/
 /*                                                                            */
 /*  Function:  saveError                                                      */
@@ -3903,19 +8068,19 @@ void errorMessage( EMSG_T *mesg, int col )
 /*             the current line is printed.                                   */
 /*                                                                            */
 /******************************************************************************/
-void saveError( char *mesg, int col )
+void saveError( ASM_T *as, char *mesg, int col )
 {
-  if( save_error_count < DIM( error_list ))
+  if( as->save_error_count < DIM( as->error_list ))
   {
-    error_list[save_error_count].mesg = mesg;
-    error_list[save_error_count].col = col;
-    save_error_count++;
+    as->error_list[as->save_error_count].mesg = mesg;
+    as->error_list[as->save_error_count].col = col;
+    as->save_error_count++;
   }
-  error_in_line = TRUE;
+  as->error_in_line = TRUE;
 
-  if( listed )
+  if( as->listed )
   {
-    printErrorMessages();
+    printErrorMessages( as );
   }
 } /* saveError()                                                              */
 
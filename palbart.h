@@ -0,0 +1,73 @@
+/******************************************************************************/
+/*                                                                            */
+/* Program:  PAL                                                              */
+/* File:     palbart.h                                                        */
+/*                                                                            */
+/* Purpose:  Interface of libpalbart, the assembler as a library.             */
+/*                                                                            */
+/* SYNOPSIS:                                                                  */
+/*    #include "palbart.h"                                                    */
+/*    cc ... -lpalbart -lm -lpthread                                          */
+/*                                                                            */
+/* DESCRIPTION                                                                */
+/*    palbartAssemble() assembles a source held in memory exactly as palbart */
+/*    assembles a file, but without touching the file system.  The object    */
+/*    output, the listing, the memory image the object loads and the errors  */
+/*    are returned in buffers owned by the caller.  Any buffer may be NULL   */
+/*    with a size of 0.  The lengths are those of the whole output, even if  */
+/*    it did not fit, so a caller can grow a buffer and assemble again.      */
+/*                                                                            */
+/*    Each call has its own assembler context, so calls may run at the same  */
+/*    time in different threads.                                              */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef PALBART_H
+#define PALBART_H
+
+/* Options of palbartAssemble(), the same as the command line flags.          */
+#define PALBART_ONE_PASS    0001        /* -1  single pass if possible.       */
+#define PALBART_SYMTAB      0002        /* -d  list the symbol table.         */
+#define PALBART_LITERALS    0004        /* -l  generate literals.             */
+#define PALBART_RIM         0010        /* -r  object in RIM format.          */
+#define PALBART_XREF        0020        /* -x  list the cross reference.      */
+#define PALBART_COMPACT     0040        /* -c  bin tape punched from image.   */
+#define PALBART_ZBLOCK_WORDS 0100       /* -z  list every word of a ZBLOCK.   */
+#define PALBART_LIST_ERRORS 0200        /* -e  list only if there are errors. */
+
+#define PALBART_IMAGE_SIZE 32768        /* Words of memory, 8 fields of 4K.   */
+#define PALBART_NAMELEN        7        /* Longest symbol name, with the NUL. */
+
+/* An error, as written to the .err file by palbart.                          */
+struct palbart_diag_t
+{
+  int          line;                    /* Source line, from 1.               */
+  int          col;                     /* Column, from 1, tabs expanded.     */
+  int          loc;                     /* Location counter at the error.     */
+  const char  *mesg;                    /* Message, e.g. "undefined symbol".  */
+  const char  *list_mesg;               /* As listed, e.g. "UD undefined".    */
+  char         name[PALBART_NAMELEN];   /* Symbol in error, or "".            */
+};
+typedef struct palbart_diag_t PALBART_DIAG_T;
+
+/* The caller's buffers for the results, and the lengths of the results.      */
+struct palbart_output_t
+{
+  unsigned char  *object;               /* The .bin or .rim output.           */
+  long            object_size;
+  long            object_length;
+  char           *listing;              /* The .lst output, NUL ended if the  */
+  long            listing_size;         /* NUL fits.                          */
+  long            listing_length;
+  unsigned short *image;                /* PALBART_IMAGE_SIZE words.  Words   */
+                                        /* not loaded are left as they were.  */
+  PALBART_DIAG_T *diags;                /* The errors, in the order found.    */
+  int             diag_size;
+  int             diag_count;
+};
+typedef struct palbart_output_t PALBART_OUTPUT_T;
+
+int palbartAssemble( const char *source, long size, int options,
+                     PALBART_OUTPUT_T *output );
+
+#endif